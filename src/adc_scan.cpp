@@ -0,0 +1,164 @@
+#include "definitions.h"
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+//================================================================================
+// DMA SENSOR SCAN
+//================================================================================
+// ADC1 runs in continuous mode and converts MAP, backpressure, IAT and supply
+// in turn, ADC_SCAN_FREQ_HZ conversions a second, straight into a DMA pool.
+// The channels are 12.5 us apart within a pass, so a SensorSample is one
+// coherent snapshot. readSensorSample() only drains what the hardware already
+// converted into the averaging rings (a few hundred conversions, tens of
+// microseconds), where 256 blocking analogRead() calls took milliseconds.
+// analogRead() must not be used on ADC1 while the scan is running.
+//
+// The overboost guard drains the scan too, every OVERBOOST_PERIOD_US, so the
+// rings see every conversion whichever task gets there first and the pool
+// cannot overflow while the control task is stalled. scanMutex keeps the two
+// out of each other's way; a drain is a few tens of microseconds.
+//
+// At boot the chip's eFuse ADC calibration is read through esp_adc_cal at
+// each correction point (sensors.h, ADC CORRECTION); with ADC Correct. on,
+// both readers convert averaged codes through it.
+//
+// While the board is idle (power.h) the scan is stopped, which also drops the
+// driver's power-management lock, and run in short bursts before each reading.
+
+static const uint32_t ADC_SCAN_FREQ_HZ = (uint32_t)SENSOR_SCAN_HZ * SENSOR_CHANNEL_COUNT;
+static const uint32_t ADC_SCAN_FRAME_BYTES = 256;   // bytes per DMA interrupt and per read
+static const uint32_t ADC_SCAN_POOL_BYTES = 8192;   // about 25 ms of conversions
+static const int ADC_SCAN_MAX_FRAMES = ADC_SCAN_POOL_BYTES / ADC_SCAN_FRAME_BYTES;
+static const int ADC1_CHANNELS = 10;
+
+static const int scanPins[SENSOR_CHANNEL_COUNT] = {
+    PRESSURE_SENSOR_PIN, BACKPRESSURE_SENSOR_PIN, IAT_SENSOR_PIN, SUPPLY_SENSE_PIN
+};
+static int8_t sensorOfAdcChannel[ADC1_CHANNELS];
+static SensorAverager averager;
+static OversamplePolicy oversamplePolicy;
+static uint8_t frame[ADC_SCAN_FRAME_BYTES];
+static SemaphoreHandle_t scanMutex = NULL;
+static StaticSemaphore_t scanMutexBuffer;
+static AdcCharacterization adcCharacterization;
+static AdcCorrection adcCorrection;
+static const uint32_t ADC_DEFAULT_VREF_MV = 1100;   // only used by chips without eFuse calibration
+
+// Reads the chip's calibration once; esp_adc_cal_raw_to_voltage() is far too
+// slow per conversion but fine for the ADC_CORRECTION_POINTS codes here.
+static void characterizeAdc() {
+    esp_adc_cal_characteristics_t chip;
+    esp_adc_cal_value_t source = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF_MV, &chip);
+    switch (source) {
+        case ESP_ADC_CAL_VAL_EFUSE_VREF: adcCharacterization.source = ADC_CAL_EFUSE_VREF; break;
+        case ESP_ADC_CAL_VAL_EFUSE_TP: adcCharacterization.source = ADC_CAL_EFUSE_TWO_POINT; break;
+        case ESP_ADC_CAL_VAL_EFUSE_TP_FIT: adcCharacterization.source = ADC_CAL_EFUSE_CURVE; break;
+        default: adcCharacterization.source = ADC_CAL_NONE; break;
+    }
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) {
+        adcCharacterization.millivolts[i] = (float)esp_adc_cal_raw_to_voltage(i * ADC_CORRECTION_STEP, &chip);
+    }
+    if (!adcCorrectionBuild(adcCorrection, adcCharacterization)) {
+        Serial.printf("ADC calibration (%s) not usable; ideal conversion in use\n", adcCalibrationSourceName(adcCharacterization.source));
+    }
+}
+
+const AdcCharacterization& sensorAdcCharacterization(bool& usable) {
+    usable = adcCorrection.enabled;
+    return adcCharacterization;
+}
+
+void beginSensorScan() {
+    scanMutex = xSemaphoreCreateMutexStatic(&scanMutexBuffer);
+    characterizeAdc();
+    sensorAveragerInit(averager, OVERSAMPLE_COUNT);
+    oversamplePolicyInit(oversamplePolicy, OVERSAMPLE_COUNT);
+    sensorAveragerSetSpikeWindow(averager, spikeRejectWindow);
+    for (int i = 0; i < ADC1_CHANNELS; i++) sensorOfAdcChannel[i] = -1;
+
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = ADC_SCAN_POOL_BYTES;
+    init.conv_num_each_intr = ADC_SCAN_FRAME_BYTES;
+    adc_digi_pattern_config_t pattern[SENSOR_CHANNEL_COUNT] = {};
+    for (int i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+        int channel = digitalPinToAnalogChannel(scanPins[i]);   // every scan pin is on ADC1
+        init.adc1_chan_mask |= 1 << channel;
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channel;
+        pattern[i].unit = 0;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        sensorOfAdcChannel[channel] = i;
+    }
+    adc_digi_initialize(&init);
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.conv_limit_num = 250;
+    config.pattern_num = SENSOR_CHANNEL_COUNT;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = ADC_SCAN_FREQ_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    adc_digi_controller_configure(&config);
+    adc_digi_start();
+}
+
+// Moves whatever the hardware has converted into the averaging rings.
+static void drainScan() {
+    // ESP_ERR_INVALID_STATE means the pool overflowed and old conversions were
+    // dropped; what was returned is still good.
+    for (int f = 0; f < ADC_SCAN_MAX_FRAMES; f++) {
+        uint32_t length = 0;
+        esp_err_t result = adc_digi_read_bytes(frame, sizeof(frame), &length, 0);
+        if ((result != ESP_OK && result != ESP_ERR_INVALID_STATE) || length == 0) break;
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t* conversion = (const adc_digi_output_data_t*)&frame[i];
+            if (conversion->type2.unit != 0 || conversion->type2.channel >= ADC1_CHANNELS) continue;
+            sensorAveragerPush(averager, sensorOfAdcChannel[conversion->type2.channel], conversion->type2.data);
+        }
+    }
+}
+
+// With adaptive oversampling the MAP channel's policy sets the window for
+// every channel; the auxiliary channels are low-passed far more heavily after.
+void readSensorSample(SensorSample& sample) {
+    xSemaphoreTake(scanMutex, portMAX_DELAY);
+    sensorAveragerSetSpikeWindow(averager, spikeRejectWindow);
+    sensorAveragerSetCorrection(averager, adcCorrectionEnabled ? &adcCorrection : nullptr);
+    drainScan();
+    int window = OVERSAMPLE_COUNT;
+    if (oversampleAdaptive) {
+        window = oversamplePolicyUpdate(oversamplePolicy, averager, SENSOR_MAP, oversampleMinCount, OVERSAMPLE_COUNT);
+    } else {
+        oversamplePolicyInit(oversamplePolicy, OVERSAMPLE_COUNT);
+    }
+    sensorAveragerSetWindow(averager, window);
+    sensorAveragerSample(averager, millis(), sample);
+    xSemaphoreGive(scanMutex);
+}
+
+bool readRecentSensorVoltage(int channel, int count, float& voltage) {
+    xSemaphoreTake(scanMutex, portMAX_DELAY);
+    drainScan();
+    bool ready = sensorAveragerRecent(averager, channel, count, voltage);
+    xSemaphoreGive(scanMutex);
+    return ready;
+}
+
+void sensorScanPause(bool paused) {
+    xSemaphoreTake(scanMutex, portMAX_DELAY);
+    if (paused) {
+        adc_digi_stop();
+    } else {
+        adc_digi_start();
+    }
+    xSemaphoreGive(scanMutex);
+}
+
+// Refills the averaging window from a stopped scan: the fresh conversions
+// push the ones from before the pause out of the rings.
+void sensorScanBurst(int burstMs) {
+    sensorScanPause(false);
+    vTaskDelay(pdMS_TO_TICKS(burstMs));
+    sensorScanPause(true);
+}
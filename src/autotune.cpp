@@ -0,0 +1,149 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "autotune.h"
+#include "control.h"
+#include <math.h>
+
+const char* autotuneRuleName(AutotuneRule rule) {
+    switch (rule) {
+        case AUTOTUNE_RULE_ZIEGLER_NICHOLS: return "Z-Nichols";
+        case AUTOTUNE_RULE_TYREUS_LUYBEN: return "Tyreus-Luy";
+        case AUTOTUNE_RULE_NO_OVERSHOOT: return "No O/shoot";
+        default: return "?";
+    }
+}
+
+void autotuneStart(Autotuner& tuner, const AutotuneConfig& config) {
+    tuner.config = config;
+    tuner.phase = AUTOTUNE_WAITING;
+    tuner.abortReason = AUTOTUNE_ABORT_NONE;
+    tuner.holdingOpen = false;
+    tuner.relayHigh = true;
+    tuner.relayStartMs = 0;
+    tuner.lastRiseMs = 0;
+    tuner.cycleMax = -1e9f;
+    tuner.cycleMin = 1e9f;
+    tuner.cycles = 0;
+    tuner.periodSumMs = 0;
+    tuner.amplitudeSumkPa = 0;
+    tuner.result.ultimateGain = 0;
+    tuner.result.ultimatePeriodMs = 0;
+    tuner.result.amplitudekPa = 0;
+    tuner.result.kp = 0; tuner.result.ki = 0; tuner.result.kd = 0;
+}
+
+void autotuneAbort(Autotuner& tuner, AutotuneAbortReason reason) {
+    if (tuner.phase == AUTOTUNE_WAITING || tuner.phase == AUTOTUNE_RELAY) {
+        tuner.phase = AUTOTUNE_ABORTED;
+        tuner.abortReason = reason;
+        tuner.holdingOpen = true;
+    }
+}
+
+void autotuneComputeGains(AutotuneResult& result, float relayAmplitude, float hysteresiskPa, AutotuneRule rule) {
+    // Describing-function estimate for a relay with hysteresis.
+    float a = result.amplitudekPa;
+    float effective = sqrtf(fmaxf(a * a - hysteresiskPa * hysteresiskPa, a * a * 0.01f));
+    result.ultimateGain = 4.0f * relayAmplitude / ((float)M_PI * effective);
+
+    float Ku = result.ultimateGain;
+    float TuSeconds = result.ultimatePeriodMs / 1000.0f;
+    float Ti, Td;
+    switch (rule) {
+        case AUTOTUNE_RULE_TYREUS_LUYBEN:
+            result.kp = Ku / 2.2f; Ti = 2.2f * TuSeconds; Td = TuSeconds / 6.3f;
+            break;
+        case AUTOTUNE_RULE_NO_OVERSHOOT:
+            result.kp = 0.2f * Ku; Ti = 0.5f * TuSeconds; Td = TuSeconds / 3.0f;
+            break;
+        case AUTOTUNE_RULE_ZIEGLER_NICHOLS:
+        default:
+            result.kp = 0.6f * Ku; Ti = 0.5f * TuSeconds; Td = 0.125f * TuSeconds;
+            break;
+    }
+    // Firmware PID form: kp*e + ki*integral(e dt) + kd*de/dt, time in seconds.
+    result.ki = (Ti > 0) ? result.kp / Ti : 0;
+    result.kd = result.kp * Td;
+}
+
+bool autotuneStep(Autotuner& tuner, float pressurekPa, float targetkPa, uint32_t timeMs, float& dutyPercent) {
+    const AutotuneConfig& cfg = tuner.config;
+
+    if (tuner.phase == AUTOTUNE_WAITING) {
+        if (pressurekPa > targetkPa + cfg.overshootLimitkPa) {
+            autotuneAbort(tuner, AUTOTUNE_ABORT_OVERSHOOT);
+        } else if (pressurekPa >= targetkPa - cfg.hysteresiskPa) {
+            tuner.phase = AUTOTUNE_RELAY;
+            tuner.relayHigh = false;
+            tuner.relayStartMs = timeMs;
+            tuner.cycleMax = pressurekPa;
+            tuner.cycleMin = pressurekPa;
+        } else {
+            return false;
+        }
+    }
+
+    if (tuner.phase != AUTOTUNE_RELAY) {
+        // Open the wastegate on the tick of an abort, and after an overshoot
+        // until the pressure is back under the target; then the PID has it.
+        // The phase stays ABORTED with its reason for the screen.
+        if (tuner.phase == AUTOTUNE_ABORTED && tuner.holdingOpen) {
+            tuner.holdingOpen = tuner.abortReason == AUTOTUNE_ABORT_OVERSHOOT && pressurekPa > targetkPa;
+            dutyPercent = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // -- Safety limits --
+    if (pressurekPa > targetkPa + cfg.overshootLimitkPa) {
+        autotuneAbort(tuner, AUTOTUNE_ABORT_OVERSHOOT);
+        dutyPercent = 0;
+        return true;
+    }
+    // The driver lifted, or the relay ran out of time: hand straight back to the PID.
+    if (pressurekPa < targetkPa - cfg.liftDropkPa) {
+        autotuneAbort(tuner, AUTOTUNE_ABORT_LIFT);
+        tuner.holdingOpen = false;
+        return false;
+    }
+    if (timeMs - tuner.relayStartMs > cfg.timeoutMs) {
+        autotuneAbort(tuner, AUTOTUNE_ABORT_TIMEOUT);
+        tuner.holdingOpen = false;
+        return false;
+    }
+
+    if (pressurekPa > tuner.cycleMax) tuner.cycleMax = pressurekPa;
+    if (pressurekPa < tuner.cycleMin) tuner.cycleMin = pressurekPa;
+
+    if (tuner.relayHigh && pressurekPa > targetkPa + cfg.hysteresiskPa) {
+        tuner.relayHigh = false;
+    } else if (!tuner.relayHigh && pressurekPa < targetkPa - cfg.hysteresiskPa) {
+        tuner.relayHigh = true;
+        // A full cycle ends on each low -> high switch. The first one starts from the
+        // spool transient, so it only arms the measurement.
+        if (tuner.lastRiseMs != 0) {
+            tuner.cycles++;
+            if (tuner.cycles > 1) {
+                tuner.periodSumMs += (float)(timeMs - tuner.lastRiseMs);
+                tuner.amplitudeSumkPa += (tuner.cycleMax - tuner.cycleMin) * 0.5f;
+            }
+        }
+        tuner.lastRiseMs = timeMs;
+        tuner.cycleMax = pressurekPa;
+        tuner.cycleMin = pressurekPa;
+
+        if (tuner.cycles > cfg.cyclesRequired) {
+            int measured = tuner.cycles - 1;
+            tuner.result.ultimatePeriodMs = tuner.periodSumMs / measured;
+            tuner.result.amplitudekPa = tuner.amplitudeSumkPa / measured;
+            float relayAmplitude = (cfg.relayHighPercent - cfg.relayLowPercent) * 0.5f * OUTPUT_COUNTS_PER_PERCENT;
+            autotuneComputeGains(tuner.result, relayAmplitude, cfg.hysteresiskPa, cfg.rule);
+            tuner.phase = AUTOTUNE_DONE;
+            return false;
+        }
+    }
+
+    dutyPercent = tuner.relayHigh ? cfg.relayHighPercent : cfg.relayLowPercent;
+    return true;
+}
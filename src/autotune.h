@@ -0,0 +1,81 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+
+//================================================================================
+// RELAY-FEEDBACK PID AUTOTUNE
+//================================================================================
+// Drives the solenoid as a relay (bang-bang with hysteresis) around the target
+// during a pull. The resulting limit cycle gives the ultimate gain Ku and period
+// Tu, from which PID gains follow by a tuning rule. Hardware independent so the
+// host plant simulator exercises the same code (tools/autotune).
+
+enum AutotuneRule {
+    AUTOTUNE_RULE_ZIEGLER_NICHOLS,
+    AUTOTUNE_RULE_TYREUS_LUYBEN,
+    AUTOTUNE_RULE_NO_OVERSHOOT,
+    AUTOTUNE_RULE_COUNT
+};
+
+enum AutotunePhase {
+    AUTOTUNE_IDLE,
+    AUTOTUNE_WAITING,      // normal control until pressure first reaches the target
+    AUTOTUNE_RELAY,
+    AUTOTUNE_DONE,
+    AUTOTUNE_ABORTED
+};
+
+enum AutotuneAbortReason {
+    AUTOTUNE_ABORT_NONE,
+    AUTOTUNE_ABORT_OVERSHOOT,
+    AUTOTUNE_ABORT_LIFT,
+    AUTOTUNE_ABORT_TIMEOUT,
+    AUTOTUNE_ABORT_USER,
+    AUTOTUNE_ABORT_SENSOR
+};
+
+struct AutotuneConfig {
+    float relayHighPercent;
+    float relayLowPercent;
+    float hysteresiskPa;
+    float overshootLimitkPa;   // abort above targetkPa + this
+    float liftDropkPa;         // abort below targetkPa - this (throttle lifted)
+    uint32_t timeoutMs;        // relay phase only
+    int cyclesRequired;
+    AutotuneRule rule;
+};
+
+struct AutotuneResult {
+    float ultimateGain;        // Ku, output units (0-255) per kPa
+    float ultimatePeriodMs;    // Tu
+    float amplitudekPa;
+    float kp, ki, kd;
+};
+
+struct Autotuner {
+    AutotuneConfig config;
+    AutotunePhase phase;
+    AutotuneAbortReason abortReason;
+    bool holdingOpen;          // aborted, and the wastegate not yet opened for it
+    bool relayHigh;
+    uint32_t relayStartMs;
+    uint32_t lastRiseMs;       // last low -> high switch
+    float cycleMax, cycleMin;
+    int cycles;                // completed cycles, the first is discarded
+    float periodSumMs;
+    float amplitudeSumkPa;
+    AutotuneResult result;
+};
+
+const char* autotuneRuleName(AutotuneRule rule);
+void autotuneStart(Autotuner& tuner, const AutotuneConfig& config);
+void autotuneAbort(Autotuner& tuner, AutotuneAbortReason reason);
+// Returns true while the tuner owns the solenoid; dutyPercent is then the relay
+// output, or 0 on the tick an abort opens the wastegate (and after an overshoot
+// abort, until the pressure is back under the target). Otherwise dutyPercent is
+// left alone and the PID keeps the solenoid.
+bool autotuneStep(Autotuner& tuner, float pressurekPa, float targetkPa, uint32_t timeMs, float& dutyPercent);
+void autotuneComputeGains(AutotuneResult& result, float relayAmplitude, float hysteresiskPa, AutotuneRule rule);
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,69 @@
+#include "boot.h"
+
+//================================================================================
+// STAGED BOOT
+//================================================================================
+const char* bootStageName(int stage) {
+    switch (stage) {
+        case BOOT_OUTPUTS: return "outputs";
+        case BOOT_PARAMETERS: return "parameters";
+        case BOOT_SENSORS: return "sensors";
+        case BOOT_CONTROL: return "control";
+        case BOOT_DISPLAY: return "display";
+        case BOOT_TOUCH: return "touch";
+        case BOOT_RESET_WINDOW: return "reset window";
+        case BOOT_INTERFACE: return "interface";
+        default: return "unknown";
+    }
+}
+
+const char* bootStageStatusName(int status) {
+    switch (status) {
+        case BOOT_PENDING: return "pending";
+        case BOOT_RUNNING: return "running";
+        case BOOT_DONE: return "done";
+        case BOOT_FAILED: return "failed";
+        case BOOT_SKIPPED: return "skipped";
+        default: return "unknown";
+    }
+}
+
+void bootLogInit(BootLog& log) {
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+        log.status[i] = BOOT_PENDING;
+        log.startUs[i] = 0;
+        log.endUs[i] = 0;
+        log.order[i] = 0;
+    }
+    log.ran = 0;
+}
+
+static bool runStage(BootLog& log, const BootSteps& steps, int stage) {
+    log.order[log.ran++] = (uint8_t)stage;
+    log.status[stage] = BOOT_RUNNING;
+    log.startUs[stage] = steps.micros(steps.context);
+    bool ok = steps.run[stage] ? steps.run[stage](steps.context) : true;
+    log.endUs[stage] = steps.micros(steps.context);
+    log.status[stage] = ok ? BOOT_DONE : BOOT_FAILED;
+    return ok;
+}
+
+void bootRunCritical(BootLog& log, const BootSteps& steps) {
+    for (int stage = 0; stage < BOOT_CRITICAL_STAGES; stage++) runStage(log, steps, stage);
+}
+
+bool bootRunBackground(BootLog& log, const BootSteps& steps) {
+    for (int stage = BOOT_CRITICAL_STAGES; stage < BOOT_STAGE_COUNT; stage++) {
+        if (!runStage(log, steps, stage)) {
+            for (int rest = stage + 1; rest < BOOT_STAGE_COUNT; rest++) log.status[rest] = BOOT_SKIPPED;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t bootStageMicros(const BootLog& log, int stage) {
+    if (stage < 0 || stage >= BOOT_STAGE_COUNT) return 0;
+    if (log.status[stage] != BOOT_DONE && log.status[stage] != BOOT_FAILED) return 0;
+    return log.endUs[stage] - log.startUs[stage];   // unsigned, so a wrap of micros() is harmless
+}
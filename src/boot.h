@@ -0,0 +1,75 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+//================================================================================
+// STAGED BOOT
+//================================================================================
+// Power-on runs as a fixed list of stages in two phases. The critical phase
+// runs first, in setup(): it drives the solenoid low, loads the parameters,
+// starts the sensor scan and the guards, and starts the control task, so boost
+// is under control a few milliseconds after reset. The background phase then
+// runs on core 1 while the control task runs on core 0: the display, touch
+// calibration (which waits for as long as a finger rests on a button), the
+// factory-reset window and the display and input task.
+//
+// A critical stage that fails is logged and the boot carries on, because the
+// control task's own checks (sensor fault, overboost cut) decide what the
+// solenoid does. A background stage that fails skips the stages after it.
+//
+// Each stage's start and end are logged in microseconds since reset; the
+// serial command "boot" prints them. Hardware independent, so tools/boot runs
+// the sequence against a simulated clock.
+
+enum BootStage {
+    BOOT_OUTPUTS,        // solenoid pin low, serial port
+    BOOT_PARAMETERS,     // EEPROM, active profile, scaled sensor voltages
+    BOOT_SENSORS,        // ADC scan, pulse counters, overboost guard
+    BOOT_CONTROL,        // data mutex and the control task
+    BOOT_DISPLAY,
+    BOOT_TOUCH,          // touch calibration
+    BOOT_RESET_WINDOW,   // factory-reset gesture
+    BOOT_INTERFACE,      // display and input task
+    BOOT_STAGE_COUNT
+};
+
+const int BOOT_CRITICAL_STAGES = BOOT_CONTROL + 1;   // stages run before the background phase
+
+enum BootStageStatus {
+    BOOT_PENDING,
+    BOOT_RUNNING,
+    BOOT_DONE,
+    BOOT_FAILED,
+    BOOT_SKIPPED         // an earlier background stage failed
+};
+
+// What each stage does. The firmware supplies the hardware; host tools
+// supply simulated delays.
+struct BootSteps {
+    void* context;
+    uint32_t (*micros)(void* context);
+    bool (*run[BOOT_STAGE_COUNT])(void* context);   // false = the stage failed
+};
+
+struct BootLog {
+    uint8_t status[BOOT_STAGE_COUNT];   // BootStageStatus
+    uint32_t startUs[BOOT_STAGE_COUNT];
+    uint32_t endUs[BOOT_STAGE_COUNT];
+    uint8_t order[BOOT_STAGE_COUNT];    // stages in the order they ran
+    int ran;
+};
+
+const char* bootStageName(int stage);
+const char* bootStageStatusName(int status);
+
+void bootLogInit(BootLog& log);
+// Runs every critical stage in order, whatever each returns.
+void bootRunCritical(BootLog& log, const BootSteps& steps);
+// Runs the background stages in order; false if one failed, in which case
+// the rest are marked skipped.
+bool bootRunBackground(BootLog& log, const BootSteps& steps);
+// Time a stage took; 0 if it has not finished.
+uint32_t bootStageMicros(const BootLog& log, int stage);
+
+#endif // BOOT_H
@@ -7,24 +7,27 @@
 // CONSTANTS
 //================================================================================
 
-// -- Sensor Signal Processing --
-const float IDLE_PRESSURE_MIN_KPA = 95.0;
-const float IDLE_PRESSURE_MAX_KPA = 105.0;
-const float REACTIVATE_PRESSURE_KPA = 75.0;
+// -- Relay Autotune --
+const float AUTOTUNE_RELAY_HIGH_PERCENT = 100.0;
+const float AUTOTUNE_RELAY_LOW_PERCENT = 0.0;
+const float AUTOTUNE_HYSTERESIS_KPA = 1.0;
+const float AUTOTUNE_OVERSHOOT_LIMIT_KPA = 15.0;
+const float AUTOTUNE_LIFT_DROP_KPA = 30.0;
+const uint32_t AUTOTUNE_TIMEOUT_MS = 8000;
+const int AUTOTUNE_CYCLES = 4;
 
-// -- Sensor Calibration --
-const float R1_OHMS = 9980.0;
-const float R2_OHMS = 15000.0;
+// -- Feed-forward Persistence --
+// The map is written at most this often, and only while off boost, to spare the flash.
+const unsigned long FEEDFORWARD_SAVE_INTERVAL_MS = 600000;
+// A fault latches and holds the failsafe duty, so the log is written soon after
+// one is raised rather than waiting to be off boost; the interval only stops a
+// run of clear-and-retrip from wearing the flash.
+const unsigned long SENSOR_FAULT_SAVE_INTERVAL_MS = 10000;
 
 // -- Touch Input --
 const uint32_t TOUCH_SENSITIVITY_OFFSET = 10000;
 const unsigned long DEBOUNCE_DELAY = 200;
 
-// -- Spool Score Parameters --
-const float ARMING_THRESHOLD_KPA = 105.0;
-const int ARMING_DWELL_SAMPLES = 5;
-const float TERMINATION_DROP_KPA = 4.0;
-
 //================================================================================
 // PARAMETER INFO TEXT
 //================================================================================
@@ -35,6 +38,9 @@ extern const char* INFO_KD;
 extern const char* INFO_MAX_I;
 extern const char* INFO_TRIG_THRESH;
 extern const char* INFO_PRESSURE_LIMIT;
+extern const char* INFO_OVERBOOST_CUT;
+extern const char* INFO_SENSOR_FAULT_CHECK;
+extern const char* INFO_SENSOR_FAILSAFE;
 extern const char* INFO_SOLENOID_FREQ;
 extern const char* INFO_PRESSURE_OFFSET;
 extern const char* INFO_MAP_SENSOR;
@@ -42,11 +48,53 @@ extern const char* INFO_SLOW_EMA;
 extern const char* INFO_FAST_EMA;
 extern const char* INFO_PRATE_THRESH;
 extern const char* INFO_RATE_PERIOD;
+extern const char* INFO_FILTER_TYPE;
+extern const char* INFO_FILTER_CUTOFF;
+extern const char* INFO_TRACKER_ALPHA;
+extern const char* INFO_TRACKER_BETA;
+extern const char* INFO_ESTIMATOR;
+extern const char* INFO_ESTIMATOR_NOISE;
+extern const char* INFO_ESTIMATOR_ACCEL;
 extern const char* INFO_OVERSAMPLING;
+extern const char* INFO_SPIKE_REJECT;
+extern const char* INFO_OVERSAMPLE_ADAPTIVE;
+extern const char* INFO_OVERSAMPLE_MIN;
+extern const char* INFO_ADC_CORRECTION;
 extern const char* INFO_SAVE_DELAY;
 extern const char* INFO_EDIT_DELAY;
 extern const char* INFO_SLEEP_DELAY;
+extern const char* INFO_IDLE_POWER;
 extern const char* INFO_TS_RATE;
+extern const char* INFO_D_FILTER;
+extern const char* INFO_SP_WEIGHT;
+extern const char* INFO_D_ON_MEAS;
+extern const char* INFO_ANTI_WINDUP;
+extern const char* INFO_BUMPLESS;
+extern const char* INFO_FEEDFORWARD;
+extern const char* INFO_GAIN_SCHEDULE;
+extern const char* INFO_TARGET_RAMP;
+extern const char* INFO_SPOOL_CURVE;
+extern const char* INFO_RPM_INPUT;
+extern const char* INFO_PULSES_PER_REV;
+extern const char* INFO_SPEED_PULSES;
+extern const char* INFO_GEAR_COUNT;
+extern const char* INFO_RPM_MAP;
+extern const char* INFO_OS_LIMITER;
+extern const char* INFO_OS_LEAD;
+extern const char* INFO_OS_SPAN;
+extern const char* INFO_OS_FLOOR;
+extern const char* INFO_ADAPT_GAINS;
+extern const char* INFO_EMAP_SENSOR;
+extern const char* INFO_IAT_SENSOR;
+extern const char* INFO_MAP_TABLE;
+extern const char* INFO_SUPPLY_SENSE;
+extern const char* INFO_SUPPLY_COMP;
+extern const char* INFO_SUPPLY_NOMINAL;
+extern const char* INFO_IAT_TRIM_START;
+extern const char* INFO_IAT_TRIM;
+extern const char* INFO_SOLENOID_CURVE;
+extern const char* INFO_SOLENOID_DEAD_TIME;
+extern const char* INFO_NOMINAL_GAIN;
 
 //================================================================================
 // MENU DEFINITIONS
@@ -61,5 +109,8 @@ extern const int mapMenuCount;
 extern const MenuItem filterMenuItems[];
 extern const int filterMenuCount;
 
+extern const SerialParam serialParams[];
+extern const int serialParamCount;
+
 
 #endif // CONFIG_H
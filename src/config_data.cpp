@@ -10,6 +10,9 @@ const char* INFO_KI = "I-Gain: Corrects steady error over time. Fights boost dro
 const char* INFO_KD = "D-Gain: Dampens overshoot by reacting to the rate of change.";
 const char* INFO_MAX_I = "Max I-Term: Prevents integral 'windup' causing large overshoots.";
 const char* INFO_TRIG_THRESH = "PID Trigger (kPa): How close to target for PID loop to activate.";
+const char* INFO_OVERBOOST_CUT = "Overboost Cut (kPa): Guard opens the wastegate and latches above target + value, even if the PID stalls. 0 = off.";
+const char* INFO_SENSOR_FAULT_CHECK = "MAP Fault Check: 1 = watch the MAP sensor for open, short, stuck, jumps or noise and latch the failsafe duty until CLR.";
+const char* INFO_SENSOR_FAILSAFE = "Failsafe Duty (%): Solenoid duty held while a MAP sensor fault is latched. 0 = wastegate open.";
 const char* INFO_PRESSURE_LIMIT = "Limiter (kPa): Forces wastegate open if pressure > target + value.";
 const char* INFO_SOLENOID_FREQ = "Solenoid Freq (Hz): Match to your specific solenoid's spec sheet.";
 const char* INFO_PRESSURE_OFFSET = "Offset (kPa): Manual correction to match final reading to a known gauge.";
@@ -18,12 +21,54 @@ const char* INFO_SLOW_EMA = "Slow EMA: Heavy smoothing for stable boost (0-1). L
 const char* INFO_FAST_EMA = "Fast EMA: Light smoothing for rapid boost change (0-1). High val=less smooth.";
 const char* INFO_PRATE_THRESH = "P-Rate Thresh (kPa): Change needed to switch from slow to fast EMA.";
 const char* INFO_RATE_PERIOD = "Rate Period (ms): Time window for calculating pressure rate of change.";
-const char* INFO_OVERSAMPLING = "Oversampling: ADC reads to avg for 1 measurement. Reduces noise at cost of CPU time.";
+const char* INFO_FILTER_TYPE = "Filter Type: 0 = adaptive EMA, 1 = spike reject + EMA, 2 = spike reject + low-pass, 3 = spike reject + tracker.";
+const char* INFO_FILTER_CUTOFF = "LP Cutoff (Hz): Corner of the low-pass (type 2). Lower = smoother but more lag.";
+const char* INFO_TRACKER_ALPHA = "Track Alpha: Tracker position gain (type 3, 0-1). High val=less smooth.";
+const char* INFO_TRACKER_BETA = "Track Beta: Tracker rate gain (type 3). About alpha^2/(2-alpha) is critically damped.";
+const char* INFO_ESTIMATOR = "Estimator: 1 = D term, EMA switch and spool score use the Kalman pressure rate. 0 = differenced.";
+const char* INFO_ESTIMATOR_NOISE = "Meas. Noise (kPa): Sensor noise the estimator assumes. Higher = smoother rate, more lag.";
+const char* INFO_ESTIMATOR_ACCEL = "Accel Noise (kPa/s^2): How fast boost can change slope. Higher = quicker, noisier rate.";
+const char* INFO_OVERSAMPLING = "Oversampling: Latest ADC conversions averaged per reading (max 512). More = less noise, slower.";
+const char* INFO_SPIKE_REJECT = "Spike Reject: Conversions in the spike filter ahead of averaging (odd, 3-15). 0 = off.";
+const char* INFO_OVERSAMPLE_ADAPTIVE = "Adaptive Oversmp: 1 = short window while boost moves, Oversampling when steady. 0 = fixed.";
+const char* INFO_OVERSAMPLE_MIN = "Min Oversample: Shortest window adaptive oversampling may use, in conversions.";
+const char* INFO_ADC_CORRECTION = "ADC Correct. (0/1): Convert readings through the chip's factory ADC calibration. Re-trim V Offset and Pressure Offset after changing.";
 const char* INFO_SAVE_DELAY = "Save/Reset Hold (ms): Time to hold SAVE or RESET button to activate.";
 const char* INFO_EDIT_DELAY = "Edit/CFG Hold (ms): Time to hold EDIT or CFG button to enter menu.";
 const char* INFO_SLEEP_DELAY = "Sleep Delay (s): Idle time at atmos before screen/solenoid turns off.";
+const char* INFO_IDLE_POWER = "Idle Power: Once asleep, 1 = slow CPU and sampling, 2 = also light sleep (no USB serial). 0 = off.";
 const char* INFO_TS_RATE = "TS Rate (ms): Sample rate for Torque Score calculation.";
 const char* INFO_TS_CUTOFF = "TS Cutoff (ms): Time after hitting target to stop integrating torque score.";
+const char* INFO_ADAPT_GAINS = "Adapt Gains (0/1): Rescale PID by the identified plant gain vs Nominal K.";
+const char* INFO_D_FILTER = "D Filter (ms): Low-pass on the D term to keep sensor noise out. 0 = off.";
+const char* INFO_SP_WEIGHT = "SP Weight (0-1): Share of target changes the P term sees. Lower = softer steps.";
+const char* INFO_D_ON_MEAS = "D on Meas. (0/1): D term follows pressure only, so target changes don't kick it.";
+const char* INFO_ANTI_WINDUP = "Anti-Windup: 0 = clamp at Max I, 1 = back-calculation, 2 = stop I while saturated.";
+const char* INFO_BUMPLESS = "Bumpless (0/1): Pre-load I term while spooling so PID takes over without a step.";
+const char* INFO_FEEDFORWARD = "Feed-Fwd (0/1): Start PID at the learned holding duty for the target. Learns either way.";
+const char* INFO_GAIN_SCHEDULE = "Gain Sched. (0/1): Scale Kp/Ki/Kd by the table for pressure error and rate. Edit over serial (gs).";
+const char* INFO_TARGET_RAMP = "Target Ramp (kPa/s): Max rate the PID target follows edits and profile changes. 0 = step.";
+const char* INFO_SPOOL_CURVE = "Spool Curve (0/1): Offset the target by time since spool-up, e.g. less boost early for traction. Edit over serial (sp).";
+const char* INFO_RPM_INPUT = "RPM Input (0/1): Count tach pulses on the RPM pin and infer the gear. Needed for RPM Map.";
+const char* INFO_PULSES_PER_REV = "Pulses/Rev: Tach pulses per crank turn. 4-cyl wasted spark = 2, 6-cyl = 3.";
+const char* INFO_SPEED_PULSES = "Speed P/km: Speed sensor pulses per km. 0 = no sensor, gear from RPM drops on upshifts.";
+const char* INFO_GEAR_COUNT = "Gears: Number of forward gears, for gear detection.";
+const char* INFO_RPM_MAP = "RPM Map (0/1): Offset the target by RPM and gear from the boost map. Edit over serial (bm).";
+const char* INFO_OS_LIMITER = "OS Limiter (0/1): Cut duty early when pressure is forecast to pass the target.";
+const char* INFO_OS_LEAD = "OS Lead (ms): How far ahead to forecast. About solenoid-to-boost response time.";
+const char* INFO_OS_SPAN = "OS Span (kPa): Forecast excess at which duty is cut to the floor. Lower = harder.";
+const char* INFO_OS_FLOOR = "OS Floor (%): Lowest duty ceiling the overshoot limiter will impose.";
+const char* INFO_EMAP_SENSOR = "Backpressure sensor: output volts and kPa at each end of its range, as for the MAP sensor.";
+const char* INFO_IAT_SENSOR = "IAT sensor: output volts and deg C at each end of its range. Nonlinear sensors need a table ('cal iat start').";
+const char* INFO_MAP_TABLE = "MAP Table (0/1): Read the MAP sensor through its multi-point table instead of Min/Max. Record with 'cal map start'.";
+const char* INFO_SUPPLY_SENSE = "Supply sense: input volts and reading at each end. Trim Max V to match a multimeter.";
+const char* INFO_SUPPLY_COMP = "Supply Comp. (0/1): Scale solenoid duty by Nominal V / measured supply so it drives the same as voltage moves.";
+const char* INFO_SUPPLY_NOMINAL = "Nominal V: Supply voltage your duty was tuned at, usually 13.5-14.4 V with the engine running.";
+const char* INFO_IAT_TRIM_START = "IAT Trim Start (C): Intake air temperature above which the target is reduced.";
+const char* INFO_IAT_TRIM = "IAT Trim (kPa/C): Target reduction per degree above the start, up to 50 kPa. 0 = off.";
+const char* INFO_SOLENOID_CURVE = "Sol. Linear (0/1): Drive the solenoid through its measured flow curve so duty acts evenly. Measure with 'sol cal'.";
+const char* INFO_SOLENOID_DEAD_TIME = "Sol. Dead Time (ms): Pull-in delay before the valve moves air. Added to every on-time.";
+const char* INFO_NOMINAL_GAIN = "Nominal K (kPa/%): Plant gain your PID was tuned at. See 'telemetry on'.";
 
 //================================================================================
 // MENU DEFINITIONS
@@ -36,7 +81,32 @@ const MenuItem pidMenuItems[] = {
     {"Max I term", &maxIntegral, P_FLOAT, 0, "", INFO_MAX_I},
     {"Trig. Thres.", &pidTriggerkPa, P_FLOAT, 1, "kPa", INFO_TRIG_THRESH}, 
     {"Press. Limiter", &PID_Control_Overhead, P_FLOAT, 1, "kPa", INFO_PRESSURE_LIMIT},
-    {"Solenoid Freq.", &valveFrequencyHz, P_INT, 0, "Hz", INFO_SOLENOID_FREQ}
+    {"Overboost Cut", &overboostMarginkPa, P_FLOAT, 0, "kPa", INFO_OVERBOOST_CUT},
+    {"MAP Fault Chk", &sensorFaultCheck, P_INT, 0, "", INFO_SENSOR_FAULT_CHECK},
+    {"Failsafe Duty", &sensorFailsafePercent, P_FLOAT, 0, "%", INFO_SENSOR_FAILSAFE},
+    {"Solenoid Freq.", &valveFrequencyHz, P_INT, 0, "Hz", INFO_SOLENOID_FREQ},
+    {"Sol. Linear", &solenoidCurve.enabled, P_INT, 0, "", INFO_SOLENOID_CURVE},
+    {"Sol. Dead Time", &solenoidCurve.deadTimeMs, P_FLOAT, 1, "ms", INFO_SOLENOID_DEAD_TIME},
+    {"D Filter", &pidDerivativeFilterMs, P_FLOAT, 0, "ms", INFO_D_FILTER},
+    {"SP Weight", &pidSetpointWeight, P_FLOAT, 2, "", INFO_SP_WEIGHT},
+    {"D on Meas.", &pidDerivativeOnMeasurement, P_INT, 0, "", INFO_D_ON_MEAS},
+    {"Anti-Windup", &pidAntiWindupMode, P_INT, 0, "", INFO_ANTI_WINDUP},
+    {"Bumpless", &pidBumplessTransfer, P_INT, 0, "", INFO_BUMPLESS},
+    {"Feed-Fwd", &feedForwardEnabled, P_INT, 0, "", INFO_FEEDFORWARD},
+    {"Gain Sched.", &gainSchedule.enabled, P_INT, 0, "", INFO_GAIN_SCHEDULE},
+    {"Target Ramp", &setpointProfile.rampkPaPerS, P_FLOAT, 0, "kPa/s", INFO_TARGET_RAMP},
+    {"Spool Curve", &setpointProfile.enabled, P_INT, 0, "", INFO_SPOOL_CURVE},
+    {"RPM Input", &rpmInputEnabled, P_INT, 0, "", INFO_RPM_INPUT},
+    {"Pulses/Rev", &rpmPulsesPerRev, P_FLOAT, 1, "", INFO_PULSES_PER_REV},
+    {"Speed P/km", &speedPulsesPerKm, P_FLOAT, 0, "", INFO_SPEED_PULSES},
+    {"Gears", &gearCount, P_INT, 0, "", INFO_GEAR_COUNT},
+    {"RPM Map", &boostMap.enabled, P_INT, 0, "", INFO_RPM_MAP},
+    {"OS Limiter", &overshootLimiter, P_INT, 0, "", INFO_OS_LIMITER},
+    {"OS Lead", &overshootLeadMs, P_FLOAT, 0, "ms", INFO_OS_LEAD},
+    {"OS Span", &overshootSpankPa, P_FLOAT, 1, "kPa", INFO_OS_SPAN},
+    {"OS Floor", &overshootFloorPercent, P_FLOAT, 0, "%", INFO_OS_FLOOR},
+    {"Adapt Gains", &adaptiveGainsEnabled, P_INT, 0, "", INFO_ADAPT_GAINS},
+    {"Nominal K", &nominalPlantGain, P_FLOAT, 2, "kPa/%", INFO_NOMINAL_GAIN}
 };
 const int pidMenuCount = sizeof(pidMenuItems) / sizeof(MenuItem);
 
@@ -46,7 +116,24 @@ const MenuItem mapMenuItems[] = {
     {"Max kPa", &MAX_KPA, P_FLOAT, 1, "kPa", INFO_MAP_SENSOR},
     {"V Offset", &RAW_VOLTAGE_OFFSET, P_FLOAT, 4, "V", INFO_MAP_SENSOR},
     {"Min Volts", &RAW_MIN_SENSOR_VOLTAGE, P_FLOAT, 2, "V", INFO_MAP_SENSOR},
-    {"Max Volts", &RAW_MAX_SENSOR_VOLTAGE, P_FLOAT, 2, "V", INFO_MAP_SENSOR}
+    {"Max Volts", &RAW_MAX_SENSOR_VOLTAGE, P_FLOAT, 2, "V", INFO_MAP_SENSOR},
+    {"MAP Table", &calibrationTables[SENSOR_MAP].enabled, P_INT, 0, "", INFO_MAP_TABLE},
+    {"EMAP Min kPa", &backpressureCalibration.minValue, P_FLOAT, 1, "kPa", INFO_EMAP_SENSOR},
+    {"EMAP Max kPa", &backpressureCalibration.maxValue, P_FLOAT, 1, "kPa", INFO_EMAP_SENSOR},
+    {"EMAP Min Volts", &backpressureCalibration.rawMinVoltage, P_FLOAT, 2, "V", INFO_EMAP_SENSOR},
+    {"EMAP Max Volts", &backpressureCalibration.rawMaxVoltage, P_FLOAT, 2, "V", INFO_EMAP_SENSOR},
+    {"IAT Min Temp", &intakeTempCalibration.minValue, P_FLOAT, 0, "C", INFO_IAT_SENSOR},
+    {"IAT Max Temp", &intakeTempCalibration.maxValue, P_FLOAT, 0, "C", INFO_IAT_SENSOR},
+    {"IAT Min Volts", &intakeTempCalibration.rawMinVoltage, P_FLOAT, 2, "V", INFO_IAT_SENSOR},
+    {"IAT Max Volts", &intakeTempCalibration.rawMaxVoltage, P_FLOAT, 2, "V", INFO_IAT_SENSOR},
+    {"Supply Min V", &supplyCalibration.minValue, P_FLOAT, 2, "V", INFO_SUPPLY_SENSE},
+    {"Supply Max V", &supplyCalibration.maxValue, P_FLOAT, 2, "V", INFO_SUPPLY_SENSE},
+    {"Supply Min In", &supplyCalibration.rawMinVoltage, P_FLOAT, 2, "V", INFO_SUPPLY_SENSE},
+    {"Supply Max In", &supplyCalibration.rawMaxVoltage, P_FLOAT, 2, "V", INFO_SUPPLY_SENSE},
+    {"Supply Comp.", &supplyCompensation, P_INT, 0, "", INFO_SUPPLY_COMP},
+    {"Nominal V", &supplyNominalVoltage, P_FLOAT, 1, "V", INFO_SUPPLY_NOMINAL},
+    {"IAT Trim Start", &iatTrimStartC, P_FLOAT, 0, "C", INFO_IAT_TRIM_START},
+    {"IAT Trim", &iatTrimkPaPerC, P_FLOAT, 2, "kPa/C", INFO_IAT_TRIM}
 };
 const int mapMenuCount = sizeof(mapMenuItems) / sizeof(MenuItem);
 
@@ -55,11 +142,115 @@ const MenuItem filterMenuItems[] = {
     {"Fast EMA-A", &fast_ema_a, P_FLOAT, 2, "", INFO_FAST_EMA},
     {"P-Rate Thres.", &kpa_rate_change_threshold, P_FLOAT, 1, "kPa", INFO_PRATE_THRESH},
     {"Rate period", &kpa_rate_time_interval_ms, P_INT, 0, "ms", INFO_RATE_PERIOD},
+    {"Filter Type", &filterSettings.type, P_INT, 0, "", INFO_FILTER_TYPE},
+    {"LP Cutoff", &filterSettings.cutoffHz, P_FLOAT, 1, "Hz", INFO_FILTER_CUTOFF},
+    {"Track Alpha", &filterSettings.trackerAlpha, P_FLOAT, 2, "", INFO_TRACKER_ALPHA},
+    {"Track Beta", &filterSettings.trackerBeta, P_FLOAT, 3, "", INFO_TRACKER_BETA},
+    {"Estimator", &estimatorSettings.enabled, P_INT, 0, "", INFO_ESTIMATOR},
+    {"Meas. Noise", &estimatorSettings.measurementNoisekPa, P_FLOAT, 2, "kPa", INFO_ESTIMATOR_NOISE},
+    {"Accel Noise", &estimatorSettings.accelNoise, P_FLOAT, 0, "", INFO_ESTIMATOR_ACCEL},
     {"Oversampling", &OVERSAMPLE_COUNT, P_INT, 0, "", INFO_OVERSAMPLING},
+    {"Spike Reject", &spikeRejectWindow, P_INT, 0, "", INFO_SPIKE_REJECT},
+    {"Adaptive Oversmp", &oversampleAdaptive, P_INT, 0, "", INFO_OVERSAMPLE_ADAPTIVE},
+    {"Min Oversample", &oversampleMinCount, P_INT, 0, "", INFO_OVERSAMPLE_MIN},
+    {"ADC Correct.", &adcCorrectionEnabled, P_INT, 0, "", INFO_ADC_CORRECTION},
     {"Save/Reset Delay", &SAVE_RESET_HOLD_TIME_MS, P_ULONG, 0, "ms", INFO_SAVE_DELAY},
     {"Edit/CFG Delay", &EDIT_HOLD_TIME_MS, P_ULONG, 0, "ms", INFO_EDIT_DELAY},
     {"Sleep Delay", &IDLE_TIMEOUT_SECONDS, P_FLOAT, 0, "s", INFO_SLEEP_DELAY},
+    {"Idle Power", &idlePowerMode, P_INT, 0, "", INFO_IDLE_POWER},
     {"TS Rate", &tsSampleRate, P_INT, 0, "ms", INFO_TS_RATE},
     {"TS Cutoff", &torqueScoreCutoffMs, P_INT, 0, "ms", INFO_TS_CUTOFF}
 };
-const int filterMenuCount = sizeof(filterMenuItems) / sizeof(MenuItem);
\ No newline at end of file
+const int filterMenuCount = sizeof(filterMenuItems) / sizeof(MenuItem);
+
+//================================================================================
+// SERIAL PARAMETER TABLE
+//================================================================================
+// Keys match the host tools' preset files (tools/common/tool_params.cpp).
+
+const SerialParam serialParams[] = {
+    {"targetkPa", &targetkPa, P_FLOAT},
+    {"kp", &kp, P_FLOAT},
+    {"ki", &ki, P_FLOAT},
+    {"kd", &kd, P_FLOAT},
+    {"maxIntegral", &maxIntegral, P_FLOAT},
+    {"PID_Control_Overhead", &PID_Control_Overhead, P_FLOAT},
+    {"pidTriggerkPa", &pidTriggerkPa, P_FLOAT},
+    {"valveFrequencyHz", &valveFrequencyHz, P_INT},
+    {"slow_ema_a", &slow_ema_a, P_FLOAT},
+    {"fast_ema_a", &fast_ema_a, P_FLOAT},
+    {"kpa_rate_change_threshold", &kpa_rate_change_threshold, P_FLOAT},
+    {"kpa_rate_time_interval_ms", &kpa_rate_time_interval_ms, P_INT},
+    {"filterType", &filterSettings.type, P_INT},
+    {"filterCutoffHz", &filterSettings.cutoffHz, P_FLOAT},
+    {"filterTrackerAlpha", &filterSettings.trackerAlpha, P_FLOAT},
+    {"filterTrackerBeta", &filterSettings.trackerBeta, P_FLOAT},
+    {"estimatorEnabled", &estimatorSettings.enabled, P_INT},
+    {"estimatorNoisekPa", &estimatorSettings.measurementNoisekPa, P_FLOAT},
+    {"estimatorAccelNoise", &estimatorSettings.accelNoise, P_FLOAT},
+    {"output_ema_a", &output_ema_a, P_FLOAT},
+    {"OVERSAMPLE_COUNT", &OVERSAMPLE_COUNT, P_INT},
+    {"spikeRejectWindow", &spikeRejectWindow, P_INT},
+    {"oversampleAdaptive", &oversampleAdaptive, P_INT},
+    {"oversampleMinCount", &oversampleMinCount, P_INT},
+    {"adcCorrection", &adcCorrectionEnabled, P_INT},
+    {"IDLE_TIMEOUT_SECONDS", &IDLE_TIMEOUT_SECONDS, P_FLOAT},
+    {"idlePowerMode", &idlePowerMode, P_INT},
+    {"RAW_MIN_SENSOR_VOLTAGE", &RAW_MIN_SENSOR_VOLTAGE, P_FLOAT},
+    {"RAW_MAX_SENSOR_VOLTAGE", &RAW_MAX_SENSOR_VOLTAGE, P_FLOAT},
+    {"RAW_VOLTAGE_OFFSET", &RAW_VOLTAGE_OFFSET, P_FLOAT},
+    {"MIN_KPA", &MIN_KPA, P_FLOAT},
+    {"MAX_KPA", &MAX_KPA, P_FLOAT},
+    {"PRESSURE_CORRECTION_KPA", &PRESSURE_CORRECTION_KPA, P_FLOAT},
+    {"torqueScoreCutoffMs", &torqueScoreCutoffMs, P_INT},
+    {"adaptiveGains", &adaptiveGainsEnabled, P_INT},
+    {"nominalPlantGain", &nominalPlantGain, P_FLOAT},
+    {"pidDerivativeFilterMs", &pidDerivativeFilterMs, P_FLOAT},
+    {"pidSetpointWeight", &pidSetpointWeight, P_FLOAT},
+    {"pidDerivativeOnMeasurement", &pidDerivativeOnMeasurement, P_INT},
+    {"pidAntiWindupMode", &pidAntiWindupMode, P_INT},
+    {"pidBumplessTransfer", &pidBumplessTransfer, P_INT},
+    {"feedForwardEnabled", &feedForwardEnabled, P_INT},
+    {"gainScheduleEnabled", &gainSchedule.enabled, P_INT},
+    {"setpointProfileEnabled", &setpointProfile.enabled, P_INT},
+    {"setpointRampkPaPerS", &setpointProfile.rampkPaPerS, P_FLOAT},
+    {"rpmInputEnabled", &rpmInputEnabled, P_INT},
+    {"rpmPulsesPerRev", &rpmPulsesPerRev, P_FLOAT},
+    {"speedPulsesPerKm", &speedPulsesPerKm, P_FLOAT},
+    {"gearCount", &gearCount, P_INT},
+    {"boostMapEnabled", &boostMap.enabled, P_INT},
+    {"overshootLimiter", &overshootLimiter, P_INT},
+    {"overshootLeadMs", &overshootLeadMs, P_FLOAT},
+    {"overshootSpankPa", &overshootSpankPa, P_FLOAT},
+    {"overshootFloorPercent", &overshootFloorPercent, P_FLOAT},
+    {"emapRawMinVoltage", &backpressureCalibration.rawMinVoltage, P_FLOAT},
+    {"emapRawMaxVoltage", &backpressureCalibration.rawMaxVoltage, P_FLOAT},
+    {"emapMinkPa", &backpressureCalibration.minValue, P_FLOAT},
+    {"emapMaxkPa", &backpressureCalibration.maxValue, P_FLOAT},
+    {"iatRawMinVoltage", &intakeTempCalibration.rawMinVoltage, P_FLOAT},
+    {"iatRawMaxVoltage", &intakeTempCalibration.rawMaxVoltage, P_FLOAT},
+    {"iatMinC", &intakeTempCalibration.minValue, P_FLOAT},
+    {"iatMaxC", &intakeTempCalibration.maxValue, P_FLOAT},
+    {"supplyRawMinVoltage", &supplyCalibration.rawMinVoltage, P_FLOAT},
+    {"supplyRawMaxVoltage", &supplyCalibration.rawMaxVoltage, P_FLOAT},
+    {"supplyMinV", &supplyCalibration.minValue, P_FLOAT},
+    {"supplyMaxV", &supplyCalibration.maxValue, P_FLOAT},
+    {"calMapEnabled", &calibrationTables[SENSOR_MAP].enabled, P_INT},
+    {"calMapInterp", &calibrationTables[SENSOR_MAP].interpolation, P_INT},
+    {"calEmapEnabled", &calibrationTables[SENSOR_BACKPRESSURE].enabled, P_INT},
+    {"calEmapInterp", &calibrationTables[SENSOR_BACKPRESSURE].interpolation, P_INT},
+    {"calIatEnabled", &calibrationTables[SENSOR_IAT].enabled, P_INT},
+    {"calIatInterp", &calibrationTables[SENSOR_IAT].interpolation, P_INT},
+    {"calSupplyEnabled", &calibrationTables[SENSOR_SUPPLY].enabled, P_INT},
+    {"calSupplyInterp", &calibrationTables[SENSOR_SUPPLY].interpolation, P_INT},
+    {"supplyCompensation", &supplyCompensation, P_INT},
+    {"supplyNominalVoltage", &supplyNominalVoltage, P_FLOAT},
+    {"iatTrimStartC", &iatTrimStartC, P_FLOAT},
+    {"iatTrimkPaPerC", &iatTrimkPaPerC, P_FLOAT},
+    {"solenoidCurveEnabled", &solenoidCurve.enabled, P_INT},
+    {"solenoidDeadTimeMs", &solenoidCurve.deadTimeMs, P_FLOAT},
+    {"overboostMarginkPa", &overboostMarginkPa, P_FLOAT},
+    {"sensorFaultCheck", &sensorFaultCheck, P_INT},
+    {"sensorFailsafePercent", &sensorFailsafePercent, P_FLOAT}
+};
+const int serialParamCount = sizeof(serialParams) / sizeof(SerialParam);
\ No newline at end of file
@@ -0,0 +1,601 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "control.h"
+#include <math.h>
+
+//================================================================================
+// SENSOR SCALING
+//================================================================================
+float fmap(float x, float in_min, float in_max, float out_min, float out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void scaleSensorVoltages(float rawMin, float rawMax, float rawOffset, float& minV, float& maxV, float& offsetV) {
+    float dividerRatio = R2_OHMS / (R1_OHMS + R2_OHMS);
+    minV = rawMin * dividerRatio;
+    maxV = rawMax * dividerRatio;
+    offsetV = rawOffset * dividerRatio;
+}
+
+LinearMap pressureMapFor(const ControlParams& params) {
+    LinearMap map = linearMapThrough(params.minSensorVoltage, params.maxSensorVoltage, params.MIN_KPA, params.MAX_KPA);
+    map.offset += params.PRESSURE_CORRECTION_KPA;
+    return map;
+}
+
+float voltageToPressure(const ControlParams& params, float sensorVoltage) {
+    if (params.calibration[SENSOR_MAP].enabled) {
+        CalibrationCurve curve;
+        calibrationCurveInit(curve);
+        calibrationCurveUpdate(curve, params.calibration[SENSOR_MAP], sensorDividerRatio(SENSOR_MAP));
+        if (curve.usable) return calibrationCurveValue(curve, sensorVoltage) + params.PRESSURE_CORRECTION_KPA;
+    }
+    return linearMapApply(pressureMapFor(params), sensorVoltage);
+}
+
+float sensorDividerRatio(int channel) {
+    if (channel == SENSOR_SUPPLY) return SUPPLY_R2_OHMS / (SUPPLY_R1_OHMS + SUPPLY_R2_OHMS);
+    return R2_OHMS / (R1_OHMS + R2_OHMS);
+}
+
+float sensorOutputVoltage(const ControlParams& params, int channel, float pinVoltage) {
+    if (channel == SENSOR_MAP) pinVoltage -= params.scaledVoltageOffset;
+    return pinVoltage / sensorDividerRatio(channel);
+}
+
+// Rebuilds any calibration table that changed and refreshes the MAP line. With
+// a table in use the line is its chord, which the thresholds the pipeline sets
+// in kPa but applies in volts are converted through.
+static void updateCalibration(ControlState& state, const ControlParams& params) {
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        calibrationCurveUpdate(state.calibration[c], params.calibration[c], sensorDividerRatio(c));
+    }
+    state.pressureMap = pressureMapFor(params);
+    if (state.calibration[SENSOR_MAP].usable) {
+        calibrationCurveChord(state.calibration[SENSOR_MAP], state.pressureMap.slope, state.pressureMap.offset);
+        state.pressureMap.offset += params.PRESSURE_CORRECTION_KPA;
+    }
+}
+
+// Sensor volts (offset taken off) to kPa, through the table when one is in use.
+static float mapPressure(const ControlState& state, const ControlParams& params, float sensorVoltage) {
+    if (state.calibration[SENSOR_MAP].usable) {
+        return calibrationCurveValue(state.calibration[SENSOR_MAP], sensorVoltage) + params.PRESSURE_CORRECTION_KPA;
+    }
+    return linearMapApply(state.pressureMap, sensorVoltage);
+}
+
+// An auxiliary channel's reading, through its table when one is in use.
+static float auxSensorValue(const ControlState& state, const SensorCalibration& line, int channel, float pinVoltage) {
+    if (state.calibration[channel].usable) return calibrationCurveValue(state.calibration[channel], pinVoltage);
+    return sensorValue(line, sensorDividerRatio(channel), pinVoltage);
+}
+
+// Refreshes the pipeline's tunables and returns the type to run; the biquad is
+// only redesigned when its corner changes. Settings out of range (a menu edit
+// part way through) run the defaults rather than an unstable tracker.
+static int updateFilterConfig(ControlState& state, const ControlParams& params) {
+    FilterSettings settings = params.filter;
+    filterSettingsSanitize(settings);
+    FilterConfig<FilterScalar>& cfg = state.filterConfig;
+    cfg.slowAlpha = FilterScalar(params.slow_ema_a);
+    cfg.fastAlpha = FilterScalar(params.fast_ema_a);
+    // The rate threshold is set in kPa; the pipeline runs in volts.
+    float kPaPerVolt = state.pressureMap.slope;
+    cfg.changeThreshold = FilterScalar(params.kpa_rate_change_threshold / kPaPerVolt);
+    cfg.lookback = params.kpa_rate_time_interval_ms / CONTROL_TASK_DELAY_MS;
+    // With the estimator on, the switch sees its rate over the span the
+    // lookback difference would cover.
+    cfg.externalChange = params.estimator.enabled != 0;
+    if (cfg.externalChange) {
+        int lookback = cfg.lookback < 1 ? 1 : (cfg.lookback > FILTER_LOOKBACK_MAX ? FILTER_LOOKBACK_MAX : cfg.lookback);
+        int span = lookback > 1 ? lookback - 1 : 1;
+        cfg.change = FilterScalar(state.estimator.rate * (span * CONTROL_TASK_DELAY_MS * SECONDS_PER_MS) / kPaPerVolt);
+    }
+    cfg.trackerAlpha = FilterScalar(settings.trackerAlpha);
+    cfg.trackerBeta = FilterScalar(settings.trackerBeta);
+    cfg.dtSeconds = FilterScalar(CONTROL_TASK_DELAY_MS * SECONDS_PER_MS);
+    if (settings.cutoffHz != state.filterCutoffHz) {
+        filterDesignLowPass(cfg, settings.cutoffHz, 1000.0f / CONTROL_TASK_DELAY_MS);
+        state.filterCutoffHz = settings.cutoffHz;
+    }
+    return settings.type;
+}
+
+// The adaptive scale reaches Ki through the integration rate, as the gain
+// schedule's Ki multiplier does, so a scale change never steps the I term.
+static void fillPidConfig(const ControlParams& params, float gainScale, PidConfig<float>& cfg) {
+    cfg.kp = gainScale * params.kp;
+    cfg.ki = params.ki;
+    cfg.kd = gainScale * params.kd;
+    cfg.outMin = 0.0f;
+    cfg.outMax = 255.0f;
+    cfg.integralLimit = params.maxIntegral;
+    cfg.setpointWeightP = params.setpointWeightP;
+    cfg.setpointWeightD = params.derivativeOnMeasurement ? 0.0f : 1.0f;
+    cfg.derivativeFilterS = params.derivativeFilterMs * SECONDS_PER_MS;
+    cfg.trackingTimeS = 0.0f;
+    cfg.integralRate = gainScale;
+    cfg.antiWindup = (params.antiWindupMode >= 0 && params.antiWindupMode < PID_ANTIWINDUP_COUNT)
+                         ? (PidAntiWindup)params.antiWindupMode : PID_ANTIWINDUP_CLAMP;
+}
+
+// Calibrates the auxiliary channels and low-passes them; IAT and supply change
+// slowly and only steer the target and the duty correction.
+static void updateAuxSensors(ControlState& state, const ControlParams& params, const SensorSample& sample, float dtMs) {
+    if (sample.samples[SENSOR_BACKPRESSURE] == 0 || sample.samples[SENSOR_IAT] == 0 || sample.samples[SENSOR_SUPPLY] == 0) return;
+    AuxSensorState& aux = state.aux;
+    float backpressure = auxSensorValue(state, params.backpressure, SENSOR_BACKPRESSURE, sample.voltage[SENSOR_BACKPRESSURE]);
+    float intakeTemp = auxSensorValue(state, params.intakeTemp, SENSOR_IAT, sample.voltage[SENSOR_IAT]);
+    float supply = auxSensorValue(state, params.supply, SENSOR_SUPPLY, sample.voltage[SENSOR_SUPPLY]);
+    if (!aux.primed) {
+        aux.backpressurekPa = backpressure;
+        aux.intakeTempC = intakeTemp;
+        aux.supplyVoltage = supply;
+        aux.primed = true;
+        return;
+    }
+    float alpha = dtMs / (AUX_SENSOR_FILTER_MS + dtMs);
+    aux.backpressurekPa += alpha * (backpressure - aux.backpressurekPa);
+    aux.intakeTempC += alpha * (intakeTemp - aux.intakeTempC);
+    aux.supplyVoltage += alpha * (supply - aux.supplyVoltage);
+}
+
+//================================================================================
+// OUTPUT STAGE
+//================================================================================
+// A sagging supply slows the pull-in, so it stretches the dead time rather
+// than scaling the whole duty.
+static float solenoidDeadBand(const ControlState& state, const ControlParams& params, bool supplyKnown) {
+    float deadTimeMs = params.solenoidCurve.deadTimeMs;
+    if (supplyKnown) deadTimeMs *= supplyCompensationFactor(state.aux.supplyVoltage, params.supplyNominalVoltage);
+    return solenoidDeadBandPercent(deadTimeMs, params.valveFrequencyHz);
+}
+
+float controlSolenoidPercent(const ControlState& state, const ControlParams& params, float controlPercent) {
+    bool supplyKnown = params.supplyCompensation && state.aux.primed;
+    if (params.solenoidCurve.enabled) {
+        return solenoidLinearize(state.solenoid, controlPercent, solenoidDeadBand(state, params, supplyKnown));
+    }
+    if (supplyKnown) return supplyCompensatedDuty(controlPercent, state.aux.supplyVoltage, params.supplyNominalVoltage);
+    return controlPercent;
+}
+
+float controlPercentForSolenoid(const ControlState& state, const ControlParams& params, float solenoidPercent) {
+    bool supplyKnown = params.supplyCompensation && state.aux.primed;
+    if (params.solenoidCurve.enabled) {
+        return solenoidFlow(params.solenoidCurve, solenoidPercent, solenoidDeadBand(state, params, supplyKnown));
+    }
+    if (supplyKnown && solenoidPercent < SUPPLY_COMP_FULL_PERCENT) {
+        return solenoidPercent / supplyCompensationFactor(state.aux.supplyVoltage, params.supplyNominalVoltage);
+    }
+    return solenoidPercent;
+}
+
+//================================================================================
+// OVERBOOST CEILING
+//================================================================================
+static void fillOverboostLimit(const ControlState& state, const ControlParams& params, float targetkPa, OverboostLimit& limit) {
+    // The pressure map is a straight line in the pin voltage once the offset is taken off.
+    limit.kPaAtZeroVolts = linearMapApply(state.pressureMap, -params.scaledVoltageOffset);
+    limit.kPaPerVolt = state.pressureMap.slope;
+    if (params.overboostMarginkPa <= 0.0f) {
+        limit.ceilingkPa = 0.0f;
+        return;
+    }
+    float overhead = params.PID_Control_Overhead > 0.0f ? params.PID_Control_Overhead : 0.0f;
+    float ceiling = targetkPa + overhead + params.overboostMarginkPa;
+    // A sensor pinned at the top of its range must still trip the guard.
+    const CalibrationCurve& curve = state.calibration[SENSOR_MAP];
+    float readable = params.MAX_KPA + params.PRESSURE_CORRECTION_KPA;
+    if (curve.usable) {
+        const CalibrationTable& table = curve.builtFrom;
+        float top = table.value[table.count - 1] > table.value[0] ? table.value[table.count - 1] : table.value[0];
+        readable = top + params.PRESSURE_CORRECTION_KPA;
+    }
+    limit.ceilingkPa = ceiling < readable ? ceiling : readable;
+    if (curve.usable) {
+        // The guard's line is the table's tangent where it reaches the
+        // ceiling, so it trips at the same voltage the table reads it.
+        float slope;
+        float pinVoltage = calibrationCurveVoltage(curve, limit.ceilingkPa - params.PRESSURE_CORRECTION_KPA, slope) +
+                           params.scaledVoltageOffset;
+        limit.kPaPerVolt = slope;
+        limit.kPaAtZeroVolts = limit.ceilingkPa - slope * pinVoltage;
+    }
+}
+
+//================================================================================
+// PIPELINE
+//================================================================================
+void controlInit(ControlState& state, const ControlParams& params, float measuredVoltage, uint32_t timeMs) {
+    state.pid.reset();
+    state.output = 0.0;
+    state.lastTime = timeMs;
+    state.output_ema_s = 0;
+
+    float initialVoltage = measuredVoltage - params.scaledVoltageOffset;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) calibrationCurveInit(state.calibration[c]);
+    updateCalibration(state, params);
+    float initialPressure = mapPressure(state, params, initialVoltage);
+    estimatorInit(state.estimator);
+    estimatorUpdate(state.estimator, params.estimator, initialPressure, 0);
+    state.filterCutoffHz = -1.0f;
+    state.filterType = updateFilterConfig(state, params);
+    state.filter.reset(state.filterType, FilterScalar(initialVoltage));
+
+    sysidInit(state.sysid);
+    state.gainScale = 1.0;
+
+    overshootInit(state.trend, initialPressure, PRESSURE_TREND_FILTER_MS);
+    rpmInit(state.rpm);
+    sensorFaultInit(state.sensorFault);
+    state.aux.primed = false;
+    state.aux.backpressurekPa = 0;
+    state.aux.intakeTempC = 0;
+    state.aux.supplyVoltage = 0;
+    solenoidLinearizerInit(state.solenoid);
+    setpointInit(state.setpoint);
+    state.dutyCeiling = 1.0;
+    state.gainMultipliers.kp = 1.0;
+    state.gainMultipliers.ki = 1.0;
+    state.gainMultipliers.kd = 1.0;
+
+    feedForwardClear(state.feedForward);
+    state.closedLoop = false;
+    state.ffSettleTicks = 0;
+
+    state.solenoidDisabledByIdle = false;
+    state.idleTimerStart = 0;
+
+    state.spoolState = SPOOL_IDLE;
+    state.torqueState = TORQUE_IDLE;
+    state.armingSampleCounter = 0;
+    state.boostEventCount = 0;
+    state.p_start = 0; state.p_peak = 0;
+    state.t_start = 0; state.t_peak = 0;
+    state.torqueLoggingStartTime = 0;
+    state.spoolPeakRate = 0;
+    state.yieldHook = nullptr;
+}
+
+static void logBoostEvent(ControlState& state, float pressure, uint32_t timestamp) {
+    if (state.boostEventCount < MAX_BOOST_EVENT_SAMPLES) {
+        state.boostEventData[state.boostEventCount].pressure = pressure;
+        state.boostEventData[state.boostEventCount].timestamp = timestamp;
+        state.boostEventCount++;
+    }
+}
+
+static float calculateSpoolScore(ControlState& state, const ControlParams& params) {
+    if (params.estimator.enabled) return state.spoolPeakRate;
+    float maxRate = 0.0;
+    for (int i = 1; i < state.boostEventCount; ++i) {
+        if (state.yieldHook) state.yieldHook();
+        float p_delta = state.boostEventData[i].pressure - state.boostEventData[i-1].pressure;
+        uint32_t t_delta = state.boostEventData[i].timestamp - state.boostEventData[i-1].timestamp;
+        if (t_delta > 0) {
+            float rate = (p_delta / t_delta) * MS_PER_SECOND;
+            if (rate > maxRate) {
+                maxRate = rate;
+            }
+        }
+    }
+    return maxRate;
+}
+
+static float calculateTorqueScore(ControlState& state, const ControlParams& params, float localTargetkPa) {
+    float totalScore = 0;
+    uint32_t setpointTime = 0;
+    for (int i = 1; i < state.boostEventCount; ++i) {
+        if (state.yieldHook) state.yieldHook();
+        float p_avg = (state.boostEventData[i].pressure + state.boostEventData[i-1].pressure) * 0.5f;
+        uint32_t t_delta = state.boostEventData[i].timestamp - state.boostEventData[i-1].timestamp;
+
+        if (p_avg >= localTargetkPa && setpointTime == 0) {
+            setpointTime = state.boostEventData[i].timestamp;
+        }
+
+        if (setpointTime > 0 && state.boostEventData[i].timestamp - setpointTime > (uint32_t)params.torqueScoreCutoffMs) {
+            break;
+        }
+
+        float area = (p_avg - 100.0f) * t_delta; // Area above atmospheric pressure
+
+        if (p_avg > localTargetkPa) { // Overshoot penalty
+            area -= (p_avg - localTargetkPa) * t_delta * 2.0f; // Penalize overshoot more heavily
+        }
+        totalScore += area;
+    }
+    return totalScore * SECONDS_PER_MS;
+}
+
+void controlStep(ControlState& state, const ControlParams& params, const ControlInput& input, ControlOutput& out) {
+    const uint32_t currentTime = input.timeMs;
+    const float localTargetkPa = input.targetkPa;
+
+    out.idleSleepStarted = false;
+    out.idleSleepEnded = false;
+    out.spoolScoreReady = false;
+    out.spoolScore = 0;
+    out.torqueScoreReady = false;
+    out.torqueScore = 0;
+
+    // -- Pressure and rate estimate, then the MAP filter pipeline; a new
+    // filter type starts from the last output --
+    float sensorVoltage = input.measuredVoltage - params.scaledVoltageOffset;
+    updateCalibration(state, params);
+    float rawPressure = mapPressure(state, params, sensorVoltage);
+    estimatorUpdate(state.estimator, params.estimator, rawPressure, (float)(currentTime - state.lastTime));
+
+    int filterType = updateFilterConfig(state, params);
+    if (filterType != state.filterType) {
+        state.filterType = filterType;
+        state.filter.reset(state.filterType, state.filter.output());
+    }
+    FilterScalar filteredVoltage = state.filter.step(FilterScalar(sensorVoltage), state.filterConfig);
+    // A table is evaluated in float, so only the line keeps a fixed-point build bit-exact.
+    float currentPressure = state.calibration[SENSOR_MAP].usable ? mapPressure(state, params, float(filteredVoltage))
+                                                                 : float(linearMapApply(state.pressureMap, PidScalar(filteredVoltage)));
+    out.rawPressure = rawPressure;
+    out.currentPressure = currentPressure;
+    out.pressureRate = state.estimator.rate;
+
+    // -- MAP plausibility: a latched fault holds the failsafe duty below --
+    out.sensorFaultRaised = SENSOR_FAULT_NONE;
+    if (params.sensorFaultCheck) {
+        float dividerRatio = R2_OHMS / (R1_OHMS + R2_OHMS);
+        SensorFaultLimits limits = {SENSOR_RAIL_LOW_V * dividerRatio, SENSOR_RAIL_HIGH_V * dividerRatio};
+        out.sensorFaultRaised = sensorFaultUpdate(state.sensorFault, limits, sensorVoltage, rawPressure, input.previousDutyPercent,
+                                                  rawPressure > ARMING_THRESHOLD_KPA, (float)(currentTime - state.lastTime));
+    } else if (state.sensorFault.active != SENSOR_FAULT_NONE) {
+        sensorFaultClear(state.sensorFault);
+    }
+    const bool sensorFault = state.sensorFault.active != SENSOR_FAULT_NONE;
+    out.sensorFault = state.sensorFault.active;
+
+    // -- Idle detection --
+    if (input.activityDetected) {
+        state.idleTimerStart = 0;
+    }
+
+    if ((currentPressure > IDLE_PRESSURE_MIN_KPA && currentPressure < IDLE_PRESSURE_MAX_KPA) || currentPressure < params.MIN_KPA) {
+        if (state.idleTimerStart == 0) {
+            state.idleTimerStart = currentTime;
+        } else if (currentTime - state.idleTimerStart > (params.IDLE_TIMEOUT_SECONDS * MS_PER_SECOND)) {
+            if (!state.solenoidDisabledByIdle) out.idleSleepStarted = true;
+            state.solenoidDisabledByIdle = true;
+        }
+    } else {
+        state.idleTimerStart = 0;
+    }
+
+    if (state.solenoidDisabledByIdle && currentPressure < REACTIVATE_PRESSURE_KPA) {
+        state.solenoidDisabledByIdle = false;
+        out.idleSleepEnded = true;
+    }
+
+    uint32_t elapsedTime = currentTime - state.lastTime;
+
+    if (input.sensors) updateAuxSensors(state, params, *input.sensors, (float)elapsedTime);
+
+    // -- Pressure trend, RPM-by-gear target, IAT trim and setpoint trajectory --
+    // The curve restarts when the trend crosses the arming threshold; the
+    // scores below still judge against the user's target.
+    overshootUpdate(state.trend, rawPressure, (float)elapsedTime);
+    bool trendUnderBoost = state.trend.pressure > ARMING_THRESHOLD_KPA;
+    rpmUpdate(state.rpm, params.rpm, input.rpmPulses, input.speedPulses, elapsedTime, trendUnderBoost);
+    float mappedTargetkPa = localTargetkPa;
+    if (params.rpm.enabled && params.boostMap.enabled) {
+        mappedTargetkPa += boostMapLookup(params.boostMap, state.rpm.rpm, (float)state.rpm.gear);
+    }
+    if (state.aux.primed) {
+        mappedTargetkPa += intakeTempTrimkPa(state.aux.intakeTempC, params.iatTrimStartC, params.iatTrimkPaPerC);
+    }
+    const float controlTargetkPa = setpointUpdate(state.setpoint, params.setpointProfile, mappedTargetkPa,
+                                                  trendUnderBoost, currentTime, (float)elapsedTime);
+    out.targetkPa = controlTargetkPa;
+    // The ceiling follows whichever target is higher, so a map offset or a
+    // slow ramp never brings it under the pressure the loop is allowed to chase.
+    fillOverboostLimit(state, params, controlTargetkPa > localTargetkPa ? controlTargetkPa : localTargetkPa,
+                       out.overboostLimit);
+
+    // -- Plant identification: only learn under boost, where duty moves pressure --
+    bool underBoost = !state.solenoidDisabledByIdle && !sensorFault && currentPressure > ARMING_THRESHOLD_KPA;
+    sysidUpdate(state.sysid, currentPressure, input.previousDutyPercent, params.sysidDelayTicks, params.sysidForgetting, underBoost);
+    // The scale slews towards its target so the estimate turning valid or
+    // invalid, or jumping, never steps Kp or Kd.
+    float targetScale = 1.0f;
+    if (params.adaptiveGains && params.nominalPlantGain > 0) {
+        PlantEstimate plant;
+        sysidEstimate(state.sysid, CONTROL_TASK_DELAY_MS, plant);
+        if (plant.valid) {
+            targetScale = params.nominalPlantGain / plant.gainkPaPerPercent;
+            if (targetScale < ADAPTIVE_GAIN_SCALE_MIN) targetScale = ADAPTIVE_GAIN_SCALE_MIN;
+            if (targetScale > ADAPTIVE_GAIN_SCALE_MAX) targetScale = ADAPTIVE_GAIN_SCALE_MAX;
+        }
+    }
+    float maxScaleStep = ADAPTIVE_GAIN_SCALE_RATE * (float)elapsedTime * SECONDS_PER_MS;
+    if (targetScale > state.gainScale + maxScaleStep) state.gainScale += maxScaleStep;
+    else if (targetScale < state.gainScale - maxScaleStep) state.gainScale -= maxScaleStep;
+    else state.gainScale = targetScale;
+
+    // -- Spool score state machine --
+    switch (state.spoolState) {
+        case SPOOL_IDLE:
+            if (currentPressure > ARMING_THRESHOLD_KPA) {
+                state.spoolState = SPOOL_ARMING;
+                state.armingSampleCounter = 1;
+            }
+            break;
+
+        case SPOOL_ARMING:
+            if (currentPressure > ARMING_THRESHOLD_KPA) {
+                state.armingSampleCounter++;
+                if (state.armingSampleCounter >= ARMING_DWELL_SAMPLES) {
+                    state.p_start = currentPressure;
+                    state.t_start = currentTime;
+                    state.p_peak = state.p_start;
+                    state.t_peak = state.t_start;
+                    state.boostEventCount = 0;
+                    logBoostEvent(state, state.p_start, state.t_start);
+                    state.spoolPeakRate = state.estimator.rate;
+                    state.spoolState = SPOOL_LOGGING;
+                }
+            } else {
+                state.spoolState = SPOOL_IDLE;
+            }
+            break;
+
+        case SPOOL_LOGGING:
+            logBoostEvent(state, currentPressure, currentTime);
+            if (state.estimator.rate > state.spoolPeakRate) state.spoolPeakRate = state.estimator.rate;
+            if (currentPressure > state.p_peak) {
+                state.p_peak = currentPressure;
+                state.t_peak = currentTime;
+            }
+            if (currentPressure < (state.p_peak - TERMINATION_DROP_KPA)) {
+                state.spoolState = SPOOL_CALCULATE_AND_DISPLAY;
+            }
+            break;
+
+        case SPOOL_CALCULATE_AND_DISPLAY:
+            break;
+    }
+
+    // -- PID --
+    // Below the trigger window the solenoid is driven fully closed-wastegate to
+    // spool; the controller either restarts from zero or tracks that output.
+    PidConfig<float> pidConfig;
+    fillPidConfig(params, state.gainScale, pidConfig);
+    float setpoint = controlTargetkPa + params.PID_Control_Overhead;
+
+    if (params.gainSchedule.enabled) {
+        gainScheduleLookup(params.gainSchedule, setpoint - currentPressure, state.trend.slope, state.gainMultipliers);
+        pidConfig.kp *= state.gainMultipliers.kp;
+        pidConfig.kd *= state.gainMultipliers.kd;
+        // The Ki multiplier scales how fast the I term moves rather than Ki, so
+        // a change never steps the I term, Max I term keeps its meaning and a
+        // multiplier of 0 holds the I term where it is.
+        pidConfig.integralRate *= state.gainMultipliers.ki;
+    }
+
+    // Lower the duty ceiling ahead of a forecast crossing of the target; the
+    // PID's anti-windup sees it as an ordinary output limit.
+    state.dutyCeiling = 1.0;
+    if (params.overshootLimiter && state.trend.slope > 0.0f) {
+        float forecast = overshootForecast(state.trend, params.overshootLeadMs);
+        state.dutyCeiling = overshootDutyCeiling(forecast, controlTargetkPa, params.overshootSpankPa,
+                                                 params.overshootFloorPercent / 100.0f);
+    }
+    pidConfig.outMax = 255.0f * state.dutyCeiling;
+    const PidConfig<PidScalar> pidCfg = pidConfigAs<PidScalar>(pidConfig);
+    const PidScalar pidSetpoint = PidScalar(setpoint), pidMeasurement = PidScalar(currentPressure);
+    if (currentPressure < controlTargetkPa - params.pidTriggerkPa) {
+        state.output = pidConfig.outMax;
+        if (params.bumplessTransfer) {
+            state.pid.track(pidCfg, PidScalar(state.output), pidSetpoint, pidMeasurement);
+        } else {
+            state.pid.reset();
+        }
+        state.closedLoop = false;
+        state.ffSettleTicks = 0;
+    } else {
+        float ffDuty;
+        if (!state.closedLoop && params.feedForwardEnabled && feedForwardLookup(state.feedForward, setpoint, ffDuty)) {
+            // Start from the learned holding duty instead of finding it from full duty.
+            float ffOutput = ffDuty * OUTPUT_COUNTS_PER_PERCENT;
+            state.pid.track(pidCfg, PidScalar(ffOutput), pidSetpoint, pidMeasurement);
+            state.output_ema_s = ffOutput;
+        }
+        state.closedLoop = true;
+        if (params.estimator.enabled) {
+            state.output = float(state.pid.updateWithRate(pidCfg, pidSetpoint, pidMeasurement, PidScalar(state.estimator.rate),
+                                                          PidScalar(elapsedTime * SECONDS_PER_MS)));
+        } else {
+            state.output = float(state.pid.update(pidCfg, pidSetpoint, pidMeasurement, PidScalar(elapsedTime * SECONDS_PER_MS)));
+        }
+
+        // Learn the holding duty from steady, unsaturated stretches.
+        if (state.output <= 0.0f || state.output >= 255.0f || state.solenoidDisabledByIdle) {
+            state.ffSettleTicks = 0;
+        } else {
+            if (state.ffSettleTicks == 0) {
+                state.ffDutySum = 0;
+                state.ffPressureSum = 0;
+                state.ffPressureMin = currentPressure;
+                state.ffPressureMax = currentPressure;
+                state.ffDutyMin = input.previousDutyPercent;
+                state.ffDutyMax = input.previousDutyPercent;
+            }
+            if (currentPressure < state.ffPressureMin) state.ffPressureMin = currentPressure;
+            if (currentPressure > state.ffPressureMax) state.ffPressureMax = currentPressure;
+            if (input.previousDutyPercent < state.ffDutyMin) state.ffDutyMin = input.previousDutyPercent;
+            if (input.previousDutyPercent > state.ffDutyMax) state.ffDutyMax = input.previousDutyPercent;
+            state.ffDutySum += input.previousDutyPercent;
+            state.ffPressureSum += currentPressure;
+            state.ffSettleTicks++;
+            if (state.ffPressureMax - state.ffPressureMin > FF_SETTLE_BAND_KPA ||
+                state.ffDutyMax - state.ffDutyMin > FF_SETTLE_DUTY_BAND) {
+                state.ffSettleTicks = 0;
+            } else if (state.ffSettleTicks >= FF_SETTLE_TICKS) {
+                feedForwardLearn(state.feedForward, state.ffPressureSum / state.ffSettleTicks,
+                                 state.ffDutySum / state.ffSettleTicks, FF_LEARN_RATE, FF_MAX_STEP_PERCENT);
+                state.ffSettleTicks = 0;
+            }
+        }
+    }
+
+    state.lastTime = currentTime;
+    state.output_ema_s = (params.output_ema_a * state.output) + ((1 - params.output_ema_a) * state.output_ema_s);
+    float localControlPercent = state.output_ema_s * OUTPUT_PERCENT_PER_COUNT;
+
+    if (state.solenoidDisabledByIdle) {
+        localControlPercent = 0;
+    }
+    if (sensorFault) {
+        // Nothing computed from the reading can be trusted; once the fault is
+        // cleared the loop starts over as if from spool.
+        state.pid.reset();
+        state.output = 0;
+        state.output_ema_s = 0;
+        state.closedLoop = false;
+        state.ffSettleTicks = 0;
+        localControlPercent = params.sensorFailsafePercent;
+    }
+    out.controlPercent = localControlPercent;
+    if (params.solenoidCurve.enabled) solenoidLinearizerUpdate(state.solenoid, params.solenoidCurve);
+    // The failsafe duty is the valve's own duty, not a share of flow.
+    out.solenoidPercent = sensorFault ? params.sensorFailsafePercent : controlSolenoidPercent(state, params, localControlPercent);
+
+    if (state.spoolState == SPOOL_CALCULATE_AND_DISPLAY) {
+        out.spoolScore = calculateSpoolScore(state, params);
+        out.spoolScoreReady = true;
+        state.spoolState = SPOOL_IDLE;
+    }
+
+    // -- Torque score state machine --
+    if (state.torqueState == TORQUE_IDLE && currentPressure > ARMING_THRESHOLD_KPA) {
+        state.torqueState = TORQUE_LOGGING;
+        state.boostEventCount = 0;
+        state.torqueLoggingStartTime = currentTime;
+    }
+
+    if (state.torqueState == TORQUE_LOGGING) {
+        if (currentTime - state.torqueLoggingStartTime > 3000 && currentPressure < localTargetkPa) {
+            state.torqueState = TORQUE_IDLE;
+            state.boostEventCount = 0;
+        } else {
+            logBoostEvent(state, currentPressure, currentTime);
+            if (currentPressure < (state.p_peak - TERMINATION_DROP_KPA)) {
+                state.torqueState = TORQUE_CALCULATE_AND_DISPLAY;
+            }
+        }
+    }
+
+    if (state.torqueState == TORQUE_CALCULATE_AND_DISPLAY) {
+        out.torqueScore = calculateTorqueScore(state, params, localTargetkPa);
+        out.torqueScoreReady = true;
+        state.torqueState = TORQUE_IDLE;
+    }
+}
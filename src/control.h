@@ -0,0 +1,292 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "estimator.h"
+#include "numeric.h"
+#include "feedforward.h"
+#include "filters.h"
+#include "fixed.h"
+#include "gainschedule.h"
+#include "overshoot.h"
+#include "overboost.h"
+#include "setpoint.h"
+#include "rpm.h"
+#include "sensors.h"
+#include "sensorfault.h"
+#include "solenoid.h"
+#include "pid.h"
+#include "sysid.h"
+
+//================================================================================
+// HARDWARE-INDEPENDENT CONTROL PIPELINE
+//================================================================================
+// Everything pidControlTask does between reading the sensor voltage and driving
+// the solenoid: the MAP filter pipeline (filters.h), idle detection, PID and the
+// spool/torque score state machines. It has no Arduino or FreeRTOS dependency
+// so the host tools in tools/ run exactly the same code as the firmware.
+
+#define CONTROL_TASK_DELAY_MS 10
+#define MAX_BOOST_EVENT_SAMPLES 1000
+
+// Arithmetic of the MAP filter pipeline (sensor volts) and the PID (kPa and
+// output counts). Float unless built with -DCONTROL_FIXED_POINT, which runs
+// both, and the scaling of the filtered reading to kPa, in Q formats whose
+// results are bit-identical on the host tools and the ESP32. Everything
+// around them stays float.
+#ifdef CONTROL_FIXED_POINT
+typedef Q8_24 FilterScalar;
+typedef Q16_16 PidScalar;
+#else
+typedef float FilterScalar;
+typedef float PidScalar;
+#endif
+
+// -- Sensor Calibration --
+const float R1_OHMS = 9980.0;
+const float R2_OHMS = 15000.0;           // also used by the backpressure and IAT inputs
+const float SUPPLY_R1_OHMS = 47000.0;    // 12 V supply sense divider
+const float SUPPLY_R2_OHMS = 10000.0;
+
+// -- Sensor Signal Processing --
+const float IDLE_PRESSURE_MIN_KPA = 95.0;
+const float IDLE_PRESSURE_MAX_KPA = 105.0;
+const float REACTIVATE_PRESSURE_KPA = 75.0;
+constexpr float OUTPUT_PERCENT_PER_COUNT = 100.0f / 255.0f;   // PID output (0-255) to duty %
+constexpr float OUTPUT_COUNTS_PER_PERCENT = 255.0f / 100.0f;   // duty % to PID output (0-255)
+
+// -- Adaptive Gains --
+const float ADAPTIVE_GAIN_SCALE_MIN = 0.5;
+const float ADAPTIVE_GAIN_SCALE_MAX = 2.0;
+const float ADAPTIVE_GAIN_SCALE_RATE = 0.5;   // max change of the scale per second
+const float SYSID_DEFAULT_FORGETTING = 0.995;
+const int SYSID_DEFAULT_DELAY_TICKS = 4;
+
+// -- Feed-forward Learning --
+const float FF_SETTLE_BAND_KPA = 2.0;      // max pressure spread over a window that counts as settled
+const float FF_SETTLE_DUTY_BAND = 4.0;     // max duty spread (%); rules out pressure held flat by a still-spooling turbo
+const int FF_SETTLE_TICKS = 50;            // settled ticks averaged into one sample
+const float FF_LEARN_RATE = 0.5;
+const float FF_MAX_STEP_PERCENT = 3.0;     // largest change per sample once a point is known
+
+// -- Pressure Trend (gain schedule and overshoot limiter) --
+const float PRESSURE_TREND_FILTER_MS = 40.0;   // low-pass on pressure slope and curvature
+
+// -- Spool Score Parameters --
+const float ARMING_THRESHOLD_KPA = 105.0;
+const int ARMING_DWELL_SAMPLES = 5;
+const float TERMINATION_DROP_KPA = 4.0;
+
+struct PressureTimestamp {
+    float pressure;
+    uint32_t timestamp;
+};
+
+enum SpoolScoreState {
+    SPOOL_IDLE,
+    SPOOL_ARMING,
+    SPOOL_LOGGING,
+    SPOOL_CALCULATE_AND_DISPLAY
+};
+
+enum TorqueScoreState {
+    TORQUE_IDLE,
+    TORQUE_LOGGING,
+    TORQUE_CALCULATE_AND_DISPLAY
+};
+
+// Snapshot of the tunables the pipeline reads each tick.
+struct ControlParams {
+    float kp, ki, kd;
+    float maxIntegral;
+    float PID_Control_Overhead;
+    float pidTriggerkPa;
+    float slow_ema_a, fast_ema_a;
+    float kpa_rate_change_threshold;
+    int kpa_rate_time_interval_ms;
+    FilterSettings filter;       // pipeline for the MAP reading; the EMA fields above feed its adaptive EMA
+    EstimatorSettings estimator; // when enabled, its rate drives the D term, the EMA switch and the spool score
+    float output_ema_a;
+    float IDLE_TIMEOUT_SECONDS;
+    float minSensorVoltage, maxSensorVoltage, scaledVoltageOffset;
+    float MIN_KPA, MAX_KPA;
+    float PRESSURE_CORRECTION_KPA;
+    int torqueScoreCutoffMs;
+
+    // -- Online plant identification / adaptive gains --
+    float sysidForgetting;
+    int sysidDelayTicks;
+    bool adaptiveGains;
+    float nominalPlantGain;    // kPa per % duty the PID gains were tuned for
+
+    // -- PID options (defaults reproduce the original loop, except that the
+    // derivative restarts from zero on entering closed loop; see pid.h) --
+    float derivativeFilterMs;  // D-term low-pass time constant, 0 = off
+    float setpointWeightP;     // proportional setpoint weight b
+    bool derivativeOnMeasurement;
+    int antiWindupMode;        // PidAntiWindup
+    bool bumplessTransfer;     // track the open-loop output instead of zeroing the integrator
+
+    // -- Feed-forward --
+    bool feedForwardEnabled;   // seed output and integrator from the learned map
+
+    // -- Gain scheduling (used when gainSchedule.enabled) --
+    GainSchedule gainSchedule;
+
+    // -- Predictive overshoot limiter --
+    bool overshootLimiter;
+    float overshootLeadMs;       // forecast horizon, about dead time plus manifold lag
+    float overshootSpankPa;      // predicted excess at which duty reaches the floor
+    float overshootFloorPercent; // lowest duty ceiling the limiter imposes
+
+    // -- Setpoint trajectory (target ramp and time-since-spool curve) --
+    SetpointProfile setpointProfile;
+
+    // -- Engine speed, gear and the RPM-by-gear target map --
+    RpmConfig rpm;
+    BoostTargetMap boostMap;     // applied when rpm.enabled and boostMap.enabled
+
+    // -- Auxiliary sensors: exhaust backpressure, intake air temperature, supply --
+    SensorCalibration backpressure, intakeTemp, supply;
+    bool supplyCompensation;     // scale solenoid duty by nominal / measured supply voltage
+    float supplyNominalVoltage;  // supply the duty was tuned at
+    float iatTrimStartC;
+    float iatTrimkPaPerC;        // target reduction per degree above iatTrimStartC, 0 = off
+
+    // -- Multi-point calibration; an enabled, valid table replaces its channel's line --
+    CalibrationTable calibration[SENSOR_CHANNEL_COUNT];
+
+    // -- Solenoid output linearization --
+    int valveFrequencyHz;
+    SolenoidCurve solenoidCurve; // when enabled, controlPercent is a share of full flow
+
+    // -- Independent overboost cut --
+    float overboostMarginkPa;    // ceiling above the target for the guard, 0 = off
+
+    // -- MAP sensor fault monitor --
+    bool sensorFaultCheck;
+    float sensorFailsafePercent; // solenoid duty while a fault is latched
+};
+
+struct ControlState {
+    // -- PID --
+    PidController<PidScalar> pid;
+    float output;
+    uint32_t lastTime;
+    float output_ema_s;
+
+    // -- MAP filter pipeline, in sensor volts --
+    PressureFilter<FilterScalar> filter;
+    FilterConfig<FilterScalar> filterConfig;
+    int filterType;            // type the pipeline was last reset to
+    float filterCutoffHz;      // corner the biquad coefficients were designed for
+
+    // -- Pressure and rate estimate, on the raw reading --
+    PressureEstimator estimator;
+    LinearMap pressureMap;     // sensor volts to kPa, from this tick's calibration; the table's chord when one is in use
+    CalibrationCurve calibration[SENSOR_CHANNEL_COUNT];   // built from params.calibration
+
+    // -- Feed-forward map (learned whether or not seeding is enabled) --
+    FeedForwardTable feedForward;
+    bool closedLoop;
+    int ffSettleTicks;
+    float ffDutySum, ffPressureSum;
+    float ffPressureMin, ffPressureMax;
+    float ffDutyMin, ffDutyMax;
+
+    // -- Engine speed and gear --
+    RpmState rpm;
+
+    // -- Auxiliary sensors --
+    AuxSensorState aux;
+
+    // -- MAP sensor plausibility --
+    SensorFaultMonitor sensorFault;
+
+    // -- Solenoid output stage --
+    SolenoidLinearizer solenoid;
+
+    // -- Setpoint trajectory --
+    SetpointState setpoint;
+
+    // -- Pressure trend, gain scheduling and overshoot limiting --
+    OvershootPredictor trend;
+    float dutyCeiling;         // fraction of full duty the limiter allowed this tick
+    GainMultipliers gainMultipliers;
+
+    // -- Plant identification --
+    SystemIdentifier sysid;
+    float gainScale;
+
+    // -- Idle detection --
+    bool solenoidDisabledByIdle;
+    uint32_t idleTimerStart;
+
+    // -- Score state machines --
+    SpoolScoreState spoolState;
+    TorqueScoreState torqueState;
+    int armingSampleCounter;
+    PressureTimestamp boostEventData[MAX_BOOST_EVENT_SAMPLES];
+    int boostEventCount;
+    float p_start, p_peak;
+    uint32_t t_start, t_peak;
+    uint32_t torqueLoggingStartTime;
+    float spoolPeakRate;       // estimator's peak rate while logging, kPa/s
+
+    // Called once per sample while scoring so the firmware can feed the watchdog.
+    void (*yieldHook)();
+};
+
+struct ControlInput {
+    uint32_t timeMs;
+    float measuredVoltage;
+    float targetkPa;
+    float previousDutyPercent;   // duty actually applied since the last tick
+    bool activityDetected;
+    uint32_t rpmPulses;          // tach pulses since the last tick
+    uint32_t speedPulses;        // vehicle speed pulses since the last tick
+    const SensorSample* sensors; // whole ADC scan; nullptr when only the MAP voltage is known
+};
+
+struct ControlOutput {
+    float rawPressure;
+    float currentPressure;
+    float pressureRate;          // estimator's rate, kPa/s
+    float targetkPa;             // setpoint trajectory output the loop chased this tick
+    float controlPercent;
+    float solenoidPercent;       // controlPercent through the output stage, to drive the solenoid
+    OverboostLimit overboostLimit; // for the overboost guard, which holds it through a stall
+    uint8_t sensorFault;         // latched SensorFaultCode; the output is the failsafe duty while set
+    uint8_t sensorFaultRaised;   // fault first detected this tick, for the fault log
+    bool idleSleepStarted;
+    bool idleSleepEnded;
+    bool spoolScoreReady;
+    float spoolScore;
+    bool torqueScoreReady;
+    float torqueScore;
+};
+
+float fmap(float x, float in_min, float in_max, float out_min, float out_max);
+void scaleSensorVoltages(float rawMin, float rawMax, float rawOffset, float& minV, float& maxV, float& offsetV);
+// Sensor volts (offset already taken off) to kPa, as a slope and offset.
+LinearMap pressureMapFor(const ControlParams& params);
+// The same through the MAP calibration table when one is in use; builds the
+// table each call, so for tools rather than every tick.
+float voltageToPressure(const ControlParams& params, float sensorVoltage);
+// Pin volts per sensor volt on a channel's input divider.
+float sensorDividerRatio(int channel);
+// A channel's pin voltage back through its divider to the sensor's output,
+// with the MAP offset taken off: the voltage calibration tables are written in.
+float sensorOutputVoltage(const ControlParams& params, int channel, float pinVoltage);
+void controlInit(ControlState& state, const ControlParams& params, float measuredVoltage, uint32_t timeMs);
+void controlStep(ControlState& state, const ControlParams& params, const ControlInput& input, ControlOutput& out);
+// Output stage: linearization with dead-band and supply correction, or the
+// plain supply correction. controlStep() applies it to its own output; the
+// firmware calls it again when the autotune relay overrides that output.
+float controlSolenoidPercent(const ControlState& state, const ControlParams& params, float controlPercent);
+// Its inverse: the controller duty that gives this valve duty, for ticks where
+// the overboost cut, the sensor failsafe or the characterization drove the valve.
+float controlPercentForSolenoid(const ControlState& state, const ControlParams& params, float solenoidPercent);
+
+#endif // CONTROL_H
@@ -8,8 +8,13 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
-#include <vector>
 #include <cmath>
+#include "control.h"
+#include "autotune.h"
+#include "boot.h"
+#include "power.h"
+#include "heap_guard.h"
+#include "textwrap.h"
 
 //================================================================================
 // PIN & HARDWARE DEFINITIONS
@@ -17,22 +22,27 @@
 #define OLED_SDA 2
 #define OLED_SCK 3
 #define SOLENOID_PIN 1
+// The analog inputs must all be ADC1 pins (GPIO 1-10) to share the DMA scan.
 #define PRESSURE_SENSOR_PIN 6
+#define BACKPRESSURE_SENSOR_PIN 4   // exhaust backpressure sensor, same divider as MAP
+#define IAT_SENSOR_PIN 5            // intake air temperature, same divider as MAP
+#define SUPPLY_SENSE_PIN 10         // 12 V supply through the SUPPLY_R1/R2 divider
 #define TOUCH_PIN_1 7
 #define TOUCH_PIN_2 8
 #define TOUCH_PIN_3 9
-#define TOUCH_PIN_4 10
+#define TOUCH_PIN_4 13
 #define TOUCH_PIN_5 11
 #define TOUCH_PIN_6 12
+#define RPM_INPUT_PIN 14         // conditioned tach signal, counted by PCNT unit 0
+#define SPEED_INPUT_PIN 15       // optional vehicle speed sensor, PCNT unit 1
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
-#define MAX_BOOST_EVENT_SAMPLES 1000
 
 //================================================================================
 // EEPROM ADDRESSES
 //================================================================================
-#define EEPROM_SIZE 512
+#define EEPROM_SIZE 4096
 #define ADDR_TARGET_KPA 0
 #define ADDR_KP 4
 #define ADDR_KI 8
@@ -60,6 +70,64 @@
 #define ADDR_TS_CUTOFF 96
 #define ADDR_PRESET_1 100
 #define ADDR_PRESET_2 (ADDR_PRESET_1 + sizeof(ControllerPreset))
+// Parameters added after the preset block; presets are free to grow up to here.
+#define ADDR_EXT_BASE 1024
+#define ADDR_ADAPTIVE_GAINS (ADDR_EXT_BASE + 0)
+#define ADDR_NOMINAL_PLANT_GAIN (ADDR_EXT_BASE + 4)
+#define ADDR_PID_D_FILTER (ADDR_EXT_BASE + 8)
+#define ADDR_PID_SP_WEIGHT (ADDR_EXT_BASE + 12)
+#define ADDR_PID_D_ON_MEAS (ADDR_EXT_BASE + 16)
+#define ADDR_PID_ANTI_WINDUP (ADDR_EXT_BASE + 20)
+#define ADDR_PID_BUMPLESS (ADDR_EXT_BASE + 24)
+#define ADDR_FEEDFORWARD_ENABLED (ADDR_EXT_BASE + 28)
+#define ADDR_OVERSHOOT_LIMITER (ADDR_EXT_BASE + 32)
+#define ADDR_OVERSHOOT_LEAD (ADDR_EXT_BASE + 36)
+#define ADDR_OVERSHOOT_SPAN (ADDR_EXT_BASE + 40)
+#define ADDR_OVERSHOOT_FLOOR (ADDR_EXT_BASE + 44)
+#define ADDR_RPM_INPUT_ENABLED (ADDR_EXT_BASE + 48)
+#define ADDR_RPM_PULSES_PER_REV (ADDR_EXT_BASE + 52)
+#define ADDR_SPEED_PULSES_PER_KM (ADDR_EXT_BASE + 56)
+#define ADDR_GEAR_COUNT (ADDR_EXT_BASE + 60)
+#define ADDR_SUPPLY_COMPENSATION (ADDR_EXT_BASE + 64)
+#define ADDR_SUPPLY_NOMINAL_VOLTAGE (ADDR_EXT_BASE + 68)
+#define ADDR_IAT_TRIM_START (ADDR_EXT_BASE + 72)
+#define ADDR_IAT_TRIM_RATE (ADDR_EXT_BASE + 76)
+#define ADDR_OVERBOOST_MARGIN (ADDR_EXT_BASE + 80)
+#define ADDR_SENSOR_FAULT_CHECK (ADDR_EXT_BASE + 84)
+#define ADDR_SENSOR_FAILSAFE (ADDR_EXT_BASE + 88)
+#define ADDR_SPIKE_REJECT_WINDOW (ADDR_EXT_BASE + 92)
+#define ADDR_OVERSAMPLE_ADAPTIVE (ADDR_EXT_BASE + 96)
+#define ADDR_OVERSAMPLE_MIN (ADDR_EXT_BASE + 100)
+#define ADDR_ADC_CORRECTION (ADDR_EXT_BASE + 104)
+#define ADDR_IDLE_POWER (ADDR_EXT_BASE + 108)
+// Learned and user tables follow the first 128 bytes of scalar settings.
+#define ADDR_EXT_TABLES (ADDR_EXT_BASE + 128)
+#define ADDR_FEEDFORWARD_TABLE ADDR_EXT_TABLES
+#define ADDR_GAIN_SCHEDULE (ADDR_FEEDFORWARD_TABLE + sizeof(FeedForwardTable))
+#define ADDR_GAIN_SCHEDULE_PRESET_1 (ADDR_GAIN_SCHEDULE + sizeof(GainSchedule))
+#define ADDR_GAIN_SCHEDULE_PRESET_2 (ADDR_GAIN_SCHEDULE_PRESET_1 + sizeof(GainSchedule))
+#define ADDR_SETPOINT_PROFILE (ADDR_GAIN_SCHEDULE_PRESET_2 + sizeof(GainSchedule))
+#define ADDR_SETPOINT_PROFILE_PRESET_1 (ADDR_SETPOINT_PROFILE + sizeof(SetpointProfile))
+#define ADDR_SETPOINT_PROFILE_PRESET_2 (ADDR_SETPOINT_PROFILE_PRESET_1 + sizeof(SetpointProfile))
+#define ADDR_GEAR_RATIOS (ADDR_SETPOINT_PROFILE_PRESET_2 + sizeof(SetpointProfile))
+#define ADDR_BOOST_MAP (ADDR_GEAR_RATIOS + sizeof(float) * RPM_MAP_GEARS)
+#define ADDR_BOOST_MAP_PRESET_1 (ADDR_BOOST_MAP + sizeof(BoostTargetMap))
+#define ADDR_BOOST_MAP_PRESET_2 (ADDR_BOOST_MAP_PRESET_1 + sizeof(BoostTargetMap))
+#define ADDR_BACKPRESSURE_CALIBRATION (ADDR_BOOST_MAP_PRESET_2 + sizeof(BoostTargetMap))
+#define ADDR_IAT_CALIBRATION (ADDR_BACKPRESSURE_CALIBRATION + sizeof(SensorCalibration))
+#define ADDR_SUPPLY_CALIBRATION (ADDR_IAT_CALIBRATION + sizeof(SensorCalibration))
+#define ADDR_SOLENOID_CURVE (ADDR_SUPPLY_CALIBRATION + sizeof(SensorCalibration))
+#define ADDR_SOLENOID_CURVE_PRESET_1 (ADDR_SOLENOID_CURVE + sizeof(SolenoidCurve))
+#define ADDR_SOLENOID_CURVE_PRESET_2 (ADDR_SOLENOID_CURVE_PRESET_1 + sizeof(SolenoidCurve))
+#define ADDR_SENSOR_FAULT_LOG (ADDR_SOLENOID_CURVE_PRESET_2 + sizeof(SolenoidCurve))
+#define ADDR_FILTER_SETTINGS (ADDR_SENSOR_FAULT_LOG + sizeof(SensorFaultLog))
+#define ADDR_FILTER_SETTINGS_PRESET_1 (ADDR_FILTER_SETTINGS + sizeof(FilterSettings))
+#define ADDR_FILTER_SETTINGS_PRESET_2 (ADDR_FILTER_SETTINGS_PRESET_1 + sizeof(FilterSettings))
+#define ADDR_ESTIMATOR_SETTINGS (ADDR_FILTER_SETTINGS_PRESET_2 + sizeof(FilterSettings))
+#define ADDR_ESTIMATOR_SETTINGS_PRESET_1 (ADDR_ESTIMATOR_SETTINGS + sizeof(EstimatorSettings))
+#define ADDR_ESTIMATOR_SETTINGS_PRESET_2 (ADDR_ESTIMATOR_SETTINGS_PRESET_1 + sizeof(EstimatorSettings))
+#define ADDR_CALIBRATION_TABLES (ADDR_ESTIMATOR_SETTINGS_PRESET_2 + sizeof(EstimatorSettings))
+static_assert(ADDR_CALIBRATION_TABLES + sizeof(CalibrationTable) * SENSOR_CHANNEL_COUNT <= EEPROM_SIZE, "EEPROM layout overflows EEPROM_SIZE");
 
 //================================================================================
 // STRUCT & ENUM DEFINITIONS
@@ -88,11 +156,6 @@ struct ControllerPreset {
     float torqueScore;
 };
 
-struct PressureTimestamp {
-    float pressure;
-    unsigned long timestamp;
-};
-
 enum ScreenState {
     MAIN_SCREEN,
     EDIT_SETPOINT,
@@ -103,20 +166,8 @@ enum ScreenState {
     EDIT_PARAMETER,
     INFO_SCREEN,
     TUNE_SCORING_SCREEN,
-    CONFIRMATION_SCREEN
-};
-
-enum SpoolScoreState {
-    SPOOL_IDLE,
-    SPOOL_ARMING,
-    SPOOL_LOGGING,
-    SPOOL_CALCULATE_AND_DISPLAY
-};
-
-enum TorqueScoreState {
-    TORQUE_IDLE,
-    TORQUE_LOGGING,
-    TORQUE_CALCULATE_AND_DISPLAY
+    CONFIRMATION_SCREEN,
+    AUTOTUNE_SCREEN
 };
 
 enum ParamType { P_FLOAT, P_INT, P_ULONG };
@@ -130,6 +181,31 @@ struct MenuItem {
     const char* info;
 };
 
+struct SerialParam {
+    const char* key;
+    void* valuePtr;
+    ParamType type;
+};
+
+// Published by the control task every tick, streamed by the serial console.
+struct TelemetrySnapshot {
+    uint32_t timeMs;
+    float pressurekPa;
+    float targetkPa;
+    float dutyPercent;
+    float gainScale;
+    float dutyCeiling;
+    PlantEstimate plant;
+    float rpm;
+    int gear;
+    float backpressurekPa;
+    float intakeTempC;
+    float supplyVoltage;
+    uint8_t sensorFault;         // latched SensorFaultCode
+    float pressureRate;          // kPa/s, from the estimator
+    uint16_t oversampleCount;    // MAP conversions averaged this tick
+};
+
 //================================================================================
 // EXTERNAL VARIABLE DECLARATIONS
 //================================================================================
@@ -138,11 +214,15 @@ struct MenuItem {
 extern Adafruit_SSD1306 display;
 extern const int touchPins[];
 extern int touchCalibrationValues[6];
+extern bool touchCalibrated;   // touchCalibrationValues hold a reading (dataMutex)
+extern PulseCounter rpmCounter;
+extern PulseCounter speedCounter;
 
 // -- RTOS --
 extern SemaphoreHandle_t dataMutex;
 extern TaskHandle_t pidControlTaskHandle;
 extern TaskHandle_t displayAndInputTaskHandle;
+extern BootLog bootLog;   // written by setup() only; read once the interface is up
 
 // -- System State --
 extern float targetkPa;
@@ -158,13 +238,36 @@ extern bool isDisplayAsleep;
 extern bool userActivity;
 extern bool displayNeedsUpdate;
 
-// -- Score State Machines --
-extern SpoolScoreState spoolState;
-extern TorqueScoreState torqueState;
-extern std::vector<PressureTimestamp> boostEventData;
-extern float p_start, p_peak;
-extern unsigned long t_start, t_peak;
-extern unsigned long torqueLoggingStartTime;
+// -- Control Pipeline (filter, PID and score state machines) --
+extern ControlState controlState;
+
+// -- Autotune (shared between tasks, guarded by dataMutex) --
+extern Autotuner autotuner;
+extern AutotuneRule autotuneRule;
+
+// -- Solenoid characterization (shared between tasks, guarded by dataMutex) --
+extern SolenoidCharacterizer solenoidCharacterizer;
+
+// -- Sensor calibration wizard (shared between tasks, guarded by dataMutex) --
+extern CalibrationWizard calibrationWizard;
+
+// -- Feed-forward map (guarded by dataMutex) --
+// Copy of controlState.feedForward waiting to be persisted; dirty = not saved yet.
+extern FeedForwardTable feedForwardTable;
+extern bool feedForwardClearRequested;
+
+// -- MAP sensor faults (guarded by dataMutex) --
+// Every fault raised, newest last; dirty = not saved yet.
+extern SensorFaultLog sensorFaultLog;
+extern bool sensorFaultClearRequested;
+
+// -- Telemetry (guarded by dataMutex) --
+extern TelemetrySnapshot telemetry;
+extern bool telemetryEnabled;
+
+// -- Idle power (guarded by dataMutex) --
+// The control task's copy of its power policy, refreshed every tick.
+extern PowerPolicy powerPolicy;
 
 // -- Preset Management --
 extern ControllerPreset presets[2];
@@ -200,7 +303,11 @@ extern float kpa_rate_change_threshold;
 extern int kpa_rate_time_interval_ms;
 extern float output_ema_a;
 extern int OVERSAMPLE_COUNT;
+extern int spikeRejectWindow;
+extern int oversampleAdaptive, oversampleMinCount;
+extern int adcCorrectionEnabled;
 extern float IDLE_TIMEOUT_SECONDS;
+extern int idlePowerMode;
 extern float RAW_MIN_SENSOR_VOLTAGE, RAW_MAX_SENSOR_VOLTAGE, RAW_VOLTAGE_OFFSET;
 extern float minSensorVoltage, maxSensorVoltage, scaledVoltageOffset;
 extern float MIN_KPA, MAX_KPA;
@@ -209,6 +316,37 @@ extern unsigned long EDIT_HOLD_TIME_MS, SAVE_RESET_HOLD_TIME_MS;
 extern int tsSampleRate;
 extern int torqueScoreCutoffMs;
 extern const int defaultTorqueScoreCutoffMs;
+extern int adaptiveGainsEnabled;
+extern float nominalPlantGain;
+extern float pidDerivativeFilterMs;
+extern float pidSetpointWeight;
+extern int pidDerivativeOnMeasurement;
+extern int pidAntiWindupMode;
+extern int pidBumplessTransfer;
+extern int feedForwardEnabled;
+extern GainSchedule gainSchedule;
+extern SetpointProfile setpointProfile;
+extern int rpmInputEnabled;
+extern float rpmPulsesPerRev;
+extern float speedPulsesPerKm;
+extern int gearCount;
+extern float gearRpmPerKph[RPM_MAP_GEARS];
+extern BoostTargetMap boostMap;
+extern SensorCalibration backpressureCalibration, intakeTempCalibration, supplyCalibration;
+extern CalibrationTable calibrationTables[SENSOR_CHANNEL_COUNT];
+extern int supplyCompensation;
+extern float supplyNominalVoltage;
+extern float iatTrimStartC, iatTrimkPaPerC;
+extern SolenoidCurve solenoidCurve;
+extern FilterSettings filterSettings;
+extern EstimatorSettings estimatorSettings;
+extern float overboostMarginkPa;
+extern int sensorFaultCheck;
+extern float sensorFailsafePercent;
+extern int overshootLimiter;
+extern float overshootLeadMs;
+extern float overshootSpankPa;
+extern float overshootFloorPercent;   // active schedule; profiles keep their own copy
 
 //================================================================================
 // FUNCTION PROTOTYPES
@@ -224,13 +362,17 @@ void drawMenuList(const char* title, const MenuItem menuItems[], int count, int
 void drawActionLabels();
 void drawHoldIndicator();
 void drawTuneScoringHoldIndicator();
-void drawCenteredString(const String &text, int y);
-void drawRightAlignedString(const String &text, int y, int maxX = SCREEN_WIDTH);
-void wrapAndDrawText(const String& text, int x, int y, int maxWidth);
+void drawCenteredString(const char* text, int y);
+void drawRightAlignedString(const char* text, int y, int maxX = SCREEN_WIDTH);
+void wrapAndDrawText(const char* text, int x, int y, int maxWidth);
 
 // -- Input --
 void handleTouchInputs();
 void calibrateTouchSensors();
+void handleSerialCommands();
+void printTelemetry();
+void reportSolenoidCharacterization();
+void reportCalibrationWizard();
 
 // -- Persistence --
 void saveTargetPressure();
@@ -241,14 +383,42 @@ void invalidatePresetScores();
 void saveAllParameters();
 void loadAllParameters();
 void initializeDefaultParameters();
+void persistFeedForwardIfDue();
+void persistSensorFaultLogIfDue();
+void loadPresetTables(int index);
+void savePresetTables(int index);
 void copyGlobalsToPreset(ControllerPreset& preset);
 void copyPresetToGlobals(const ControllerPreset& preset);
 void showConfirmationScreen(const char* line1, const char* line2, unsigned long duration, ScreenState nextScreen);
 
 // -- Helpers --
 void calculateScaledVoltages();
-float readOversampledVoltage();
-float fmap(float x, float in_min, float in_max, float out_min, float out_max);
+void beginSensorScan();
+void readSensorSample(SensorSample& sample);
+bool readRecentSensorVoltage(int channel, int count, float& voltage);
+void sensorScanPause(bool paused);
+void sensorScanBurst(int burstMs);
+// The chip's ADC calibration as read at boot, and whether it built a usable correction.
+const AdcCharacterization& sensorAdcCharacterization(bool& usable);
+// Caller holds dataMutex.
+void fillControlParams(ControlParams& params);
 bool isPresetDataValid(const ControllerPreset& preset);
+void beginPulseCounters();
+
+// -- Overboost Guard --
+void beginOverboostGuard();
+void overboostGuardPause(bool paused);
+void overboostGuardSetLimit(const OverboostLimit& limit);
+bool overboostGuardTripped();
+void overboostGuardClear();
+void overboostGuardSnapshot(OverboostMonitor& snapshot, OverboostLimit& limit);
+uint32_t overboostGuardStackHeadroom();
+
+// -- Idle Power --
+void beginPowerManagement();
+// Whether esp_pm took the configuration, and with automatic light sleep.
+bool powerManagementAvailable(bool& lightSleep);
+void powerEnterIdle(bool lightSleep);
+void powerExitIdle();
 
 #endif // DEFINITIONS_H
\ No newline at end of file
@@ -52,6 +52,8 @@ void updateDisplay() {
     static float last_peakHoldkPa = -1.0;
     static float last_spoolScore = -1.0;
     static float last_torqueScore = -1.0;
+    static bool last_overboostCut = false;
+    static uint8_t last_sensorFault = SENSOR_FAULT_NONE;
 
 
     bool shouldDisplayBeOn = true;
@@ -66,7 +68,9 @@ void updateDisplay() {
     if (!isDisplayOn) return;
     
     float local_targetkPa, local_pressurekPa, local_controlPercent, local_peakHoldkPa, local_spoolScore, local_torqueScore;
+    uint8_t local_sensorFault;
     if (xSemaphoreTake(dataMutex, (TickType_t)10) == pdTRUE) {
+        local_sensorFault = telemetry.sensorFault;
         local_targetkPa = targetkPa;
         local_pressurekPa = pressurekPa;
         local_peakHoldkPa = peakHoldkPa;
@@ -94,6 +98,8 @@ void updateDisplay() {
                 last_peakHoldkPa = -1.0;
                 last_spoolScore = -1.0;
                 last_torqueScore = -1.0;
+                last_overboostCut = false;
+                last_sensorFault = SENSOR_FAULT_NONE;
             }
 
             if (local_targetkPa != last_targetkPa) {
@@ -120,6 +126,36 @@ void updateDisplay() {
                 drawRightAlignedString(buffer, 32);
                 last_peakHoldkPa = local_peakHoldkPa;
             }
+            // A latched overboost cut or sensor fault takes over the score line
+            // until CLR; the overboost cut is shown if both are latched.
+            {
+                bool overboostCut = overboostGuardTripped();
+                uint8_t sensorFault = overboostCut ? SENSOR_FAULT_NONE : local_sensorFault;
+                if (overboostCut != last_overboostCut || sensorFault != last_sensorFault) {
+                    bool banner = overboostCut || sensorFault != SENSOR_FAULT_NONE;
+                    display.fillRect(0, 42, 128, 9, banner ? SSD1306_WHITE : SSD1306_BLACK);
+                    if (banner) {
+                        display.setTextColor(SSD1306_BLACK);
+                        if (overboostCut) {
+                            drawCenteredString("OVERBOOST CUT", 43);
+                        } else {
+                            snprintf(buffer, sizeof(buffer), "MAP FAULT: %s", sensorFaultName(sensorFault));
+                            drawCenteredString(buffer, 43);
+                        }
+                        display.setTextColor(SSD1306_WHITE);
+                    } else {
+                        display.setCursor(2, 42); display.print("SS:");
+                    }
+                    last_spoolScore = -1.0;
+                    last_torqueScore = -1.0;
+                    last_overboostCut = overboostCut;
+                    last_sensorFault = sensorFault;
+                }
+            }
+            if (last_overboostCut || last_sensorFault != SENSOR_FAULT_NONE) {
+                drawHoldIndicator();
+                break;
+            }
             if (abs(local_spoolScore - last_spoolScore) > 0.05) {
                 display.fillRect(20, 42, 46, 8, SSD1306_BLACK);
                 display.setCursor(20, 42);
@@ -149,8 +185,8 @@ void updateDisplay() {
                 display.clearDisplay();
                 display.setTextSize(1); drawCenteredString("Configuration", 2);
                 display.drawFastHLine(0, 12, 128, SSD1306_WHITE);
-                const char* titles[] = {"PID Tuning", "MAP Sensor", "Filtering/Misc"};
-                for(int i=0; i<3; i++) {
+                const char* titles[] = {"PID Tuning", "MAP Sensor", "Filtering/Misc", "Autotune"};
+                for(int i=0; i<4; i++) {
                     int yPos = 16 + i * 10;
                     if (i == configMenuIndex) {
                         display.setCursor(5, yPos);
@@ -228,6 +264,51 @@ void updateDisplay() {
             drawActionLabels();
             drawTuneScoringHoldIndicator();
             break;
+        case AUTOTUNE_SCREEN:
+            {
+                Autotuner local_tuner;
+                if (xSemaphoreTake(dataMutex, (TickType_t)10) == pdTRUE) {
+                    local_tuner = autotuner;
+                    xSemaphoreGive(dataMutex);
+                } else { return; }
+
+                display.clearDisplay();
+                display.setTextSize(1); drawCenteredString("Autotune", 2);
+                display.drawFastHLine(0, 12, 128, SSD1306_WHITE);
+                display.setCursor(2, 16);
+                snprintf(buffer, sizeof(buffer), "Rule: %s", autotuneRuleName(autotuneRule));
+                display.print(buffer);
+
+                display.setCursor(2, 26);
+                switch (local_tuner.phase) {
+                    case AUTOTUNE_IDLE: display.print("SEL to start"); break;
+                    case AUTOTUNE_WAITING: display.print("Pull to target..."); break;
+                    case AUTOTUNE_RELAY:
+                        snprintf(buffer, sizeof(buffer), "Relay cycle %d/%d", max(0, local_tuner.cycles - 1), local_tuner.config.cyclesRequired);
+                        display.print(buffer);
+                        break;
+                    case AUTOTUNE_DONE:
+                        snprintf(buffer, sizeof(buffer), "Tu %.0fms A %.1fkPa", local_tuner.result.ultimatePeriodMs, local_tuner.result.amplitudekPa);
+                        display.print(buffer);
+                        display.setCursor(2, 36);
+                        snprintf(buffer, sizeof(buffer), "P%.2f I%.3f", local_tuner.result.kp, local_tuner.result.ki);
+                        display.print(buffer);
+                        display.setCursor(2, 46);
+                        snprintf(buffer, sizeof(buffer), "D%.2f  Hold Save", local_tuner.result.kd);
+                        display.print(buffer);
+                        break;
+                    case AUTOTUNE_ABORTED:
+                        {
+                            const char* reasons[] = {"", "overshoot", "lift", "timeout", "stopped", "sensor"};
+                            snprintf(buffer, sizeof(buffer), "Aborted: %s", reasons[local_tuner.abortReason]);
+                            display.print(buffer);
+                        }
+                        break;
+                }
+                drawActionLabels();
+                drawTuneScoringHoldIndicator();
+            }
+            break;
         case CONFIRMATION_SCREEN:
             display.clearDisplay();
             display.setTextSize(2);
@@ -281,6 +362,16 @@ void drawActionLabels() {
             labels[0]="BACK"; labels[1]="SaveA"; labels[4]="SaveB";
             active[0]=true; active[1]=true; active[4]=true;
             break;
+        case AUTOTUNE_SCREEN:
+            {
+                AutotunePhase phase = autotuner.phase;
+                bool running = (phase == AUTOTUNE_WAITING || phase == AUTOTUNE_RELAY);
+                labels[0]="BACK"; labels[5]=running ? "STOP" : "SEL";
+                active[0]=true; active[5]=true;
+                if (!running) { labels[2]="-"; labels[3]="+"; active[2]=true; active[3]=true; }
+                if (phase == AUTOTUNE_DONE) { labels[1]="SaveA"; labels[4]="SaveB"; active[1]=true; active[4]=true; }
+            }
+            break;
         case CONFIRMATION_SCREEN:
             break;
     }
@@ -417,51 +508,47 @@ void drawTuneScoringHoldIndicator() {
     }
 }
 
-void drawCenteredString(const String &text, int y) {
+void drawCenteredString(const char* text, int y) {
     int16_t x1, y1; uint16_t w, h;
     display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
     display.setCursor((SCREEN_WIDTH - w) / 2, y);
     display.print(text);
 }
 
-void drawRightAlignedString(const String &text, int y, int maxX) {
+void drawRightAlignedString(const char* text, int y, int maxX) {
     int16_t x1, y1; uint16_t w, h;
     display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
     display.setCursor(maxX - w, y);
     display.print(text);
 }
 
-void wrapAndDrawText(const String& text, int x, int y, int maxWidth) {
+// Lines are copied out of text one at a time. When the screen runs out, the
+// next word and "..." stand for the rest.
+void wrapAndDrawText(const char* text, int x, int y, int maxWidth) {
     display.setTextSize(1);
-    String currentLine = "";
-    String currentWord = "";
-    int line_height = 8;
-
-    for (unsigned int i = 0; i < text.length(); i++) {
-        char c = text.charAt(i);
-        if (c == ' ' || i == text.length() - 1) {
-            if (c != ' ') currentWord += c;
-            int16_t x1, y1; uint16_t w, h;
-            String testLine = currentLine + (currentLine.length() > 0 ? " " : "") + currentWord;
-            display.getTextBounds(testLine, 0, 0, &x1, &y1, &w, &h);
-
-            if (w > maxWidth && currentLine.length() > 0) {
-                display.setCursor(x, y);
-                display.print(currentLine);
-                y += line_height;
-                if (y > SCREEN_HEIGHT - line_height - 10) { 
-                    currentLine = currentWord + "...";
-                    break;
-                }
-                currentLine = currentWord;
-            } else {
-                currentLine = testLine;
-            }
-            currentWord = "";
-        } else {
-            currentWord += c;
+    const int lineHeight = 8;
+    char line[SCREEN_WIDTH / TEXT_CHAR_WIDTH + 1];
+    int maxChars = maxWidth / TEXT_CHAR_WIDTH;
+    if (maxChars > (int)sizeof(line) - 1) maxChars = sizeof(line) - 1;
+
+    const char* rest = text;
+    while (*rest != '\0') {
+        const char* next;
+        int length = textWrapLine(rest, maxChars, &next);
+        memcpy(line, rest, length);
+        line[length] = '\0';
+        display.setCursor(x, y);
+        display.print(line);
+        y += lineHeight;
+        rest = next;
+        if (*rest != '\0' && y > SCREEN_HEIGHT - lineHeight - 10) {
+            int word = (int)strcspn(rest, " ");
+            if (word > maxChars - 3) word = maxChars - 3;
+            memcpy(line, rest, word);
+            strcpy(line + word, "...");
+            display.setCursor(x, y);
+            display.print(line);
+            return;
         }
     }
-    display.setCursor(x, y);
-    display.print(currentLine);
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "estimator.h"
+#include "numeric.h"
+#include <math.h>
+
+void estimatorSettingsReset(EstimatorSettings& settings) {
+    settings.enabled = 0;
+    settings.measurementNoisekPa = ESTIMATOR_MEASUREMENT_NOISE_DEFAULT_KPA;
+    settings.accelNoise = ESTIMATOR_ACCEL_NOISE_DEFAULT;
+}
+
+bool estimatorSettingsSanitize(EstimatorSettings& settings) {
+    bool valid = (settings.enabled == 0 || settings.enabled == 1) && !isnan(settings.measurementNoisekPa) &&
+                 settings.measurementNoisekPa > 0.0f && settings.measurementNoisekPa <= 50.0f && !isnan(settings.accelNoise) &&
+                 settings.accelNoise > 0.0f && settings.accelNoise <= 100000.0f;
+    if (!valid) estimatorSettingsReset(settings);
+    return valid;
+}
+
+void estimatorInit(PressureEstimator& est) {
+    est.pressure = 0;
+    est.rate = 0;
+    est.p00 = est.p01 = est.p11 = 0;
+    est.primed = false;
+}
+
+void estimatorUpdate(PressureEstimator& est, const EstimatorSettings& settings, float measuredkPa, float dtMs) {
+    float r = settings.measurementNoisekPa * settings.measurementNoisekPa;
+    if (!est.primed) {
+        est.pressure = measuredkPa;
+        est.rate = 0;
+        est.p00 = r;
+        est.p01 = 0;
+        est.p11 = ESTIMATOR_INITIAL_RATE_SIGMA * ESTIMATOR_INITIAL_RATE_SIGMA;
+        est.primed = true;
+        return;
+    }
+    if (dtMs <= 0.0f) return;
+
+    // -- Predict: the acceleration over the tick is the process noise --
+    float dt = dtMs * SECONDS_PER_MS;
+    float q = settings.accelNoise * settings.accelNoise;
+    float dt2 = dt * dt;
+    est.pressure += est.rate * dt;
+    est.p00 += dt * (2.0f * est.p01 + dt * est.p11) + q * dt2 * dt2 * 0.25f;
+    est.p01 += dt * est.p11 + q * dt2 * dt * 0.5f;
+    est.p11 += q * dt2;
+
+    // -- Correct --
+    float innovation = measuredkPa - est.pressure;
+    float s = est.p00 + r;
+    float k0 = est.p00 / s;
+    float k1 = est.p01 / s;
+    est.pressure += k0 * innovation;
+    est.rate += k1 * innovation;
+    est.p11 -= k1 * est.p01;
+    est.p01 *= 1.0f - k0;
+    est.p00 *= 1.0f - k0;
+}
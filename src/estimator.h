@@ -0,0 +1,46 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+//================================================================================
+// PRESSURE STATE ESTIMATOR
+//================================================================================
+// Two-state Kalman filter on the raw MAP reading: pressure and its rate of
+// change, with a constant-rate model driven by random acceleration,
+//   p' = p + v * dt,  v' = v + a * dt,  a ~ N(0, accelNoise^2)
+// and the reading p + N(0, measurementNoise^2). Both noise figures are set per
+// profile in physical units, so retuning for a noisier sensor is one number.
+// At a fixed tick the gains settle to those of an alpha-beta tracker, which
+// follows a steady rise without the lag of an EMA; the tick length is taken
+// from the clock each update. Constant time per tick.
+//
+// When enabled, one estimate serves every consumer of the pressure slope: the
+// PID's derivative term, the adaptive EMA's fast/slow switch and the spool
+// score. It runs (and reports its rate) either way.
+
+const float ESTIMATOR_MEASUREMENT_NOISE_DEFAULT_KPA = 0.5;
+const float ESTIMATOR_ACCEL_NOISE_DEFAULT = 2000.0;   // kPa/s^2
+const float ESTIMATOR_INITIAL_RATE_SIGMA = 500.0;     // kPa/s, before the first updates
+
+// Stored per profile.
+struct EstimatorSettings {
+    int enabled;
+    float measurementNoisekPa;   // sigma of the reading
+    float accelNoise;            // sigma of the pressure's acceleration, kPa/s^2
+};
+
+struct PressureEstimator {
+    float pressure;              // kPa
+    float rate;                  // kPa/s
+    float p00, p01, p11;         // covariance of (pressure, rate)
+    bool primed;
+};
+
+void estimatorSettingsReset(EstimatorSettings& settings);
+// Resets the settings if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool estimatorSettingsSanitize(EstimatorSettings& settings);
+
+void estimatorInit(PressureEstimator& est);
+// One reading dtMs after the last; the first reading only primes the estimate.
+void estimatorUpdate(PressureEstimator& est, const EstimatorSettings& settings, float measuredkPa, float dtMs);
+
+#endif // ESTIMATOR_H
@@ -0,0 +1,93 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "feedforward.h"
+#include <math.h>
+
+static void locate(float pressurekPa, int& index, float& frac) {
+    float position = (pressurekPa - FF_TABLE_MIN_KPA) / FF_TABLE_STEP_KPA;
+    if (position < 0.0f) position = 0.0f;
+    if (position > (float)(FF_TABLE_POINTS - 1)) position = (float)(FF_TABLE_POINTS - 1);
+    index = (int)position;
+    if (index > FF_TABLE_POINTS - 2) index = FF_TABLE_POINTS - 2;
+    frac = position - (float)index;
+}
+
+void feedForwardClear(FeedForwardTable& table) {
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        table.dutyPercent[i] = 0.0f;
+        table.samples[i] = 0;
+    }
+    table.dirty = false;
+}
+
+bool feedForwardSanitize(FeedForwardTable& table) {
+    bool clean = true;
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        float d = table.dutyPercent[i];
+        if (isnan(d) || isinf(d) || d < 0.0f || d > 100.0f) {
+            table.dutyPercent[i] = 0.0f;
+            table.samples[i] = 0;
+            clean = false;
+        }
+    }
+    table.dirty = false;
+    return clean;
+}
+
+bool feedForwardLookup(const FeedForwardTable& table, float pressurekPa, float& dutyPercent) {
+    int i;
+    float frac;
+    locate(pressurekPa, i, frac);
+    bool lowKnown = table.samples[i] >= FF_MIN_SAMPLES;
+    bool highKnown = table.samples[i + 1] >= FF_MIN_SAMPLES;
+    if (lowKnown && highKnown) {
+        dutyPercent = table.dutyPercent[i] + (table.dutyPercent[i + 1] - table.dutyPercent[i]) * frac;
+        return true;
+    }
+    // One learned neighbour is good enough when the target sits on its side.
+    if (lowKnown && frac <= 0.5f) { dutyPercent = table.dutyPercent[i]; return true; }
+    if (highKnown && frac >= 0.5f) { dutyPercent = table.dutyPercent[i + 1]; return true; }
+    return false;
+}
+
+static float clampDuty(float dutyPercent) {
+    if (dutyPercent < 0.0f) return 0.0f;
+    if (dutyPercent > 100.0f) return 100.0f;
+    return dutyPercent;
+}
+
+static float boundedStep(float step, float maxStepPercent) {
+    if (step > maxStepPercent) return maxStepPercent;
+    if (step < -maxStepPercent) return -maxStepPercent;
+    return step;
+}
+
+void feedForwardLearn(FeedForwardTable& table, float pressurekPa, float dutyPercent, float rate, float maxStepPercent) {
+    dutyPercent = clampDuty(dutyPercent);
+    int i;
+    float frac;
+    locate(pressurekPa, i, frac);
+    float w0 = 1.0f - frac, w1 = frac;
+
+    // An unknown point starts where it makes the segment pass through this
+    // sample (extending the known neighbour's slope), or at the sample itself
+    // when both are unknown or the sample is on the far side.
+    bool lowKnown = table.samples[i] > 0, highKnown = table.samples[i + 1] > 0;
+    if (!lowKnown) {
+        table.dutyPercent[i] = (highKnown && w0 >= 0.5f) ? clampDuty((dutyPercent - w1 * table.dutyPercent[i + 1]) / w0) : dutyPercent;
+    }
+    if (!highKnown) {
+        table.dutyPercent[i + 1] = (lowKnown && w1 >= 0.5f) ? clampDuty((dutyPercent - w0 * table.dutyPercent[i]) / w1) : dutyPercent;
+    }
+
+    // Normalised LMS on the interpolated value, so the pair converges to the
+    // line through the samples rather than to their average.
+    float predicted = w0 * table.dutyPercent[i] + w1 * table.dutyPercent[i + 1];
+    float err = (dutyPercent - predicted) * rate / (w0 * w0 + w1 * w1);
+    table.dutyPercent[i] = clampDuty(table.dutyPercent[i] + boundedStep(w0 * err, maxStepPercent));
+    table.dutyPercent[i + 1] = clampDuty(table.dutyPercent[i + 1] + boundedStep(w1 * err, maxStepPercent));
+    // Only samples on a point's own half of the segment count towards trusting it.
+    if (w0 >= 0.5f && table.samples[i] < 255) table.samples[i]++;
+    if (w1 >= 0.5f && table.samples[i + 1] < 255) table.samples[i + 1]++;
+    table.dirty = true;
+}
@@ -0,0 +1,35 @@
+#ifndef FEEDFORWARD_H
+#define FEEDFORWARD_H
+
+#include <stdint.h>
+
+//================================================================================
+// LEARNED FEED-FORWARD DUTY MAP
+//================================================================================
+// Holding duty (%) needed to sit at each boost pressure, on evenly spaced
+// breakpoints so a lookup is one index computation and one interpolation.
+// Points start unknown and are filled from settled periods of closed-loop
+// control at whatever pressure the loop actually held, so a tune with some
+// steady-state error still learns correct points. After the first sample each
+// update moves a point by at most a bounded step so one odd pull cannot wreck
+// the map.
+
+#define FF_TABLE_POINTS 12
+const float FF_TABLE_MIN_KPA = 100.0;
+const float FF_TABLE_STEP_KPA = 20.0;
+const uint8_t FF_MIN_SAMPLES = 3;          // before a point is trusted for seeding
+
+struct FeedForwardTable {
+    float dutyPercent[FF_TABLE_POINTS];
+    uint8_t samples[FF_TABLE_POINTS];    // samples from the point's own half-segments, saturates at 255
+    bool dirty;                          // learned since last persisted
+};
+
+void feedForwardClear(FeedForwardTable& table);
+// Clears points that are out of range (e.g. blank EEPROM); returns false if any were.
+bool feedForwardSanitize(FeedForwardTable& table);
+// Returns false when the neighbouring points are not learned yet.
+bool feedForwardLookup(const FeedForwardTable& table, float pressurekPa, float& dutyPercent);
+void feedForwardLearn(FeedForwardTable& table, float pressurekPa, float dutyPercent, float rate, float maxStepPercent);
+
+#endif // FEEDFORWARD_H
@@ -0,0 +1,323 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <math.h>
+
+//================================================================================
+// MAP FILTER PIPELINE
+//================================================================================
+// Header-only, templated on the arithmetic type like pid.h. A pipeline is a
+// FilterChain of stages fixed at compile time; step() runs them in order and
+// inlines into one kernel with fixed-size state, no modulo and no allocation.
+// Every stage has
+//   void reset(T x)                           settle on a constant input x
+//   T step(T x, const FilterConfig<T>& cfg)   one sample in, one out
+// and reads its tunables from the shared FilterConfig, so they can change at
+// run time without touching the state.
+//
+// Stages:
+//   - DecimatorStage<T, N>: average of each block of N inputs, held for the
+//     next N samples
+//   - MedianStage<T, W>: running median of the last W inputs (odd W up to 7),
+//     removes spikes shorter than (W + 1) / 2 samples
+//   - AdaptiveEmaStage<T>: the original MAP filter; slow alpha while steady,
+//     fast alpha while the input has moved more than a threshold over the
+//     lookback (or, with externalChange, by a change the caller supplies)
+//   - BiquadStage<T>: second-order low-pass, direct form II transposed
+//   - AlphaBetaStage<T>: position and rate tracker, no lag on a steady ramp
+//
+// PressureFilter holds one of the FILTER_TYPE_COUNT pipelines and picks it
+// from a small enum at run time, so each profile can choose its own.
+
+#define FILTER_LOOKBACK_MAX 20   // adaptive EMA lookback, samples
+
+enum FilterType {
+    FILTER_ADAPTIVE_EMA,         // original behaviour
+    FILTER_MEDIAN_EMA,           // spike rejection ahead of the adaptive EMA
+    FILTER_BIQUAD,               // spike rejection, then a 2nd-order low-pass
+    FILTER_TRACKER,              // spike rejection, then the alpha-beta tracker
+    FILTER_TYPE_COUNT
+};
+
+// Stored per profile.
+struct FilterSettings {
+    int type;                    // FilterType
+    float cutoffHz;              // biquad corner
+    float trackerAlpha, trackerBeta;
+};
+
+const float FILTER_CUTOFF_MIN_HZ = 0.5;
+const float FILTER_CUTOFF_DEFAULT_HZ = 5.0;
+const float FILTER_TRACKER_ALPHA_DEFAULT = 0.3;
+const float FILTER_TRACKER_BETA_DEFAULT = 0.05;   // about alpha^2 / (2 - alpha), critically damped
+
+inline void filterSettingsReset(FilterSettings& settings) {
+    settings.type = FILTER_ADAPTIVE_EMA;
+    settings.cutoffHz = FILTER_CUTOFF_DEFAULT_HZ;
+    settings.trackerAlpha = FILTER_TRACKER_ALPHA_DEFAULT;
+    settings.trackerBeta = FILTER_TRACKER_BETA_DEFAULT;
+}
+
+// Resets the settings if anything is out of range (e.g. blank EEPROM); returns
+// false if it did. The corner must stay under the Nyquist frequency of the
+// sample rate it is used at, which the design clamps separately.
+inline bool filterSettingsSanitize(FilterSettings& settings) {
+    bool valid = settings.type >= 0 && settings.type < FILTER_TYPE_COUNT && !isnan(settings.cutoffHz) &&
+                 settings.cutoffHz >= FILTER_CUTOFF_MIN_HZ && settings.cutoffHz <= 1000.0f &&
+                 settings.trackerAlpha > 0.0f && settings.trackerAlpha <= 1.0f && settings.trackerBeta > 0.0f &&
+                 settings.trackerBeta < 4.0f - 2.0f * settings.trackerAlpha;
+    if (!valid) filterSettingsReset(settings);
+    return valid;
+}
+
+template <typename T>
+struct FilterConfig {
+    // -- Adaptive EMA --
+    T slowAlpha, fastAlpha;
+    T changeThreshold;           // input units
+    int lookback;                // samples, 1..FILTER_LOOKBACK_MAX
+    bool externalChange;         // switch on change below rather than on the lookback difference
+    T change;                    // input units over the lookback, e.g. from a rate estimate
+    // -- Biquad, normalized so a0 = 1 --
+    T b0, b1, b2, a1, a2;
+    // -- Alpha-beta tracker --
+    T trackerAlpha, trackerBeta;
+    T dtSeconds;                 // sample period
+};
+
+// Butterworth (Q = 1/sqrt 2) low-pass coefficients; the corner is clamped
+// between FILTER_CUTOFF_MIN_HZ and 0.45 of the sample rate. cosf and sinf come
+// from the C library, so the host tools and the ESP32 may round them
+// differently; the other stages use only correctly rounded arithmetic.
+template <typename T>
+inline void filterDesignLowPass(FilterConfig<T>& cfg, float cutoffHz, float sampleHz) {
+    if (cutoffHz < FILTER_CUTOFF_MIN_HZ) cutoffHz = FILTER_CUTOFF_MIN_HZ;
+    if (cutoffHz > 0.45f * sampleHz) cutoffHz = 0.45f * sampleHz;
+    float w0 = 2.0f * (float)M_PI * cutoffHz / sampleHz;
+    float cosw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * 0.70710678f);
+    float a0 = 1.0f + alpha;
+    cfg.b0 = T((1.0f - cosw) * 0.5f / a0);
+    cfg.b1 = T((1.0f - cosw) / a0);
+    cfg.b2 = cfg.b0;
+    cfg.a1 = T(-2.0f * cosw / a0);
+    cfg.a2 = T((1.0f - alpha) / a0);
+}
+
+//================================================================================
+// STAGES
+//================================================================================
+template <typename T, int N>
+class DecimatorStage {
+    static_assert(N >= 1, "decimation factor must be at least 1");
+public:
+    void reset(T x) {
+        sum = T(0);
+        count = 0;
+        held = x;
+    }
+
+    T step(T x, const FilterConfig<T>&) {
+        sum += x;
+        if (++count == N) {
+            held = sum / T(N);
+            sum = T(0);
+            count = 0;
+        }
+        return held;
+    }
+
+private:
+    T sum, held;
+    int count;
+};
+
+template <typename T, int W>
+class MedianStage {
+    static_assert(W >= 1 && W <= 7 && (W & 1), "median window must be odd and at most 7");
+public:
+    void reset(T x) {
+        for (int i = 0; i < W; i++) window[i] = x;
+        next = 0;
+    }
+
+    T step(T x, const FilterConfig<T>&) {
+        window[next] = x;
+        if (++next == W) next = 0;
+        if (W == 3) {
+            T a = window[0], b = window[1], c = window[W - 1];
+            T lo = a < b ? a : b, hi = a < b ? b : a;
+            return c < lo ? lo : (c > hi ? hi : c);
+        }
+        // Insertion sort of a copy; W is small and fixed, so this unrolls.
+        T sorted[W];
+        for (int i = 0; i < W; i++) {
+            T v = window[i];
+            int j = i;
+            for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+            sorted[j] = v;
+        }
+        return sorted[W / 2];
+    }
+
+private:
+    T window[W];
+    int next;
+};
+
+template <typename T>
+class AdaptiveEmaStage {
+public:
+    void reset(T x) {
+        for (int i = 0; i < FILTER_LOOKBACK_MAX; i++) history[i] = x;
+        index = 0;
+        ema = x;
+    }
+
+    T step(T x, const FilterConfig<T>& cfg) {
+        int lookback = cfg.lookback < 1 ? 1 : (cfg.lookback > FILTER_LOOKBACK_MAX ? FILTER_LOOKBACK_MAX : cfg.lookback);
+        if (index >= lookback) index = 0;
+        // The oldest entry of the ring, lookback - 1 samples back (the previous
+        // one for a lookback of 1), is the one after the slot written now.
+        int oldest = index + 1 < lookback ? index + 1 : 0;
+        T change = cfg.externalChange ? cfg.change : x - history[oldest];
+        if (change < T(0)) change = -change;
+        T alpha = change > cfg.changeThreshold ? cfg.fastAlpha : cfg.slowAlpha;
+        ema = (alpha * x) + ((T(1) - alpha) * ema);
+        history[index] = x;
+        index = oldest;
+        return ema;
+    }
+
+private:
+    T history[FILTER_LOOKBACK_MAX];
+    int index;
+    T ema;
+};
+
+template <typename T>
+class BiquadStage {
+public:
+    // The steady state for x depends on the coefficients, which only step()
+    // sees, so the first step settles it.
+    void reset(T x) {
+        z1 = z2 = T(0);
+        settle = x;
+        primed = false;
+    }
+
+    T step(T x, const FilterConfig<T>& cfg) {
+        if (!primed) {
+            // Unity gain at DC: y = x needs z1 = (1 - b0) x and z2 = (b2 - a2) x.
+            z1 = (T(1) - cfg.b0) * settle;
+            z2 = (cfg.b2 - cfg.a2) * settle;
+            primed = true;
+        }
+        T y = cfg.b0 * x + z1;
+        z1 = cfg.b1 * x - cfg.a1 * y + z2;
+        z2 = cfg.b2 * x - cfg.a2 * y;
+        return y;
+    }
+
+private:
+    T z1, z2, settle;
+    bool primed;
+};
+
+template <typename T>
+class AlphaBetaStage {
+public:
+    void reset(T x) {
+        position = x;
+        rate = T(0);
+    }
+
+    T step(T x, const FilterConfig<T>& cfg) {
+        T predicted = position + rate * cfg.dtSeconds;
+        T residual = x - predicted;
+        position = predicted + cfg.trackerAlpha * residual;
+        if (cfg.dtSeconds > T(0)) rate += cfg.trackerBeta * residual / cfg.dtSeconds;
+        return position;
+    }
+
+    T rateEstimate() const { return rate; }
+
+private:
+    T position, rate;
+};
+
+//================================================================================
+// PIPELINE
+//================================================================================
+template <typename T, typename... Stages>
+class FilterChain;
+
+template <typename T>
+class FilterChain<T> {
+public:
+    void reset(T) {}
+    T step(T x, const FilterConfig<T>&) { return x; }
+};
+
+template <typename T, typename First, typename... Rest>
+class FilterChain<T, First, Rest...> {
+public:
+    void reset(T x) {
+        head.reset(x);
+        tail.reset(x);
+    }
+
+    T step(T x, const FilterConfig<T>& cfg) { return tail.step(head.step(x, cfg), cfg); }
+
+private:
+    First head;
+    FilterChain<T, Rest...> tail;
+};
+
+template <typename T> using AdaptiveEmaPipeline = FilterChain<T, AdaptiveEmaStage<T>>;
+template <typename T> using MedianEmaPipeline = FilterChain<T, MedianStage<T, 3>, AdaptiveEmaStage<T>>;
+template <typename T> using BiquadPipeline = FilterChain<T, MedianStage<T, 3>, BiquadStage<T>>;
+template <typename T> using TrackerPipeline = FilterChain<T, MedianStage<T, 3>, AlphaBetaStage<T>>;
+
+template <typename T>
+class PressureFilter {
+public:
+    // Selects a pipeline (out-of-range types fall back to the adaptive EMA)
+    // and settles it on x.
+    void reset(int filterType, T x) {
+        type = (filterType >= 0 && filterType < FILTER_TYPE_COUNT) ? filterType : FILTER_ADAPTIVE_EMA;
+        switch (type) {
+            case FILTER_MEDIAN_EMA: medianEma.reset(x); break;
+            case FILTER_BIQUAD: biquad.reset(x); break;
+            case FILTER_TRACKER: tracker.reset(x); break;
+            default: adaptiveEma.reset(x); break;
+        }
+        last = x;
+    }
+
+    T step(T x, const FilterConfig<T>& cfg) {
+        switch (type) {
+            case FILTER_MEDIAN_EMA: last = medianEma.step(x, cfg); break;
+            case FILTER_BIQUAD: last = biquad.step(x, cfg); break;
+            case FILTER_TRACKER: last = tracker.step(x, cfg); break;
+            default: last = adaptiveEma.step(x, cfg); break;
+        }
+        return last;
+    }
+
+    int activeType() const { return type; }
+    T output() const { return last; }
+
+private:
+    // Only the selected pipeline is live, so they share storage.
+    union {
+        AdaptiveEmaPipeline<T> adaptiveEma;
+        MedianEmaPipeline<T> medianEma;
+        BiquadPipeline<T> biquad;
+        TrackerPipeline<T> tracker;
+    };
+    int type;
+    T last;
+};
+
+#endif // FILTERS_H
@@ -0,0 +1,108 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+#include <math.h>
+#include "numeric.h"
+
+//================================================================================
+// Q-FORMAT FIXED POINT
+//================================================================================
+// Fixed<F> is a signed 32-bit value with F fraction bits (Q(31-F).F), for
+// the templated PID (pid.h) and MAP filter stages (filters.h). Every
+// operation is integer arithmetic with a defined result, so a given input
+// sequence gives the same bits on the host and on the ESP32:
+//   - add, subtract, multiply and divide saturate at +/- the largest value
+//     instead of wrapping, and divide by zero gives the limit of the
+//     dividend's sign (zero for zero)
+//   - multiply and divide round to nearest, halves away from zero
+//   - conversion from float rounds to nearest and saturates; NaN becomes zero
+// Products and quotients go through a 64-bit intermediate. Conversions
+// between formats shift with the same rounding.
+//
+// The control pipeline picks its formats in control.h: volts in Q8.24 for the
+// filter (biquad coefficients need the fraction bits, the range is a few
+// volts) and kPa, duty counts and gains in Q16.16 for the PID.
+
+template <int F>
+class Fixed {
+    static_assert(F > 0 && F < 31, "fraction bits must leave a sign and an integer bit");
+public:
+    static const int FRACTION_BITS = F;
+    static const int32_t RAW_MAX = INT32_MAX;
+    static const int32_t RAW_MIN = -INT32_MAX;   // symmetric, so negation cannot overflow
+
+    int32_t raw;
+
+    Fixed() = default;   // uninitialized, like float; keeps the filter union trivial
+    explicit Fixed(int value) : raw(saturate((int64_t)value * ((int64_t)1 << F))) {}
+    explicit Fixed(float value) : raw(fromFloat(value)) {}
+    template <int G>
+    explicit Fixed(Fixed<G> other)
+        : raw(G > F ? shiftDown(other.raw, G > F ? G - F : 1) : saturate((int64_t)other.raw * ((int64_t)1 << (G > F ? 0 : F - G)))) {}
+
+    static Fixed fromRaw(int32_t value) {
+        Fixed result;
+        result.raw = value;
+        return result;
+    }
+
+    explicit operator float() const { return (float)raw * (1.0f / (float)((int64_t)1 << F)); }
+
+    Fixed operator-() const { return fromRaw(-raw); }
+    Fixed operator+(Fixed b) const { return fromRaw(saturate((int64_t)raw + b.raw)); }
+    Fixed operator-(Fixed b) const { return fromRaw(saturate((int64_t)raw - b.raw)); }
+    Fixed operator*(Fixed b) const { return fromRaw(shiftDown((int64_t)raw * b.raw, F)); }
+    Fixed operator/(Fixed b) const {
+        if (b.raw == 0) return fromRaw(raw > 0 ? RAW_MAX : (raw < 0 ? RAW_MIN : 0));
+        int64_t numerator = (int64_t)raw * ((int64_t)1 << F);
+        int64_t quotient = numerator / b.raw;
+        int64_t remainder = numerator % b.raw;
+        int64_t twice = remainder < 0 ? -2 * remainder : 2 * remainder;
+        if (twice >= (b.raw < 0 ? -(int64_t)b.raw : (int64_t)b.raw)) quotient += (numerator < 0) != (b.raw < 0) ? -1 : 1;
+        return fromRaw(saturate(quotient));
+    }
+    Fixed& operator+=(Fixed b) { return *this = *this + b; }
+    Fixed& operator-=(Fixed b) { return *this = *this - b; }
+    Fixed& operator*=(Fixed b) { return *this = *this * b; }
+    Fixed& operator/=(Fixed b) { return *this = *this / b; }
+
+    bool operator==(Fixed b) const { return raw == b.raw; }
+    bool operator!=(Fixed b) const { return raw != b.raw; }
+    bool operator<(Fixed b) const { return raw < b.raw; }
+    bool operator<=(Fixed b) const { return raw <= b.raw; }
+    bool operator>(Fixed b) const { return raw > b.raw; }
+    bool operator>=(Fixed b) const { return raw >= b.raw; }
+
+private:
+    static int32_t saturate(int64_t value) {
+        if (value > RAW_MAX) return RAW_MAX;
+        if (value < RAW_MIN) return RAW_MIN;
+        return (int32_t)value;
+    }
+
+    // value / 2^bits, rounded to nearest with halves away from zero.
+    static int32_t shiftDown(int64_t value, int bits) {
+        int64_t half = (int64_t)1 << (bits - 1);
+        return saturate(value >= 0 ? (value + half) >> bits : -((-value + half) >> bits));
+    }
+
+    static int32_t fromFloat(float value) {
+        if (isnan(value)) return 0;
+        float scaled = value * (float)((int64_t)1 << F);   // a power of two: exact
+        if (scaled >= 2147483647.0f) return RAW_MAX;
+        if (scaled <= -2147483647.0f) return RAW_MIN;
+        return (int32_t)lroundf(scaled);
+    }
+};
+
+typedef Fixed<24> Q8_24;
+typedef Fixed<16> Q16_16;
+
+// As linearMapApply() in numeric.h; slope and offset are rounded to F bits.
+template <int F>
+inline Fixed<F> linearMapApply(const LinearMap& map, Fixed<F> x) {
+    return x * Fixed<F>(map.slope) + Fixed<F>(map.offset);
+}
+
+#endif // FIXED_H
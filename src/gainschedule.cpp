@@ -0,0 +1,78 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "gainschedule.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void locate(float value, float minValue, float step, int points, int& index, float& frac) {
+    float position = (value - minValue) / step;
+    if (position < 0.0f) position = 0.0f;
+    if (position > (float)(points - 1)) position = (float)(points - 1);
+    index = (int)position;
+    if (index > points - 2) index = points - 2;
+    frac = position - (float)index;
+}
+
+static float bilinear(const float table[GS_RATE_POINTS][GS_ERROR_POINTS], int r, float fr, int e, float fe) {
+    float low = table[r][e] + (table[r][e + 1] - table[r][e]) * fe;
+    float high = table[r + 1][e] + (table[r + 1][e + 1] - table[r + 1][e]) * fe;
+    return low + (high - low) * fr;
+}
+
+void gainScheduleReset(GainSchedule& schedule) {
+    schedule.enabled = 0;
+    for (int r = 0; r < GS_RATE_POINTS; r++) {
+        for (int e = 0; e < GS_ERROR_POINTS; e++) {
+            schedule.kp[r][e] = 1.0f;
+            schedule.ki[r][e] = 1.0f;
+            schedule.kd[r][e] = 1.0f;
+        }
+    }
+}
+
+static bool validMultiplier(float m) {
+    return !isnan(m) && !isinf(m) && m >= 0.0f && m <= GS_MULTIPLIER_MAX;
+}
+
+bool gainScheduleSanitize(GainSchedule& schedule) {
+    bool clean = schedule.enabled == 0 || schedule.enabled == 1;
+    for (int r = 0; r < GS_RATE_POINTS && clean; r++) {
+        for (int e = 0; e < GS_ERROR_POINTS; e++) {
+            if (!validMultiplier(schedule.kp[r][e]) || !validMultiplier(schedule.ki[r][e]) ||
+                !validMultiplier(schedule.kd[r][e])) {
+                clean = false;
+                break;
+            }
+        }
+    }
+    if (!clean) gainScheduleReset(schedule);
+    return clean;
+}
+
+void gainScheduleLookup(const GainSchedule& schedule, float errorkPa, float ratekPaPerS, GainMultipliers& m) {
+    int e, r;
+    float fe, fr;
+    locate(errorkPa, GS_ERROR_MIN_KPA, GS_ERROR_STEP_KPA, GS_ERROR_POINTS, e, fe);
+    locate(ratekPaPerS, GS_RATE_MIN_KPA_S, GS_RATE_STEP_KPA_S, GS_RATE_POINTS, r, fr);
+    m.kp = bilinear(schedule.kp, r, fr, e, fe);
+    m.ki = bilinear(schedule.ki, r, fr, e, fe);
+    m.kd = bilinear(schedule.kd, r, fr, e, fe);
+}
+
+float* gainScheduleEntry(GainSchedule& schedule, const char* key) {
+    float (*table)[GS_ERROR_POINTS];
+    if (strncmp(key, "kp.", 3) == 0) table = schedule.kp;
+    else if (strncmp(key, "ki.", 3) == 0) table = schedule.ki;
+    else if (strncmp(key, "kd.", 3) == 0) table = schedule.kd;
+    else return nullptr;
+
+    char* end = nullptr;
+    long r = strtol(key + 3, &end, 10);
+    if (end == key + 3 || *end != '.') return nullptr;
+    const char* column = end + 1;
+    long e = strtol(column, &end, 10);
+    if (end == column || *end != '\0') return nullptr;
+    if (r < 0 || r >= GS_RATE_POINTS || e < 0 || e >= GS_ERROR_POINTS) return nullptr;
+    return &table[r][e];
+}
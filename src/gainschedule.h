@@ -0,0 +1,40 @@
+#ifndef GAINSCHEDULE_H
+#define GAINSCHEDULE_H
+
+//================================================================================
+// PID GAIN SCHEDULE
+//================================================================================
+// Multipliers on Kp, Ki and Kd looked up every tick from the pressure error
+// (setpoint - pressure) and its rate of change. Both axes are evenly spaced and
+// sized at compile time, so a lookup is two index computations and one bilinear
+// interpolation with no allocation. Inputs beyond the outer breakpoints use the
+// edge values. A table of 1.0 reproduces the fixed gains.
+
+#define GS_ERROR_POINTS 5
+#define GS_RATE_POINTS 4
+const float GS_ERROR_MIN_KPA = -20.0;       // pressure above setpoint
+const float GS_ERROR_STEP_KPA = 10.0;
+const float GS_RATE_MIN_KPA_S = -100.0;     // pressure falling
+const float GS_RATE_STEP_KPA_S = 100.0;
+const float GS_MULTIPLIER_MAX = 10.0;
+
+struct GainSchedule {
+    int enabled;
+    float kp[GS_RATE_POINTS][GS_ERROR_POINTS];
+    float ki[GS_RATE_POINTS][GS_ERROR_POINTS];
+    float kd[GS_RATE_POINTS][GS_ERROR_POINTS];
+};
+
+struct GainMultipliers {
+    float kp, ki, kd;
+};
+
+// Disabled, all multipliers 1.0.
+void gainScheduleReset(GainSchedule& schedule);
+// Resets the schedule if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool gainScheduleSanitize(GainSchedule& schedule);
+void gainScheduleLookup(const GainSchedule& schedule, float errorkPa, float ratekPaPerS, GainMultipliers& m);
+// Cell for a "kp.R.E" style key (table, rate row, error column); nullptr if the key is not one.
+float* gainScheduleEntry(GainSchedule& schedule, const char* key);
+
+#endif // GAINSCHEDULE_H
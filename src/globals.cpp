@@ -8,11 +8,13 @@
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 const int touchPins[] = {TOUCH_PIN_1, TOUCH_PIN_2, TOUCH_PIN_3, TOUCH_PIN_4, TOUCH_PIN_5, TOUCH_PIN_6};
 int touchCalibrationValues[6];
+bool touchCalibrated = false;
 
 // -- RTOS --
 SemaphoreHandle_t dataMutex;
 TaskHandle_t pidControlTaskHandle;
 TaskHandle_t displayAndInputTaskHandle;
+BootLog bootLog;
 
 // -- System State --
 float targetkPa;
@@ -29,13 +31,21 @@ bool isDisplayAsleep = false;
 bool userActivity = false;
 bool displayNeedsUpdate = true;
 
-// -- Score State Machines --
-SpoolScoreState spoolState = SPOOL_IDLE;
-TorqueScoreState torqueState = TORQUE_IDLE;
-std::vector<PressureTimestamp> boostEventData;
-float p_start, p_peak;
-unsigned long t_start, t_peak;
-unsigned long torqueLoggingStartTime = 0;
+// -- Control Pipeline --
+ControlState controlState;
+
+// -- Autotune --
+Autotuner autotuner = {};
+AutotuneRule autotuneRule = AUTOTUNE_RULE_ZIEGLER_NICHOLS;
+SolenoidCharacterizer solenoidCharacterizer = {};
+CalibrationWizard calibrationWizard = {};
+FeedForwardTable feedForwardTable = {};
+bool feedForwardClearRequested = false;
+SensorFaultLog sensorFaultLog = {};
+bool sensorFaultClearRequested = false;
+TelemetrySnapshot telemetry = {};
+bool telemetryEnabled = false;
+PowerPolicy powerPolicy = {};
 
 // -- Preset Management --
 ControllerPreset presets[2];
@@ -74,8 +84,13 @@ float fast_ema_a = 0.3;
 float kpa_rate_change_threshold = 8.0;
 int kpa_rate_time_interval_ms = 50;
 float output_ema_a = 0.2;
-int OVERSAMPLE_COUNT = 256;
+int OVERSAMPLE_COUNT = 64;
+int spikeRejectWindow = SPIKE_WINDOW_DEFAULT;
+int oversampleAdaptive = 0;
+int oversampleMinCount = OVERSAMPLE_MIN_DEFAULT;
+int adcCorrectionEnabled = 0;
 float IDLE_TIMEOUT_SECONDS = 60;
+int idlePowerMode = POWER_SETTING_SCALING;
 //Defaults configured for BOSCH 0281002976 PST-3 sensor
 //https://www.bosch-motorsport.com/content/downloads/Raceparts/Resources/pdf/Data%20Sheet_70513419_Pressure_Sensor_Combined_PST_1/PST_3.pdf
 float RAW_MIN_SENSOR_VOLTAGE = 0.4;
@@ -89,3 +104,37 @@ unsigned long SAVE_RESET_HOLD_TIME_MS = 1000;
 int tsSampleRate = 10;
 int torqueScoreCutoffMs = 500;
 const int defaultTorqueScoreCutoffMs = 500;
+int adaptiveGainsEnabled = 0;
+float nominalPlantGain = 1.0;
+float pidDerivativeFilterMs = 0.0;
+float pidSetpointWeight = 1.0;
+int pidDerivativeOnMeasurement = 0;
+int pidAntiWindupMode = 0;
+int pidBumplessTransfer = 0;
+int feedForwardEnabled = 0;
+GainSchedule gainSchedule = {};
+SetpointProfile setpointProfile = {};
+int rpmInputEnabled = 0;
+float rpmPulsesPerRev = 2.0;
+float speedPulsesPerKm = 0.0;
+int gearCount = 6;
+float gearRpmPerKph[RPM_MAP_GEARS] = {};
+BoostTargetMap boostMap = {};
+SensorCalibration backpressureCalibration = BACKPRESSURE_CALIBRATION_DEFAULT;
+SensorCalibration intakeTempCalibration = IAT_CALIBRATION_DEFAULT;
+SensorCalibration supplyCalibration = SUPPLY_CALIBRATION_DEFAULT;
+CalibrationTable calibrationTables[SENSOR_CHANNEL_COUNT] = {};
+int supplyCompensation = 0;
+float supplyNominalVoltage = 13.5;
+float iatTrimStartC = 40.0;
+float iatTrimkPaPerC = 0.0;
+SolenoidCurve solenoidCurve = {0, 0.0, {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100}};
+FilterSettings filterSettings = {FILTER_ADAPTIVE_EMA, FILTER_CUTOFF_DEFAULT_HZ, FILTER_TRACKER_ALPHA_DEFAULT, FILTER_TRACKER_BETA_DEFAULT};
+EstimatorSettings estimatorSettings = {0, ESTIMATOR_MEASUREMENT_NOISE_DEFAULT_KPA, ESTIMATOR_ACCEL_NOISE_DEFAULT};
+float overboostMarginkPa = OVERBOOST_MARGIN_DEFAULT_KPA;
+int sensorFaultCheck = 1;
+float sensorFailsafePercent = SENSOR_FAILSAFE_DEFAULT_PERCENT;
+int overshootLimiter = 0;
+float overshootLeadMs = 200.0;
+float overshootSpankPa = 10.0;
+float overshootFloorPercent = 0.0;
@@ -0,0 +1,30 @@
+#include "heap_guard.h"
+
+//================================================================================
+// HEAP GUARD
+//================================================================================
+void heapGuardInit(HeapGuard& guard) {
+    guard.armed = false;
+    guard.abortOnAllocation = false;
+    guard.allocations = 0;
+    guard.bytes = 0;
+    guard.largest = 0;
+}
+
+void heapGuardArm(HeapGuard& guard, bool abortOnAllocation) {
+    heapGuardInit(guard);
+    guard.abortOnAllocation = abortOnAllocation;
+    guard.armed = true;
+}
+
+void heapGuardDisarm(HeapGuard& guard) {
+    guard.armed = false;
+}
+
+bool heapGuardRecord(HeapGuard& guard, size_t size) {
+    if (!guard.armed) return false;
+    guard.allocations++;
+    guard.bytes += (uint32_t)size;
+    if (size > guard.largest) guard.largest = (uint32_t)size;
+    return guard.abortOnAllocation;
+}
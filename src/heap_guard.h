@@ -0,0 +1,49 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//================================================================================
+// HEAP GUARD
+//================================================================================
+// Once setup() has finished, nothing in the firmware allocates: the tasks,
+// their stacks and the mutexes are static, the control state is fixed-size
+// (boostEventData holds MAX_BOOST_EVENT_SAMPLES), the display draws from char
+// buffers rather than String, and the serial console formats into a static
+// buffer where Print::printf would allocate for lines over 64 bytes.
+//
+// Built with -DBOOST_HEAP_GUARD and the --wrap linker flags in platformio.ini,
+// heap_hook.cpp routes every malloc, calloc and realloc (so every new and
+// String) and every heap_caps_ allocation through heapGuardRecord(). setup()
+// arms it as it returns; from then on each allocation is counted, with its
+// size, for the serial command "heap". With -DBOOST_HEAP_GUARD_ABORT as well,
+// the first one aborts, and the panic backtrace shows who made it.
+//
+// The framework still allocates on its own behalf: saving settings commits
+// the EEPROM through NVS, and newlib sets up a task's number-conversion
+// buffers the first time that task prints a float. The count shows those
+// too, so leave abort mode to a bench run that does not save.
+//
+// Hardware independent; tools/heap wraps the host's allocator the same way
+// and runs a whole drive cycle through the control path with it armed.
+
+struct HeapGuard {
+    bool armed;
+    bool abortOnAllocation;
+    uint32_t allocations;      // since armed
+    uint32_t bytes;
+    uint32_t largest;
+};
+
+void heapGuardInit(HeapGuard& guard);
+void heapGuardArm(HeapGuard& guard, bool abortOnAllocation);
+void heapGuardDisarm(HeapGuard& guard);
+// One allocation of size bytes; returns true when the caller must abort.
+bool heapGuardRecord(HeapGuard& guard, size_t size);
+
+// Firmware (heap_hook.cpp): whether the hook is built in, and its counts.
+bool heapGuardSnapshot(HeapGuard& snapshot);
+void heapGuardArmAfterSetup();
+
+#endif // HEAP_GUARD_H
@@ -0,0 +1,91 @@
+#include "definitions.h"
+
+//================================================================================
+// HEAP ALLOCATION HOOK
+//================================================================================
+// See heap_guard.h. The linker's --wrap sends every call to these allocators,
+// from this firmware and from the framework's libraries alike, to the
+// __wrap_ versions here, which count it and call the real one. malloc() in
+// ESP-IDF goes to heap_caps_malloc_default() rather than heap_caps_malloc(),
+// so nothing is counted twice. free() is not wrapped.
+
+#ifdef BOOST_HEAP_GUARD
+
+static HeapGuard guard;
+static portMUX_TYPE guardLock = portMUX_INITIALIZER_UNLOCKED;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_heap_caps_malloc(size_t size, uint32_t caps);
+void* __real_heap_caps_calloc(size_t count, size_t size, uint32_t caps);
+void* __real_heap_caps_realloc(void* ptr, size_t size, uint32_t caps);
+}
+
+// Safe from an interrupt as well as a task.
+static void record(size_t size) {
+    portENTER_CRITICAL_SAFE(&guardLock);
+    bool stop = heapGuardRecord(guard, size);
+    portEXIT_CRITICAL_SAFE(&guardLock);
+    if (stop) abort();
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    record(size);
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+    record(count * size);
+    return __real_calloc(count, size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    record(size);
+    return __real_realloc(ptr, size);
+}
+
+extern "C" void* __wrap_heap_caps_malloc(size_t size, uint32_t caps) {
+    record(size);
+    return __real_heap_caps_malloc(size, caps);
+}
+
+extern "C" void* __wrap_heap_caps_calloc(size_t count, size_t size, uint32_t caps) {
+    record(count * size);
+    return __real_heap_caps_calloc(count, size, caps);
+}
+
+extern "C" void* __wrap_heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+    record(size);
+    return __real_heap_caps_realloc(ptr, size, caps);
+}
+
+void heapGuardArmAfterSetup() {
+#ifdef BOOST_HEAP_GUARD_ABORT
+    const bool abortOnAllocation = true;
+#else
+    const bool abortOnAllocation = false;
+#endif
+    portENTER_CRITICAL(&guardLock);
+    heapGuardArm(guard, abortOnAllocation);
+    portEXIT_CRITICAL(&guardLock);
+}
+
+bool heapGuardSnapshot(HeapGuard& snapshot) {
+    portENTER_CRITICAL(&guardLock);
+    snapshot = guard;
+    portEXIT_CRITICAL(&guardLock);
+    return true;
+}
+
+#else
+
+void heapGuardArmAfterSetup() {}
+
+bool heapGuardSnapshot(HeapGuard& snapshot) {
+    heapGuardInit(snapshot);
+    return false;
+}
+
+#endif
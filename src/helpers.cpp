@@ -2,10 +2,8 @@
 #include "config.h"
 
 void calculateScaledVoltages() {
-    float dividerRatio = R2_OHMS / (R1_OHMS + R2_OHMS);
-    minSensorVoltage = RAW_MIN_SENSOR_VOLTAGE * dividerRatio;
-    maxSensorVoltage = RAW_MAX_SENSOR_VOLTAGE * dividerRatio;
-    scaledVoltageOffset = RAW_VOLTAGE_OFFSET * dividerRatio;
+    scaleSensorVoltages(RAW_MIN_SENSOR_VOLTAGE, RAW_MAX_SENSOR_VOLTAGE, RAW_VOLTAGE_OFFSET,
+                        minSensorVoltage, maxSensorVoltage, scaledVoltageOffset);
 }
 
 void calibrateTouchSensors() {
@@ -38,24 +36,73 @@ void calibrateTouchSensors() {
         }
         delay(10);
     }
-    for (int i = 0; i < 6; i++) { touchCalibrationValues[i] = touch_sum[i] / samples;
+    // The control task is already running and reads the first pad's value for
+    // the light sleep touch wake.
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        for (int i = 0; i < 6; i++) { touchCalibrationValues[i] = touch_sum[i] / samples;
+        }
+        touchCalibrated = true;
+        xSemaphoreGive(dataMutex);
     }
     display.clearDisplay(); drawCenteredString("Calibration Complete!", (SCREEN_HEIGHT / 2) - 4); display.display();
     delay(1000);
 }
 
-float readOversampledVoltage() {
-    uint32_t total_adc_value = 0;
-    int oversample_count_local = OVERSAMPLE_COUNT;
-    for (int i = 0; i < oversample_count_local; i++) {
-        total_adc_value += analogRead(PRESSURE_SENSOR_PIN);
-    }
-    float avg_adc_value = (float)total_adc_value / oversample_count_local;
-    return (avg_adc_value / 4095.0) * 3.3;
-}
-
-float fmap(float x, float in_min, float in_max, float out_min, float out_max) {
-    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+void fillControlParams(ControlParams& params) {
+    params.kp = kp; params.ki = ki; params.kd = kd;
+    params.maxIntegral = maxIntegral;
+    params.PID_Control_Overhead = PID_Control_Overhead;
+    params.pidTriggerkPa = pidTriggerkPa;
+    params.slow_ema_a = slow_ema_a;
+    params.fast_ema_a = fast_ema_a;
+    params.kpa_rate_change_threshold = kpa_rate_change_threshold;
+    params.kpa_rate_time_interval_ms = kpa_rate_time_interval_ms;
+    params.filter = filterSettings;
+    params.estimator = estimatorSettings;
+    params.output_ema_a = output_ema_a;
+    params.IDLE_TIMEOUT_SECONDS = IDLE_TIMEOUT_SECONDS;
+    params.minSensorVoltage = minSensorVoltage;
+    params.maxSensorVoltage = maxSensorVoltage;
+    params.scaledVoltageOffset = scaledVoltageOffset;
+    params.MIN_KPA = MIN_KPA;
+    params.MAX_KPA = MAX_KPA;
+    params.PRESSURE_CORRECTION_KPA = PRESSURE_CORRECTION_KPA;
+    params.torqueScoreCutoffMs = torqueScoreCutoffMs;
+    params.sysidForgetting = SYSID_DEFAULT_FORGETTING;
+    params.sysidDelayTicks = SYSID_DEFAULT_DELAY_TICKS;
+    params.adaptiveGains = adaptiveGainsEnabled != 0;
+    params.nominalPlantGain = nominalPlantGain;
+    params.derivativeFilterMs = pidDerivativeFilterMs;
+    params.setpointWeightP = pidSetpointWeight;
+    params.derivativeOnMeasurement = pidDerivativeOnMeasurement != 0;
+    params.antiWindupMode = pidAntiWindupMode;
+    params.bumplessTransfer = pidBumplessTransfer != 0;
+    params.feedForwardEnabled = feedForwardEnabled != 0;
+    params.gainSchedule = gainSchedule;
+    params.setpointProfile = setpointProfile;
+    params.overshootLimiter = overshootLimiter != 0;
+    params.overshootLeadMs = overshootLeadMs;
+    params.overshootSpankPa = overshootSpankPa;
+    params.overshootFloorPercent = overshootFloorPercent;
+    params.rpm.enabled = rpmInputEnabled != 0;
+    params.rpm.pulsesPerRev = rpmPulsesPerRev;
+    params.rpm.speedPulsesPerKm = speedPulsesPerKm;
+    params.rpm.gearCount = gearCount;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) params.rpm.gearRpmPerKph[g] = gearRpmPerKph[g];
+    params.boostMap = boostMap;
+    params.backpressure = backpressureCalibration;
+    params.intakeTemp = intakeTempCalibration;
+    params.supply = supplyCalibration;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) params.calibration[c] = calibrationTables[c];
+    params.supplyCompensation = supplyCompensation != 0;
+    params.supplyNominalVoltage = supplyNominalVoltage;
+    params.iatTrimStartC = iatTrimStartC;
+    params.iatTrimkPaPerC = iatTrimkPaPerC;
+    params.valveFrequencyHz = valveFrequencyHz;
+    params.solenoidCurve = solenoidCurve;
+    params.overboostMarginkPa = overboostMarginkPa;
+    params.sensorFaultCheck = sensorFaultCheck != 0;
+    params.sensorFailsafePercent = sensorFailsafePercent;
 }
 
 bool isPresetDataValid(const ControllerPreset& preset) {
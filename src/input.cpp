@@ -93,8 +93,10 @@ void handleTouchInputs() {
                         peakHoldkPa = pressurekPa; 
                         spoolScore = 0.0;
                         torqueScore = 0.0;
+                        sensorFaultClearRequested = true;
                         xSemaphoreGive(dataMutex);
                     }
+                    overboostGuardClear();
                     lastInstantActionTime = millis();
                     displayNeedsUpdate = true;
                 }
@@ -185,13 +187,14 @@ void handleTouchInputs() {
             if (millis() - lastInstantActionTime > DEBOUNCE_DELAY) {
                 if (rawReadings[2] > (touchCalibrationValues[2] + TOUCH_SENSITIVITY_OFFSET)) { configMenuIndex = max(0, configMenuIndex - 1);
                 lastInstantActionTime = millis(); displayNeedsUpdate = true; } 
-                else if (rawReadings[3] > (touchCalibrationValues[3] + TOUCH_SENSITIVITY_OFFSET)) { configMenuIndex = min(2, configMenuIndex + 1);
+                else if (rawReadings[3] > (touchCalibrationValues[3] + TOUCH_SENSITIVITY_OFFSET)) { configMenuIndex = min(3, configMenuIndex + 1);
                 lastInstantActionTime = millis(); displayNeedsUpdate = true; } 
                 else if (rawReadings[5] > (touchCalibrationValues[5] + TOUCH_SENSITIVITY_OFFSET)) {
                     menuScrollOffset = 0;
                     if (configMenuIndex == 0) currentScreen = PID_TUNING_MENU;
                     else if (configMenuIndex == 1) currentScreen = MAP_SENSOR_MENU;
                     else if (configMenuIndex == 2) currentScreen = FILTERING_MISC_MENU;
+                    else if (configMenuIndex == 3) currentScreen = AUTOTUNE_SCREEN;
                     lastInstantActionTime = millis(); displayNeedsUpdate = true;
                 }
                 else if (rawReadings[0] > (touchCalibrationValues[0] + TOUCH_SENSITIVITY_OFFSET)) {
@@ -282,14 +285,18 @@ void handleTouchInputs() {
                 } else { holdCount = 0;
                 }
                 
-                if (tempEditValue < 0 && currentEditingValuePtr != &RAW_VOLTAGE_OFFSET && currentEditingValuePtr != &PRESSURE_CORRECTION_KPA) { tempEditValue = 0;
+                if (tempEditValue < 0 && currentEditingValuePtr != &RAW_VOLTAGE_OFFSET && currentEditingValuePtr != &PRESSURE_CORRECTION_KPA &&
+                    currentEditingValuePtr != &intakeTempCalibration.minValue && currentEditingValuePtr != &iatTrimStartC) { tempEditValue = 0;
                 }
                 
                 if (rawReadings[5] > (touchCalibrationValues[5] + TOUCH_SENSITIVITY_OFFSET)) {
                     if (millis() - lastInstantActionTime > DEBOUNCE_DELAY) {
-                        if(currentEditingType == P_FLOAT) *(float*)currentEditingValuePtr = tempEditValue;
-                        else if(currentEditingType == P_INT) *(int*)currentEditingValuePtr = (int)tempEditValue;
-                        else *(unsigned long*)currentEditingValuePtr = (unsigned long)tempEditValue;
+                        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                            if(currentEditingType == P_FLOAT) *(float*)currentEditingValuePtr = tempEditValue;
+                            else if(currentEditingType == P_INT) *(int*)currentEditingValuePtr = (int)tempEditValue;
+                            else *(unsigned long*)currentEditingValuePtr = (unsigned long)tempEditValue;
+                            xSemaphoreGive(dataMutex);
+                        }
                         currentScreen = lastMenuScreen;
                         if(currentScreen == PID_TUNING_MENU) pidMenuIndex = lastMenuIndex;
                         else if(currentScreen == MAP_SENSOR_MENU) mapMenuIndex = lastMenuIndex;
@@ -345,6 +352,71 @@ void handleTouchInputs() {
                 saveBHoldStart = 0;
             }
             break;
+        case AUTOTUNE_SCREEN:
+            {
+                AutotunePhase phase = AUTOTUNE_IDLE;
+                if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) { phase = autotuner.phase; xSemaphoreGive(dataMutex); }
+                bool running = (phase == AUTOTUNE_WAITING || phase == AUTOTUNE_RELAY);
+
+                if (millis() - lastInstantActionTime > DEBOUNCE_DELAY) {
+                    if (rawReadings[0] > (touchCalibrationValues[0] + TOUCH_SENSITIVITY_OFFSET)) {
+                        // Leaving the screen never leaves the relay running unattended.
+                        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) { autotuneAbort(autotuner, AUTOTUNE_ABORT_USER); xSemaphoreGive(dataMutex); }
+                        currentScreen = CONFIG_MENU;
+                        lastInstantActionTime = millis(); displayNeedsUpdate = true;
+                    } else if (!running && rawReadings[2] > (touchCalibrationValues[2] + TOUCH_SENSITIVITY_OFFSET)) {
+                        autotuneRule = (AutotuneRule)((autotuneRule + AUTOTUNE_RULE_COUNT - 1) % AUTOTUNE_RULE_COUNT);
+                        lastInstantActionTime = millis(); displayNeedsUpdate = true;
+                    } else if (!running && rawReadings[3] > (touchCalibrationValues[3] + TOUCH_SENSITIVITY_OFFSET)) {
+                        autotuneRule = (AutotuneRule)((autotuneRule + 1) % AUTOTUNE_RULE_COUNT);
+                        lastInstantActionTime = millis(); displayNeedsUpdate = true;
+                    } else if (rawReadings[5] > (touchCalibrationValues[5] + TOUCH_SENSITIVITY_OFFSET)) {
+                        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                            if (running) {
+                                autotuneAbort(autotuner, AUTOTUNE_ABORT_USER);
+                            } else {
+                                AutotuneConfig config;
+                                config.relayHighPercent = AUTOTUNE_RELAY_HIGH_PERCENT;
+                                config.relayLowPercent = AUTOTUNE_RELAY_LOW_PERCENT;
+                                config.hysteresiskPa = AUTOTUNE_HYSTERESIS_KPA;
+                                config.overshootLimitkPa = AUTOTUNE_OVERSHOOT_LIMIT_KPA;
+                                config.liftDropkPa = AUTOTUNE_LIFT_DROP_KPA;
+                                config.timeoutMs = AUTOTUNE_TIMEOUT_MS;
+                                config.cyclesRequired = AUTOTUNE_CYCLES;
+                                config.rule = autotuneRule;
+                                autotuneStart(autotuner, config);
+                            }
+                            xSemaphoreGive(dataMutex);
+                        }
+                        lastInstantActionTime = millis(); displayNeedsUpdate = true;
+                    }
+                }
+
+                // Save A / Save B: apply the suggested gains and store them in a profile
+                if (phase == AUTOTUNE_DONE) {
+                    for (int p = 0; p < 2; p++) {
+                        int button = (p == 0) ? 1 : 4;
+                        unsigned long* holdStart = (p == 0) ? &saveAHoldStart : &saveBHoldStart;
+                        if (rawReadings[button] > (touchCalibrationValues[button] + TOUCH_SENSITIVITY_OFFSET)) {
+                            if (*holdStart == 0) *holdStart = millis();
+                            else if (millis() - *holdStart > SAVE_RESET_HOLD_TIME_MS) {
+                                if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                                    kp = autotuner.result.kp; ki = autotuner.result.ki; kd = autotuner.result.kd;
+                                    autotuner.phase = AUTOTUNE_IDLE;
+                                    xSemaphoreGive(dataMutex);
+                                }
+                                saveCurrentConfigToProfile(p);
+                                *holdStart = 0;
+                                waitForRelease = true;
+                            }
+                        } else {
+                            if (*holdStart != 0) displayNeedsUpdate = true;
+                            *holdStart = 0;
+                        }
+                    }
+                }
+            }
+            break;
         case INFO_SCREEN:
             break;
         case CONFIRMATION_SCREEN:
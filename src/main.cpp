@@ -3,52 +3,49 @@
 #include "config.h"
 
 //================================================================================
-// SETUP (Core 1)
+// BOOT STAGES
 //================================================================================
-void setup() {
-    Serial.begin(115200);
-    
-    Wire.begin(OLED_SDA, OLED_SCK);
-    Wire.setClock(400000);
+// See boot.h. The critical stages bring the solenoid under control; the
+// background stages run after the control task has started.
 
-    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-        Serial.println(F("SSD1306 allocation failed"));
-        for (;;);
-    }
-    
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-    display.setTextSize(1);
-    
-    display.ssd1306_command(SSD1306_SETCONTRAST);
-    display.ssd1306_command(DISPLAY_BRIGHTNESS);
-    
-    calibrateTouchSensors();
-    
-    pinMode(TOUCH_PIN_6, INPUT);
-    unsigned long startTime = millis();
-    bool manualResetRequested = true; 
+// Both tasks, their stacks and the data mutex are static, so nothing is left
+// on the heap that could fragment it (heap_guard.h).
+// The tasks keep their large structs (ControlParams, calibration tables)
+// static too, off these stacks; the `heap` command prints each one's headroom.
+static const uint32_t TASK_STACK_BYTES = 4096;   // StackType_t is a byte on the ESP32
+static StackType_t pidControlStack[TASK_STACK_BYTES];
+static StaticTask_t pidControlTaskBuffer;
+static StackType_t displayAndInputStack[TASK_STACK_BYTES];
+static StaticTask_t displayAndInputTaskBuffer;
+static StaticSemaphore_t dataMutexBuffer;
 
-    while (millis() - startTime < 3000) {
-        if (touchRead(TOUCH_PIN_6) < (touchCalibrationValues[5] + TOUCH_SENSITIVITY_OFFSET)) {
-            manualResetRequested = false; 
-            break;
-        }
-        delay(50); 
-    }
+static uint32_t bootMicros(void*) {
+    return micros();
+}
 
-    if (manualResetRequested) {
-        drawCenteredString("FACTORY RESET...", SCREEN_HEIGHT / 2);
-        display.display();
-        EEPROM.begin(EEPROM_SIZE);
-        initializeDefaultParameters();
-        delay(2000); 
+static void loadPresetScores() {
+    ControllerPreset tempPreset;
+    EEPROM.get(ADDR_PRESET_1, tempPreset);
+    if (isPresetDataValid(tempPreset)) {
+        spoolScoreA = tempPreset.spoolScore;
+        torqueScoreA = tempPreset.torqueScore;
     }
-
-    if (!manualResetRequested) { 
-        EEPROM.begin(EEPROM_SIZE);
+    EEPROM.get(ADDR_PRESET_2, tempPreset);
+    if (isPresetDataValid(tempPreset)) {
+        spoolScoreB = tempPreset.spoolScore;
+        torqueScoreB = tempPreset.torqueScore;
     }
+}
+
+static bool bootOutputs(void*) {
+    pinMode(SOLENOID_PIN, OUTPUT);
+    digitalWrite(SOLENOID_PIN, LOW);
+    Serial.begin(115200);
+    return true;
+}
 
+static bool bootParameters(void*) {
+    EEPROM.begin(EEPROM_SIZE);
     if (EEPROM.read(ADDR_INITIALIZED) != 'V') {
         initializeDefaultParameters();
     } else {
@@ -60,6 +57,7 @@ void setup() {
             EEPROM.get(ADDR_PRESET_1 + (lastActivePreset * sizeof(ControllerPreset)), presetToLoad);
             if (isPresetDataValid(presetToLoad)) {
                 copyPresetToGlobals(presetToLoad);
+                loadPresetTables(lastActivePreset);
                 activePresetIndex = lastActivePreset;
                 activeProfile = (lastActivePreset == 0) ? 'A' : 'B';
             } else {
@@ -69,35 +67,114 @@ void setup() {
             activePresetIndex = -1;
         }
     }
-    
+
     // Load scores for display
-    ControllerPreset tempPreset;
-    EEPROM.get(ADDR_PRESET_1, tempPreset);
-    if (isPresetDataValid(tempPreset)) {
-        spoolScoreA = tempPreset.spoolScore;
-        torqueScoreA = tempPreset.torqueScore;
-    }
-    EEPROM.get(ADDR_PRESET_2, tempPreset);
-    if (isPresetDataValid(tempPreset)) {
-        spoolScoreB = tempPreset.spoolScore;
-        torqueScoreB = tempPreset.torqueScore;
-    }
-    
-    peakHoldkPa = 100.0f;
+    loadPresetScores();
 
+    peakHoldkPa = 100.0f;
     calculateScaledVoltages();
-    pinMode(SOLENOID_PIN, OUTPUT);
-    digitalWrite(SOLENOID_PIN, LOW);
-    analogReadResolution(12);
+    return true;
+}
 
-    dataMutex = xSemaphoreCreateMutex();
+static bool bootSensors(void*) {
+    beginPowerManagement();
+    beginSensorScan();
+    beginPulseCounters();
+    beginOverboostGuard();
+    return true;
+}
+
+static bool bootControl(void*) {
+    dataMutex = xSemaphoreCreateMutexStatic(&dataMutexBuffer);
     if (dataMutex == NULL) {
         Serial.println("Mutex creation failed!");
+        return false;
+    }
+    pidControlTaskHandle = xTaskCreateStaticPinnedToCore(pidControlTask, "PID Control", TASK_STACK_BYTES, NULL, 2,
+                                                         pidControlStack, &pidControlTaskBuffer, 0);
+    return pidControlTaskHandle != NULL;
+}
+
+// A failure here leaves the control task running without a display or the
+// interface task.
+static bool bootDisplay(void*) {
+    Wire.begin(OLED_SDA, OLED_SCK);
+    Wire.setClock(400000);
+
+    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+        Serial.println(F("SSD1306 allocation failed"));
+        return false;
     }
 
-    xTaskCreatePinnedToCore(pidControlTask, "PID Control", 4096, NULL, 2, &pidControlTaskHandle, 0);
-    xTaskCreatePinnedToCore(displayAndInputTask, "Display & Input", 4096, NULL, 1, &displayAndInputTaskHandle, 1);
+    display.clearDisplay();
+    display.setTextColor(SSD1306_WHITE);
+    display.setTextSize(1);
+
+    display.ssd1306_command(SSD1306_SETCONTRAST);
+    display.ssd1306_command(DISPLAY_BRIGHTNESS);
+    return true;
+}
+
+static bool bootTouch(void*) {
+    calibrateTouchSensors();
+    return true;
+}
+
+// CLR held for the whole window restores the defaults. The control task is
+// already running on the saved parameters, so they are replaced under the
+// mutex and the learned feed-forward map it holds is cleared with them.
+static bool bootResetWindow(void*) {
+    pinMode(TOUCH_PIN_6, INPUT);
+    unsigned long startTime = millis();
+    bool manualResetRequested = true;
+
+    while (millis() - startTime < 3000) {
+        if (touchRead(TOUCH_PIN_6) < (touchCalibrationValues[5] + TOUCH_SENSITIVITY_OFFSET)) {
+            manualResetRequested = false;
+            break;
+        }
+        delay(50);
+    }
+
+    if (manualResetRequested) {
+        drawCenteredString("FACTORY RESET...", SCREEN_HEIGHT / 2);
+        display.display();
+        if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            initializeDefaultParameters();
+            loadPresetScores();
+            calculateScaledVoltages();
+            feedForwardClearRequested = true;
+            xSemaphoreGive(dataMutex);
+        }
+        delay(2000);
+    }
+    return true;
+}
+
+static bool bootInterface(void*) {
+    displayAndInputTaskHandle = xTaskCreateStaticPinnedToCore(displayAndInputTask, "Display & Input", TASK_STACK_BYTES, NULL, 1,
+                                                               displayAndInputStack, &displayAndInputTaskBuffer, 1);
+    return displayAndInputTaskHandle != NULL;
+}
+
+//================================================================================
+// SETUP (Core 1)
+//================================================================================
+void setup() {
+    BootSteps steps = {NULL, bootMicros, {bootOutputs, bootParameters, bootSensors, bootControl,
+                                          bootDisplay, bootTouch, bootResetWindow, bootInterface}};
+    bootLogInit(bootLog);
+    bootRunCritical(bootLog, steps);
+    if (bootLog.status[BOOT_CONTROL] == BOOT_DONE) {
+        // Core 1 from here on, alongside the control task on core 0.
+        bootRunBackground(bootLog, steps);
+    }
+    Serial.printf("Boot: control at %.1f ms, done at %.1f ms\n",
+                  (double)(bootLog.endUs[BOOT_CONTROL] * 0.001f),
+                  (double)(bootLog.endUs[bootLog.order[bootLog.ran - 1]] * 0.001f));
 
+    // Everything from here on runs without allocating.
+    heapGuardArmAfterSetup();
     vTaskDelete(NULL);
 }
 
@@ -0,0 +1,40 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+//================================================================================
+// SINGLE-PRECISION NUMERIC KERNEL
+//================================================================================
+// The ESP32-S3 FPU does single precision only; every double operand (a bare
+// 1000.0, a float passed to a double parameter) becomes a software library
+// call. The control path is kept in float: constants here are float and
+// constexpr, divisions by a constant are multiplications by its reciprocal,
+// and a linear calibration is reduced to a slope and offset once instead of a
+// division per reading.
+//
+// Each control-path translation unit starts with
+//   #pragma GCC diagnostic error "-Wdouble-promotion"
+// so a stray promotion there fails the build, on the host tools as on the
+// target.
+
+constexpr float MS_PER_SECOND = 1000.0f;
+constexpr float SECONDS_PER_MS = 1.0f / MS_PER_SECOND;
+
+// y = x * slope + offset
+struct LinearMap {
+    float slope;
+    float offset;
+};
+
+// The line through (inMin, outMin) and (inMax, outMax); inMin != inMax.
+inline LinearMap linearMapThrough(float inMin, float inMax, float outMin, float outMax) {
+    LinearMap map;
+    map.slope = (outMax - outMin) / (inMax - inMin);
+    map.offset = outMin - inMin * map.slope;
+    return map;
+}
+
+inline float linearMapApply(const LinearMap& map, float x) {
+    return x * map.slope + map.offset;
+}
+
+#endif // NUMERIC_H
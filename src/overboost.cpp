@@ -0,0 +1,65 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "overboost.h"
+
+void overboostInit(OverboostMonitor& monitor) {
+    monitor.tripped = false;
+    monitor.overChecks = 0;
+    monitor.firstOverUs = 0;
+    monitor.checks = 0;
+    monitor.lastCheckUs = 0;
+    monitor.maxGapUs = 0;
+    monitor.maxCheckUs = 0;
+    monitor.trips = 0;
+    monitor.tripUs = 0;
+    monitor.tripkPa = 0;
+    monitor.tripCeilingkPa = 0;
+    monitor.latencyUs = 0;
+    monitor.peakkPa = 0;
+}
+
+float overboostPressure(const OverboostLimit& limit, float pinVoltage) {
+    return limit.kPaAtZeroVolts + limit.kPaPerVolt * pinVoltage;
+}
+
+bool overboostCheck(OverboostMonitor& monitor, const OverboostLimit& limit, float pinVoltage, uint32_t nowUs) {
+    if (monitor.checks > 0) {
+        uint32_t gap = nowUs - monitor.lastCheckUs;
+        if (gap > monitor.maxGapUs) monitor.maxGapUs = gap;
+    }
+    monitor.checks++;
+    monitor.lastCheckUs = nowUs;
+
+    float pressure = overboostPressure(limit, pinVoltage);
+    if (monitor.tripped) {
+        if (pressure > monitor.peakkPa) monitor.peakkPa = pressure;
+        return true;
+    }
+    if (limit.ceilingkPa <= 0.0f || pressure < limit.ceilingkPa) {
+        monitor.overChecks = 0;
+        return false;
+    }
+    if (monitor.overChecks == 0) monitor.firstOverUs = nowUs;
+    monitor.overChecks++;
+    if (monitor.overChecks < OVERBOOST_CONFIRM_CHECKS) return false;
+
+    monitor.tripped = true;
+    monitor.trips++;
+    monitor.tripUs = nowUs;
+    monitor.tripkPa = pressure;
+    monitor.tripCeilingkPa = limit.ceilingkPa;
+    monitor.peakkPa = pressure;
+    monitor.latencyUs = 0;
+    return true;
+}
+
+void overboostCheckDone(OverboostMonitor& monitor, uint32_t startUs, uint32_t endUs) {
+    uint32_t duration = endUs - startUs;
+    if (duration > monitor.maxCheckUs) monitor.maxCheckUs = duration;
+    if (monitor.tripped && monitor.tripUs == startUs) monitor.latencyUs = endUs - monitor.firstOverUs;
+}
+
+void overboostClear(OverboostMonitor& monitor) {
+    monitor.tripped = false;
+    monitor.overChecks = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef OVERBOOST_H
+#define OVERBOOST_H
+
+#include <stdint.h>
+
+//================================================================================
+// OVERBOOST CUT
+//================================================================================
+// A last line of defence that does not depend on the control task. The control
+// task runs every 10 ms but can stall for hundreds of milliseconds (score
+// calculation, EEPROM commits); with the solenoid held on through a stall the
+// turbo is free to make whatever boost the wastegate spring allows.
+//
+// The guard runs on its own timer every OVERBOOST_PERIOD_US, averages the
+// newest OVERBOOST_WINDOW MAP conversions straight from the ADC scan and
+// compares them with a ceiling the control task publishes each tick. After
+// OVERBOOST_CONFIRM_CHECKS consecutive readings at or over the ceiling it
+// forces the solenoid off (wastegate open) and latches until the user clears
+// it. A ceiling published before a stall stays in force through it.
+//
+// The guard only needs a straight line from pin voltage to kPa, so the limit
+// carries one rather than the whole sensor calibration.
+
+const float OVERBOOST_MARGIN_DEFAULT_KPA = 30.0;   // ceiling above the target; 0 = off
+const float OVERBOOST_MARGIN_MAX_KPA = 100.0;
+const uint32_t OVERBOOST_PERIOD_US = 500;
+const int OVERBOOST_WINDOW = 8;                    // MAP conversions averaged per check, 400 us at 20 kHz
+const uint32_t OVERBOOST_WINDOW_US = 400;
+const int OVERBOOST_CONFIRM_CHECKS = 2;            // a single-conversion spike is only ever in one window
+// Worst case from pressure crossing the ceiling to the pin going low: half the
+// averaging window before the average crosses, a period until the next check,
+// OVERBOOST_CONFIRM_CHECKS - 1 more to confirm, and as much again for timer
+// jitter and the check itself.
+const uint32_t OVERBOOST_LATENCY_BOUND_US =
+    OVERBOOST_WINDOW_US / 2 + OVERBOOST_CONFIRM_CHECKS * OVERBOOST_PERIOD_US + OVERBOOST_PERIOD_US;
+
+struct OverboostLimit {
+    float ceilingkPa;          // 0 = guard off
+    float kPaAtZeroVolts;      // pin voltage to kPa, the MAP calibration as a line
+    float kPaPerVolt;
+};
+
+struct OverboostMonitor {
+    bool tripped;              // latched until overboostClear()
+    int overChecks;            // consecutive checks at or over the ceiling
+    uint32_t firstOverUs;      // start of the first of those checks
+    uint32_t checks;
+    uint32_t lastCheckUs;
+    // -- Profiling: worst cases since power-up --
+    uint32_t maxGapUs;         // between checks; shows the guard being starved
+    uint32_t maxCheckUs;       // one check, reading the ADC to writing the pin
+    // -- Last trip --
+    uint32_t trips;
+    uint32_t tripUs;
+    float tripkPa;
+    float tripCeilingkPa;
+    uint32_t latencyUs;        // first reading over the ceiling to the pin going low
+    float peakkPa;             // highest reading while tripped
+};
+
+void overboostInit(OverboostMonitor& monitor);
+float overboostPressure(const OverboostLimit& limit, float pinVoltage);
+// One check at nowUs; returns true while the solenoid must be held off.
+bool overboostCheck(OverboostMonitor& monitor, const OverboostLimit& limit, float pinVoltage, uint32_t nowUs);
+// After the pin has been written; startUs is the nowUs passed to overboostCheck().
+void overboostCheckDone(OverboostMonitor& monitor, uint32_t startUs, uint32_t endUs);
+// Re-arms the guard; the last trip's details are kept for reporting.
+void overboostClear(OverboostMonitor& monitor);
+
+#endif // OVERBOOST_H
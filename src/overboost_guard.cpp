@@ -0,0 +1,104 @@
+#include "definitions.h"
+#include <esp_timer.h>
+
+//================================================================================
+// OVERBOOST GUARD (Core 1)
+//================================================================================
+// Runs overboostCheck() (overboost.h) every OVERBOOST_PERIOD_US. A periodic
+// esp_timer wakes the highest-priority task on the core the control task does
+// not use, so neither a stalled control task nor the UI can hold it back. The
+// MAP reading comes straight from the DMA scan (readRecentSensorVoltage()),
+// not from the control task's filtered pressure.
+//
+// Once tripped the guard writes the solenoid pin low on every check. The
+// control task also drives it low while the guard is tripped, so if it wrote
+// the pin high just before the trip, the pin is low again within one period.
+//
+// Nothing running from flash executes during a flash erase or write (EEPROM
+// commits), this task included; those happen after a pull, when the scores
+// are saved, when a sensor fault is logged, or from the menus.
+//
+// The timer stops while the board is idle (power.h): the solenoid is off and
+// the scan it reads is stopped too.
+
+static portMUX_TYPE guardLock = portMUX_INITIALIZER_UNLOCKED;
+static OverboostMonitor monitor;
+static OverboostLimit limit = {0.0, 0.0, 0.0};   // off until the control task publishes one
+static TaskHandle_t guardTaskHandle = NULL;
+static StackType_t guardStack[2048];
+static StaticTask_t guardTaskBuffer;
+static esp_timer_handle_t guardTimer = NULL;
+
+static void guardTimerCallback(void* arg) {
+    xTaskNotifyGive(guardTaskHandle);
+}
+
+static void overboostGuardTask(void* pvParameters) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t startUs = (uint32_t)esp_timer_get_time();
+        float voltage;
+        if (!readRecentSensorVoltage(SENSOR_MAP, OVERBOOST_WINDOW, voltage)) continue;
+        portENTER_CRITICAL(&guardLock);
+        bool cut = overboostCheck(monitor, limit, voltage, startUs);
+        portEXIT_CRITICAL(&guardLock);
+        if (cut) digitalWrite(SOLENOID_PIN, LOW);
+        uint32_t endUs = (uint32_t)esp_timer_get_time();
+        portENTER_CRITICAL(&guardLock);
+        overboostCheckDone(monitor, startUs, endUs);
+        portEXIT_CRITICAL(&guardLock);
+    }
+}
+
+uint32_t overboostGuardStackHeadroom() {
+    return guardTaskHandle ? (uint32_t)uxTaskGetStackHighWaterMark(guardTaskHandle) : 0;
+}
+
+void beginOverboostGuard() {
+    overboostInit(monitor);
+    guardTaskHandle = xTaskCreateStaticPinnedToCore(overboostGuardTask, "Overboost", sizeof(guardStack), NULL, configMAX_PRIORITIES - 1,
+                                                    guardStack, &guardTaskBuffer, 1);
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = guardTimerCallback;
+    timerArgs.name = "overboost";
+    esp_timer_create(&timerArgs, &guardTimer);
+    esp_timer_start_periodic(guardTimer, OVERBOOST_PERIOD_US);
+}
+
+void overboostGuardPause(bool paused) {
+    if (paused) {
+        esp_timer_stop(guardTimer);
+        return;
+    }
+    // The pause is not a starved guard, so the gap statistic restarts here.
+    portENTER_CRITICAL(&guardLock);
+    monitor.lastCheckUs = (uint32_t)esp_timer_get_time();
+    portEXIT_CRITICAL(&guardLock);
+    esp_timer_start_periodic(guardTimer, OVERBOOST_PERIOD_US);
+}
+
+void overboostGuardSetLimit(const OverboostLimit& newLimit) {
+    portENTER_CRITICAL(&guardLock);
+    limit = newLimit;
+    portEXIT_CRITICAL(&guardLock);
+}
+
+bool overboostGuardTripped() {
+    portENTER_CRITICAL(&guardLock);
+    bool tripped = monitor.tripped;
+    portEXIT_CRITICAL(&guardLock);
+    return tripped;
+}
+
+void overboostGuardClear() {
+    portENTER_CRITICAL(&guardLock);
+    overboostClear(monitor);
+    portEXIT_CRITICAL(&guardLock);
+}
+
+void overboostGuardSnapshot(OverboostMonitor& snapshot, OverboostLimit& currentLimit) {
+    portENTER_CRITICAL(&guardLock);
+    snapshot = monitor;
+    currentLimit = limit;
+    portEXIT_CRITICAL(&guardLock);
+}
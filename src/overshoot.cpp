@@ -0,0 +1,41 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "overshoot.h"
+#include "numeric.h"
+
+void overshootInit(OvershootPredictor& pred, float pressurekPa, float filterMs) {
+    pred.pressure = pressurekPa;
+    pred.slope = 0.0f;
+    pred.curvature = 0.0f;
+    pred.filterMs = filterMs;
+}
+
+void overshootUpdate(OvershootPredictor& pred, float pressurekPa, float dtMs) {
+    if (dtMs <= 0.0f) return;
+    float alpha = dtMs / (pred.filterMs + dtMs);
+    float perSecond = MS_PER_SECOND / dtMs;
+    float previousPressure = pred.pressure;
+    pred.pressure += (pressurekPa - pred.pressure) * alpha;
+    float slope = (pred.pressure - previousPressure) * perSecond;
+    float previousSlope = pred.slope;
+    pred.slope += (slope - pred.slope) * alpha;
+    float curvature = (pred.slope - previousSlope) * perSecond;
+    pred.curvature += (curvature - pred.curvature) * alpha;
+}
+
+float overshootForecast(const OvershootPredictor& pred, float leadMs) {
+    float t = leadMs * SECONDS_PER_MS;
+    float curvature = pred.curvature;
+    if (curvature > OVERSHOOT_MAX_CURVATURE) curvature = OVERSHOOT_MAX_CURVATURE;
+    if (curvature < -OVERSHOOT_MAX_CURVATURE) curvature = -OVERSHOOT_MAX_CURVATURE;
+    float lag = pred.filterMs * SECONDS_PER_MS;
+    return pred.pressure + pred.slope * (t + lag) + 0.5f * curvature * t * t;
+}
+
+float overshootDutyCeiling(float forecastkPa, float targetkPa, float spankPa, float floorFraction) {
+    float excess = forecastkPa - targetkPa;
+    if (excess <= 0.0f) return 1.0f;
+    if (spankPa <= 0.0f) return floorFraction;
+    float ceiling = 1.0f - excess / spankPa;
+    return ceiling < floorFraction ? floorFraction : ceiling;
+}
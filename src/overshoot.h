@@ -0,0 +1,34 @@
+#ifndef OVERSHOOT_H
+#define OVERSHOOT_H
+
+//================================================================================
+// PREDICTIVE OVERSHOOT LIMITER
+//================================================================================
+// Tracks the level, slope and curvature of the pressure through its own short
+// low-pass (the display/PID filter can lag by a second at the slow alpha) and
+// forecasts where it will be one wastegate response time ahead:
+//   p(t + T) = p + slope * (T + lag) + curvature * T^2 / 2
+// where lag is the low-pass delay on a ramp.
+// When the forecast crosses the target the duty ceiling is lowered before the
+// pressure gets there, linearly from full duty at no predicted excess down to
+// a floor at spankPa of predicted excess. Constant time per tick.
+
+// Curvature is a second difference of a noisy signal; the quadratic term is
+// bounded so a noise spike cannot dominate the forecast.
+const float OVERSHOOT_MAX_CURVATURE = 2000.0;   // kPa/s^2
+
+struct OvershootPredictor {
+    float pressure;            // filtered, kPa
+    float slope;               // filtered, kPa/s
+    float curvature;           // filtered, kPa/s^2
+    float filterMs;
+};
+
+// filterMs is the low-pass time constant applied to the level and both derivatives.
+void overshootInit(OvershootPredictor& pred, float pressurekPa, float filterMs);
+void overshootUpdate(OvershootPredictor& pred, float pressurekPa, float dtMs);
+float overshootForecast(const OvershootPredictor& pred, float leadMs);
+// Fraction (floor..1) of full duty allowed for a forecast against a target.
+float overshootDutyCeiling(float forecastkPa, float targetkPa, float spankPa, float floorFraction);
+
+#endif // OVERSHOOT_H
@@ -89,8 +89,11 @@ void loadPreset(int index) {
         sprintf(line1, "PROFILE %c BAD", (index == 0 ? 'A' : 'B'));
         showConfirmationScreen(line1, "RESET TO DEFAULTS", 2500, MAIN_SCREEN);
         
-        initializeDefaultParameters(); 
-        copyGlobalsToPreset(presetToLoad); 
+        if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            initializeDefaultParameters();
+            copyGlobalsToPreset(presetToLoad);
+            xSemaphoreGive(dataMutex);
+        }
         EEPROM.put(ADDR_PRESET_1 + (index * sizeof(ControllerPreset)), presetToLoad); 
         if (!EEPROM.commit()) {
             Serial.println("Preset fix commit failed");
@@ -98,7 +101,12 @@ void loadPreset(int index) {
         return; 
     }
 
-    copyPresetToGlobals(presetToLoad);
+    // The control task copies these every tick (fillControlParams()).
+    if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        copyPresetToGlobals(presetToLoad);
+        loadPresetTables(index);
+        xSemaphoreGive(dataMutex);
+    }
     activePresetIndex = index;
     EEPROM.put(ADDR_ACTIVE_PRESET, activePresetIndex);
     if (!EEPROM.commit()) {
@@ -123,6 +131,33 @@ void saveAllParameters() {
     EEPROM.put(ADDR_OVERSAMPLE_COUNT, OVERSAMPLE_COUNT); EEPROM.put(ADDR_SAVE_RESET_HOLD, SAVE_RESET_HOLD_TIME_MS);
     EEPROM.put(ADDR_EDIT_HOLD, EDIT_HOLD_TIME_MS); EEPROM.put(ADDR_IDLE_TIMEOUT, IDLE_TIMEOUT_SECONDS);
     EEPROM.put(ADDR_TS_CUTOFF, torqueScoreCutoffMs);
+    EEPROM.put(ADDR_ADAPTIVE_GAINS, adaptiveGainsEnabled); EEPROM.put(ADDR_NOMINAL_PLANT_GAIN, nominalPlantGain);
+    EEPROM.put(ADDR_PID_D_FILTER, pidDerivativeFilterMs); EEPROM.put(ADDR_PID_SP_WEIGHT, pidSetpointWeight);
+    EEPROM.put(ADDR_PID_D_ON_MEAS, pidDerivativeOnMeasurement); EEPROM.put(ADDR_PID_ANTI_WINDUP, pidAntiWindupMode);
+    EEPROM.put(ADDR_PID_BUMPLESS, pidBumplessTransfer); EEPROM.put(ADDR_FEEDFORWARD_ENABLED, feedForwardEnabled);
+    EEPROM.put(ADDR_OVERSHOOT_LIMITER, overshootLimiter); EEPROM.put(ADDR_OVERSHOOT_LEAD, overshootLeadMs);
+    EEPROM.put(ADDR_OVERSHOOT_SPAN, overshootSpankPa); EEPROM.put(ADDR_OVERSHOOT_FLOOR, overshootFloorPercent);
+    EEPROM.put(ADDR_GAIN_SCHEDULE, gainSchedule);
+    EEPROM.put(ADDR_SETPOINT_PROFILE, setpointProfile);
+    EEPROM.put(ADDR_RPM_INPUT_ENABLED, rpmInputEnabled); EEPROM.put(ADDR_RPM_PULSES_PER_REV, rpmPulsesPerRev);
+    EEPROM.put(ADDR_SPEED_PULSES_PER_KM, speedPulsesPerKm); EEPROM.put(ADDR_GEAR_COUNT, gearCount);
+    EEPROM.put(ADDR_GEAR_RATIOS, gearRpmPerKph);
+    EEPROM.put(ADDR_BOOST_MAP, boostMap);
+    EEPROM.put(ADDR_BACKPRESSURE_CALIBRATION, backpressureCalibration);
+    EEPROM.put(ADDR_IAT_CALIBRATION, intakeTempCalibration);
+    EEPROM.put(ADDR_SUPPLY_CALIBRATION, supplyCalibration);
+    EEPROM.put(ADDR_CALIBRATION_TABLES, calibrationTables);
+    EEPROM.put(ADDR_SUPPLY_COMPENSATION, supplyCompensation); EEPROM.put(ADDR_SUPPLY_NOMINAL_VOLTAGE, supplyNominalVoltage);
+    EEPROM.put(ADDR_IAT_TRIM_START, iatTrimStartC); EEPROM.put(ADDR_IAT_TRIM_RATE, iatTrimkPaPerC);
+    EEPROM.put(ADDR_OVERBOOST_MARGIN, overboostMarginkPa);
+    EEPROM.put(ADDR_SENSOR_FAULT_CHECK, sensorFaultCheck); EEPROM.put(ADDR_SENSOR_FAILSAFE, sensorFailsafePercent);
+    EEPROM.put(ADDR_SPIKE_REJECT_WINDOW, spikeRejectWindow);
+    EEPROM.put(ADDR_OVERSAMPLE_ADAPTIVE, oversampleAdaptive); EEPROM.put(ADDR_OVERSAMPLE_MIN, oversampleMinCount);
+    EEPROM.put(ADDR_ADC_CORRECTION, adcCorrectionEnabled);
+    EEPROM.put(ADDR_IDLE_POWER, idlePowerMode);
+    EEPROM.put(ADDR_SOLENOID_CURVE, solenoidCurve);
+    EEPROM.put(ADDR_FILTER_SETTINGS, filterSettings);
+    EEPROM.put(ADDR_ESTIMATOR_SETTINGS, estimatorSettings);
     if (!EEPROM.commit()) {
         Serial.println("EEPROM commit failed");
         showConfirmationScreen("EEPROM", "SAVE FAIL", 2000, MAIN_SCREEN);
@@ -145,6 +180,130 @@ void loadAllParameters() {
     if (torqueScoreCutoffMs < 0 || torqueScoreCutoffMs > 10000) {
         torqueScoreCutoffMs = defaultTorqueScoreCutoffMs;
     }
+    // The extended block reads as 0xFF on units saved before it existed.
+    EEPROM.get(ADDR_ADAPTIVE_GAINS, adaptiveGainsEnabled); EEPROM.get(ADDR_NOMINAL_PLANT_GAIN, nominalPlantGain);
+    if (adaptiveGainsEnabled != 0 && adaptiveGainsEnabled != 1) {
+        adaptiveGainsEnabled = 0;
+    }
+    if (isnan(nominalPlantGain) || isinf(nominalPlantGain) || nominalPlantGain <= 0) {
+        nominalPlantGain = 1.0;
+    }
+    EEPROM.get(ADDR_PID_D_FILTER, pidDerivativeFilterMs); EEPROM.get(ADDR_PID_SP_WEIGHT, pidSetpointWeight);
+    EEPROM.get(ADDR_PID_D_ON_MEAS, pidDerivativeOnMeasurement); EEPROM.get(ADDR_PID_ANTI_WINDUP, pidAntiWindupMode);
+    EEPROM.get(ADDR_PID_BUMPLESS, pidBumplessTransfer); EEPROM.get(ADDR_FEEDFORWARD_ENABLED, feedForwardEnabled);
+    if (isnan(pidDerivativeFilterMs) || isinf(pidDerivativeFilterMs) || pidDerivativeFilterMs < 0 || pidDerivativeFilterMs > 1000) {
+        pidDerivativeFilterMs = 0.0;
+    }
+    if (isnan(pidSetpointWeight) || isinf(pidSetpointWeight) || pidSetpointWeight < 0 || pidSetpointWeight > 1) {
+        pidSetpointWeight = 1.0;
+    }
+    if (pidDerivativeOnMeasurement != 0 && pidDerivativeOnMeasurement != 1) pidDerivativeOnMeasurement = 0;
+    if (pidAntiWindupMode < 0 || pidAntiWindupMode >= PID_ANTIWINDUP_COUNT) pidAntiWindupMode = PID_ANTIWINDUP_CLAMP;
+    if (pidBumplessTransfer != 0 && pidBumplessTransfer != 1) pidBumplessTransfer = 0;
+    if (feedForwardEnabled != 0 && feedForwardEnabled != 1) feedForwardEnabled = 0;
+    EEPROM.get(ADDR_OVERSHOOT_LIMITER, overshootLimiter); EEPROM.get(ADDR_OVERSHOOT_LEAD, overshootLeadMs);
+    EEPROM.get(ADDR_OVERSHOOT_SPAN, overshootSpankPa); EEPROM.get(ADDR_OVERSHOOT_FLOOR, overshootFloorPercent);
+    if (overshootLimiter != 0 && overshootLimiter != 1) overshootLimiter = 0;
+    if (isnan(overshootLeadMs) || isinf(overshootLeadMs) || overshootLeadMs < 0 || overshootLeadMs > 2000) {
+        overshootLeadMs = 200.0;
+    }
+    if (isnan(overshootSpankPa) || isinf(overshootSpankPa) || overshootSpankPa < 0 || overshootSpankPa > 100) {
+        overshootSpankPa = 10.0;
+    }
+    if (isnan(overshootFloorPercent) || isinf(overshootFloorPercent) || overshootFloorPercent < 0 || overshootFloorPercent > 100) {
+        overshootFloorPercent = 0.0;
+    }
+    EEPROM.get(ADDR_GAIN_SCHEDULE, gainSchedule);
+    if (!gainScheduleSanitize(gainSchedule)) {
+        Serial.println("Gain schedule reset");
+    }
+    EEPROM.get(ADDR_SETPOINT_PROFILE, setpointProfile);
+    if (!setpointProfileSanitize(setpointProfile)) {
+        Serial.println("Setpoint profile reset");
+    }
+    EEPROM.get(ADDR_RPM_INPUT_ENABLED, rpmInputEnabled); EEPROM.get(ADDR_RPM_PULSES_PER_REV, rpmPulsesPerRev);
+    EEPROM.get(ADDR_SPEED_PULSES_PER_KM, speedPulsesPerKm); EEPROM.get(ADDR_GEAR_COUNT, gearCount);
+    if (rpmInputEnabled != 0 && rpmInputEnabled != 1) rpmInputEnabled = 0;
+    if (isnan(rpmPulsesPerRev) || isinf(rpmPulsesPerRev) || rpmPulsesPerRev <= 0 || rpmPulsesPerRev > 64) {
+        rpmPulsesPerRev = 2.0;
+    }
+    if (isnan(speedPulsesPerKm) || isinf(speedPulsesPerKm) || speedPulsesPerKm < 0 || speedPulsesPerKm > 100000) {
+        speedPulsesPerKm = 0.0;
+    }
+    if (gearCount < 1 || gearCount > RPM_MAP_GEARS) gearCount = RPM_MAP_GEARS;
+    EEPROM.get(ADDR_GEAR_RATIOS, gearRpmPerKph);
+    for (int g = 0; g < RPM_MAP_GEARS; g++) {
+        if (isnan(gearRpmPerKph[g]) || isinf(gearRpmPerKph[g]) || gearRpmPerKph[g] < 0 || gearRpmPerKph[g] > 1000) {
+            gearRpmPerKph[g] = 0.0;
+        }
+    }
+    EEPROM.get(ADDR_BOOST_MAP, boostMap);
+    if (!boostMapSanitize(boostMap)) {
+        Serial.println("Boost map reset");
+    }
+    EEPROM.get(ADDR_BACKPRESSURE_CALIBRATION, backpressureCalibration);
+    EEPROM.get(ADDR_IAT_CALIBRATION, intakeTempCalibration);
+    EEPROM.get(ADDR_SUPPLY_CALIBRATION, supplyCalibration);
+    bool calibrationClean = sensorCalibrationSanitize(backpressureCalibration, BACKPRESSURE_CALIBRATION_DEFAULT);
+    calibrationClean = sensorCalibrationSanitize(intakeTempCalibration, IAT_CALIBRATION_DEFAULT) && calibrationClean;
+    calibrationClean = sensorCalibrationSanitize(supplyCalibration, SUPPLY_CALIBRATION_DEFAULT) && calibrationClean;
+    if (!calibrationClean) {
+        Serial.println("Sensor calibration reset");
+    }
+    EEPROM.get(ADDR_CALIBRATION_TABLES, calibrationTables);
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        if (!calibrationTableSanitize(calibrationTables[c])) Serial.printf("Calibration table %s reset\n", sensorChannelKey(c));
+    }
+    EEPROM.get(ADDR_SUPPLY_COMPENSATION, supplyCompensation); EEPROM.get(ADDR_SUPPLY_NOMINAL_VOLTAGE, supplyNominalVoltage);
+    EEPROM.get(ADDR_IAT_TRIM_START, iatTrimStartC); EEPROM.get(ADDR_IAT_TRIM_RATE, iatTrimkPaPerC);
+    if (supplyCompensation != 0 && supplyCompensation != 1) supplyCompensation = 0;
+    if (isnan(supplyNominalVoltage) || isinf(supplyNominalVoltage) || supplyNominalVoltage < SUPPLY_VALID_MIN_V || supplyNominalVoltage > 30) {
+        supplyNominalVoltage = 13.5;
+    }
+    if (isnan(iatTrimStartC) || isinf(iatTrimStartC) || iatTrimStartC < -40 || iatTrimStartC > 150) {
+        iatTrimStartC = 40.0;
+    }
+    if (isnan(iatTrimkPaPerC) || isinf(iatTrimkPaPerC) || iatTrimkPaPerC < 0 || iatTrimkPaPerC > 10) {
+        iatTrimkPaPerC = 0.0;
+    }
+    EEPROM.get(ADDR_OVERBOOST_MARGIN, overboostMarginkPa);
+    if (isnan(overboostMarginkPa) || isinf(overboostMarginkPa) || overboostMarginkPa < 0 || overboostMarginkPa > OVERBOOST_MARGIN_MAX_KPA) {
+        overboostMarginkPa = OVERBOOST_MARGIN_DEFAULT_KPA;
+    }
+    EEPROM.get(ADDR_SENSOR_FAULT_CHECK, sensorFaultCheck); EEPROM.get(ADDR_SENSOR_FAILSAFE, sensorFailsafePercent);
+    if (sensorFaultCheck != 0 && sensorFaultCheck != 1) sensorFaultCheck = 1;
+    EEPROM.get(ADDR_SPIKE_REJECT_WINDOW, spikeRejectWindow);
+    if (!spikeWindowValid(spikeRejectWindow)) spikeRejectWindow = SPIKE_WINDOW_DEFAULT;
+    EEPROM.get(ADDR_OVERSAMPLE_ADAPTIVE, oversampleAdaptive); EEPROM.get(ADDR_OVERSAMPLE_MIN, oversampleMinCount);
+    if (oversampleAdaptive != 0 && oversampleAdaptive != 1) oversampleAdaptive = 0;
+    if (oversampleMinCount < 1 || oversampleMinCount > SENSOR_AVERAGE_MAX) oversampleMinCount = OVERSAMPLE_MIN_DEFAULT;
+    EEPROM.get(ADDR_ADC_CORRECTION, adcCorrectionEnabled);
+    if (adcCorrectionEnabled != 0 && adcCorrectionEnabled != 1) adcCorrectionEnabled = 0;
+    EEPROM.get(ADDR_IDLE_POWER, idlePowerMode);
+    if (idlePowerMode < 0 || idlePowerMode >= POWER_SETTING_COUNT) idlePowerMode = POWER_SETTING_SCALING;
+    if (isnan(sensorFailsafePercent) || isinf(sensorFailsafePercent) || sensorFailsafePercent < 0 || sensorFailsafePercent > 100) {
+        sensorFailsafePercent = SENSOR_FAILSAFE_DEFAULT_PERCENT;
+    }
+    EEPROM.get(ADDR_SOLENOID_CURVE, solenoidCurve);
+    if (!solenoidCurveSanitize(solenoidCurve)) {
+        Serial.println("Solenoid curve reset");
+    }
+    EEPROM.get(ADDR_FILTER_SETTINGS, filterSettings);
+    if (!filterSettingsSanitize(filterSettings)) {
+        Serial.println("Filter settings reset");
+    }
+    EEPROM.get(ADDR_ESTIMATOR_SETTINGS, estimatorSettings);
+    if (!estimatorSettingsSanitize(estimatorSettings)) {
+        Serial.println("Estimator settings reset");
+    }
+    EEPROM.get(ADDR_FEEDFORWARD_TABLE, feedForwardTable);
+    if (!feedForwardSanitize(feedForwardTable)) {
+        Serial.println("Feed-forward map reset");
+    }
+    EEPROM.get(ADDR_SENSOR_FAULT_LOG, sensorFaultLog);
+    if (!sensorFaultLogSanitize(sensorFaultLog)) {
+        Serial.println("Sensor fault log reset");
+    }
 }
 
 void initializeDefaultParameters(){
@@ -160,7 +319,9 @@ void initializeDefaultParameters(){
     fast_ema_a = 0.3;
     kpa_rate_change_threshold = 10.0;
     kpa_rate_time_interval_ms = 50;
-    OVERSAMPLE_COUNT = 256;
+    filterSettingsReset(filterSettings);
+    estimatorSettingsReset(estimatorSettings);
+    OVERSAMPLE_COUNT = 64;
     IDLE_TIMEOUT_SECONDS = 60;
     RAW_MIN_SENSOR_VOLTAGE = 0.4;
     RAW_MAX_SENSOR_VOLTAGE = 4.65;
@@ -170,6 +331,47 @@ void initializeDefaultParameters(){
     PRESSURE_CORRECTION_KPA = 1.27;
     EDIT_HOLD_TIME_MS = 1000;
     SAVE_RESET_HOLD_TIME_MS = 1000;
+    adaptiveGainsEnabled = 0;
+    nominalPlantGain = 1.0;
+    pidDerivativeFilterMs = 0.0;
+    pidSetpointWeight = 1.0;
+    pidDerivativeOnMeasurement = 0;
+    pidAntiWindupMode = PID_ANTIWINDUP_CLAMP;
+    pidBumplessTransfer = 0;
+    feedForwardEnabled = 0;
+    feedForwardClear(feedForwardTable);
+    EEPROM.put(ADDR_FEEDFORWARD_TABLE, feedForwardTable);
+    gainScheduleReset(gainSchedule);
+    setpointProfileReset(setpointProfile);
+    rpmInputEnabled = 0;
+    rpmPulsesPerRev = 2.0;
+    speedPulsesPerKm = 0.0;
+    gearCount = RPM_MAP_GEARS;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) gearRpmPerKph[g] = 0.0;
+    boostMapReset(boostMap);
+    backpressureCalibration = BACKPRESSURE_CALIBRATION_DEFAULT;
+    intakeTempCalibration = IAT_CALIBRATION_DEFAULT;
+    supplyCalibration = SUPPLY_CALIBRATION_DEFAULT;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) calibrationTableReset(calibrationTables[c]);
+    supplyCompensation = 0;
+    supplyNominalVoltage = 13.5;
+    iatTrimStartC = 40.0;
+    iatTrimkPaPerC = 0.0;
+    solenoidCurveReset(solenoidCurve);
+    overboostMarginkPa = OVERBOOST_MARGIN_DEFAULT_KPA;
+    sensorFaultCheck = 1;
+    sensorFailsafePercent = SENSOR_FAILSAFE_DEFAULT_PERCENT;
+    spikeRejectWindow = SPIKE_WINDOW_DEFAULT;
+    oversampleAdaptive = 0;
+    oversampleMinCount = OVERSAMPLE_MIN_DEFAULT;
+    adcCorrectionEnabled = 0;
+    idlePowerMode = POWER_SETTING_SCALING;
+    sensorFaultLogClear(sensorFaultLog);
+    EEPROM.put(ADDR_SENSOR_FAULT_LOG, sensorFaultLog);
+    overshootLimiter = 0;
+    overshootLeadMs = 200.0;
+    overshootSpankPa = 10.0;
+    overshootFloorPercent = 0.0;
     
     saveAllParameters();
     
@@ -180,6 +382,7 @@ void initializeDefaultParameters(){
     for (int i = 0; i < 2; i++) {
         presets[i] = defaultPreset;
         EEPROM.put(ADDR_PRESET_1 + (i * sizeof(ControllerPreset)), presets[i]);
+        savePresetTables(i);
     }
     
     activePresetIndex = 0;
@@ -254,6 +457,7 @@ void saveCurrentConfigToProfile(int index) {
     }
 
     EEPROM.put(ADDR_PRESET_1 + (index * sizeof(ControllerPreset)), preset);
+    savePresetTables(index);
 
     if (!EEPROM.commit()) {
         Serial.println("Config save commit failed");
@@ -264,3 +468,86 @@ void saveCurrentConfigToProfile(int index) {
         showConfirmationScreen(line1, "SAVED", 1500, TUNE_SCORING_SCREEN);
     }
 }
+
+// Gain schedules, setpoint profiles, boost maps, solenoid curves, filter and estimator settings live beside the presets
+// rather than inside ControllerPreset so profiles saved before they existed
+// keep their layout. Callers commit.
+void loadPresetTables(int index) {
+    if (index < 0 || index > 1) return;
+    EEPROM.get(ADDR_GAIN_SCHEDULE_PRESET_1 + (index * sizeof(GainSchedule)), gainSchedule);
+    gainScheduleSanitize(gainSchedule);
+    EEPROM.get(ADDR_SETPOINT_PROFILE_PRESET_1 + (index * sizeof(SetpointProfile)), setpointProfile);
+    setpointProfileSanitize(setpointProfile);
+    EEPROM.get(ADDR_BOOST_MAP_PRESET_1 + (index * sizeof(BoostTargetMap)), boostMap);
+    boostMapSanitize(boostMap);
+    EEPROM.get(ADDR_SOLENOID_CURVE_PRESET_1 + (index * sizeof(SolenoidCurve)), solenoidCurve);
+    solenoidCurveSanitize(solenoidCurve);
+    EEPROM.get(ADDR_FILTER_SETTINGS_PRESET_1 + (index * sizeof(FilterSettings)), filterSettings);
+    filterSettingsSanitize(filterSettings);
+    EEPROM.get(ADDR_ESTIMATOR_SETTINGS_PRESET_1 + (index * sizeof(EstimatorSettings)), estimatorSettings);
+    estimatorSettingsSanitize(estimatorSettings);
+}
+
+void savePresetTables(int index) {
+    if (index < 0 || index > 1) return;
+    EEPROM.put(ADDR_GAIN_SCHEDULE_PRESET_1 + (index * sizeof(GainSchedule)), gainSchedule);
+    EEPROM.put(ADDR_SETPOINT_PROFILE_PRESET_1 + (index * sizeof(SetpointProfile)), setpointProfile);
+    EEPROM.put(ADDR_BOOST_MAP_PRESET_1 + (index * sizeof(BoostTargetMap)), boostMap);
+    EEPROM.put(ADDR_SOLENOID_CURVE_PRESET_1 + (index * sizeof(SolenoidCurve)), solenoidCurve);
+    EEPROM.put(ADDR_FILTER_SETTINGS_PRESET_1 + (index * sizeof(FilterSettings)), filterSettings);
+    EEPROM.put(ADDR_ESTIMATOR_SETTINGS_PRESET_1 + (index * sizeof(EstimatorSettings)), estimatorSettings);
+}
+
+// Writes the learned feed-forward map when it has changed, but only while off
+// boost and not more often than FEEDFORWARD_SAVE_INTERVAL_MS.
+void persistFeedForwardIfDue() {
+    static unsigned long lastSaveTime = 0;
+    if (millis() - lastSaveTime < FEEDFORWARD_SAVE_INTERVAL_MS) return;
+
+    FeedForwardTable snapshot;
+    bool due = false;
+    if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        if (feedForwardTable.dirty && pressurekPa < ARMING_THRESHOLD_KPA) {
+            snapshot = feedForwardTable;
+            feedForwardTable.dirty = false;
+            due = true;
+        }
+        xSemaphoreGive(dataMutex);
+    }
+    if (!due) return;
+
+    snapshot.dirty = false;
+    EEPROM.put(ADDR_FEEDFORWARD_TABLE, snapshot);
+    if (!EEPROM.commit()) {
+        Serial.println("Feed-forward commit failed");
+    }
+    lastSaveTime = millis();
+}
+
+// Writes the sensor fault log when a fault has been added, at most every
+// SENSOR_FAULT_SAVE_INTERVAL_MS.
+void persistSensorFaultLogIfDue() {
+    static unsigned long lastSaveTime = 0;
+    static bool saved = false;
+    if (saved && millis() - lastSaveTime < SENSOR_FAULT_SAVE_INTERVAL_MS) return;
+
+    SensorFaultLog snapshot;
+    bool due = false;
+    if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        if (sensorFaultLog.dirty) {
+            snapshot = sensorFaultLog;
+            sensorFaultLog.dirty = false;
+            due = true;
+        }
+        xSemaphoreGive(dataMutex);
+    }
+    if (!due) return;
+
+    snapshot.dirty = false;
+    EEPROM.put(ADDR_SENSOR_FAULT_LOG, snapshot);
+    if (!EEPROM.commit()) {
+        Serial.println("Sensor fault log commit failed");
+    }
+    lastSaveTime = millis();
+    saved = true;
+}
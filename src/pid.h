@@ -0,0 +1,195 @@
+#ifndef PID_H
+#define PID_H
+
+#include <math.h>
+
+//================================================================================
+// PID CONTROLLER
+//================================================================================
+// Header-only, templated on the arithmetic type: float, or a Q format from
+// fixed.h. Every update is constant time.
+//
+//   u = Kp * (e - (1-b)*(r - r0)) + Ki * integral(e) + Kd * d/dt(c*r - y)
+//   e = r - y, r0 = setpoint when closed loop (re)started
+//
+// Options:
+//   - setpoint weights b (proportional) and c (derivative); c = 0 is
+//     derivative on measurement, so setpoint changes do not kick the D term.
+//     b applies to setpoint changes since the last reset()/track(), so the
+//     proportional term does not carry b times an absolute pressure.
+//   - first-order low-pass on the derivative (time constant in seconds)
+//   - the measurement's rate of change supplied by a state estimator
+//     (updateWithRate) instead of differenced here
+//   - anti-windup by hard clamp, back-calculation or conditional integration
+//   - bumpless transfer: track() aligns the integrator with an externally
+//     applied output so switching to closed loop does not step the output
+//   - an integration rate that scales the error integrated each update, for
+//     gain scheduling: changing it changes how fast the I term moves, never
+//     the I term itself, and 0 holds it
+// The integrator stores the integral of the error (not Ki times it), so
+// integralLimit keeps the meaning of the existing "Max I term" parameter.
+//
+// The first update after reset() has nothing to difference, so its derivative
+// is zero. The original loop kept the error from its last closed-loop tick,
+// so re-entering closed loop kicked the D term by the change in error since
+// then. That kick is gone with every option, including the defaults.
+
+enum PidAntiWindup {
+    PID_ANTIWINDUP_CLAMP,              // clamp the integral at +/- integralLimit only
+    PID_ANTIWINDUP_BACK_CALCULATION,   // bleed the integrator by the saturation excess
+    PID_ANTIWINDUP_CONDITIONAL,        // stop integrating while saturated in the error's direction
+    PID_ANTIWINDUP_COUNT
+};
+
+template <typename T>
+struct PidConfig {
+    T kp, ki, kd;
+    T outMin, outMax;
+    T integralLimit;
+    T setpointWeightP;          // b
+    T setpointWeightD;          // c
+    T derivativeFilterS;        // 0 disables the filter
+    T trackingTimeS;            // back-calculation time constant, 0 picks sqrt(Ti*Td) or Ti
+    T integralRate;             // scales the error integrated per update, 1 for plain PID
+    PidAntiWindup antiWindup;
+};
+
+// The same settings in another arithmetic type, e.g. float tunables for a
+// fixed-point controller.
+template <typename T, typename U>
+PidConfig<T> pidConfigAs(const PidConfig<U>& cfg) {
+    PidConfig<T> result;
+    result.kp = T(cfg.kp);
+    result.ki = T(cfg.ki);
+    result.kd = T(cfg.kd);
+    result.outMin = T(cfg.outMin);
+    result.outMax = T(cfg.outMax);
+    result.integralLimit = T(cfg.integralLimit);
+    result.setpointWeightP = T(cfg.setpointWeightP);
+    result.setpointWeightD = T(cfg.setpointWeightD);
+    result.derivativeFilterS = T(cfg.derivativeFilterS);
+    result.trackingTimeS = T(cfg.trackingTimeS);
+    result.integralRate = T(cfg.integralRate);
+    result.antiWindup = cfg.antiWindup;
+    return result;
+}
+
+template <typename T>
+class PidController {
+public:
+    T integral;                 // integral of the error, in error * seconds
+    T derivative;               // filtered derivative term input, per second
+    T output;                   // last saturated output
+    T unsaturated;              // last output before the limits
+
+    void reset() {
+        setpointOrigin = T(0);
+        integral = T(0);
+        derivative = T(0);
+        output = T(0);
+        unsaturated = T(0);
+        lastDerivativeInput = T(0);
+        lastSetpointTerm = T(0);
+        primed = false;
+    }
+
+    T update(const PidConfig<T>& cfg, T setpoint, T measurement, T dtSeconds) {
+        return step(cfg, setpoint, measurement, nullptr, dtSeconds);
+    }
+
+    // As update(), with d(measurement)/dt given rather than differenced; the
+    // setpoint's share of the derivative is still differenced here.
+    T updateWithRate(const PidConfig<T>& cfg, T setpoint, T measurement, T measurementRate, T dtSeconds) {
+        return step(cfg, setpoint, measurement, &measurementRate, dtSeconds);
+    }
+
+    // Bumpless transfer: while something else drives the actuator, keep the
+    // integrator and derivative state where the controller would produce
+    // appliedOutput if it took over now.
+    void track(const PidConfig<T>& cfg, T appliedOutput, T setpoint, T measurement) {
+        lastDerivativeInput = cfg.setpointWeightD * setpoint - measurement;
+        lastSetpointTerm = cfg.setpointWeightD * setpoint;
+        setpointOrigin = setpoint;
+        derivative = T(0);
+        primed = true;
+        output = saturate(cfg, appliedOutput);
+        unsaturated = output;
+        if (cfg.ki > T(0)) {
+            T proportional = cfg.kp * (setpoint - measurement);
+            integral = (output - proportional) / cfg.ki;
+            clampIntegral(cfg);
+        } else {
+            integral = T(0);
+        }
+    }
+
+private:
+    T setpointOrigin;
+    T lastDerivativeInput;
+    T lastSetpointTerm;
+    bool primed;
+
+    T step(const PidConfig<T>& cfg, T setpoint, T measurement, const T* measurementRate, T dtSeconds) {
+        T error = setpoint - measurement;
+        T setpointTerm = cfg.setpointWeightD * setpoint;
+        T derivativeInput = setpointTerm - measurement;
+
+        if (!primed) setpointOrigin = setpoint;
+        if (dtSeconds > T(0) && primed) {
+            T raw = measurementRate ? (setpointTerm - lastSetpointTerm) / dtSeconds - *measurementRate
+                                    : (derivativeInput - lastDerivativeInput) / dtSeconds;
+            if (cfg.derivativeFilterS > T(0)) {
+                derivative += (raw - derivative) * (dtSeconds / (cfg.derivativeFilterS + dtSeconds));
+            } else {
+                derivative = raw;
+            }
+        }
+        lastDerivativeInput = derivativeInput;
+        lastSetpointTerm = setpointTerm;
+        primed = true;
+
+        T proportional = cfg.kp * (error - (T(1) - cfg.setpointWeightP) * (setpoint - setpointOrigin));
+        T derivativeTerm = cfg.kd * derivative;
+
+        if (cfg.antiWindup == PID_ANTIWINDUP_CONDITIONAL) {
+            T predicted = proportional + cfg.ki * integral + derivativeTerm;
+            bool pushingHigh = predicted >= cfg.outMax && error > T(0);
+            bool pushingLow = predicted <= cfg.outMin && error < T(0);
+            if (!pushingHigh && !pushingLow) integral += error * dtSeconds * cfg.integralRate;
+        } else {
+            integral += error * dtSeconds * cfg.integralRate;
+        }
+        clampIntegral(cfg);
+
+        unsaturated = proportional + cfg.ki * integral + derivativeTerm;
+        output = saturate(cfg, unsaturated);
+
+        if (cfg.antiWindup == PID_ANTIWINDUP_BACK_CALCULATION && cfg.ki > T(0) && output != unsaturated) {
+            // d(integral)/dt gains (u_sat - u) / (Ki * Tt); applied after the
+            // output so this tick's command is unchanged, as in the textbook form.
+            integral += (output - unsaturated) * dtSeconds / (cfg.ki * trackingTime(cfg));
+            clampIntegral(cfg);
+        }
+        return output;
+    }
+
+    static T saturate(const PidConfig<T>& cfg, T value) {
+        if (value < cfg.outMin) return cfg.outMin;
+        if (value > cfg.outMax) return cfg.outMax;
+        return value;
+    }
+
+    void clampIntegral(const PidConfig<T>& cfg) {
+        if (integral > cfg.integralLimit) integral = cfg.integralLimit;
+        if (integral < -cfg.integralLimit) integral = -cfg.integralLimit;
+    }
+
+    static T trackingTime(const PidConfig<T>& cfg) {
+        if (cfg.trackingTimeS > T(0)) return cfg.trackingTimeS;
+        T ti = cfg.kp / cfg.ki;
+        if (cfg.kd > T(0) && cfg.kp > T(0)) return T(sqrtf(float(ti * (cfg.kd / cfg.kp))));
+        return ti > T(0) ? ti : T(1);
+    }
+};
+
+#endif // PID_H
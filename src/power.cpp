@@ -0,0 +1,115 @@
+#include "power.h"
+#include "control.h"
+
+//================================================================================
+// IDLE POWER POLICY
+//================================================================================
+const char* powerModeName(int mode) {
+    switch (mode) {
+        case POWER_ACTIVE: return "active";
+        case POWER_IDLE: return "idle";
+        case POWER_WAKING: return "waking";
+        default: return "unknown";
+    }
+}
+
+const char* powerWakeReasonName(int reason) {
+    switch (reason) {
+        case POWER_WAKE_NONE: return "none";
+        case POWER_WAKE_PRESSURE: return "pressure";
+        case POWER_WAKE_CONTROL: return "control";
+        case POWER_WAKE_ACTIVITY: return "activity";
+        case POWER_WAKE_SETTING: return "setting";
+        default: return "unknown";
+    }
+}
+
+int powerBurstMs(int window) {
+    if (window < 1) window = 1;
+    float ms = (float)window * (1000.0f / SENSOR_SCAN_HZ);
+    int whole = (int)ms;
+    return (whole < ms ? whole + 1 : whole) + 1;
+}
+
+uint32_t powerWakeBoundMs(int window, uint32_t activeTickMs) {
+    if (activeTickMs < 1) activeTickMs = 1;
+    uint32_t burst = (uint32_t)powerBurstMs(window);
+    return POWER_IDLE_TICK_MS + (burst + activeTickMs - 1) / activeTickMs * activeTickMs;
+}
+
+float powerEstimatedCurrentmA(const PowerStats& stats, int window, bool lightSleep) {
+    float activeMs = (float)stats.modeMs[POWER_ACTIVE] + (float)stats.modeMs[POWER_WAKING];
+    float idleMs = (float)stats.modeMs[POWER_IDLE];
+    if (activeMs + idleMs <= 0) return POWER_ACTIVE_MA;
+    float awake = ((float)powerBurstMs(window) + POWER_IDLE_AWAKE_MS) / (float)POWER_IDLE_TICK_MS;
+    if (awake > 1) awake = 1;
+    float idlemA = awake * POWER_SCALED_MA + (1 - awake) * (lightSleep ? POWER_LIGHT_SLEEP_MA : POWER_SCALED_MA);
+    return (activeMs * POWER_ACTIVE_MA + idleMs * idlemA) / (activeMs + idleMs);
+}
+
+void powerPolicyInit(PowerPolicy& policy, uint32_t timeMs) {
+    policy.mode = POWER_ACTIVE;
+    policy.lastTimeMs = timeMs;
+    policy.quietSinceMs = timeMs;
+    policy.wakeStartMs = 0;
+    for (int i = 0; i < POWER_MODE_COUNT; i++) policy.stats.modeMs[i] = 0;
+    for (int i = 0; i < POWER_WAKE_REASON_COUNT; i++) policy.stats.wakes[i] = 0;
+    policy.stats.lastWakeReason = POWER_WAKE_NONE;
+    policy.stats.lastWakeMs = 0;
+    policy.stats.worstWakeMs = 0;
+}
+
+static int wakeReason(const PowerInput& input) {
+    if (input.setting == POWER_SETTING_OFF) return POWER_WAKE_SETTING;
+    if (input.activity) return POWER_WAKE_ACTIVITY;
+    if (!input.controlIdle) return POWER_WAKE_CONTROL;
+    if (input.pressurekPa < REACTIVATE_PRESSURE_KPA + POWER_WAKE_MARGIN_KPA || input.pressurekPa > IDLE_PRESSURE_MAX_KPA) {
+        return POWER_WAKE_PRESSURE;
+    }
+    return POWER_WAKE_NONE;
+}
+
+void powerPolicyUpdate(PowerPolicy& policy, const PowerInput& input, PowerDecision& decision) {
+    policy.stats.modeMs[policy.mode] += input.timeMs - policy.lastTimeMs;
+    policy.lastTimeMs = input.timeMs;
+    decision.enterIdle = false;
+    decision.exitIdle = false;
+
+    // Entry needs the pressure back in the idle band, well clear of the wake
+    // threshold, so a reading near it cannot make the mode flap.
+    bool inBand = input.pressurekPa >= IDLE_PRESSURE_MIN_KPA && input.pressurekPa <= IDLE_PRESSURE_MAX_KPA;
+    if (input.activity || !input.controlIdle || !inBand) policy.quietSinceMs = input.timeMs;
+
+    switch (policy.mode) {
+        case POWER_ACTIVE:
+            if (input.setting != POWER_SETTING_OFF && input.controlIdle &&
+                input.timeMs - policy.quietSinceMs >= POWER_IDLE_ENTER_MS) {
+                policy.mode = POWER_IDLE;
+                decision.enterIdle = true;
+            }
+            break;
+        case POWER_IDLE: {
+            int reason = wakeReason(input);
+            if (reason != POWER_WAKE_NONE) {
+                policy.mode = POWER_WAKING;
+                policy.wakeStartMs = input.timeMs;
+                policy.quietSinceMs = input.timeMs;
+                policy.stats.wakes[reason]++;
+                policy.stats.lastWakeReason = (uint8_t)reason;
+                decision.exitIdle = true;
+            }
+            break;
+        }
+        case POWER_WAKING:
+            if (input.timeMs - policy.wakeStartMs >= (uint32_t)powerBurstMs(input.window)) {
+                policy.mode = POWER_ACTIVE;
+                policy.stats.lastWakeMs = input.timeMs - policy.wakeStartMs;
+                if (policy.stats.lastWakeMs > policy.stats.worstWakeMs) policy.stats.worstWakeMs = policy.stats.lastWakeMs;
+            }
+            break;
+    }
+
+    bool idle = policy.mode == POWER_IDLE;
+    decision.tickMs = idle ? POWER_IDLE_TICK_MS : input.activeTickMs;
+    decision.burstMs = idle ? powerBurstMs(input.window) : 0;
+}
@@ -0,0 +1,111 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+//================================================================================
+// IDLE POWER POLICY
+//================================================================================
+// Decides when the board may save power while the engine is off. Once the
+// control pipeline has disabled the solenoid for idle (control.h,
+// solenoidDisabledByIdle) and nothing has been touched for POWER_IDLE_ENTER_MS,
+// the policy enters POWER_IDLE. The firmware (power_manager.cpp) then releases
+// its power-management locks so the CPU drops to its lowest frequency and,
+// if allowed, light sleeps between ticks. It also stops the DMA scan and the
+// overboost guard's timer, and the control task ticks every POWER_IDLE_TICK_MS
+// with a short burst of conversions (powerBurstMs()) before each reading.
+//
+// Any of these wakes it: the pressure leaves the idle band (below
+// REACTIVATE_PRESSURE_KPA + POWER_WAKE_MARGIN_KPA, so an engine start is caught
+// before the pipeline reactivates, or above IDLE_PRESSURE_MAX_KPA), the
+// pipeline leaves idle, a touch, or the setting being turned off. The firmware takes the locks back and restarts the scan and the
+// guard at once. The policy then stays in POWER_WAKING until the averaging
+// window has refilled at full rate, and returns to POWER_ACTIVE. From the
+// change to the end of the wake takes at most powerWakeBoundMs().
+//
+// The policy also keeps time in each mode and the wake latencies, and
+// estimates the chip's mean supply current from them for the diagnostics
+// (there is no current sense on the board). Hardware independent, so
+// tools/power drives it through simulated engine starts and touches.
+
+enum PowerMode {
+    POWER_ACTIVE,
+    POWER_IDLE,
+    POWER_WAKING,        // full rate again, waiting for a full averaging window
+    POWER_MODE_COUNT
+};
+
+enum PowerSetting {
+    POWER_SETTING_OFF,          // always full rate
+    POWER_SETTING_SCALING,      // lowest CPU frequency and slow sampling while idle
+    POWER_SETTING_LIGHT_SLEEP,  // as scaling, plus light sleep between ticks (drops USB serial)
+    POWER_SETTING_COUNT
+};
+
+enum PowerWakeReason {
+    POWER_WAKE_NONE,
+    POWER_WAKE_PRESSURE,
+    POWER_WAKE_CONTROL,   // the pipeline left idle by itself
+    POWER_WAKE_ACTIVITY,  // a touch
+    POWER_WAKE_SETTING,
+    POWER_WAKE_REASON_COUNT
+};
+
+const uint32_t POWER_IDLE_ENTER_MS = 5000;   // idle and untouched this long first
+const uint32_t POWER_IDLE_TICK_MS = 100;
+const float POWER_WAKE_MARGIN_KPA = 10.0;
+
+// ESP32-S3 supply current (datasheet, radios off) for the estimate: both
+// cores at 240 MHz, at 80 MHz, and in light sleep.
+const float POWER_ACTIVE_MA = 50.0;
+const float POWER_SCALED_MA = 20.0;
+const float POWER_LIGHT_SLEEP_MA = 0.25;
+const float POWER_IDLE_AWAKE_MS = 2.0;   // per idle tick besides the burst: control step and input poll
+
+struct PowerInput {
+    uint32_t timeMs;
+    int setting;             // PowerSetting
+    bool controlIdle;        // solenoidDisabledByIdle
+    bool activity;           // a touch since the previous tick
+    float pressurekPa;
+    int window;              // conversions averaged per reading
+    uint32_t activeTickMs;   // the control task's tick at full rate
+};
+
+struct PowerDecision {
+    bool enterIdle;          // release the locks, stop the scan and the guard
+    bool exitIdle;           // take the locks, restart the scan and the guard
+    uint32_t tickMs;         // until the next tick
+    int burstMs;             // > 0: run the scan this long before the next reading
+};
+
+struct PowerStats {
+    uint32_t modeMs[POWER_MODE_COUNT];
+    uint32_t wakes[POWER_WAKE_REASON_COUNT];
+    uint8_t lastWakeReason;
+    uint32_t lastWakeMs;     // from the tick that saw the change to POWER_ACTIVE
+    uint32_t worstWakeMs;
+};
+
+struct PowerPolicy {
+    uint8_t mode;            // PowerMode
+    uint32_t lastTimeMs;
+    uint32_t quietSinceMs;   // last activity, leaving idle or any pressure outside the idle band
+    uint32_t wakeStartMs;
+    PowerStats stats;
+};
+
+void powerPolicyInit(PowerPolicy& policy, uint32_t timeMs);
+void powerPolicyUpdate(PowerPolicy& policy, const PowerInput& input, PowerDecision& decision);
+
+const char* powerModeName(int mode);
+const char* powerWakeReasonName(int reason);
+// Milliseconds of scanning that fill a window of conversions, plus one.
+int powerBurstMs(int window);
+// Longest from a wake condition arising to POWER_ACTIVE: up to one idle tick
+// to see it, then the window refilling, then the tick that sees it full.
+uint32_t powerWakeBoundMs(int window, uint32_t activeTickMs);
+// Mean supply current over the time recorded in stats, in mA.
+float powerEstimatedCurrentmA(const PowerStats& stats, int window, bool lightSleep);
+
+#endif // POWER_H
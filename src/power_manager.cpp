@@ -0,0 +1,98 @@
+#include "config.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+
+//================================================================================
+// IDLE POWER MANAGEMENT
+//================================================================================
+// Carries out the idle power policy (power.h) on the ESP32-S3. esp_pm scales
+// the CPU between 240 and 80 MHz and, when the build has tickless idle, light
+// sleeps whenever every task is blocked. Two locks hold it at full speed and
+// awake; the control task releases them on entering idle and takes them back
+// on the first tick that sees a wake condition. The DMA scan and the overboost
+// guard's timer are stopped as well, as either would keep the CPU at full
+// speed. In light sleep the first button's touch pad wakes the chip at once,
+// rather than at the next idle tick. The control task starts before the touch
+// pads are calibrated; until they are, there is no threshold to wake on, so
+// the pad is not armed and a touch is only seen at the next idle tick.
+//
+// Builds without CONFIG_PM_ENABLE refuse the configuration; the CPU frequency
+// is then switched directly and there is no light sleep.
+
+static const int POWER_MAX_MHZ = 240;
+static const int POWER_MIN_MHZ = 80;
+
+static esp_pm_lock_handle_t fullSpeedLock = NULL;
+static esp_pm_lock_handle_t awakeLock = NULL;
+static bool pmConfigured = false;
+static bool lightSleepConfigured = false;
+static bool awakeLockReleased = false;
+static bool touchWakeArmed = false;
+
+void beginPowerManagement() {
+    esp_pm_config_esp32s3_t config = {};
+    config.max_freq_mhz = POWER_MAX_MHZ;
+    config.min_freq_mhz = POWER_MIN_MHZ;
+    config.light_sleep_enable = true;
+    if (esp_pm_configure(&config) == ESP_OK) {
+        lightSleepConfigured = true;
+    } else {
+        config.light_sleep_enable = false;
+        if (esp_pm_configure(&config) != ESP_OK) return;
+    }
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "control", &fullSpeedLock) != ESP_OK ||
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &awakeLock) != ESP_OK) {
+        lightSleepConfigured = false;
+        return;
+    }
+    esp_pm_lock_acquire(fullSpeedLock);
+    esp_pm_lock_acquire(awakeLock);
+    pmConfigured = true;
+}
+
+bool powerManagementAvailable(bool& lightSleep) {
+    lightSleep = pmConfigured && lightSleepConfigured;
+    return pmConfigured;
+}
+
+void powerEnterIdle(bool lightSleep) {
+    overboostGuardPause(true);
+    sensorScanPause(true);
+    if (!pmConfigured) {
+        setCpuFrequencyMhz(POWER_MIN_MHZ);
+        return;
+    }
+    if (lightSleep && lightSleepConfigured) {
+        bool calibrated = false;
+        int threshold = 0;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            calibrated = touchCalibrated;
+            threshold = touchCalibrationValues[0] + TOUCH_SENSITIVITY_OFFSET;
+            xSemaphoreGive(dataMutex);
+        }
+        if (calibrated) {
+            touchSleepWakeUpEnable(TOUCH_PIN_1, threshold);
+            esp_sleep_enable_touchpad_wakeup();
+            touchWakeArmed = true;
+        }
+        esp_pm_lock_release(awakeLock);
+        awakeLockReleased = true;
+    }
+    esp_pm_lock_release(fullSpeedLock);
+}
+
+void powerExitIdle() {
+    if (!pmConfigured) {
+        setCpuFrequencyMhz(POWER_MAX_MHZ);
+    } else {
+        esp_pm_lock_acquire(fullSpeedLock);
+        if (awakeLockReleased) {
+            esp_pm_lock_acquire(awakeLock);
+            if (touchWakeArmed) esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TOUCHPAD);
+            touchWakeArmed = false;
+            awakeLockReleased = false;
+        }
+    }
+    sensorScanPause(false);
+    overboostGuardPause(false);
+}
@@ -0,0 +1,61 @@
+#include "definitions.h"
+#include <driver/pcnt.h>
+
+//================================================================================
+// PCNT PULSE COUNTERS
+//================================================================================
+// Tach and speed pulses are counted in hardware, so no edge costs an
+// interrupt. Each unit counts rising edges and wraps at PCNT_WRAP back to 0;
+// takePulses() returns the difference since its last call, which stays
+// correct as long as it is called before PCNT_WRAP pulses go by (about 3 s of
+// a 10 kHz signal; the control task calls it every tick).
+
+static const int16_t PCNT_WRAP = 30000;
+static const uint16_t PCNT_GLITCH_FILTER = 1000;   // APB cycles (80 MHz): ignore pulses under 12.5 us
+
+struct PcntChannel {
+    pcnt_unit_t unit;
+    int16_t last;
+};
+
+static PcntChannel rpmChannel = {PCNT_UNIT_0, 0};
+static PcntChannel speedChannel = {PCNT_UNIT_1, 0};
+
+static void beginChannel(PcntChannel& channel, int pin) {
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = pin;
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.channel = PCNT_CHANNEL_0;
+    config.unit = channel.unit;
+    config.pos_mode = PCNT_COUNT_INC;
+    config.neg_mode = PCNT_COUNT_DIS;
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.counter_h_lim = PCNT_WRAP;
+    config.counter_l_lim = 0;
+    pcnt_unit_config(&config);
+    pcnt_set_filter_value(channel.unit, PCNT_GLITCH_FILTER);
+    pcnt_filter_enable(channel.unit);
+    pcnt_counter_pause(channel.unit);
+    pcnt_counter_clear(channel.unit);
+    pcnt_counter_resume(channel.unit);
+    channel.last = 0;
+}
+
+static uint32_t takeChannelPulses(void* context) {
+    PcntChannel& channel = *(PcntChannel*)context;
+    int16_t now = 0;
+    pcnt_get_counter_value(channel.unit, &now);
+    int32_t delta = (int32_t)now - channel.last;
+    if (delta < 0) delta += PCNT_WRAP;
+    channel.last = now;
+    return (uint32_t)delta;
+}
+
+PulseCounter rpmCounter = {&rpmChannel, takeChannelPulses};
+PulseCounter speedCounter = {&speedChannel, takeChannelPulses};
+
+void beginPulseCounters() {
+    beginChannel(rpmChannel, RPM_INPUT_PIN);
+    beginChannel(speedChannel, SPEED_INPUT_PIN);
+}
@@ -0,0 +1,166 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "rpm.h"
+#include <math.h>
+#include <stdlib.h>
+
+void rpmInit(RpmState& state) {
+    for (int i = 0; i < RPM_WINDOW_TICKS; i++) {
+        state.rpmPulses[i] = 0;
+        state.speedPulses[i] = 0;
+        state.tickMs[i] = 0;
+    }
+    state.index = 0;
+    state.rpmPulseSum = 0;
+    state.speedPulseSum = 0;
+    state.windowMs = 0;
+    state.rpm = 0.0f;
+    state.speedKph = 0.0f;
+    state.gear = 0;
+    state.peakRpm = 0.0f;
+    state.peakAgeMs = 0.0f;
+    state.shiftLatched = false;
+    state.troughRpm = 0.0f;
+    state.idleMs = 0;
+}
+
+static uint16_t clampCount(uint32_t value) {
+    return value > 65535 ? 65535 : (uint16_t)value;
+}
+
+static void gearFromSpeed(RpmState& state, const RpmConfig& config) {
+    if (state.speedKph < SPEED_GEAR_MIN_KPH) {
+        state.gear = 0;
+        return;
+    }
+    float ratio = state.rpm / state.speedKph;
+    int best = 0;
+    float bestError = SPEED_GEAR_TOLERANCE;
+    for (int g = 0; g < config.gearCount && g < RPM_MAP_GEARS; g++) {
+        float expected = config.gearRpmPerKph[g];
+        if (expected <= 0.0f) continue;
+        float error = fabsf(ratio - expected) / expected;
+        if (error <= bestError) {
+            bestError = error;
+            best = g + 1;
+        }
+    }
+    // Clutch in or wheelspin matches no gear; keep the last one.
+    if (best) state.gear = best;
+}
+
+static void gearFromRpmDrops(RpmState& state, const RpmConfig& config, uint32_t dtMs, bool underBoost) {
+    if (state.rpm < RPM_IDLE_RPM) {
+        state.idleMs += dtMs;
+        if (state.idleMs >= RPM_GEAR_RESET_MS) {
+            state.gear = 1;
+            state.shiftLatched = false;
+            state.peakRpm = state.rpm;
+            state.peakAgeMs = 0.0f;
+        }
+    } else {
+        state.idleMs = 0;
+    }
+    if (state.gear == 0) state.gear = 1;
+
+    if (state.shiftLatched) {
+        if (state.rpm < state.troughRpm) state.troughRpm = state.rpm;
+        if (state.rpm < state.troughRpm * (1.0f + RPM_SHIFT_REARM_RISE)) return;
+        state.shiftLatched = false;
+        state.peakRpm = state.rpm;
+        state.peakAgeMs = 0.0f;
+    }
+
+    if (state.rpm >= state.peakRpm || state.peakAgeMs > RPM_SHIFT_WINDOW_MS) {
+        state.peakRpm = state.rpm;
+        state.peakAgeMs = 0.0f;
+        return;
+    }
+    state.peakAgeMs += (float)dtMs;
+    if (underBoost && state.peakRpm >= RPM_SHIFT_MIN_RPM && state.rpm <= state.peakRpm * (1.0f - RPM_SHIFT_MIN_DROP)) {
+        if (state.gear < config.gearCount && state.gear < RPM_MAP_GEARS) state.gear++;
+        state.shiftLatched = true;
+        state.troughRpm = state.rpm;
+    }
+}
+
+void rpmUpdate(RpmState& state, const RpmConfig& config, uint32_t rpmPulses, uint32_t speedPulses, uint32_t dtMs,
+               bool underBoost) {
+    if (dtMs == 0) return;
+    int i = state.index;
+    state.rpmPulseSum -= state.rpmPulses[i];
+    state.speedPulseSum -= state.speedPulses[i];
+    state.windowMs -= state.tickMs[i];
+    state.rpmPulses[i] = clampCount(rpmPulses);
+    state.speedPulses[i] = clampCount(speedPulses);
+    state.tickMs[i] = clampCount(dtMs);
+    state.rpmPulseSum += state.rpmPulses[i];
+    state.speedPulseSum += state.speedPulses[i];
+    state.windowMs += state.tickMs[i];
+    state.index = (i + 1) % RPM_WINDOW_TICKS;
+
+    if (!config.enabled || config.pulsesPerRev <= 0.0f) {
+        state.rpm = 0.0f;
+        state.speedKph = 0.0f;
+        state.gear = 0;
+        return;
+    }
+    state.rpm = state.rpmPulseSum * 60000.0f / (config.pulsesPerRev * state.windowMs);
+    state.speedKph = config.speedPulsesPerKm > 0.0f
+                   ? state.speedPulseSum * 3600000.0f / (config.speedPulsesPerKm * state.windowMs) : 0.0f;
+
+    if (config.speedPulsesPerKm > 0.0f) gearFromSpeed(state, config);
+    else gearFromRpmDrops(state, config, dtMs, underBoost);
+}
+
+void boostMapReset(BoostTargetMap& map) {
+    map.enabled = 0;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) {
+        for (int r = 0; r < RPM_MAP_POINTS; r++) map.offsetkPa[g][r] = 0.0f;
+    }
+}
+
+bool boostMapSanitize(BoostTargetMap& map) {
+    bool clean = map.enabled == 0 || map.enabled == 1;
+    for (int g = 0; g < RPM_MAP_GEARS && clean; g++) {
+        for (int r = 0; r < RPM_MAP_POINTS; r++) {
+            float v = map.offsetkPa[g][r];
+            if (isnan(v) || isinf(v) || fabsf(v) > RPM_MAP_MAX_OFFSET_KPA) {
+                clean = false;
+                break;
+            }
+        }
+    }
+    if (!clean) boostMapReset(map);
+    return clean;
+}
+
+static void locate(float position, int points, int& index, float& frac) {
+    if (position < 0.0f) position = 0.0f;
+    if (position > (float)(points - 1)) position = (float)(points - 1);
+    index = (int)position;
+    if (index > points - 2) index = points - 2;
+    frac = position - (float)index;
+}
+
+float boostMapLookup(const BoostTargetMap& map, float rpm, float gear) {
+    int r, g;
+    float fr, fg;
+    locate((rpm - RPM_MAP_MIN_RPM) / RPM_MAP_STEP_RPM, RPM_MAP_POINTS, r, fr);
+    locate(gear - 1.0f, RPM_MAP_GEARS, g, fg);
+    const float (*t)[RPM_MAP_POINTS] = map.offsetkPa;
+    float low = t[g][r] + (t[g][r + 1] - t[g][r]) * fr;
+    float high = t[g + 1][r] + (t[g + 1][r + 1] - t[g + 1][r]) * fr;
+    return low + (high - low) * fg;
+}
+
+float* boostMapEntry(BoostTargetMap& map, const char* key) {
+    char* end = nullptr;
+    long g = strtol(key, &end, 10);
+    if (end == key || *end != '.') return nullptr;
+    const char* column = end + 1;
+    long r = strtol(column, &end, 10);
+    if (end == column || *end != '\0') return nullptr;
+    if (g < 1 || g > RPM_MAP_GEARS || r < 0 || r >= RPM_MAP_POINTS) return nullptr;
+    return &map.offsetkPa[g - 1][r];
+}
@@ -0,0 +1,93 @@
+#ifndef RPM_H
+#define RPM_H
+
+#include <stdint.h>
+
+//================================================================================
+// ENGINE SPEED, GEAR AND RPM-BY-GEAR BOOST MAP
+//================================================================================
+// Engine speed comes from tach pulses counted in hardware (the PCNT peripheral
+// on the ESP32, see pulse_counter.cpp); an optional vehicle speed input is
+// counted the same way. Each tick the control pipeline receives the pulses
+// seen since the previous tick and sums them over a fixed 200 ms window, so
+// RPM and speed cost constant time and memory. Resolution is one pulse per
+// window: 150 rpm at 2 pulses/rev.
+//
+// Gear comes from the speed input when one is configured: RPM per km/h is
+// matched against the configured ratio of each gear. Without one it is
+// inferred from the RPM pattern of an upshift under boost, a drop of 15% or
+// more from a peak within 400 ms, and reset to first once the engine idles.
+// That is a heuristic: a lift and re-apply at high RPM can look like a shift.
+//
+// The boost map holds a kPa offset from the target for each gear and RPM
+// breakpoint, bilinearly interpolated. Beyond the outer breakpoints the edge
+// values apply; while the gear is unknown the first-gear row is used.
+
+#define RPM_MAP_POINTS 8
+#define RPM_MAP_GEARS 6
+const float RPM_MAP_MIN_RPM = 1000.0;
+const float RPM_MAP_STEP_RPM = 1000.0;
+const float RPM_MAP_MAX_OFFSET_KPA = 200.0;
+
+#define RPM_WINDOW_TICKS 20          // pulses are summed over the last 20 control ticks
+const float RPM_IDLE_RPM = 1300.0;   // below this for RPM_GEAR_RESET_MS, RPM inference drops back to first
+const uint32_t RPM_GEAR_RESET_MS = 1000;
+const float RPM_SHIFT_MIN_RPM = 2500.0;
+const float RPM_SHIFT_WINDOW_MS = 400.0;
+const float RPM_SHIFT_MIN_DROP = 0.15;
+const float RPM_SHIFT_REARM_RISE = 0.05;   // after a shift, RPM must climb this far off its trough first
+const float SPEED_GEAR_MIN_KPH = 5.0;
+const float SPEED_GEAR_TOLERANCE = 0.12;  // RPM per km/h within 12% of a gear's ratio
+
+// Where pulses come from. The firmware wraps PCNT units; host tools supply a
+// simulated engine.
+struct PulseCounter {
+    void* context;
+    uint32_t (*takePulses)(void* context);   // pulses since the previous call
+};
+
+struct RpmConfig {
+    bool enabled;
+    float pulsesPerRev;                    // tach pulses per crank revolution
+    float speedPulsesPerKm;                // 0 = no speed input, infer gear from RPM drops
+    int gearCount;                         // forward gears, up to RPM_MAP_GEARS
+    float gearRpmPerKph[RPM_MAP_GEARS];    // engine RPM per km/h in each gear, for the speed input
+};
+
+struct RpmState {
+    uint16_t rpmPulses[RPM_WINDOW_TICKS];
+    uint16_t speedPulses[RPM_WINDOW_TICKS];
+    uint16_t tickMs[RPM_WINDOW_TICKS];
+    int index;
+    uint32_t rpmPulseSum, speedPulseSum, windowMs;
+    float rpm;
+    float speedKph;
+    int gear;                   // 1-based, 0 = unknown
+    float peakRpm;              // RPM-drop inference: recent peak and its age
+    float peakAgeMs;
+    bool shiftLatched;          // a shift was counted; waiting for RPM to climb again
+    float troughRpm;
+    uint32_t idleMs;
+};
+
+struct BoostTargetMap {
+    int enabled;
+    float offsetkPa[RPM_MAP_GEARS][RPM_MAP_POINTS];
+};
+
+void rpmInit(RpmState& state);
+// One tick: pulses seen since the last tick over dtMs. underBoost gates the
+// RPM-drop shift detection.
+void rpmUpdate(RpmState& state, const RpmConfig& config, uint32_t rpmPulses, uint32_t speedPulses, uint32_t dtMs,
+               bool underBoost);
+
+// Disabled, all offsets zero.
+void boostMapReset(BoostTargetMap& map);
+// Resets the map if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool boostMapSanitize(BoostTargetMap& map);
+// Offset for an RPM and a gear (1-based; fractional gears interpolate, 0 uses first).
+float boostMapLookup(const BoostTargetMap& map, float rpm, float gear);
+// Cell for a "G.R" key (gear 1..6, RPM column 0..7); nullptr if the key is not one.
+float* boostMapEntry(BoostTargetMap& map, const char* key);
+
+#endif // RPM_H
@@ -0,0 +1,148 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "sensorfault.h"
+#include "numeric.h"
+#include <math.h>
+
+static const char* const FAULT_NAMES[SENSOR_FAULT_CODE_COUNT] = {"none", "open", "short", "stuck", "slew", "noise"};
+
+const char* sensorFaultName(uint8_t code) {
+    return code < SENSOR_FAULT_CODE_COUNT ? FAULT_NAMES[code] : "?";
+}
+
+//================================================================================
+// MONITOR
+//================================================================================
+void sensorFaultInit(SensorFaultMonitor& monitor) {
+    monitor.active = SENSOR_FAULT_NONE;
+    monitor.detail = 0;
+    sensorFaultClear(monitor);
+}
+
+void sensorFaultClear(SensorFaultMonitor& monitor) {
+    monitor.active = SENSOR_FAULT_NONE;
+    monitor.ticks = 0;
+    monitor.lastkPa = 0;
+    monitor.prevkPa = 0;
+    monitor.stuckTicks = 0;
+    monitor.voltMin = monitor.voltMax = 0;
+    monitor.dutyMin = monitor.dutyMax = 0;
+    monitor.slewHistory = 0;
+    monitor.noiseFast = 0;
+    monitor.noiseFloor = 0;
+}
+
+static uint8_t raise(SensorFaultMonitor& monitor, uint8_t code, float detail) {
+    monitor.active = code;
+    monitor.detail = detail;
+    return code;
+}
+
+uint8_t sensorFaultUpdate(SensorFaultMonitor& monitor, const SensorFaultLimits& limits, float pinVoltage, float rawkPa,
+                          float dutyPercent, bool underBoost, float dtMs) {
+    if (monitor.active != SENSOR_FAULT_NONE) return SENSOR_FAULT_NONE;
+
+    // -- Rails: decided on this tick's reading alone --
+    if (pinVoltage < limits.railLowV) return raise(monitor, SENSOR_FAULT_OPEN, pinVoltage);
+    if (pinVoltage > limits.railHighV) return raise(monitor, SENSOR_FAULT_SHORT, pinVoltage);
+
+    int ticks = monitor.ticks;
+    if (monitor.ticks < SENSOR_NOISE_SETTLED_TICKS) monitor.ticks++;
+
+    // -- Stuck: how long the reading has stayed inside the band, and how far
+    // the duty has swung meanwhile; a reading that leaves the band starts a
+    // new run from itself --
+    if (!underBoost) {
+        monitor.stuckTicks = 0;
+    } else {
+        if (monitor.stuckTicks > 0) {
+            float lo = pinVoltage < monitor.voltMin ? pinVoltage : monitor.voltMin;
+            float hi = pinVoltage > monitor.voltMax ? pinVoltage : monitor.voltMax;
+            if (hi - lo >= SENSOR_STUCK_BAND_V) monitor.stuckTicks = 0;
+        }
+        if (monitor.stuckTicks == 0) {
+            monitor.voltMin = monitor.voltMax = pinVoltage;
+            monitor.dutyMin = monitor.dutyMax = dutyPercent;
+        } else {
+            if (pinVoltage < monitor.voltMin) monitor.voltMin = pinVoltage;
+            if (pinVoltage > monitor.voltMax) monitor.voltMax = pinVoltage;
+            if (dutyPercent < monitor.dutyMin) monitor.dutyMin = dutyPercent;
+            if (dutyPercent > monitor.dutyMax) monitor.dutyMax = dutyPercent;
+        }
+        if (monitor.stuckTicks < SENSOR_STUCK_TICKS) monitor.stuckTicks++;
+        float dutySpan = monitor.dutyMax - monitor.dutyMin;
+        if (monitor.stuckTicks >= SENSOR_STUCK_TICKS && dutySpan >= SENSOR_STUCK_DUTY_SPAN) {
+            return raise(monitor, SENSOR_FAULT_STUCK, dutySpan);
+        }
+    }
+
+    if (ticks == 0) {
+        monitor.lastkPa = monitor.prevkPa = rawkPa;
+        return SENSOR_FAULT_NONE;
+    }
+
+    // -- Slew --
+    float rate = dtMs > 0.0f ? fabsf(rawkPa - monitor.lastkPa) * MS_PER_SECOND / dtMs : 0.0f;
+    monitor.slewHistory = (uint8_t)(monitor.slewHistory << 1) | (rate > SENSOR_SLEW_MAX_KPA_PER_S ? 1 : 0);
+    uint8_t slewMask = (uint8_t)((1u << SENSOR_SLEW_WINDOW) - 1u);
+    uint8_t recent = monitor.slewHistory & slewMask;
+    if (recent & (uint8_t)(recent - 1)) return raise(monitor, SENSOR_FAULT_SLEW, rate);
+
+    // -- Noise: second difference, so a steady ramp reads as quiet. A jump the
+    // slew check has seen in this or the last difference is left to it. --
+    if (ticks >= 2 && (monitor.slewHistory & 3u) == 0) {
+        float roughness = fabsf(rawkPa - 2.0f * monitor.lastkPa + monitor.prevkPa);
+        monitor.noiseFast += SENSOR_NOISE_FAST_ALPHA * (roughness - monitor.noiseFast);
+        float threshold = SENSOR_NOISE_RATIO * monitor.noiseFloor;
+        if (threshold < SENSOR_NOISE_MIN_KPA) threshold = SENSOR_NOISE_MIN_KPA;
+        if (ticks >= SENSOR_NOISE_WARMUP_TICKS && monitor.noiseFast > threshold) {
+            return raise(monitor, SENSOR_FAULT_NOISE, monitor.noiseFast);
+        }
+        // The floor is the mean roughness until warm, then follows it slowly.
+        float alpha = 1.0f / (float)(ticks - 1);
+        if (alpha < SENSOR_NOISE_FLOOR_ALPHA) alpha = SENSOR_NOISE_FLOOR_ALPHA;
+        if (monitor.noiseFast <= threshold) monitor.noiseFloor += alpha * (roughness - monitor.noiseFloor);
+    }
+    monitor.prevkPa = monitor.lastkPa;
+    monitor.lastkPa = rawkPa;
+    return SENSOR_FAULT_NONE;
+}
+
+//================================================================================
+// FAULT LOG
+//================================================================================
+void sensorFaultLogClear(SensorFaultLog& log) {
+    for (int i = 0; i < SENSOR_FAULT_LOG_SIZE; i++) {
+        log.records[i].code = SENSOR_FAULT_NONE;
+        log.records[i].timeMs = 0;
+        log.records[i].voltage = 0;
+        log.records[i].detail = 0;
+    }
+    log.next = 0;
+    log.count = 0;
+    log.dirty = false;
+}
+
+bool sensorFaultLogSanitize(SensorFaultLog& log) {
+    bool valid = log.next < SENSOR_FAULT_LOG_SIZE && log.count <= SENSOR_FAULT_LOG_SIZE;
+    for (int i = 0; valid && i < log.count; i++) {
+        const SensorFaultRecord& r = log.records[(log.next + SENSOR_FAULT_LOG_SIZE - 1 - i) % SENSOR_FAULT_LOG_SIZE];
+        if (r.code == SENSOR_FAULT_NONE || r.code >= SENSOR_FAULT_CODE_COUNT || isnan(r.voltage) || isnan(r.detail)) valid = false;
+    }
+    if (!valid) sensorFaultLogClear(log);
+    log.dirty = false;
+    return valid;
+}
+
+void sensorFaultLogAdd(SensorFaultLog& log, const SensorFaultRecord& record) {
+    log.records[log.next] = record;
+    log.next = (log.next + 1) % SENSOR_FAULT_LOG_SIZE;
+    if (log.count < SENSOR_FAULT_LOG_SIZE) log.count++;
+    log.dirty = true;
+}
+
+bool sensorFaultLogGet(const SensorFaultLog& log, int age, SensorFaultRecord& record) {
+    if (age < 0 || age >= log.count) return false;
+    record = log.records[(log.next + SENSOR_FAULT_LOG_SIZE - 1 - age) % SENSOR_FAULT_LOG_SIZE];
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef SENSORFAULT_H
+#define SENSORFAULT_H
+
+#include <stdint.h>
+
+//================================================================================
+// MAP SENSOR FAULT MONITOR
+//================================================================================
+// Plausibility checks on the MAP reading, one update per control tick, each
+// O(1) in time and memory:
+//   - rails: the pin near 0 V (sensor unplugged, signal or supply open, short
+//     to ground) or near the 5 V rail through the divider (short to supply)
+//   - stuck: under boost, where duty moves the pressure, the reading has not
+//     moved by more than a few ADC counts for at least SENSOR_STUCK_TICKS and
+//     the duty actually applied has swung by SENSOR_STUCK_DUTY_SPAN or more
+//     since it stopped (a frozen sensor or a stalled ADC scan)
+//   - slew: the reading moves faster than manifold pressure physically can,
+//     twice within SENSOR_SLEW_WINDOW ticks (an intermittent connection)
+//   - noise: the tick-to-tick roughness (second difference) jumps well above
+//     the floor learned since power-up (a failing sensor or a loose ground)
+// A fault latches, and the pipeline drives the solenoid at the failsafe duty
+// from the tick it is detected until the fault is cleared. Each fault is
+// added to a small ring the firmware keeps in EEPROM.
+
+enum SensorFaultCode {
+    SENSOR_FAULT_NONE = 0,
+    SENSOR_FAULT_OPEN,
+    SENSOR_FAULT_SHORT,
+    SENSOR_FAULT_STUCK,
+    SENSOR_FAULT_SLEW,
+    SENSOR_FAULT_NOISE,
+    SENSOR_FAULT_CODE_COUNT
+};
+
+// Sensor-side volts; the pipeline takes them through the MAP divider.
+const float SENSOR_RAIL_LOW_V = 0.2;         // a working sensor never drives below its 0.4-0.5 V floor
+const float SENSOR_RAIL_HIGH_V = 4.85;       // nor above its 4.5-4.65 V ceiling
+const int SENSOR_STUCK_TICKS = 50;            // shortest run that can be called stuck
+const float SENSOR_STUCK_BAND_V = 0.002;     // pin volts, about 2.5 ADC counts
+const float SENSOR_STUCK_DUTY_SPAN = 20.0;   // % of duty applied
+const float SENSOR_SLEW_MAX_KPA_PER_S = 3000.0;
+const int SENSOR_SLEW_WINDOW = 8;            // ticks, at most 8
+const float SENSOR_NOISE_FAST_ALPHA = 0.1;
+const float SENSOR_NOISE_FLOOR_ALPHA = 0.002;
+const float SENSOR_NOISE_RATIO = 6.0;        // over the learned floor
+const float SENSOR_NOISE_MIN_KPA = 3.0;      // and over this, so a quiet sensor's floor is not a hair trigger
+const int SENSOR_NOISE_WARMUP_TICKS = 50;
+const int SENSOR_NOISE_SETTLED_TICKS = 1000; // the floor's averaging has reached SENSOR_NOISE_FLOOR_ALPHA
+const float SENSOR_FAILSAFE_DEFAULT_PERCENT = 0.0;   // wastegate open
+
+struct SensorFaultLimits {
+    float railLowV, railHighV;   // pin volts, offset removed
+};
+
+struct SensorFaultMonitor {
+    uint8_t active;              // latched SensorFaultCode
+    float detail;                // what tripped it: volts, kPa/s, kPa, or the duty span
+    int ticks;                   // since init or clear, up to SENSOR_NOISE_SETTLED_TICKS
+    float lastkPa, prevkPa;
+    // -- Stuck: the current run inside the band --
+    int stuckTicks;              // up to SENSOR_STUCK_TICKS
+    float voltMin, voltMax, dutyMin, dutyMax;
+    // -- Slew: one bit per tick, newest in bit 0 --
+    uint8_t slewHistory;
+    // -- Noise --
+    float noiseFast, noiseFloor;
+};
+
+#define SENSOR_FAULT_LOG_SIZE 8
+
+struct SensorFaultRecord {
+    uint8_t code;
+    uint32_t timeMs;             // uptime when raised
+    float voltage;               // MAP pin voltage that tick
+    float detail;
+};
+
+struct SensorFaultLog {
+    SensorFaultRecord records[SENSOR_FAULT_LOG_SIZE];
+    uint8_t next;                // slot the next record goes in
+    uint8_t count;
+    bool dirty;                  // added to since last persisted
+};
+
+const char* sensorFaultName(uint8_t code);
+
+void sensorFaultInit(SensorFaultMonitor& monitor);
+// One tick. pinVoltage has the offset removed; dutyPercent is what was applied
+// since the last tick, and underBoost says whether it can move the pressure
+// (off boost the wastegate is shut whatever the duty). Returns the fault raised this tick, SENSOR_FAULT_NONE
+// if none (including while one is already latched).
+uint8_t sensorFaultUpdate(SensorFaultMonitor& monitor, const SensorFaultLimits& limits, float pinVoltage, float rawkPa,
+                          float dutyPercent, bool underBoost, float dtMs);
+// Re-arms the monitor; the checks start over as after power-up.
+void sensorFaultClear(SensorFaultMonitor& monitor);
+
+void sensorFaultLogClear(SensorFaultLog& log);
+// Clears the log if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool sensorFaultLogSanitize(SensorFaultLog& log);
+void sensorFaultLogAdd(SensorFaultLog& log, const SensorFaultRecord& record);
+// age 0 is the newest record; false past the oldest.
+bool sensorFaultLogGet(const SensorFaultLog& log, int age, SensorFaultRecord& record);
+
+#endif // SENSORFAULT_H
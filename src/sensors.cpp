@@ -0,0 +1,604 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "sensors.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void sensorAveragerInit(SensorAverager& averager, int window) {
+    averager.correction = nullptr;
+    averager.spikeWindow = 0;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        spikeRejectorReset(averager.spike[c]);
+        averager.sum[c] = 0;
+        averager.head[c] = 0;
+        averager.filled[c] = 0;
+        for (int i = 0; i < SENSOR_AVERAGE_MAX; i++) averager.codes[c][i] = 0;
+    }
+    averager.window = 1;
+    sensorAveragerSetWindow(averager, window);
+}
+
+void sensorAveragerSetWindow(SensorAverager& averager, int window) {
+    if (window < 1) window = 1;
+    if (window > SENSOR_AVERAGE_MAX) window = SENSOR_AVERAGE_MAX;
+    if (window == averager.window) return;
+    averager.window = window;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        int count = averager.filled[c] < window ? averager.filled[c] : window;
+        uint32_t sum = 0;
+        for (int i = 1; i <= count; i++) {
+            sum += averager.codes[c][(averager.head[c] - i + SENSOR_AVERAGE_MAX) % SENSOR_AVERAGE_MAX];
+        }
+        averager.sum[c] = sum;
+    }
+}
+
+void sensorAveragerSetCorrection(SensorAverager& averager, const AdcCorrection* correction) {
+    averager.correction = correction;
+}
+
+void sensorAveragerSetSpikeWindow(SensorAverager& averager, int window) {
+    if (window < 3) {
+        window = 0;
+    } else {
+        if (window > SPIKE_WINDOW_MAX) window = SPIKE_WINDOW_MAX;
+        window |= 1;
+    }
+    if (window == averager.spikeWindow) return;
+    averager.spikeWindow = window;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) spikeRejectorReset(averager.spike[c]);
+}
+
+bool spikeWindowValid(int window) {
+    return window == 0 || (window >= 3 && window <= SPIKE_WINDOW_MAX && (window & 1));
+}
+
+void sensorAveragerPush(SensorAverager& averager, int channel, uint16_t code) {
+    if (channel < 0 || channel >= SENSOR_CHANNEL_COUNT) return;
+    if (averager.spikeWindow) code = spikeRejectorStep(averager.spike[channel], averager.spikeWindow, code);
+    int head = averager.head[channel];
+    // The code leaving the window is still in the ring, since the ring is at
+    // least as long as the window; read it before head overwrites it.
+    if (averager.filled[channel] >= averager.window) {
+        averager.sum[channel] -= averager.codes[channel][(head - averager.window + SENSOR_AVERAGE_MAX) % SENSOR_AVERAGE_MAX];
+    }
+    averager.codes[channel][head] = code;
+    averager.sum[channel] += code;
+    averager.head[channel] = (head + 1) % SENSOR_AVERAGE_MAX;
+    if (averager.filled[channel] < SENSOR_AVERAGE_MAX) averager.filled[channel]++;
+}
+
+void sensorAveragerSample(const SensorAverager& averager, uint32_t timeMs, SensorSample& sample) {
+    sample.timeMs = timeMs;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        int count = averager.filled[c] < averager.window ? averager.filled[c] : averager.window;
+        sample.samples[c] = (uint16_t)count;
+        float code = count > 0 ? (float)averager.sum[c] / count : 0.0f;
+        sample.voltage[c] = adcCodeToVolts(averager.correction, code);
+    }
+}
+
+bool sensorAveragerRecent(const SensorAverager& averager, int channel, int count, float& voltage) {
+    if (channel < 0 || channel >= SENSOR_CHANNEL_COUNT || count < 1 || count > averager.filled[channel]) return false;
+    uint32_t sum = 0;
+    for (int i = 1; i <= count; i++) {
+        sum += averager.codes[channel][(averager.head[channel] - i + SENSOR_AVERAGE_MAX) % SENSOR_AVERAGE_MAX];
+    }
+    voltage = adcCodeToVolts(averager.correction, (float)sum / count);
+    return true;
+}
+
+void oversamplePolicyInit(OversamplePolicy& policy, int window) {
+    policy.primed = false;
+    policy.noiseVariance = 0;
+    policy.rate = 0;
+    policy.window = window;
+}
+
+int oversamplePolicyUpdate(OversamplePolicy& policy, const SensorAverager& averager, int channel, int minWindow, int maxWindow) {
+    if (maxWindow > SENSOR_AVERAGE_MAX) maxWindow = SENSOR_AVERAGE_MAX;
+    if (maxWindow < 1) maxWindow = 1;
+    if (minWindow < 1) minWindow = 1;
+    if (minWindow > maxWindow) minWindow = maxWindow;
+    const int span = OVERSAMPLE_RATE_SPAN;
+    if (channel < 0 || channel >= SENSOR_CHANNEL_COUNT || averager.filled[channel] < 2 * span) {
+        policy.window = maxWindow;
+        return maxWindow;
+    }
+
+    // One pass over the newest 2 * span conversions, newest first.
+    const uint16_t* codes = averager.codes[channel];
+    int index = averager.head[channel];
+    int32_t newer = 0, older = 0, previous = -1;
+    uint32_t differenceSq = 0;
+    for (int i = 0; i < 2 * span; i++) {
+        index = index == 0 ? SENSOR_AVERAGE_MAX - 1 : index - 1;
+        int32_t code = codes[index];
+        if (i < span) newer += code;
+        else older += code;
+        if (previous >= 0) differenceSq += (uint32_t)((code - previous) * (code - previous));
+        previous = code;
+    }
+    // White noise of variance s^2 gives successive differences of variance 2 s^2.
+    float variance = (float)differenceSq / (2.0f * (2 * span - 1));
+    if (!policy.primed) {
+        policy.noiseVariance = variance;
+        policy.primed = true;
+    } else {
+        policy.noiseVariance += OVERSAMPLE_NOISE_SMOOTHING * (variance - policy.noiseVariance);
+    }
+    // Difference of two span means, span conversions apart.
+    float scale = SENSOR_SCAN_HZ / ((float)span * span);
+    policy.rate = (float)(newer - older) * scale;
+    float rateSigma = sqrtf(2.0f * policy.noiseVariance / span) * SENSOR_SCAN_HZ / span;
+    float excess = fabsf(policy.rate) - OVERSAMPLE_RATE_SIGMAS * rateSigma;
+
+    int target = maxWindow;
+    if (excess > 0.0f) {
+        float best = cbrtf(2.0f * policy.noiseVariance * SENSOR_SCAN_HZ * SENSOR_SCAN_HZ / (excess * excess));
+        if (best < (float)maxWindow) target = best < (float)minWindow ? minWindow : (int)best;
+    }
+    int window = policy.window < minWindow ? minWindow : (policy.window > maxWindow ? maxWindow : policy.window);
+    if (target < window) {
+        window = target;
+    } else {
+        int grown = window + (window >> 2 > 1 ? window >> 2 : 1);
+        window = grown < target ? grown : target;
+    }
+    policy.window = window;
+    return window;
+}
+
+void spikeRejectorReset(SpikeRejector& rejector) {
+    rejector.next = 0;
+    rejector.filled = 0;
+}
+
+// First index of sorted[0..count) not less than code.
+static int lowerBound(const uint16_t* sorted, int count, uint16_t code) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (sorted[mid] < code) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+uint16_t spikeRejectorStep(SpikeRejector& rejector, int window, uint16_t code) {
+    uint16_t* sorted = rejector.sorted;
+    int i;
+    if (rejector.filled < window) {
+        // Still filling: an insertion.
+        i = rejector.filled++;
+        while (i > 0 && sorted[i - 1] > code) {
+            sorted[i] = sorted[i - 1];
+            i--;
+        }
+    } else {
+        // The oldest code's slot is reused for the new one and slid into place;
+        // successive conversions are close, so the slide is usually short.
+        uint16_t oldest = rejector.recent[rejector.next];
+        i = lowerBound(sorted, window, oldest);
+        if (code > oldest) {
+            for (; i + 1 < window && sorted[i + 1] < code; i++) sorted[i] = sorted[i + 1];
+        } else {
+            for (; i > 0 && sorted[i - 1] > code; i--) sorted[i] = sorted[i - 1];
+        }
+    }
+    sorted[i] = code;
+    rejector.recent[rejector.next] = code;
+    if (++rejector.next == window) rejector.next = 0;
+    if (rejector.filled < window) return code;
+
+    int half = window >> 1;
+    int median = sorted[half];
+    int deviation = code > median ? code - median : median - code;
+    if (deviation <= SPIKE_MIN_CODES) return code;   // the usual case; no threshold can be lower
+
+    // Median absolute deviation: the deviations below and above the median
+    // are each ascending outwards, so merging them finds the median of all
+    // of them (the median's own zero is the smallest) in half a window.
+    int below = half - 1, above = half + 1, mad = 0;
+    for (int n = 0; n < half; n++) {
+        int down = below >= 0 ? median - sorted[below] : 0x10000;
+        int up = above < window ? sorted[above] - median : 0x10000;
+        if (down <= up) {
+            mad = down;
+            below--;
+        } else {
+            mad = up;
+            above++;
+        }
+    }
+    float threshold = SPIKE_MAD_SCALE * mad;
+    if (threshold < SPIKE_MIN_CODES) threshold = SPIKE_MIN_CODES;
+    return deviation > threshold ? (uint16_t)median : code;
+}
+
+float sensorValue(const SensorCalibration& calibration, float dividerRatio, float pinVoltage) {
+    float span = calibration.rawMaxVoltage - calibration.rawMinVoltage;
+    if (span <= 0.0f) return calibration.minValue;   // mid-edit; the console sets one end at a time
+    float sensorVoltage = pinVoltage / dividerRatio;
+    return (sensorVoltage - calibration.rawMinVoltage) * (calibration.maxValue - calibration.minValue) / span + calibration.minValue;
+}
+
+bool sensorCalibrationSanitize(SensorCalibration& calibration, const SensorCalibration& defaults) {
+    const float values[] = {calibration.rawMinVoltage, calibration.rawMaxVoltage, calibration.minValue, calibration.maxValue};
+    bool clean = true;
+    for (float v : values) {
+        if (isnan(v) || isinf(v)) clean = false;
+    }
+    if (clean && calibration.rawMaxVoltage <= calibration.rawMinVoltage) clean = false;
+    if (!clean) calibration = defaults;
+    return clean;
+}
+
+float supplyCompensationFactor(float supplyVoltage, float nominalVoltage) {
+    if (supplyVoltage < SUPPLY_VALID_MIN_V || nominalVoltage <= 0.0f) return 1.0f;
+    float factor = nominalVoltage / supplyVoltage;
+    if (factor < SUPPLY_COMP_MIN) factor = SUPPLY_COMP_MIN;
+    if (factor > SUPPLY_COMP_MAX) factor = SUPPLY_COMP_MAX;
+    return factor;
+}
+
+float supplyCompensatedDuty(float dutyPercent, float supplyVoltage, float nominalVoltage) {
+    // Full-on requests stay full on, so spool-up is not cut short by a high supply.
+    if (dutyPercent >= SUPPLY_COMP_FULL_PERCENT) return dutyPercent;
+    float duty = dutyPercent * supplyCompensationFactor(supplyVoltage, nominalVoltage);
+    if (duty > 100.0f) duty = 100.0f;
+    return duty;
+}
+
+float intakeTempTrimkPa(float intakeTempC, float startC, float kPaPerC) {
+    if (kPaPerC <= 0.0f || intakeTempC <= startC) return 0.0f;
+    float trim = (intakeTempC - startC) * kPaPerC;
+    if (trim > IAT_TRIM_MAX_KPA) trim = IAT_TRIM_MAX_KPA;
+    return -trim;
+}
+
+//================================================================================
+// ADC CORRECTION
+//================================================================================
+const char* adcCalibrationSourceName(int source) {
+    switch (source) {
+        case ADC_CAL_EFUSE_VREF: return "eFuse Vref";
+        case ADC_CAL_EFUSE_TWO_POINT: return "eFuse two-point";
+        case ADC_CAL_EFUSE_CURVE: return "eFuse curve fit";
+        default: return "none";
+    }
+}
+
+bool adcCorrectionBuild(AdcCorrection& correction, const AdcCharacterization& characterization) {
+    correction.enabled = false;
+    if (characterization.source <= ADC_CAL_NONE || characterization.source >= ADC_CAL_SOURCE_COUNT) return false;
+    const float* mv = characterization.millivolts;
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) {
+        float ideal = (float)(i * ADC_CORRECTION_STEP) * ADC_VOLTS_PER_CODE * 1000.0f;
+        if (isnan(mv[i]) || fabsf(mv[i] - ideal) > ADC_CORRECTION_MAX_DEVIATION_MV) return false;
+        // Flat is allowed (the top end saturates); falling is not.
+        if (i > 0 && mv[i] < mv[i - 1]) return false;
+    }
+    if (mv[ADC_CORRECTION_POINTS - 1] <= mv[0]) return false;
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) correction.volts[i] = mv[i] * 0.001f;
+    for (int i = 0; i < ADC_CORRECTION_POINTS - 1; i++) {
+        correction.voltsPerCode[i] = (correction.volts[i + 1] - correction.volts[i]) * (1.0f / ADC_CORRECTION_STEP);
+    }
+    correction.enabled = true;
+    return true;
+}
+
+float adcCodeToVolts(const AdcCorrection* correction, float code) {
+    if (!correction || !correction->enabled) return code * ADC_VOLTS_PER_CODE;
+    int i = (int)(code * (1.0f / ADC_CORRECTION_STEP));
+    if (i < 0) i = 0;
+    if (i > ADC_CORRECTION_POINTS - 2) i = ADC_CORRECTION_POINTS - 2;
+    return correction->volts[i] + (code - (float)(i * ADC_CORRECTION_STEP)) * correction->voltsPerCode[i];
+}
+
+//================================================================================
+// CALIBRATION TABLES
+//================================================================================
+void calibrationTableReset(CalibrationTable& table) {
+    table.enabled = 0;
+    table.interpolation = CAL_INTERP_LINEAR;
+    table.count = 0;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        table.volts[i] = 0.0f;
+        table.value[i] = 0.0f;
+    }
+}
+
+bool calibrationPointsValid(const float* volts, const float* value, int count) {
+    if (count < 2 || count > CAL_TABLE_POINTS) return false;
+    for (int i = 0; i < count; i++) {
+        if (isnan(volts[i]) || isinf(volts[i]) || isnan(value[i]) || isinf(value[i])) return false;
+    }
+    bool rising = value[1] > value[0];
+    for (int i = 1; i < count; i++) {
+        if (volts[i] <= volts[i - 1]) return false;
+        if (rising ? value[i] <= value[i - 1] : value[i] >= value[i - 1]) return false;
+    }
+    return true;
+}
+
+bool calibrationTableSanitize(CalibrationTable& table) {
+    bool clean = (table.enabled == 0 || table.enabled == 1) && table.interpolation >= 0 &&
+                 table.interpolation < CAL_INTERP_COUNT &&
+                 (table.count == 0 || calibrationPointsValid(table.volts, table.value, table.count));
+    if (!clean) calibrationTableReset(table);
+    return clean;
+}
+
+bool calibrationTableParse(CalibrationTable& table, const char* text) {
+    float volts[CAL_TABLE_POINTS] = {0};
+    float value[CAL_TABLE_POINTS] = {0};
+    int count = 0;
+    const char* p = text;
+    while (*p) {
+        if (count == CAL_TABLE_POINTS) return false;
+        char* end = nullptr;
+        volts[count] = strtof(p, &end);
+        if (end == p || *end != ':') return false;
+        p = end + 1;
+        value[count] = strtof(p, &end);
+        if (end == p) return false;
+        count++;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p != '\0') return false;
+    }
+    if (count > 0 && !calibrationPointsValid(volts, value, count)) return false;
+    table.count = count;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        table.volts[i] = volts[i];
+        table.value[i] = value[i];
+    }
+    return true;
+}
+
+void calibrationTableFormat(const CalibrationTable& table, char* buffer, int size) {
+    int used = 0;
+    if (size > 0) buffer[0] = '\0';
+    for (int i = 0; i < table.count && used < size; i++) {
+        used += snprintf(buffer + used, size - used, "%s%.6g:%.6g", i ? "," : "", (double)table.volts[i], (double)table.value[i]);
+    }
+}
+
+static const char* const SENSOR_CHANNEL_KEYS[SENSOR_CHANNEL_COUNT] = {"map", "emap", "iat", "supply"};
+
+int sensorChannelFromKey(const char* key) {
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        if (strcmp(key, SENSOR_CHANNEL_KEYS[c]) == 0) return c;
+    }
+    return -1;
+}
+
+const char* sensorChannelKey(int channel) {
+    return (channel >= 0 && channel < SENSOR_CHANNEL_COUNT) ? SENSOR_CHANNEL_KEYS[channel] : "?";
+}
+
+void calibrationCurveInit(CalibrationCurve& curve) {
+    curve.built = false;
+    curve.usable = false;
+}
+
+void calibrationCurveUpdate(CalibrationCurve& curve, const CalibrationTable& table, float scale) {
+    // A table that is off stays unused whatever its points; enabling it differs from builtFrom.
+    if (curve.built && !curve.usable && !table.enabled) return;
+    if (curve.built && curve.builtScale == scale && memcmp(&curve.builtFrom, &table, sizeof(table)) == 0) return;
+    curve.built = true;
+    curve.builtFrom = table;
+    curve.builtScale = scale;
+    curve.usable = table.enabled && scale > 0.0f && calibrationPointsValid(table.volts, table.value, table.count);
+    if (!curve.usable) return;
+
+    const int n = table.count;
+    float h[CAL_TABLE_POINTS - 1], delta[CAL_TABLE_POINTS - 1], slope[CAL_TABLE_POINTS];
+    for (int i = 0; i < n; i++) curve.knots[i] = table.volts[i] * scale;
+    for (int i = 0; i < n - 1; i++) {
+        h[i] = curve.knots[i + 1] - curve.knots[i];
+        delta[i] = (table.value[i + 1] - table.value[i]) / h[i];
+    }
+    if (table.interpolation != CAL_INTERP_CUBIC || n == 2) {
+        for (int i = 0; i < n - 1; i++) {
+            curve.coeff[i][0] = table.value[i];
+            curve.coeff[i][1] = delta[i];
+            curve.coeff[i][2] = 0.0f;
+            curve.coeff[i][3] = 0.0f;
+        }
+        curve.firstSlope = delta[0];
+        curve.lastSlope = delta[n - 2];
+    } else {
+        // Fritsch-Carlson: inside, the weighted harmonic mean of the
+        // neighbouring secants (the values are strictly monotone, so they
+        // share a sign); at the ends, the three-point estimate, zeroed if it
+        // points against the end secant.
+        for (int i = 1; i < n - 1; i++) {
+            float w1 = 2.0f * h[i] + h[i - 1], w2 = h[i] + 2.0f * h[i - 1];
+            slope[i] = (w1 + w2) / (w1 / delta[i - 1] + w2 / delta[i]);
+        }
+        slope[0] = ((2.0f * h[0] + h[1]) * delta[0] - h[0] * delta[1]) / (h[0] + h[1]);
+        if (slope[0] * delta[0] <= 0.0f) slope[0] = 0.0f;
+        slope[n - 1] = ((2.0f * h[n - 2] + h[n - 3]) * delta[n - 2] - h[n - 2] * delta[n - 3]) / (h[n - 2] + h[n - 3]);
+        if (slope[n - 1] * delta[n - 2] <= 0.0f) slope[n - 1] = 0.0f;
+        for (int i = 0; i < n - 1; i++) {
+            curve.coeff[i][0] = table.value[i];
+            curve.coeff[i][1] = slope[i];
+            curve.coeff[i][2] = (3.0f * delta[i] - 2.0f * slope[i] - slope[i + 1]) / h[i];
+            curve.coeff[i][3] = (slope[i] + slope[i + 1] - 2.0f * delta[i]) / (h[i] * h[i]);
+        }
+        // A flat end would read the same for everything beyond it; carry on along the secant instead.
+        curve.firstSlope = slope[0] != 0.0f ? slope[0] : delta[0];
+        curve.lastSlope = slope[n - 1] != 0.0f ? slope[n - 1] : delta[n - 2];
+    }
+
+    curve.segments = n - 1;
+    const float span = curve.knots[n - 1] - curve.knots[0];
+    curve.segmentsPerVolt = curve.segments / span;
+    curve.uniform = true;
+    for (int i = 0; i < n - 1; i++) {
+        if (fabsf(h[i] * curve.segmentsPerVolt - 1.0f) > 1e-4f) curve.uniform = false;
+    }
+}
+
+static float segmentValue(const CalibrationCurve& curve, int i, float pinVoltage) {
+    float t = pinVoltage - curve.knots[i];
+    const float* c = curve.coeff[i];
+    return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+}
+
+float calibrationCurveValue(const CalibrationCurve& curve, float pinVoltage) {
+    const int last = curve.segments;
+    if (pinVoltage <= curve.knots[0]) return curve.coeff[0][0] + (pinVoltage - curve.knots[0]) * curve.firstSlope;
+    if (pinVoltage >= curve.knots[last]) {
+        return curve.builtFrom.value[last] + (pinVoltage - curve.knots[last]) * curve.lastSlope;
+    }
+    int i;
+    if (curve.uniform) {
+        // Rounding may land a hair either side of a knot; both segments meet there.
+        i = (int)((pinVoltage - curve.knots[0]) * curve.segmentsPerVolt);
+        if (i >= last) i = last - 1;
+    } else {
+        int lo = 0, hi = last;   // knots[lo] < pinVoltage < knots[hi]
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (pinVoltage < curve.knots[mid]) hi = mid;
+            else lo = mid;
+        }
+        i = lo;
+    }
+    return segmentValue(curve, i, pinVoltage);
+}
+
+float calibrationCurveVoltage(const CalibrationCurve& curve, float value, float& slope) {
+    const int last = curve.segments;
+    const float* values = curve.builtFrom.value;
+    // Flip a falling table so the search below only deals with rising values.
+    const float sign = values[last] > values[0] ? 1.0f : -1.0f;
+    if (sign * value <= sign * values[0]) {
+        slope = curve.firstSlope;
+        return curve.knots[0] + (value - values[0]) / slope;
+    }
+    if (sign * value >= sign * values[last]) {
+        slope = curve.lastSlope;
+        return curve.knots[last] + (value - values[last]) / slope;
+    }
+    int i = 0;
+    while (sign * values[i + 1] < sign * value) i++;
+    // Monotone within the segment: bisect to well under a millivolt.
+    float lo = curve.knots[i], hi = curve.knots[i + 1];
+    for (int k = 0; k < 24; k++) {
+        float mid = 0.5f * (lo + hi);
+        if (sign * segmentValue(curve, i, mid) < sign * value) lo = mid;
+        else hi = mid;
+    }
+    float v = 0.5f * (lo + hi);
+    float t = v - curve.knots[i];
+    const float* c = curve.coeff[i];
+    slope = c[1] + t * (2.0f * c[2] + t * 3.0f * c[3]);
+    if (slope == 0.0f) slope = (values[i + 1] - values[i]) / (curve.knots[i + 1] - curve.knots[i]);
+    return v;
+}
+
+void calibrationCurveChord(const CalibrationCurve& curve, float& slope, float& offset) {
+    const int last = curve.segments;
+    slope = (curve.builtFrom.value[last] - curve.builtFrom.value[0]) / (curve.knots[last] - curve.knots[0]);
+    offset = curve.builtFrom.value[0] - curve.knots[0] * slope;
+}
+
+//================================================================================
+// CALIBRATION WIZARD
+//================================================================================
+const char* calWizardResultName(CalWizardResult result) {
+    switch (result) {
+        case CALWIZ_RECORDED: return "recorded";
+        case CALWIZ_REPLACED: return "replaced";
+        case CALWIZ_UNSTABLE: return "reading unstable";
+        case CALWIZ_FULL: return "table full";
+        default: return "none";
+    }
+}
+
+void calibrationWizardStart(CalibrationWizard& wizard, int channel) {
+    wizard.phase = CALWIZ_WAITING;
+    wizard.channel = channel;
+    wizard.count = 0;
+    wizard.finished = 0;
+    wizard.result = CALWIZ_NONE;
+    wizard.resultVolts = 0.0f;
+    wizard.resultNoise = 0.0f;
+}
+
+void calibrationWizardCancel(CalibrationWizard& wizard) {
+    wizard.phase = CALWIZ_IDLE;
+}
+
+bool calibrationWizardPoint(CalibrationWizard& wizard, float reference, uint32_t timeMs) {
+    if (wizard.phase != CALWIZ_WAITING || isnan(reference) || isinf(reference)) return false;
+    wizard.phase = CALWIZ_AVERAGING;
+    wizard.reference = reference;
+    wizard.startMs = timeMs;
+    wizard.samples = 0;
+    wizard.mean = 0.0f;
+    wizard.m2 = 0.0f;
+    return true;
+}
+
+void calibrationWizardStep(CalibrationWizard& wizard, float sensorVolts, uint32_t timeMs) {
+    if (wizard.phase != CALWIZ_AVERAGING) return;
+    wizard.samples++;
+    float deviation = sensorVolts - wizard.mean;
+    wizard.mean += deviation / wizard.samples;
+    wizard.m2 += deviation * (sensorVolts - wizard.mean);
+    if (timeMs - wizard.startMs < CAL_WIZARD_AVERAGE_MS) return;
+
+    float noise = wizard.samples > 1 ? sqrtf(wizard.m2 / (wizard.samples - 1)) : 0.0f;
+    CalWizardResult result = CALWIZ_RECORDED;
+    int slot = wizard.count;
+    for (int i = 0; i < wizard.count; i++) {
+        if (fabsf(wizard.volts[i] - wizard.mean) < CAL_WIZARD_MIN_SPACING_V) {
+            slot = i;
+            result = CALWIZ_REPLACED;
+        }
+    }
+    if (noise > CAL_WIZARD_MAX_NOISE_V) result = CALWIZ_UNSTABLE;
+    else if (slot == CAL_TABLE_POINTS) result = CALWIZ_FULL;
+    if (result == CALWIZ_RECORDED || result == CALWIZ_REPLACED) {
+        wizard.volts[slot] = wizard.mean;
+        wizard.value[slot] = wizard.reference;
+        if (slot == wizard.count) wizard.count++;
+    }
+    wizard.result = result;
+    wizard.resultVolts = wizard.mean;
+    wizard.resultNoise = noise;
+    wizard.finished++;
+    wizard.phase = CALWIZ_WAITING;
+}
+
+bool calibrationWizardFinish(CalibrationWizard& wizard, CalibrationTable& table) {
+    if (wizard.phase != CALWIZ_WAITING) return false;
+    float volts[CAL_TABLE_POINTS], value[CAL_TABLE_POINTS];
+    int count = wizard.count;
+    // Insertion sort by voltage; the points arrive in whatever order the gauge was set.
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        for (; j > 0 && volts[j - 1] > wizard.volts[i]; j--) {
+            volts[j] = volts[j - 1];
+            value[j] = value[j - 1];
+        }
+        volts[j] = wizard.volts[i];
+        value[j] = wizard.value[i];
+    }
+    if (!calibrationPointsValid(volts, value, count)) return false;
+    table.count = count;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        table.volts[i] = i < count ? volts[i] : 0.0f;
+        table.value[i] = i < count ? value[i] : 0.0f;
+    }
+    table.enabled = 1;
+    wizard.phase = CALWIZ_IDLE;
+    return true;
+}
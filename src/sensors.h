@@ -0,0 +1,345 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdint.h>
+
+//================================================================================
+// MULTI-CHANNEL SENSOR SAMPLES
+//================================================================================
+// The ADC scans every analog input in one hardware pass (continuous DMA mode on
+// the ESP32, see adc_scan.cpp), so the control task never blocks on a
+// conversion. Each conversion is pushed into a per-channel ring; once a tick
+// the rings are averaged over the last OVERSAMPLE_COUNT conversions and the
+// averages are published together as one SensorSample with one timestamp.
+//
+// Ahead of the rings, an optional Hampel filter runs over each channel's raw
+// conversions: a conversion further from the median of the newest few than
+// SPIKE_MAD_SCALE times their median absolute deviation (and at least
+// SPIKE_MIN_CODES) is replaced by that median. Ignition and injector spikes of
+// one or two conversions then never reach the average, while ordinary noise
+// and steps pass through untouched. The window is kept sorted beside its ring,
+// so each conversion costs a binary search and a move of the few codes
+// between the old and new value's places.
+//
+// The averaging window can follow the signal instead of staying at
+// OVERSAMPLE_COUNT: OversamplePolicy estimates the conversion noise (from
+// successive differences, so a ramp does not count as noise) and the rate of
+// change (the newest OVERSAMPLE_RATE_SPAN conversions against the span
+// before) once a tick. It picks the window that minimizes lag error plus
+// noise, about cbrt(2 sigma^2 f^2 / rate^2) at f conversions a second. A rate
+// within OVERSAMPLE_RATE_SIGMAS standard errors of zero counts as steady and
+// gets the longest window. The window shrinks at once when a transient starts
+// and grows back by at most a quarter per tick, so the reading never jumps
+// when the window changes.
+//
+// The averaged code becomes a pin voltage through the chip's own ADC
+// calibration when ADC correction is on (see ADC CORRECTION below), or the
+// ideal code / 4095 * 3.3 V otherwise.
+//
+// Every auxiliary channel is calibrated like the MAP sensor: the pin voltage
+// is scaled back through its divider to the sensor's output voltage, then
+// mapped linearly from [rawMinVoltage, rawMaxVoltage] onto [minValue, maxValue].
+// A calibration table (below) replaces that line for any channel.
+
+enum SensorChannel {
+    SENSOR_MAP,
+    SENSOR_BACKPRESSURE,     // exhaust manifold pressure, kPa absolute
+    SENSOR_IAT,              // intake air temperature, deg C
+    SENSOR_SUPPLY,           // 12 V supply that feeds the solenoid, V
+    SENSOR_CHANNEL_COUNT
+};
+
+#define SENSOR_AVERAGE_MAX 512       // largest oversample window per channel
+const float SENSOR_SCAN_HZ = 20000.0;   // conversions per second per channel
+#define SPIKE_WINDOW_MAX 15          // longest spike-rejection window, conversions
+const int SPIKE_WINDOW_DEFAULT = 7;  // removes spikes of up to 3 conversions
+const float SPIKE_MAD_SCALE = 4.45;  // 3 sigma of Gaussian noise, in median absolute deviations
+const int SPIKE_MIN_CODES = 12;      // never reject closer than this to the median
+constexpr float ADC_FULL_SCALE_CODE = 4095.0f;
+constexpr float ADC_FULL_SCALE_VOLTS = 3.3f;
+constexpr float ADC_VOLTS_PER_CODE = ADC_FULL_SCALE_VOLTS / ADC_FULL_SCALE_CODE;
+
+// -- Supply compensation and IAT trim --
+const float SUPPLY_VALID_MIN_V = 6.0;       // below this the supply input is taken as not wired
+const float SUPPLY_COMP_MIN = 0.75;         // limits on the duty correction factor
+const float SUPPLY_COMP_MAX = 1.5;
+const float SUPPLY_COMP_FULL_PERCENT = 99.0;  // the solenoid is held fully on from here; left uncorrected
+const float IAT_TRIM_MAX_KPA = 50.0;        // largest target reduction for hot intake air
+const float AUX_SENSOR_FILTER_MS = 500.0;   // low-pass on the auxiliary channels
+
+struct SensorCalibration {
+    float rawMinVoltage, rawMaxVoltage;   // sensor output at the ends of its range
+    float minValue, maxValue;             // reading at those voltages
+};
+
+const SensorCalibration BACKPRESSURE_CALIBRATION_DEFAULT = {0.4, 4.65, 20.0, 500.0};
+const SensorCalibration IAT_CALIBRATION_DEFAULT = {0.5, 4.5, -40.0, 150.0};
+const SensorCalibration SUPPLY_CALIBRATION_DEFAULT = {0.0, 16.0, 0.0, 16.0};
+
+// One synchronized scan, averaged.
+struct SensorSample {
+    uint32_t timeMs;                         // when the averaging window ended
+    float voltage[SENSOR_CHANNEL_COUNT];     // averaged pin voltage
+    uint16_t samples[SENSOR_CHANNEL_COUNT];  // conversions averaged; 0 = no data yet
+};
+
+struct SpikeRejector {
+    uint16_t recent[SPIKE_WINDOW_MAX];   // newest conversions in arrival order
+    uint16_t sorted[SPIKE_WINDOW_MAX];   // the same codes, ascending
+    int next, filled;
+};
+
+struct AdcCorrection;
+
+struct SensorAverager {
+    const AdcCorrection* correction;         // nullptr = ideal conversion
+    SpikeRejector spike[SENSOR_CHANNEL_COUNT];
+    int spikeWindow;                         // 0 = no spike rejection
+    uint16_t codes[SENSOR_CHANNEL_COUNT][SENSOR_AVERAGE_MAX];
+    uint32_t sum[SENSOR_CHANNEL_COUNT];      // of the newest 'window' codes
+    int head[SENSOR_CHANNEL_COUNT];
+    int filled[SENSOR_CHANNEL_COUNT];
+    int window;
+};
+
+const int OVERSAMPLE_MIN_DEFAULT = 16;
+const int OVERSAMPLE_RATE_SPAN = 64;            // conversions in each half of the rate estimate
+const float OVERSAMPLE_NOISE_SMOOTHING = 0.1;   // per tick, on the noise variance
+const float OVERSAMPLE_RATE_SIGMAS = 3.0;        // a rate below this many sigmas of noise is taken as none
+
+struct OversamplePolicy {
+    bool primed;
+    float noiseVariance;                     // codes^2 per conversion
+    float rate;                              // codes per second, last tick
+    int window;                              // current choice
+};
+
+// Calibrated readings after the low-pass, as the control pipeline uses them.
+struct AuxSensorState {
+    bool primed;
+    float backpressurekPa;
+    float intakeTempC;
+    float supplyVoltage;
+};
+
+// Starts with spike rejection and ADC correction off.
+void sensorAveragerInit(SensorAverager& averager, int window);
+// Converts averaged codes through correction from now on; nullptr (or a
+// correction that is not enabled) converts ideally.
+void sensorAveragerSetCorrection(SensorAverager& averager, const AdcCorrection* correction);
+// Changes the window (clamped to 1..SENSOR_AVERAGE_MAX); cost is one pass over
+// the ring, and only when the window actually changes.
+void sensorAveragerSetWindow(SensorAverager& averager, int window);
+// Spike rejection window: 0 (or anything under 3) turns it off, even windows
+// round up and the length is clamped to SPIKE_WINDOW_MAX. A change restarts
+// the rejectors, which pass conversions through until their window fills.
+void sensorAveragerSetSpikeWindow(SensorAverager& averager, int window);
+// 0, or odd from 3 to SPIKE_WINDOW_MAX.
+bool spikeWindowValid(int window);
+void sensorAveragerPush(SensorAverager& averager, int channel, uint16_t code);
+void sensorAveragerSample(const SensorAverager& averager, uint32_t timeMs, SensorSample& sample);
+// Pin voltage averaged over the newest count conversions of one channel,
+// regardless of the window; false until the channel has that many.
+bool sensorAveragerRecent(const SensorAverager& averager, int channel, int count, float& voltage);
+
+void oversamplePolicyInit(OversamplePolicy& policy, int window);
+// Once a tick, after the conversions are in: returns the window to average one
+// channel over, within minWindow..maxWindow (clamped to 1..SENSOR_AVERAGE_MAX).
+// Holds maxWindow until the channel has 2 * OVERSAMPLE_RATE_SPAN conversions.
+int oversamplePolicyUpdate(OversamplePolicy& policy, const SensorAverager& averager, int channel, int minWindow, int maxWindow);
+
+void spikeRejectorReset(SpikeRejector& rejector);
+// Pushes one conversion through a window of 'window' (odd, 3..SPIKE_WINDOW_MAX)
+// and returns it, or the window's median if it is a spike.
+uint16_t spikeRejectorStep(SpikeRejector& rejector, int window, uint16_t code);
+
+// Pin voltage to reading; dividerRatio is pin voltage over sensor voltage.
+float sensorValue(const SensorCalibration& calibration, float dividerRatio, float pinVoltage);
+// Resets to the defaults if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool sensorCalibrationSanitize(SensorCalibration& calibration, const SensorCalibration& defaults);
+
+// nominalVoltage / supplyVoltage within SUPPLY_COMP_MIN..MAX; 1 when the
+// supply reading is implausible.
+float supplyCompensationFactor(float supplyVoltage, float nominalVoltage);
+// Duty that gives the solenoid the same average drive at supplyVoltage as
+// dutyPercent does at nominalVoltage. Leaves the duty alone when the supply
+// reading is implausible.
+float supplyCompensatedDuty(float dutyPercent, float supplyVoltage, float nominalVoltage);
+// Target reduction (negative kPa) for intake air above startC.
+float intakeTempTrimkPa(float intakeTempC, float startC, float kPaPerC);
+
+//================================================================================
+// ADC CORRECTION
+//================================================================================
+// The ESP32-S3 ADC is not the ideal code / 4095 * 3.3 V. Gain and offset
+// differ from chip to chip by tens of millivolts, and at 11 dB attenuation the
+// response flattens towards the top of the range. Espressif measures each chip
+// at the factory and burns the result into eFuse, and the IDF's esp_adc_cal
+// turns it into a code-to-millivolt conversion. That conversion is far too
+// slow to call for every one of 80,000 conversions a second, so at boot it is
+// evaluated once at ADC_CORRECTION_POINTS evenly spaced codes (an
+// AdcCharacterization) and built into an AdcCorrection. An averaged code then
+// costs one index computation and a linear interpolation between the two
+// neighbouring points. The correction applies to the average, not to each
+// conversion; over the few codes of noise in a window the curve is straight,
+// so the two agree.
+//
+// A chip without eFuse calibration, or a characterization that is not
+// plausible, leaves the ideal conversion in place.
+
+const int ADC_CORRECTION_STEP = 65;           // codes between points
+#define ADC_CORRECTION_POINTS 64              // codes 0, 65, ..., 4095
+static_assert((ADC_CORRECTION_POINTS - 1) * ADC_CORRECTION_STEP == 4095, "points must span the 12-bit range");
+const float ADC_CORRECTION_MAX_DEVIATION_MV = 400.0;   // from the ideal conversion; more is taken as bad data
+
+enum AdcCalibrationSource {
+    ADC_CAL_NONE,              // no eFuse data; the IDF's default reference is not a calibration
+    ADC_CAL_EFUSE_VREF,        // eFuse reference voltage
+    ADC_CAL_EFUSE_TWO_POINT,   // eFuse two-point line
+    ADC_CAL_EFUSE_CURVE,       // eFuse two-point line with the curve-fitting correction
+    ADC_CAL_SOURCE_COUNT
+};
+
+// The chip's calibrated conversion, recorded at each point's code.
+struct AdcCharacterization {
+    int source;                                      // AdcCalibrationSource
+    float millivolts[ADC_CORRECTION_POINTS];         // at code i * ADC_CORRECTION_STEP
+};
+
+struct AdcCorrection {
+    bool enabled;                                    // false: ideal conversion
+    float volts[ADC_CORRECTION_POINTS];
+    float voltsPerCode[ADC_CORRECTION_POINTS - 1];   // slope of each segment
+};
+
+const char* adcCalibrationSourceName(int source);
+// Builds the correction; false, leaving it disabled, for no calibration or a
+// characterization that is not rising or strays more than
+// ADC_CORRECTION_MAX_DEVIATION_MV from the ideal conversion.
+bool adcCorrectionBuild(AdcCorrection& correction, const AdcCharacterization& characterization);
+// An averaged code (0 to 4095) to pin volts; ideal when correction is
+// nullptr or not enabled.
+float adcCodeToVolts(const AdcCorrection* correction, float code);
+
+//================================================================================
+// CALIBRATION TABLES
+//================================================================================
+// A two-point line cannot follow a sensor that is not straight, or a divider
+// and input stage that bend it. A CalibrationTable holds up to
+// CAL_TABLE_POINTS (sensor output voltage, reading) pairs measured against a
+// reference, and replaces the line for its channel when enabled. Between the
+// points the reading is interpolated linearly or by a monotone cubic
+// (Fritsch-Carlson), which never overshoots between points, so a rising table
+// always reads rising. Past the ends it carries on along the end slope.
+//
+// The table is built once, whenever it changes, into a CalibrationCurve: one
+// cubic per segment in pin volts. When the points are evenly spaced the
+// segment is found by one index computation; otherwise by a binary search
+// over the few points. Either way a reading costs one polynomial.
+//
+// The wizard records the points on the car or the bench: with a gauge (or
+// thermometer, or multimeter) on the same pressure as the sensor, each point
+// averages the sensor for CAL_WIZARD_AVERAGE_MS and pairs the mean with the
+// reading typed in. A reading that moves more than CAL_WIZARD_MAX_NOISE_V
+// over the average is refused, and a point within CAL_WIZARD_MIN_SPACING_V of
+// one already taken replaces it.
+
+#define CAL_TABLE_POINTS 10
+const uint32_t CAL_WIZARD_AVERAGE_MS = 1000;
+const float CAL_WIZARD_MAX_NOISE_V = 0.02;    // standard deviation, sensor volts
+const float CAL_WIZARD_MIN_SPACING_V = 0.05;
+
+enum CalibrationInterpolation {
+    CAL_INTERP_LINEAR,
+    CAL_INTERP_CUBIC,          // monotone piecewise cubic
+    CAL_INTERP_COUNT
+};
+
+struct CalibrationTable {
+    int enabled;
+    int interpolation;                   // CalibrationInterpolation
+    int count;                           // points in use: 0, or 2 to CAL_TABLE_POINTS
+    float volts[CAL_TABLE_POINTS];       // sensor output voltage, strictly rising
+    float value[CAL_TABLE_POINTS];       // reading there, strictly rising or strictly falling
+};
+
+struct CalibrationCurve {
+    bool built;
+    CalibrationTable builtFrom;          // table and scale the curve belongs to
+    float builtScale;
+    bool usable;                         // enabled with valid points; otherwise the line applies
+    bool uniform;                        // evenly spaced: the segment is found by index
+    int segments;
+    float segmentsPerVolt;
+    float knots[CAL_TABLE_POINTS];       // pin volts
+    float coeff[CAL_TABLE_POINTS - 1][4];  // c0 + t (c1 + t (c2 + t c3)), t = volts past the segment's knot
+    float firstSlope, lastSlope;         // per pin volt, beyond the ends
+};
+
+enum CalWizardPhase {
+    CALWIZ_IDLE,
+    CALWIZ_WAITING,            // for the next reference reading
+    CALWIZ_AVERAGING
+};
+
+enum CalWizardResult {
+    CALWIZ_NONE,
+    CALWIZ_RECORDED,
+    CALWIZ_REPLACED,           // close to an earlier point, which it replaced
+    CALWIZ_UNSTABLE,           // the reading moved during the average; not recorded
+    CALWIZ_FULL                // CAL_TABLE_POINTS already taken; not recorded
+};
+
+struct CalibrationWizard {
+    CalWizardPhase phase;
+    int channel;
+    float reference;                     // reading for the point being averaged
+    uint32_t startMs;
+    int samples;
+    float mean, m2;                      // running mean and sum of squared deviations, volts
+    int count;
+    float volts[CAL_TABLE_POINTS];       // in the order taken
+    float value[CAL_TABLE_POINTS];
+    int finished;                        // points averaged so far, for the reporter
+    CalWizardResult result;              // of the latest, with its mean and noise
+    float resultVolts, resultNoise;
+};
+
+// Disabled, linear, no points.
+void calibrationTableReset(CalibrationTable& table);
+// Resets the table if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool calibrationTableSanitize(CalibrationTable& table);
+// At least two points, volts strictly rising and values strictly monotone.
+bool calibrationPointsValid(const float* volts, const float* value, int count);
+// Points as "volts:value,volts:value,..." (empty clears them). Parse leaves the
+// table untouched and returns false on a malformed or non-monotone list.
+bool calibrationTableParse(CalibrationTable& table, const char* text);
+void calibrationTableFormat(const CalibrationTable& table, char* buffer, int size);
+// "map", "emap", "iat", "supply"; -1 for anything else.
+int sensorChannelFromKey(const char* key);
+const char* sensorChannelKey(int channel);
+
+void calibrationCurveInit(CalibrationCurve& curve);
+// Rebuilds when the table or scale changed since the last build; scale is pin
+// volts per sensor volt (the divider ratio).
+void calibrationCurveUpdate(CalibrationCurve& curve, const CalibrationTable& table, float scale);
+// Reading at a pin voltage; only meaningful while curve.usable.
+float calibrationCurveValue(const CalibrationCurve& curve, float pinVoltage);
+// Pin voltage that reads value, and the curve's slope (per pin volt) there.
+float calibrationCurveVoltage(const CalibrationCurve& curve, float value, float& slope);
+// The straight line through the end points, for thresholds set in reading units.
+void calibrationCurveChord(const CalibrationCurve& curve, float& slope, float& offset);
+
+const char* calWizardResultName(CalWizardResult result);
+void calibrationWizardStart(CalibrationWizard& wizard, int channel);
+void calibrationWizardCancel(CalibrationWizard& wizard);
+// Starts averaging a point for a reference reading; false unless waiting for one.
+bool calibrationWizardPoint(CalibrationWizard& wizard, float reference, uint32_t timeMs);
+// Once a tick with the channel's sensor output voltage.
+void calibrationWizardStep(CalibrationWizard& wizard, float sensorVolts, uint32_t timeMs);
+// Sorts the points by voltage into the table (interpolation kept) and enables
+// it; false, leaving the table alone, while a point is being averaged or
+// unless they form a valid table.
+bool calibrationWizardFinish(CalibrationWizard& wizard, CalibrationTable& table);
+
+#endif // SENSORS_H
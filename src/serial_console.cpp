@@ -0,0 +1,767 @@
+#include "config.h"
+#include <stdarg.h>
+
+//================================================================================
+// SERIAL CONSOLE
+//================================================================================
+// Line-based commands on the USB serial port, mainly for loading presets
+// exported by tools/sweep:
+//   key=value   set a parameter (keys from serialParams[])
+//   get         print every parameter as key=value
+//   save        store the current parameters (same as holding SAVE in a menu)
+//   save A|B    store the current parameters into profile A or B
+//   telemetry on|off   stream control and plant-identification values
+//   ff          print the learned feed-forward map
+//   ff clear    forget the learned feed-forward map
+//   gs          print the gain schedule tables
+//   gs reset    set every gain multiplier back to 1
+//   gs.kp.R.E=value  set one multiplier (also gs.ki / gs.kd); R = rate row, E = error column
+//   sp=ms:kPa,...    set the time-since-spool boost curve
+//   bm          print the RPM-by-gear boost map, with the current RPM and gear
+//   bm reset    set every boost map offset back to 0
+//   bm.G.R=value     set the kPa offset for gear G (1-6) at RPM column R (0 = 1000 rpm, 1000 rpm apart)
+//   gear.G=value     set gear G's engine RPM per km/h, for gear detection from the speed input
+//   sol         print the solenoid flow curve and dead time
+//   sol reset   set the curve back to a straight line with no dead time
+//   sol.N=value      set the flow (%) at breakpoint N (0-10, N * 10 % effective duty)
+//   sol cal     measure the curve on the bench (see reportSolenoidCharacterization)
+//   sol stop    abort the measurement
+//   ob          print the overboost guard: ceiling, last trip and its timing
+//   ob clear    re-arm the guard after a trip (same as CLR on the main screen)
+//   faults      print the active MAP sensor fault and the fault log, newest first
+//   faults clear     re-arm the sensor fault check (same as CLR on the main screen)
+//   faults reset     erase the fault log
+//   bench       time controlStep() on a scratch pipeline, in CPU cycles
+//   adc         print the chip's ADC calibration against the ideal conversion
+//   boot        print when each boot stage ran and how long it took
+//   power       print the idle power mode, time in each mode, estimated current and wake latency
+//   heap        print the free heap and any allocations since setup() (heap_guard.h)
+//   cal         print the sensor calibration tables with each sensor's output voltage now
+//   cal.S=V:X,...    set sensor S's table (S = map, emap, iat, supply): output voltage V reads X
+//   cal S reset      clear sensor S's table; its Min/Max line applies again
+//   cal S start      record sensor S's table against a reference gauge (see reportCalibrationWizard)
+//   cal point X      average the sensor and record it against the reference reading X
+//   cal done         sort the recorded points into the table and enable it
+//   cal stop         abort the recording
+
+// Print::printf() formats into 64 bytes on the stack and allocates for anything
+// longer, a telemetry line included; this formats into a static buffer
+// instead. Only the display task prints here.
+static void consolePrintf(const char* format, ...) {
+    static char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return;
+    if (length >= (int)sizeof(buffer)) length = sizeof(buffer) - 1;
+    Serial.write((const uint8_t*)buffer, length);
+}
+
+static const SerialParam* findSerialParam(const char* key) {
+    for (int i = 0; i < serialParamCount; i++) {
+        if (strcmp(serialParams[i].key, key) == 0) return &serialParams[i];
+    }
+    return nullptr;
+}
+
+static void printGainScheduleCells() {
+    static const char* const names[] = {"kp", "ki", "kd"};
+    for (int t = 0; t < 3; t++) {
+        for (int r = 0; r < GS_RATE_POINTS; r++) {
+            for (int e = 0; e < GS_ERROR_POINTS; e++) {
+                char key[16];
+                snprintf(key, sizeof(key), "%s.%d.%d", names[t], r, e);
+                consolePrintf("gs.%s=%.6g\n", key, *gainScheduleEntry(gainSchedule, key));
+            }
+        }
+    }
+}
+
+static bool setGainScheduleCell(const char* key, const char* value) {
+    float* cell = gainScheduleEntry(gainSchedule, key);
+    if (!cell) return false;
+    char* end = nullptr;
+    float v = strtof(value, &end);
+    if (end == value || isnan(v) || isinf(v) || v < 0 || v > GS_MULTIPLIER_MAX) return false;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        *cell = v;
+        xSemaphoreGive(dataMutex);
+    }
+    return true;
+}
+
+static void printSetpointCurve() {
+    SetpointProfile profile;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        profile = setpointProfile;
+        xSemaphoreGive(dataMutex);
+    }
+    char curve[SP_PROFILE_POINTS * 32];
+    setpointProfileFormat(profile, curve, sizeof(curve));
+    consolePrintf("sp=%s\n", curve);
+}
+
+static void printBoostMapCells() {
+    for (int g = 1; g <= RPM_MAP_GEARS; g++) {
+        for (int r = 0; r < RPM_MAP_POINTS; r++) {
+            char key[16];
+            snprintf(key, sizeof(key), "%d.%d", g, r);
+            consolePrintf("bm.%s=%.6g\n", key, *boostMapEntry(boostMap, key));
+        }
+    }
+    for (int g = 0; g < RPM_MAP_GEARS; g++) consolePrintf("gear.%d=%.6g\n", g + 1, gearRpmPerKph[g]);
+}
+
+// Boost map offsets ("G.R") and gear ratios ("gear.G") share the same value checks.
+static bool setRpmTableCell(const char* key, const char* value, bool gearRatio) {
+    float* cell = nullptr;
+    if (gearRatio) {
+        char* end = nullptr;
+        long g = strtol(key, &end, 10);
+        if (end != key && *end == '\0' && g >= 1 && g <= RPM_MAP_GEARS) cell = &gearRpmPerKph[g - 1];
+    } else {
+        cell = boostMapEntry(boostMap, key);
+    }
+    if (!cell) return false;
+    char* end = nullptr;
+    float v = strtof(value, &end);
+    if (end == value || isnan(v) || isinf(v)) return false;
+    if (gearRatio ? (v < 0 || v > 1000) : fabsf(v) > RPM_MAP_MAX_OFFSET_KPA) return false;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        *cell = v;
+        xSemaphoreGive(dataMutex);
+    }
+    return true;
+}
+
+static void printSolenoidCurveCells() {
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) consolePrintf("sol.%d=%.6g\n", i, solenoidCurve.flowPercent[i]);
+}
+
+static bool setSolenoidCurveCell(const char* key, const char* value) {
+    float* cell = solenoidCurveEntry(solenoidCurve, key);
+    if (!cell) return false;
+    char* end = nullptr;
+    float v = strtof(value, &end);
+    if (end == value || isnan(v) || isinf(v) || v < 0 || v > 100) return false;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        *cell = v;
+        xSemaphoreGive(dataMutex);
+    }
+    return true;
+}
+
+static void printCalibrationTables() {
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        char points[CAL_TABLE_POINTS * 32];
+        calibrationTableFormat(calibrationTables[c], points, sizeof(points));
+        if (calibrationTables[c].count > 0) consolePrintf("cal.%s=%s\n", sensorChannelKey(c), points);
+    }
+}
+
+static bool setCalibrationTable(const char* key, const char* value) {
+    int channel = sensorChannelFromKey(key);
+    if (channel < 0) return false;
+    bool ok = false;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        ok = calibrationTableParse(calibrationTables[channel], value);
+        xSemaphoreGive(dataMutex);
+    }
+    return ok;
+}
+
+static void showCalibrationTables() {
+    static CalibrationTable tables[SENSOR_CHANNEL_COUNT];   // too large for this task's stack
+    static ControlParams params;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) tables[c] = calibrationTables[c];
+        fillControlParams(params);
+        xSemaphoreGive(dataMutex);
+    }
+    static const char* const interpolations[CAL_INTERP_COUNT] = {"linear", "cubic"};
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        const CalibrationTable& t = tables[c];
+        float pin = 0;
+        bool live = readRecentSensorVoltage(c, OVERSAMPLE_COUNT, pin);
+        bool valid = calibrationPointsValid(t.volts, t.value, t.count);
+        consolePrintf("%s: %s, %s, %d points%s", sensorChannelKey(c), t.enabled ? "enabled" : "disabled",
+                      interpolations[t.interpolation], t.count, t.enabled && !valid ? " (too few, line in use)" : "");
+        if (live) consolePrintf(", sensor now %.4f V", sensorOutputVoltage(params, c, pin));
+        Serial.println();
+        for (int i = 0; i < t.count; i++) consolePrintf("  %.4f V = %.6g\n", t.volts[i], t.value[i]);
+    }
+}
+
+// The chip's ADC calibration beside the ideal conversion every ninth point,
+// then every point as adc.source= / adc.mv= lines for tools/adccal --chip.
+static void showAdcCorrection() {
+    bool usable = false;
+    const AdcCharacterization& chip = sensorAdcCharacterization(usable);
+    consolePrintf("ADC calibration: %s; correction %s\n", adcCalibrationSourceName(chip.source),
+                  !usable ? "unavailable, ideal conversion in use" : (adcCorrectionEnabled ? "on" : "off"));
+    if (chip.source == ADC_CAL_NONE) return;
+    Serial.println("code,ideal_mV,chip_mV");
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i += 9) {   // 0 to 4095 in eight rows
+        int code = i * ADC_CORRECTION_STEP;
+        consolePrintf("%d,%.1f,%.1f\n", code, code * ADC_VOLTS_PER_CODE * 1000.0f, chip.millivolts[i]);
+    }
+    consolePrintf("adc.source=%d\nadc.mv=", chip.source);
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) consolePrintf("%s%.1f", i ? "," : "", chip.millivolts[i]);
+    Serial.println();
+}
+
+static void showBootLog() {
+    Serial.println("stage,status,start_ms,duration_ms");
+    for (int stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+        consolePrintf("%s,%s,%.3f,%.3f\n", bootStageName(stage), bootStageStatusName(bootLog.status[stage]),
+                      bootLog.startUs[stage] * 0.001, bootStageMicros(bootLog, stage) * 0.001);
+    }
+}
+
+// The current is estimated from the time in each mode (power.h); the board
+// has no current sense.
+static void showPowerStatus() {
+    PowerPolicy power;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        power = powerPolicy;
+        xSemaphoreGive(dataMutex);
+    }
+    bool lightSleep = false;
+    bool available = powerManagementAvailable(lightSleep);
+    int window = OVERSAMPLE_COUNT < SENSOR_AVERAGE_MAX ? OVERSAMPLE_COUNT : SENSOR_AVERAGE_MAX;
+    consolePrintf("%s, setting %d; esp_pm %s, light sleep %s\n", powerModeName(power.mode), idlePowerMode,
+                  available ? "on" : "unavailable (CPU clock switched directly)", lightSleep ? "available" : "unavailable");
+    uint32_t totalMs = 0;
+    for (int mode = 0; mode < POWER_MODE_COUNT; mode++) totalMs += power.stats.modeMs[mode];
+    for (int mode = 0; mode < POWER_MODE_COUNT; mode++) {
+        consolePrintf("%s %.1f s (%.1f%%)\n", powerModeName(mode), power.stats.modeMs[mode] * 0.001,
+                      totalMs ? power.stats.modeMs[mode] * 100.0 / totalMs : 0.0);
+    }
+    bool sleeping = idlePowerMode == POWER_SETTING_LIGHT_SLEEP && lightSleep;
+    consolePrintf("estimated mean current %.1f mA (%.1f mA at full rate)\n",
+                  powerEstimatedCurrentmA(power.stats, window, sleeping), POWER_ACTIVE_MA);
+    Serial.print("wakes:");
+    for (int reason = POWER_WAKE_PRESSURE; reason < POWER_WAKE_REASON_COUNT; reason++) {
+        consolePrintf(" %s %lu", powerWakeReasonName(reason), (unsigned long)power.stats.wakes[reason]);
+    }
+    consolePrintf("\nlast wake (%s) %lu ms, longest %lu ms (bound %lu ms)\n", powerWakeReasonName(power.stats.lastWakeReason),
+                  (unsigned long)power.stats.lastWakeMs, (unsigned long)power.stats.worstWakeMs,
+                  (unsigned long)powerWakeBoundMs(window, (uint32_t)tsSampleRate));
+}
+
+static void showHeap() {
+    HeapGuard guard;
+    bool built = heapGuardSnapshot(guard);
+    consolePrintf("free heap %lu bytes, lowest %lu, largest block %lu\n", (unsigned long)ESP.getFreeHeap(),
+                  (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap());
+    // Bytes of each static task stack never touched since boot.
+    consolePrintf("stack headroom: control %lu, display %lu, overboost %lu bytes\n",
+                  (unsigned long)uxTaskGetStackHighWaterMark(pidControlTaskHandle),
+                  (unsigned long)uxTaskGetStackHighWaterMark(displayAndInputTaskHandle),
+                  (unsigned long)overboostGuardStackHeadroom());
+    if (!built) {
+        Serial.println("allocation tracking not built in (-DBOOST_HEAP_GUARD)");
+        return;
+    }
+    consolePrintf("%lu allocations since setup, %lu bytes, largest %lu\n", (unsigned long)guard.allocations,
+                  (unsigned long)guard.bytes, (unsigned long)guard.largest);
+}
+
+static int calibrationPointsReported = 0;
+
+static void runCalibrationCommand(const char* args) {
+    char key[8];
+    int used = 0;
+    if (strcmp(args, "stop") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            calibrationWizardCancel(calibrationWizard);
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK calibration recording stopped");
+    } else if (strcmp(args, "done") == 0) {
+        bool ok = false;
+        int channel = 0;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            channel = calibrationWizard.channel;
+            ok = calibrationWizardFinish(calibrationWizard, calibrationTables[channel]);
+            xSemaphoreGive(dataMutex);
+        }
+        if (!ok) {
+            Serial.println("ERR need 2 or more points, rising in voltage and steadily rising or falling in reading, and no point in progress");
+            return;
+        }
+        char points[CAL_TABLE_POINTS * 32];
+        calibrationTableFormat(calibrationTables[channel], points, sizeof(points));
+        consolePrintf("OK cal.%s=%s\n", sensorChannelKey(channel), points);
+        Serial.println("Table enabled; save to keep it.");
+        showConfirmationScreen("SENSOR TABLE", "RECORDED", 2000, MAIN_SCREEN);
+    } else if (strncmp(args, "point ", 6) == 0) {
+        char* end = nullptr;
+        float reference = strtof(args + 6, &end);
+        bool ok = false;
+        if (end != args + 6 && *end == '\0' && xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            ok = calibrationWizardPoint(calibrationWizard, reference, millis());
+            xSemaphoreGive(dataMutex);
+        }
+        if (!ok) Serial.println("ERR no recording waiting for a point (cal S start), or bad reading");
+    } else if (sscanf(args, "%7s %n", key, &used) == 1 && used > 0 && sensorChannelFromKey(key) >= 0) {
+        int channel = sensorChannelFromKey(key);
+        const char* action = args + used;
+        if (strcmp(action, "reset") == 0) {
+            if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                calibrationTableReset(calibrationTables[channel]);
+                xSemaphoreGive(dataMutex);
+            }
+            consolePrintf("OK %s table cleared\n", key);
+        } else if (strcmp(action, "start") == 0) {
+            if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                calibrationWizardStart(calibrationWizard, channel);
+                xSemaphoreGive(dataMutex);
+            }
+            calibrationPointsReported = 0;
+            consolePrintf("Recording the %s table. Hold the sensor and a reference gauge at one value,\n", key);
+            consolePrintf("then 'cal point <reading>'; repeat across the range (up to %d points), 'cal done' to finish.\n", CAL_TABLE_POINTS);
+            if (channel == SENSOR_MAP) Serial.println("The pressure correction still adds to the table; set it to 0 if the gauge is your reference.");
+        } else {
+            consolePrintf("ERR unknown command cal %s\n", args);
+        }
+    } else {
+        consolePrintf("ERR unknown command cal %s\n", args);
+    }
+}
+
+// A pull from atmosphere to the target and back through a scratch pipeline
+// with the live parameters; the control task's own state is not touched.
+static void printControlBenchmark() {
+    static ControlState bench;   // too large for this task's stack
+    static ControlParams params;
+    const int ticks = 1000;
+    ControlInput input = {};
+    ControlOutput out = {};
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        fillControlParams(params);
+        input.targetkPa = targetkPa;
+        xSemaphoreGive(dataMutex);
+    }
+    LinearMap map = pressureMapFor(params);
+    float atmosphereVoltage = (100.0f - map.offset) / map.slope + params.scaledVoltageOffset;
+    float targetVoltage = (input.targetkPa - map.offset) / map.slope + params.scaledVoltageOffset;
+    controlInit(bench, params, atmosphereVoltage, 0);
+    uint32_t total = 0, worst = 0;
+    for (int i = 1; i <= ticks; i++) {
+        float progress = i < ticks / 2 ? (float)i / (ticks / 4) : (float)(ticks - i) / (ticks / 4);
+        if (progress > 1.0f) progress = 1.0f;
+        input.timeMs = (uint32_t)i * CONTROL_TASK_DELAY_MS;
+        input.measuredVoltage = atmosphereVoltage + (targetVoltage - atmosphereVoltage) * progress;
+        input.previousDutyPercent = out.solenoidPercent;
+        uint32_t start = ESP.getCycleCount();
+        controlStep(bench, params, input, out);
+        uint32_t cycles = ESP.getCycleCount() - start;
+        total += cycles;
+        if (cycles > worst) worst = cycles;
+    }
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    consolePrintf("controlStep: %lu cycles/tick mean, %lu worst (%lu us at %lu MHz) over %d ticks\n",
+                  (unsigned long)(total / ticks), (unsigned long)worst, (unsigned long)(worst / mhz), (unsigned long)mhz, ticks);
+}
+
+static void printSerialParam(const SerialParam& param) {
+    if (param.type == P_FLOAT) consolePrintf("%s=%.6g\n", param.key, *(float*)param.valuePtr);
+    else if (param.type == P_INT) consolePrintf("%s=%d\n", param.key, *(int*)param.valuePtr);
+    else consolePrintf("%s=%lu\n", param.key, *(unsigned long*)param.valuePtr);
+}
+
+static bool setSerialParam(const SerialParam& param, const char* value) {
+    char* end = nullptr;
+    if (param.type == P_FLOAT) {
+        float v = strtof(value, &end);
+        if (end == value || isnan(v) || isinf(v)) return false;
+        if (param.valuePtr == &setpointProfile.rampkPaPerS && v < 0) return false;
+        if (param.valuePtr == &rpmPulsesPerRev && (v <= 0 || v > 64)) return false;
+        if (param.valuePtr == &speedPulsesPerKm && v < 0) return false;
+        if (param.valuePtr == &supplyNominalVoltage && (v < SUPPLY_VALID_MIN_V || v > 30)) return false;
+        if (param.valuePtr == &iatTrimkPaPerC && (v < 0 || v > 10)) return false;
+        if (param.valuePtr == &solenoidCurve.deadTimeMs && (v < 0 || v > SOLENOID_DEAD_TIME_MAX_MS)) return false;
+        if (param.valuePtr == &overboostMarginkPa && (v < 0 || v > OVERBOOST_MARGIN_MAX_KPA)) return false;
+        if (param.valuePtr == &sensorFailsafePercent && (v < 0 || v > 100)) return false;
+        // The corner must stay under the control loop's Nyquist frequency.
+        if (param.valuePtr == &filterSettings.cutoffHz && (v < FILTER_CUTOFF_MIN_HZ || v > 0.45f * 1000.0f / CONTROL_TASK_DELAY_MS)) return false;
+        if (param.valuePtr == &filterSettings.trackerAlpha && (v <= 0 || v > 1)) return false;
+        if (param.valuePtr == &filterSettings.trackerBeta && (v <= 0 || v >= 4.0f - 2.0f * filterSettings.trackerAlpha)) return false;
+        if (param.valuePtr == &estimatorSettings.measurementNoisekPa && (v <= 0 || v > 50)) return false;
+        if (param.valuePtr == &estimatorSettings.accelNoise && (v <= 0 || v > 100000)) return false;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            *(float*)param.valuePtr = v;
+            xSemaphoreGive(dataMutex);
+        }
+    } else if (param.type == P_INT) {
+        long v = strtol(value, &end, 10);
+        if (end == value) return false;
+        if (param.valuePtr == &valveFrequencyHz && (v <= 0 || v > 100)) return false;
+        if (param.valuePtr == &OVERSAMPLE_COUNT && (v <= 0 || v > SENSOR_AVERAGE_MAX)) return false;
+        if (param.valuePtr == &spikeRejectWindow && !spikeWindowValid((int)v)) return false;
+        if (param.valuePtr == &oversampleMinCount && (v <= 0 || v > SENSOR_AVERAGE_MAX)) return false;
+        if ((param.valuePtr == &adaptiveGainsEnabled || param.valuePtr == &pidDerivativeOnMeasurement ||
+             param.valuePtr == &pidBumplessTransfer || param.valuePtr == &feedForwardEnabled || param.valuePtr == &gainSchedule.enabled || param.valuePtr == &overshootLimiter ||
+             param.valuePtr == &setpointProfile.enabled || param.valuePtr == &rpmInputEnabled ||
+             param.valuePtr == &boostMap.enabled || param.valuePtr == &supplyCompensation ||
+             param.valuePtr == &solenoidCurve.enabled || param.valuePtr == &sensorFaultCheck ||
+             param.valuePtr == &estimatorSettings.enabled || param.valuePtr == &oversampleAdaptive ||
+             param.valuePtr == &adcCorrectionEnabled) && v != 0 && v != 1) return false;
+        if (param.valuePtr == &idlePowerMode && (v < 0 || v >= POWER_SETTING_COUNT)) return false;
+        if (param.valuePtr == &gearCount && (v < 1 || v > RPM_MAP_GEARS)) return false;
+        if (param.valuePtr == &pidAntiWindupMode && (v < 0 || v >= PID_ANTIWINDUP_COUNT)) return false;
+        if (param.valuePtr == &filterSettings.type && (v < 0 || v >= FILTER_TYPE_COUNT)) return false;
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+            if (param.valuePtr == &calibrationTables[c].enabled && v != 0 && v != 1) return false;
+            if (param.valuePtr == &calibrationTables[c].interpolation && (v < 0 || v >= CAL_INTERP_COUNT)) return false;
+        }
+        *(int*)param.valuePtr = (int)v;
+    } else {
+        unsigned long v = strtoul(value, &end, 10);
+        if (end == value) return false;
+        *(unsigned long*)param.valuePtr = v;
+    }
+    return true;
+}
+
+static void runSerialCommand(char* line) {
+    char* eq = strchr(line, '=');
+    if (eq) {
+        *eq = '\0';
+        if (strncmp(line, "gs.", 3) == 0) {
+            if (setGainScheduleCell(line + 3, eq + 1)) consolePrintf("%s=%s\n", line, eq + 1);
+            else consolePrintf("ERR bad gain schedule entry %s\n", line);
+            return;
+        }
+        if (strncmp(line, "bm.", 3) == 0 || strncmp(line, "gear.", 5) == 0) {
+            bool gearRatio = line[0] == 'g';
+            if (setRpmTableCell(line + (gearRatio ? 5 : 3), eq + 1, gearRatio)) consolePrintf("%s=%s\n", line, eq + 1);
+            else consolePrintf("ERR bad %s entry %s\n", gearRatio ? "gear ratio" : "boost map", line);
+            return;
+        }
+        if (strncmp(line, "sol.", 4) == 0) {
+            if (setSolenoidCurveCell(line + 4, eq + 1)) consolePrintf("%s=%s\n", line, eq + 1);
+            else consolePrintf("ERR bad solenoid curve entry %s\n", line);
+            return;
+        }
+        if (strncmp(line, "cal.", 4) == 0) {
+            if (setCalibrationTable(line + 4, eq + 1)) consolePrintf("%s=%s\n", line, eq + 1);
+            else consolePrintf("ERR bad calibration table %s, expected volts:value,... rising in volts and monotone in value\n", line);
+            return;
+        }
+        if (strcmp(line, "sp") == 0) {
+            bool ok = false;
+            if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+                ok = setpointProfileParse(setpointProfile, eq + 1);
+                xSemaphoreGive(dataMutex);
+            }
+            if (ok) printSetpointCurve();
+            else Serial.println("ERR bad setpoint curve, expected ms:kPa,... with increasing ms");
+            return;
+        }
+        const SerialParam* param = findSerialParam(line);
+        if (!param) {
+            consolePrintf("ERR unknown key %s\n", line);
+        } else if (!setSerialParam(*param, eq + 1)) {
+            consolePrintf("ERR bad value for %s\n", line);
+        } else {
+            calculateScaledVoltages();
+            printSerialParam(*param);
+        }
+        return;
+    }
+
+    if (strcmp(line, "get") == 0) {
+        for (int i = 0; i < serialParamCount; i++) printSerialParam(serialParams[i]);
+        printGainScheduleCells();
+        printSetpointCurve();
+        printBoostMapCells();
+        printSolenoidCurveCells();
+        printCalibrationTables();
+    } else if (strcmp(line, "save") == 0) {
+        saveAllParameters();
+        activePresetIndex = -1;
+        EEPROM.put(ADDR_ACTIVE_PRESET, activePresetIndex);
+        EEPROM.commit();
+        showConfirmationScreen("SETTINGS", "SAVED!", 1500, MAIN_SCREEN);
+        Serial.println("OK saved");
+    } else if (strcmp(line, "telemetry on") == 0 || strcmp(line, "telemetry off") == 0) {
+        telemetryEnabled = (line[11] == 'n');
+        if (telemetryEnabled) Serial.println("time_ms,kpa,target_kpa,duty_pct,gain_scale,duty_ceiling,a,b,c,plant_gain,tau_ms,valid,rpm,gear,emap_kpa,iat_c,supply_v,ob_tripped,ob_latency_us,ob_max_gap_us,sensor_fault,rate_kpa_s,oversample");
+    } else if (strcmp(line, "ff") == 0) {
+        FeedForwardTable table;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            table = feedForwardTable;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("kpa,duty_pct,samples");
+        for (int i = 0; i < FF_TABLE_POINTS; i++) {
+            consolePrintf("%.0f,%.2f,%d\n", FF_TABLE_MIN_KPA + i * FF_TABLE_STEP_KPA, table.dutyPercent[i], table.samples[i]);
+        }
+    } else if (strcmp(line, "ff clear") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            feedForwardClearRequested = true;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK feed-forward cleared");
+    } else if (strcmp(line, "gs") == 0) {
+        GainSchedule schedule;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            schedule = gainSchedule;
+            xSemaphoreGive(dataMutex);
+        }
+        consolePrintf("enabled=%d\n", schedule.enabled);
+        Serial.print("table,rate_kpa_s");
+        for (int e = 0; e < GS_ERROR_POINTS; e++) consolePrintf(",err_%.0f", GS_ERROR_MIN_KPA + e * GS_ERROR_STEP_KPA);
+        Serial.println();
+        const float (*tables[3])[GS_ERROR_POINTS] = {schedule.kp, schedule.ki, schedule.kd};
+        static const char* const names[] = {"kp", "ki", "kd"};
+        for (int t = 0; t < 3; t++) {
+            for (int r = 0; r < GS_RATE_POINTS; r++) {
+                consolePrintf("%s,%.0f", names[t], GS_RATE_MIN_KPA_S + r * GS_RATE_STEP_KPA_S);
+                for (int e = 0; e < GS_ERROR_POINTS; e++) consolePrintf(",%.2f", tables[t][r][e]);
+                Serial.println();
+            }
+        }
+    } else if (strcmp(line, "gs reset") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            int enabled = gainSchedule.enabled;
+            gainScheduleReset(gainSchedule);
+            gainSchedule.enabled = enabled;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK gain schedule reset");
+    } else if (strcmp(line, "bm") == 0) {
+        BoostTargetMap map;
+        float rpm = 0;
+        int gear = 0;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            map = boostMap;
+            rpm = telemetry.rpm;
+            gear = telemetry.gear;
+            xSemaphoreGive(dataMutex);
+        }
+        consolePrintf("enabled=%d rpm=%.0f gear=%d\n", map.enabled, rpm, gear);
+        Serial.print("gear");
+        for (int r = 0; r < RPM_MAP_POINTS; r++) consolePrintf(",rpm_%.0f", RPM_MAP_MIN_RPM + r * RPM_MAP_STEP_RPM);
+        Serial.println();
+        for (int g = 0; g < RPM_MAP_GEARS; g++) {
+            consolePrintf("%d", g + 1);
+            for (int r = 0; r < RPM_MAP_POINTS; r++) consolePrintf(",%.1f", map.offsetkPa[g][r]);
+            Serial.println();
+        }
+    } else if (strcmp(line, "bm reset") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            int enabled = boostMap.enabled;
+            boostMapReset(boostMap);
+            boostMap.enabled = enabled;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK boost map reset");
+    } else if (strcmp(line, "sol") == 0) {
+        SolenoidCurve curve;
+        int frequencyHz = 0;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            curve = solenoidCurve;
+            frequencyHz = valveFrequencyHz;
+            xSemaphoreGive(dataMutex);
+        }
+        consolePrintf("enabled=%d dead_time_ms=%.2f dead_band_pct=%.1f at %d Hz\n", curve.enabled, curve.deadTimeMs,
+                      solenoidDeadBandPercent(curve.deadTimeMs, frequencyHz), frequencyHz);
+        Serial.println("effective_duty_pct,flow_pct");
+        for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) {
+            consolePrintf("%.0f,%.1f\n", i * SOLENOID_CURVE_STEP_PERCENT, curve.flowPercent[i]);
+        }
+    } else if (strcmp(line, "sol reset") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            int enabled = solenoidCurve.enabled;
+            solenoidCurveReset(solenoidCurve);
+            solenoidCurve.enabled = enabled;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK solenoid curve reset");
+    } else if (strcmp(line, "sol cal") == 0 && rpmInputEnabled == 0) {
+        // The engine-off check reads RPM; without the input a running engine would pass it.
+        Serial.println("ERR RPM input off: enable it (rpmInputEnabled=1) so an engine start stops the routine");
+    } else if (strcmp(line, "sol cal") == 0) {
+        bool started = false;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            bool tuning = autotuner.phase == AUTOTUNE_WAITING || autotuner.phase == AUTOTUNE_RELAY;
+            if (telemetry.rpm <= 0 && !tuning && !overboostGuardTripped() && telemetry.sensorFault == SENSOR_FAULT_NONE) {
+                float supplyFactor = supplyCompensationFactor(telemetry.supplyVoltage, supplyNominalVoltage);
+                solenoidCharacterizeStart(solenoidCharacterizer, valveFrequencyHz, supplyFactor);
+                started = true;
+            }
+            xSemaphoreGive(dataMutex);
+        }
+        if (!started) {
+            Serial.println("ERR engine running, autotune active, overboost cut or sensor fault latched");
+        } else {
+            Serial.println("Solenoid characterization: regulated air (100-200 kPa) into the solenoid inlet,");
+            Serial.println("MAP sensor on the actuator port, engine off. Takes about 32 s; 'sol stop' aborts.");
+        }
+    } else if (strcmp(line, "sol stop") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            solenoidCharacterizeAbort(solenoidCharacterizer, SOLCHAR_ABORT_USER);
+            xSemaphoreGive(dataMutex);
+        }
+    } else if (strcmp(line, "ob") == 0) {
+        OverboostMonitor monitor;
+        OverboostLimit limit;
+        overboostGuardSnapshot(monitor, limit);
+        if (limit.ceilingkPa > 0) consolePrintf("ceiling %.1f kPa, ", limit.ceilingkPa);
+        else Serial.print("guard off, ");
+        consolePrintf("%s, %lu trips\n", monitor.tripped ? "TRIPPED" : "armed", (unsigned long)monitor.trips);
+        if (monitor.trips > 0) {
+            consolePrintf("last trip at %.1f kPa against a %.1f kPa ceiling, peak %.1f kPa, cut %lu us after the first reading over\n",
+                          monitor.tripkPa, monitor.tripCeilingkPa, monitor.peakkPa, (unsigned long)monitor.latencyUs);
+        }
+        consolePrintf("%lu checks, longest gap %lu us, longest check %lu us (bound %lu us)\n",
+                      (unsigned long)monitor.checks, (unsigned long)monitor.maxGapUs, (unsigned long)monitor.maxCheckUs,
+                      (unsigned long)OVERBOOST_LATENCY_BOUND_US);
+    } else if (strcmp(line, "ob clear") == 0) {
+        overboostGuardClear();
+        Serial.println("OK overboost guard re-armed");
+    } else if (strcmp(line, "faults") == 0) {
+        SensorFaultLog log;
+        uint8_t active = SENSOR_FAULT_NONE;
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            log = sensorFaultLog;
+            active = telemetry.sensorFault;
+            xSemaphoreGive(dataMutex);
+        }
+        consolePrintf("check %s, active fault: %s\n", sensorFaultCheck ? "on" : "off", sensorFaultName(active));
+        Serial.println("code,time_ms,voltage,detail");
+        SensorFaultRecord record;
+        for (int age = 0; sensorFaultLogGet(log, age, record); age++) {
+            consolePrintf("%s,%lu,%.3f,%.3f\n", sensorFaultName(record.code), (unsigned long)record.timeMs, record.voltage, record.detail);
+        }
+    } else if (strcmp(line, "faults clear") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            sensorFaultClearRequested = true;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK sensor fault check re-armed");
+    } else if (strcmp(line, "faults reset") == 0) {
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            sensorFaultLogClear(sensorFaultLog);
+            sensorFaultLog.dirty = true;
+            xSemaphoreGive(dataMutex);
+        }
+        Serial.println("OK sensor fault log erased");
+    } else if (strcmp(line, "bench") == 0) {
+        printControlBenchmark();
+    } else if (strcmp(line, "adc") == 0) {
+        showAdcCorrection();
+    } else if (strcmp(line, "boot") == 0) {
+        showBootLog();
+    } else if (strcmp(line, "power") == 0) {
+        showPowerStatus();
+    } else if (strcmp(line, "heap") == 0) {
+        showHeap();
+    } else if (strcmp(line, "cal") == 0) {
+        showCalibrationTables();
+    } else if (strncmp(line, "cal ", 4) == 0) {
+        runCalibrationCommand(line + 4);
+    } else if (strcmp(line, "save A") == 0 || strcmp(line, "save B") == 0) {
+        int index = (line[5] == 'A') ? 0 : 1;
+        saveCurrentConfigToProfile(index);
+        consolePrintf("OK saved profile %c\n", line[5]);
+    } else {
+        consolePrintf("ERR unknown command %s\n", line);
+    }
+}
+
+void handleSerialCommands() {
+    static char line[96];
+    static int length = 0;
+
+    while (Serial.available() > 0) {
+        char c = Serial.read();
+        if (c == '\r') continue;
+        if (c == '\n') {
+            line[length] = '\0';
+            // Preset files carry '#' comments; ignore them along with blank lines.
+            if (length > 0 && line[0] != '#') runSerialCommand(line);
+            length = 0;
+        } else if (length < (int)sizeof(line) - 1) {
+            line[length++] = c;
+        }
+    }
+}
+
+// Called from the display task; reports each measured step of a solenoid
+// characterization and, once it finishes, copies the result into the active
+// curve (not saved until the next save).
+void reportSolenoidCharacterization() {
+    static int reportedSteps = 0;
+    SolenoidCharacterizer c;
+    bool finished = false;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        c = solenoidCharacterizer;
+        if (c.phase == SOLCHAR_DONE) {
+            solenoidCurve.deadTimeMs = c.deadTimeMs;
+            for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) solenoidCurve.flowPercent[i] = c.flowPercent[i];
+        }
+        if (c.phase == SOLCHAR_DONE || c.phase == SOLCHAR_ABORTED) {
+            solenoidCharacterizer.phase = SOLCHAR_IDLE;
+            finished = true;
+        }
+        xSemaphoreGive(dataMutex);
+    }
+    if (c.phase == SOLCHAR_IDLE) return;
+
+    int measured = (c.phase == SOLCHAR_RUNNING || c.phase == SOLCHAR_ABORTED) ? c.step : SOLCHAR_STEPS;
+    for (; reportedSteps < measured; reportedSteps++) {
+        consolePrintf("sol step %d/%d duty %.0f%% %.1f kPa\n", reportedSteps + 1, SOLCHAR_STEPS,
+                      reportedSteps * SOLCHAR_STEP_PERCENT, c.pressurekPa[reportedSteps]);
+    }
+    if (!finished) return;
+    reportedSteps = 0;
+    if (c.phase == SOLCHAR_ABORTED) {
+        consolePrintf("ERR solenoid characterization aborted: %s\n", solenoidCharAbortName(c.abortReason));
+        showConfirmationScreen("SOLENOID CAL", "ABORTED", 2000, MAIN_SCREEN);
+        return;
+    }
+    consolePrintf("OK solenoid curve measured, dead time %.2f ms\n", c.deadTimeMs);
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) consolePrintf("sol.%d=%.1f\n", i, c.flowPercent[i]);
+    Serial.println("Enable with solenoidCurveEnabled=1, then save.");
+    showConfirmationScreen("SOLENOID CURVE", "MEASURED", 2000, MAIN_SCREEN);
+}
+
+// Called from the display task; reports each point the calibration wizard
+// finishes averaging.
+void reportCalibrationWizard() {
+    CalibrationWizard w;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        w = calibrationWizard;
+        xSemaphoreGive(dataMutex);
+    }
+    if (w.finished <= calibrationPointsReported) return;
+    calibrationPointsReported = w.finished;
+    consolePrintf("cal point %s: %.4f V (noise %.4f V) = %.6g, %d in the table\n", calWizardResultName(w.result),
+                  w.resultVolts, w.resultNoise, w.reference, w.count);
+}
+
+// Called from the display task; prints the latest control-task snapshot.
+void printTelemetry() {
+    if (!telemetryEnabled) return;
+    TelemetrySnapshot snapshot;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        snapshot = telemetry;
+        xSemaphoreGive(dataMutex);
+    }
+    // The guard is read directly, so a trip shows even while the control task is stalled.
+    OverboostMonitor guard;
+    OverboostLimit limit;
+    overboostGuardSnapshot(guard, limit);
+    consolePrintf("%lu,%.2f,%.1f,%.1f,%.3f,%.2f,%.5f,%.5f,%.3f,%.3f,%.0f,%d,%.0f,%d,%.1f,%.1f,%.2f,%d,%lu,%lu,%d,%.1f,%u\n",
+                  (unsigned long)snapshot.timeMs, snapshot.pressurekPa, snapshot.targetkPa, snapshot.dutyPercent,
+                  snapshot.gainScale, snapshot.dutyCeiling, snapshot.plant.a, snapshot.plant.b, snapshot.plant.c,
+                  snapshot.plant.gainkPaPerPercent, snapshot.plant.timeConstantMs, snapshot.plant.valid ? 1 : 0,
+                  snapshot.rpm, snapshot.gear, snapshot.backpressurekPa, snapshot.intakeTempC, snapshot.supplyVoltage,
+                  guard.tripped ? 1 : 0, (unsigned long)guard.latencyUs, (unsigned long)guard.maxGapUs,
+                  snapshot.sensorFault, snapshot.pressureRate, (unsigned)snapshot.oversampleCount);
+}
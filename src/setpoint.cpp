@@ -0,0 +1,118 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "setpoint.h"
+#include "numeric.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const float SP_MAX_TIME_MS = 60000.0f;
+static const float SP_MAX_OFFSET_KPA = 200.0f;
+
+void setpointProfileReset(SetpointProfile& profile) {
+    profile.enabled = 0;
+    profile.rampkPaPerS = 0.0f;
+    profile.count = 0;
+    for (int i = 0; i < SP_PROFILE_POINTS; i++) {
+        profile.timeMs[i] = 0.0f;
+        profile.offsetkPa[i] = 0.0f;
+    }
+}
+
+static bool validPoints(const float* timeMs, const float* offsetkPa, int count) {
+    for (int i = 0; i < count; i++) {
+        if (isnan(timeMs[i]) || timeMs[i] < 0.0f || timeMs[i] > SP_MAX_TIME_MS) return false;
+        if (isnan(offsetkPa[i]) || fabsf(offsetkPa[i]) > SP_MAX_OFFSET_KPA) return false;
+        if (i > 0 && timeMs[i] <= timeMs[i - 1]) return false;
+    }
+    return true;
+}
+
+bool setpointProfileSanitize(SetpointProfile& profile) {
+    bool clean = (profile.enabled == 0 || profile.enabled == 1) &&
+                 !isnan(profile.rampkPaPerS) && profile.rampkPaPerS >= 0.0f && profile.rampkPaPerS <= 10000.0f &&
+                 profile.count >= 0 && profile.count <= SP_PROFILE_POINTS &&
+                 validPoints(profile.timeMs, profile.offsetkPa, profile.count);
+    if (!clean) setpointProfileReset(profile);
+    return clean;
+}
+
+void setpointInit(SetpointState& state) {
+    state.rampedTarget = 0.0f;
+    state.primed = false;
+    state.spooling = false;
+    state.spoolStartMs = 0;
+    state.cursor = 0;
+}
+
+float setpointOffset(const SetpointProfile& profile, int& cursor, float msSinceSpool) {
+    if (profile.count == 0) return 0.0f;
+    if (msSinceSpool <= profile.timeMs[0]) return profile.offsetkPa[0];
+    while (cursor < profile.count - 1 && msSinceSpool >= profile.timeMs[cursor + 1]) cursor++;
+    if (cursor >= profile.count - 1) return profile.offsetkPa[profile.count - 1];
+    float span = profile.timeMs[cursor + 1] - profile.timeMs[cursor];
+    float frac = (msSinceSpool - profile.timeMs[cursor]) / span;
+    return profile.offsetkPa[cursor] + (profile.offsetkPa[cursor + 1] - profile.offsetkPa[cursor]) * frac;
+}
+
+float setpointUpdate(SetpointState& state, const SetpointProfile& profile, float targetkPa, bool spooling,
+                     uint32_t timeMs, float dtMs) {
+    if (!state.primed || profile.rampkPaPerS <= 0.0f) {
+        state.rampedTarget = targetkPa;
+        state.primed = true;
+    } else {
+        float maxStep = profile.rampkPaPerS * dtMs * SECONDS_PER_MS;
+        float step = targetkPa - state.rampedTarget;
+        if (step > maxStep) step = maxStep;
+        if (step < -maxStep) step = -maxStep;
+        state.rampedTarget += step;
+    }
+
+    if (spooling && !state.spooling) {
+        state.spoolStartMs = timeMs;
+        state.cursor = 0;
+    }
+    state.spooling = spooling;
+    if (!profile.enabled) return state.rampedTarget;
+
+    // Off boost the curve sits at its start, so the next pull closes the loop
+    // against the early target.
+    float msSinceSpool = spooling ? (float)(timeMs - state.spoolStartMs) : 0.0f;
+    if (!spooling) state.cursor = 0;
+    return state.rampedTarget + setpointOffset(profile, state.cursor, msSinceSpool);
+}
+
+bool setpointProfileParse(SetpointProfile& profile, const char* text) {
+    float timeMs[SP_PROFILE_POINTS] = {0};
+    float offsetkPa[SP_PROFILE_POINTS] = {0};
+    int count = 0;
+    const char* p = text;
+    while (*p) {
+        if (count == SP_PROFILE_POINTS) return false;
+        char* end = nullptr;
+        timeMs[count] = strtof(p, &end);
+        if (end == p || *end != ':') return false;
+        p = end + 1;
+        offsetkPa[count] = strtof(p, &end);
+        if (end == p) return false;
+        count++;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p != '\0') return false;
+    }
+    if (!validPoints(timeMs, offsetkPa, count)) return false;
+    profile.count = count;
+    for (int i = 0; i < count; i++) {
+        profile.timeMs[i] = timeMs[i];
+        profile.offsetkPa[i] = offsetkPa[i];
+    }
+    return true;
+}
+
+void setpointProfileFormat(const SetpointProfile& profile, char* buffer, int size) {
+    int used = 0;
+    if (size > 0) buffer[0] = '\0';
+    for (int i = 0; i < profile.count && used < size; i++) {
+        used += snprintf(buffer + used, size - used, "%s%.6g:%.6g", i ? "," : "", (double)profile.timeMs[i], (double)profile.offsetkPa[i]);
+    }
+}
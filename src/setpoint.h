@@ -0,0 +1,54 @@
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+#include <stdint.h>
+
+//================================================================================
+// SETPOINT TRAJECTORY
+//================================================================================
+// Turns the user's target into the setpoint the controller chases:
+//   - a rate limit, so a target edit or profile switch ramps instead of
+//     stepping (0 keeps the old step behaviour)
+//   - an optional boost curve over time since spool, as a short list of
+//     (ms, kPa offset) breakpoints relative to the target, e.g. hold 30 kPa
+//     back for the first 800 ms to protect traction, then the full target.
+// Between breakpoints the offset is interpolated; past the last one it holds.
+// The curve keeps a cursor that only moves forward during a pull, so
+// evaluation is O(1) amortized per tick.
+
+#define SP_PROFILE_POINTS 6
+
+struct SetpointProfile {
+    int enabled;                         // boost curve on/off; the ramp is separate
+    float rampkPaPerS;                   // max setpoint slew, 0 = step
+    int count;                           // breakpoints in use
+    float timeMs[SP_PROFILE_POINTS];     // strictly increasing
+    float offsetkPa[SP_PROFILE_POINTS];
+};
+
+struct SetpointState {
+    float rampedTarget;
+    bool primed;
+    bool spooling;
+    uint32_t spoolStartMs;
+    int cursor;
+};
+
+// Disabled, no ramp, no breakpoints.
+void setpointProfileReset(SetpointProfile& profile);
+// Resets the profile if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool setpointProfileSanitize(SetpointProfile& profile);
+void setpointInit(SetpointState& state);
+// Offset at msSinceSpool; cursor must start at 0 and only see increasing times.
+float setpointOffset(const SetpointProfile& profile, int& cursor, float msSinceSpool);
+// One tick: returns the setpoint for this target. spooling is true while the
+// engine is making boost; its rising edge restarts the curve.
+float setpointUpdate(SetpointState& state, const SetpointProfile& profile, float targetkPa, bool spooling,
+                     uint32_t timeMs, float dtMs);
+
+// Breakpoint list as "ms:kPa,ms:kPa,..." (empty clears it). Parse leaves the
+// profile untouched and returns false on a malformed list.
+bool setpointProfileParse(SetpointProfile& profile, const char* text);
+void setpointProfileFormat(const SetpointProfile& profile, char* buffer, int size);
+
+#endif // SETPOINT_H
@@ -0,0 +1,219 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "solenoid.h"
+#include <math.h>
+#include <stdlib.h>
+
+void solenoidCurveReset(SolenoidCurve& curve) {
+    curve.enabled = 0;
+    curve.deadTimeMs = 0.0f;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) curve.flowPercent[i] = i * SOLENOID_CURVE_STEP_PERCENT;
+}
+
+bool solenoidCurveSanitize(SolenoidCurve& curve) {
+    bool clean = (curve.enabled == 0 || curve.enabled == 1) && !isnan(curve.deadTimeMs) &&
+                 curve.deadTimeMs >= 0.0f && curve.deadTimeMs <= SOLENOID_DEAD_TIME_MAX_MS;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS && clean; i++) {
+        float v = curve.flowPercent[i];
+        if (isnan(v) || v < 0.0f || v > 100.0f) clean = false;
+    }
+    if (!clean) solenoidCurveReset(curve);
+    return clean;
+}
+
+float* solenoidCurveEntry(SolenoidCurve& curve, const char* key) {
+    char* end = nullptr;
+    long i = strtol(key, &end, 10);
+    if (end == key || *end != '\0' || i < 0 || i >= SOLENOID_CURVE_POINTS) return nullptr;
+    return &curve.flowPercent[i];
+}
+
+void solenoidLinearizerInit(SolenoidLinearizer& linearizer) {
+    linearizer.built = false;
+    for (int k = 0; k < SOLENOID_INVERSE_POINTS; k++) linearizer.dutyAtFlow[k] = (float)k;
+}
+
+void solenoidLinearizerUpdate(SolenoidLinearizer& linearizer, const SolenoidCurve& curve) {
+    bool changed = !linearizer.built;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS && !changed; i++) {
+        if (linearizer.builtFrom[i] != curve.flowPercent[i]) changed = true;
+    }
+    if (!changed) return;
+
+    // Invert the rising envelope of the curve, so a dip (a noisy point or a
+    // half-edited table) maps to the lowest duty that reaches each flow.
+    float envelope[SOLENOID_CURVE_POINTS];
+    float highest = 0.0f;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) {
+        linearizer.builtFrom[i] = curve.flowPercent[i];
+        float v = curve.flowPercent[i];
+        if (v > 100.0f) v = 100.0f;
+        if (v > highest || i == 0) highest = v < 0.0f ? 0.0f : v;
+        envelope[i] = highest;
+    }
+    linearizer.built = true;
+
+    const float flowStep = 100.0f / (SOLENOID_INVERSE_POINTS - 1);
+    const float first = envelope[0], last = envelope[SOLENOID_CURVE_POINTS - 1];
+    if (last - first < 1.0f) {
+        // A flat curve has no inverse; pass duty through rather than jump between the ends.
+        for (int k = 0; k < SOLENOID_INVERSE_POINTS; k++) linearizer.dutyAtFlow[k] = k * flowStep;
+        return;
+    }
+    // A curve that stays flat at the start has its first flow where the flat part ends.
+    int i = 0;
+    while (envelope[i + 1] <= first) i++;
+    const float openDuty = i * SOLENOID_CURVE_STEP_PERCENT;
+    for (int k = 0; k < SOLENOID_INVERSE_POINTS; k++) {
+        float flow = k * flowStep;
+        if (flow <= first) {
+            linearizer.dutyAtFlow[k] = openDuty;
+        } else if (flow > last) {
+            linearizer.dutyAtFlow[k] = 100.0f;
+        } else {
+            // envelope[i] < flow <= envelope[i + 1]; i only moves forward as flow rises.
+            // Ending on the last point, a curve that saturates early maps full
+            // flow to the duty where it saturates.
+            while (envelope[i + 1] < flow) i++;
+            float frac = (flow - envelope[i]) / (envelope[i + 1] - envelope[i]);
+            linearizer.dutyAtFlow[k] = (i + frac) * SOLENOID_CURVE_STEP_PERCENT;
+        }
+    }
+}
+
+float solenoidDeadBandPercent(float deadTimeMs, int frequencyHz) {
+    if (frequencyHz <= 0 || deadTimeMs <= 0.0f) return 0.0f;
+    // Dead time over the period (1000 / f ms), in percent.
+    float band = deadTimeMs * frequencyHz / 10.0f;
+    return band > SOLENOID_DEAD_BAND_MAX_PERCENT ? SOLENOID_DEAD_BAND_MAX_PERCENT : band;
+}
+
+float solenoidLinearize(const SolenoidLinearizer& linearizer, float flowPercent, float deadBandPercent) {
+    if (flowPercent <= 0.0f) return 0.0f;
+    if (flowPercent >= 100.0f) return 100.0f;
+    const float flowStep = 100.0f / (SOLENOID_INVERSE_POINTS - 1);
+    float position = flowPercent / flowStep;
+    int k = (int)position;
+    if (k > SOLENOID_INVERSE_POINTS - 2) k = SOLENOID_INVERSE_POINTS - 2;
+    float frac = position - (float)k;
+    float effective = linearizer.dutyAtFlow[k] + (linearizer.dutyAtFlow[k + 1] - linearizer.dutyAtFlow[k]) * frac;
+    return deadBandPercent + effective * (100.0f - deadBandPercent) / 100.0f;
+}
+
+float solenoidFlow(const SolenoidCurve& curve, float dutyPercent, float deadBandPercent) {
+    if (dutyPercent <= deadBandPercent) return curve.flowPercent[0];
+    float effective = (dutyPercent - deadBandPercent) * 100.0f / (100.0f - deadBandPercent);
+    if (effective >= 100.0f) return curve.flowPercent[SOLENOID_CURVE_POINTS - 1];
+    float position = effective / SOLENOID_CURVE_STEP_PERCENT;
+    int i = (int)position;
+    float frac = position - (float)i;
+    return curve.flowPercent[i] + (curve.flowPercent[i + 1] - curve.flowPercent[i]) * frac;
+}
+
+//================================================================================
+// CHARACTERIZATION
+//================================================================================
+const char* solenoidCharAbortName(SolenoidCharAbortReason reason) {
+    switch (reason) {
+        case SOLCHAR_ABORT_NO_RESPONSE: return "no response";
+        case SOLCHAR_ABORT_ENGINE: return "engine running";
+        case SOLCHAR_ABORT_USER: return "stopped";
+        case SOLCHAR_ABORT_SENSOR: return "sensor fault";
+        case SOLCHAR_ABORT_NO_RPM: return "RPM input off";
+        default: return "";
+    }
+}
+
+void solenoidCharacterizeStart(SolenoidCharacterizer& c, int frequencyHz, float supplyFactor) {
+    c.phase = SOLCHAR_RUNNING;
+    c.abortReason = SOLCHAR_ABORT_NONE;
+    c.frequencyHz = frequencyHz;
+    c.supplyFactor = supplyFactor > 0.0f ? supplyFactor : 1.0f;
+    c.step = 0;
+    c.stepStarted = false;
+    c.stepStartMs = 0;
+    c.pressureSum = 0;
+    c.pressureCount = 0;
+    for (int j = 0; j < SOLCHAR_STEPS; j++) c.pressurekPa[j] = 0;
+    c.deadTimeMs = 0;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) c.flowPercent[i] = i * SOLENOID_CURVE_STEP_PERCENT;
+}
+
+void solenoidCharacterizeAbort(SolenoidCharacterizer& c, SolenoidCharAbortReason reason) {
+    if (c.phase == SOLCHAR_RUNNING) {
+        c.phase = SOLCHAR_ABORTED;
+        c.abortReason = reason;
+    }
+}
+
+bool solenoidCharacterizeStep(SolenoidCharacterizer& c, float pressurekPa, bool engineRunning, uint32_t timeMs,
+                              float& dutyPercent) {
+    if (c.phase != SOLCHAR_RUNNING) return false;
+    if (engineRunning) {
+        solenoidCharacterizeAbort(c, SOLCHAR_ABORT_ENGINE);
+        return false;
+    }
+    if (!c.stepStarted) {
+        c.stepStarted = true;
+        c.stepStartMs = timeMs;
+        c.pressureSum = 0;
+        c.pressureCount = 0;
+    }
+    uint32_t elapsed = timeMs - c.stepStartMs;
+    if (elapsed >= SOLCHAR_SETTLE_MS) {
+        c.pressureSum += pressurekPa;
+        c.pressureCount++;
+    }
+    if (elapsed >= SOLCHAR_SETTLE_MS + SOLCHAR_AVERAGE_MS) {
+        c.pressurekPa[c.step] = c.pressureSum / c.pressureCount;
+        c.step++;
+        c.stepStarted = false;
+        if (c.step == SOLCHAR_STEPS) {
+            if (solenoidCharacterizeFit(c)) c.phase = SOLCHAR_DONE;
+            else solenoidCharacterizeAbort(c, SOLCHAR_ABORT_NO_RESPONSE);
+            return false;
+        }
+    }
+    dutyPercent = c.step * SOLCHAR_STEP_PERCENT;
+    return true;
+}
+
+bool solenoidCharacterizeFit(SolenoidCharacterizer& c) {
+    const int last = SOLCHAR_STEPS - 1;
+    float span = c.pressurekPa[last] - c.pressurekPa[0];
+    if (fabsf(span) < SOLCHAR_MIN_SPAN_KPA) return false;
+
+    // Response in % of the 0-100 % duty swing, made monotonic against noise.
+    float response[SOLCHAR_STEPS];
+    float highest = 0.0f;
+    for (int j = 0; j < SOLCHAR_STEPS; j++) {
+        float r = (c.pressurekPa[j] - c.pressurekPa[0]) * 100.0f / span;
+        if (r > 100.0f) r = 100.0f;
+        if (r > highest) highest = r;
+        response[j] = highest;
+    }
+    response[last] = 100.0f;
+
+    // The dead band ends where the first clear rise, extended back, meets zero;
+    // it cannot start before the last step that showed no flow.
+    int j = 1;
+    while (j < last && response[j] < SOLCHAR_DEAD_BAND_FLOW) j++;
+    float deadBand = j * SOLCHAR_STEP_PERCENT;
+    if (j < last && response[j + 1] > response[j]) {
+        deadBand -= response[j] * SOLCHAR_STEP_PERCENT / (response[j + 1] - response[j]);
+    }
+    if (deadBand < (j - 1) * SOLCHAR_STEP_PERCENT) deadBand = (j - 1) * SOLCHAR_STEP_PERCENT;
+    if (deadBand > SOLENOID_DEAD_BAND_MAX_PERCENT) deadBand = SOLENOID_DEAD_BAND_MAX_PERCENT;
+    c.deadTimeMs = c.frequencyHz > 0 ? deadBand * 10.0f / c.frequencyHz / c.supplyFactor : 0.0f;
+    if (c.deadTimeMs > SOLENOID_DEAD_TIME_MAX_MS) c.deadTimeMs = SOLENOID_DEAD_TIME_MAX_MS;
+
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) {
+        float duty = deadBand + i * SOLENOID_CURVE_STEP_PERCENT * (100.0f - deadBand) / 100.0f;
+        float position = duty / SOLCHAR_STEP_PERCENT;
+        int k = (int)position;
+        if (k > last - 1) k = last - 1;
+        float frac = position - (float)k;
+        c.flowPercent[i] = response[k] + (response[k + 1] - response[k]) * frac;
+    }
+    return true;
+}
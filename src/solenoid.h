@@ -0,0 +1,120 @@
+#ifndef SOLENOID_H
+#define SOLENOID_H
+
+#include <stdint.h>
+
+//================================================================================
+// SOLENOID OUTPUT LINEARIZATION
+//================================================================================
+// A 3-port boost solenoid does not pass air in proportion to its duty: the
+// first part of every on-time is spent pulling the armature in (dead time),
+// and the flow curve over the rest of the period is anything but straight.
+// With the curve enabled the controller's output is read as a share of the
+// valve's full flow, and this stage picks the duty that gives it:
+//
+//   duty = deadBand + effectiveDuty(flow) * (100 - deadBand) / 100
+//
+// The dead band is the dead time as a share of the PWM period, so one curve
+// holds at any valve frequency. The curve is measured over the effective duty
+// (the part of the period after the dead band) on evenly spaced breakpoints;
+// its inverse is built once whenever the curve changes, on evenly spaced flow
+// breakpoints, so each tick costs one index computation and one interpolation.
+
+#define SOLENOID_CURVE_POINTS 11       // flow at 0, 10, ... 100 % effective duty
+#define SOLENOID_INVERSE_POINTS 101    // effective duty at 0, 1, ... 100 % flow
+const float SOLENOID_CURVE_STEP_PERCENT = 10.0;
+const float SOLENOID_DEAD_TIME_MAX_MS = 20.0;
+const float SOLENOID_DEAD_BAND_MAX_PERCENT = 50.0;   // however high the frequency, half the period still moves air
+
+struct SolenoidCurve {
+    int enabled;
+    float deadTimeMs;                          // pull-in delay at the nominal supply voltage
+    float flowPercent[SOLENOID_CURVE_POINTS];  // share of full flow, should not fall with duty
+};
+
+struct SolenoidLinearizer {
+    bool built;
+    float builtFrom[SOLENOID_CURVE_POINTS];        // curve the inverse belongs to
+    float dutyAtFlow[SOLENOID_INVERSE_POINTS];     // effective duty (%) for each flow breakpoint
+};
+
+// Disabled, no dead time and a straight line, which together pass duty through unchanged.
+void solenoidCurveReset(SolenoidCurve& curve);
+// Resets the curve if anything is out of range (e.g. blank EEPROM); returns false if it did.
+bool solenoidCurveSanitize(SolenoidCurve& curve);
+// "N" = breakpoint 0-10 (N * 10 % effective duty); nullptr for anything else.
+float* solenoidCurveEntry(SolenoidCurve& curve, const char* key);
+
+void solenoidLinearizerInit(SolenoidLinearizer& linearizer);
+// Rebuilds the inverse when the curve's points changed since the last build.
+void solenoidLinearizerUpdate(SolenoidLinearizer& linearizer, const SolenoidCurve& curve);
+// Dead time as a share (%) of the PWM period, capped at SOLENOID_DEAD_BAND_MAX_PERCENT.
+float solenoidDeadBandPercent(float deadTimeMs, int frequencyHz);
+// Duty that passes flowPercent of full flow. 0 and 100 stay fully off and fully on.
+float solenoidLinearize(const SolenoidLinearizer& linearizer, float flowPercent, float deadBandPercent);
+// Flow the curve describes at a duty; the forward model solenoidLinearize() inverts.
+float solenoidFlow(const SolenoidCurve& curve, float dutyPercent, float deadBandPercent);
+
+//================================================================================
+// SOLENOID CHARACTERIZATION
+//================================================================================
+// Measures the curve on the bench: regulated air into the solenoid's inlet and
+// the MAP sensor on the port that feeds the wastegate actuator, engine off.
+// The routine holds each duty from 0 to 100 % in SOLCHAR_STEP_PERCENT steps,
+// lets the line settle, and averages the pressure. The responses are scaled
+// so 0 % duty reads 0 and 100 % duty reads 100, whichever way the valve is
+// plumbed. The dead band is where the first rise past SOLCHAR_DEAD_BAND_FLOW,
+// extended back, meets zero; it is converted to a dead time at the test
+// frequency, and the response beyond it is resampled onto the curve's
+// breakpoints.
+
+#define SOLCHAR_STEPS 21
+const float SOLCHAR_STEP_PERCENT = 5.0;
+const uint32_t SOLCHAR_SETTLE_MS = 1000;     // after each duty change
+const uint32_t SOLCHAR_AVERAGE_MS = 500;     // then averaged
+const float SOLCHAR_MIN_SPAN_KPA = 5.0;      // less between 0 and 100 % means no air or a dead valve
+const float SOLCHAR_DEAD_BAND_FLOW = 2.0;    // % of full response that counts as the valve passing air
+
+enum SolenoidCharPhase {
+    SOLCHAR_IDLE,
+    SOLCHAR_RUNNING,
+    SOLCHAR_DONE,
+    SOLCHAR_ABORTED
+};
+
+enum SolenoidCharAbortReason {
+    SOLCHAR_ABORT_NONE,
+    SOLCHAR_ABORT_NO_RESPONSE,
+    SOLCHAR_ABORT_ENGINE,      // the engine started, this is a bench routine
+    SOLCHAR_ABORT_USER,
+    SOLCHAR_ABORT_SENSOR,      // the MAP sensor fault monitor tripped
+    SOLCHAR_ABORT_NO_RPM       // the RPM input is off, so a running engine would go unseen
+};
+
+struct SolenoidCharacterizer {
+    SolenoidCharPhase phase;
+    SolenoidCharAbortReason abortReason;
+    int frequencyHz;
+    float supplyFactor;                    // nominal / measured supply at the start, 1 when unknown
+    int step;
+    bool stepStarted;
+    uint32_t stepStartMs;
+    float pressureSum;
+    int pressureCount;
+    float pressurekPa[SOLCHAR_STEPS];      // averaged response at each step
+    float deadTimeMs;                      // results, valid once DONE
+    float flowPercent[SOLENOID_CURVE_POINTS];
+};
+
+const char* solenoidCharAbortName(SolenoidCharAbortReason reason);
+// supplyFactor scales the measured dead time back to the nominal supply voltage.
+void solenoidCharacterizeStart(SolenoidCharacterizer& c, int frequencyHz, float supplyFactor);
+void solenoidCharacterizeAbort(SolenoidCharacterizer& c, SolenoidCharAbortReason reason);
+// Returns true while the routine owns the solenoid; dutyPercent is then the raw
+// duty to apply, bypassing the linearization being measured.
+bool solenoidCharacterizeStep(SolenoidCharacterizer& c, float pressurekPa, bool engineRunning, uint32_t timeMs,
+                              float& dutyPercent);
+// Turns the step responses into a dead time and curve; false when the span is too small.
+bool solenoidCharacterizeFit(SolenoidCharacterizer& c);
+
+#endif // SOLENOID_H
@@ -0,0 +1,88 @@
+#pragma GCC diagnostic error "-Wdouble-promotion"
+
+#include "sysid.h"
+#include <math.h>
+
+static const float SYSID_INITIAL_COVARIANCE = 1000.0f;
+// Without excitation forgetting inflates P without bound; stop forgetting past this trace.
+static const float SYSID_MAX_COVARIANCE_TRACE = 1.0e5f;
+static const uint32_t SYSID_MIN_UPDATES = 50;
+// Regressors are scaled to order one; raw kPa next to the constant term leaves
+// P badly conditioned in single precision.
+static const float SYSID_SCALE = 0.01f;
+static const float SYSID_MIN_COVARIANCE = 1.0e-9f;
+
+static void resetCovariance(SystemIdentifier& id) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) id.P[i][j] = (i == j) ? SYSID_INITIAL_COVARIANCE : 0.0f;
+    }
+}
+
+void sysidInit(SystemIdentifier& id) {
+    id.theta[0] = 0.9f; id.theta[1] = 0.0f; id.theta[2] = 0.1f;
+    resetCovariance(id);
+    for (int i = 0; i <= SYSID_MAX_DELAY_TICKS; i++) id.dutyHistory[i] = 0.0f;
+    id.dutyIndex = 0;
+    id.lastPressure = 0.0f;
+    id.primed = false;
+    id.updates = 0;
+}
+
+void sysidUpdate(SystemIdentifier& id, float pressurekPa, float previousDutyPercent, int delayTicks, float forgetting, bool learn) {
+    if (delayTicks < 0) delayTicks = 0;
+    if (delayTicks > SYSID_MAX_DELAY_TICKS) delayTicks = SYSID_MAX_DELAY_TICKS;
+    const int historyLen = SYSID_MAX_DELAY_TICKS + 1;
+    id.dutyIndex = (id.dutyIndex + 1) % historyLen;
+    id.dutyHistory[id.dutyIndex] = previousDutyPercent;
+    float delayedDuty = id.dutyHistory[(id.dutyIndex - delayTicks + historyLen) % historyLen];
+
+    if (learn && id.primed) {
+        const float phi[3] = {id.lastPressure * SYSID_SCALE, delayedDuty * SYSID_SCALE, 1.0f};
+        const float y = pressurekPa * SYSID_SCALE;
+
+        float Pphi[3];
+        for (int i = 0; i < 3; i++) {
+            Pphi[i] = id.P[i][0] * phi[0] + id.P[i][1] * phi[1] + id.P[i][2] * phi[2];
+        }
+        float denom = forgetting + phi[0] * Pphi[0] + phi[1] * Pphi[1] + phi[2] * Pphi[2];
+        if (denom > 1e-6f) {
+            float k[3] = {Pphi[0] / denom, Pphi[1] / denom, Pphi[2] / denom};
+            float predicted = id.theta[0] * phi[0] + id.theta[1] * phi[1] + id.theta[2] * phi[2];
+            float err = y - predicted;
+            for (int i = 0; i < 3; i++) id.theta[i] += k[i] * err;
+
+            float trace = id.P[0][0] + id.P[1][1] + id.P[2][2];
+            float lambda = (trace > SYSID_MAX_COVARIANCE_TRACE) ? 1.0f : forgetting;
+            // P = (P - k * phi' * P) / lambda, kept symmetric
+            for (int i = 0; i < 3; i++) {
+                for (int j = i; j < 3; j++) {
+                    float v = (id.P[i][j] - k[i] * Pphi[j]) / lambda;
+                    id.P[i][j] = v;
+                    id.P[j][i] = v;
+                }
+            }
+            // Rounding can still push P indefinite over long runs; restart it.
+            if (!(id.P[0][0] > SYSID_MIN_COVARIANCE && id.P[1][1] > SYSID_MIN_COVARIANCE && id.P[2][2] > SYSID_MIN_COVARIANCE)) {
+                resetCovariance(id);
+            }
+            id.updates++;
+        }
+    }
+
+    id.lastPressure = pressurekPa;
+    id.primed = true;
+}
+
+void sysidEstimate(const SystemIdentifier& id, float tickMs, PlantEstimate& est) {
+    est.a = id.theta[0];
+    est.b = id.theta[1];
+    est.c = id.theta[2] / SYSID_SCALE;
+    est.valid = id.updates >= SYSID_MIN_UPDATES && est.a > 0.0f && est.a < 0.999f && est.b > 0.0f;
+    if (est.valid) {
+        est.gainkPaPerPercent = est.b / (1.0f - est.a);
+        est.timeConstantMs = -tickMs / logf(est.a);
+    } else {
+        est.gainkPaPerPercent = 0.0f;
+        est.timeConstantMs = 0.0f;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef SYSID_H
+#define SYSID_H
+
+#include <stdint.h>
+
+//================================================================================
+// ONLINE PLANT IDENTIFICATION (RECURSIVE LEAST SQUARES)
+//================================================================================
+// Fits a first-order-plus-dead-time model, one control tick per sample:
+//   p[k] = a * p[k-1] + b * u[k-1-d] + c
+// with p the filtered pressure (kPa), u the solenoid duty (%) and d a fixed
+// dead time in ticks. The exponential forgetting factor lets the estimate
+// follow gear, RPM, temperature and solenoid wear. Cost is constant per tick
+// and all state is fixed size.
+
+#define SYSID_MAX_DELAY_TICKS 16
+
+struct SystemIdentifier {
+    float theta[3];            // a, b, c
+    float P[3][3];             // covariance
+    float dutyHistory[SYSID_MAX_DELAY_TICKS + 1];
+    int dutyIndex;
+    float lastPressure;
+    bool primed;
+    uint32_t updates;
+};
+
+struct PlantEstimate {
+    float a, b, c;
+    float gainkPaPerPercent;   // steady-state dp/du = b / (1 - a)
+    float timeConstantMs;      // -dt / ln(a)
+    bool valid;
+};
+
+void sysidInit(SystemIdentifier& id);
+// Adds one sample: the pressure measured this tick and the duty applied during
+// the previous one. Set learn=false while the loop carries no information (idle,
+// lifted throttle); the delay line still advances.
+void sysidUpdate(SystemIdentifier& id, float pressurekPa, float previousDutyPercent, int delayTicks, float forgetting, bool learn);
+void sysidEstimate(const SystemIdentifier& id, float tickMs, PlantEstimate& est);
+
+#endif // SYSID_H
@@ -3,185 +3,190 @@
 //================================================================================
 // PID CONTROL TASK (Core 0)
 //================================================================================
+static void controlYield() {
+    vTaskDelay(1); // Yield to prevent watchdog timeout
+}
+
 void pidControlTask(void *pvParameters) {
-    float error = 0.0, lastError = 0.0, integral = 0.0, derivative = 0.0, output = 0.0;
-    unsigned long lastTime = millis();
-    float v_ema_s = 0, output_ema_s = 0;
-    
-    int local_kpa_rate_time_interval_ms;
-    int local_valve_frequency;
-    const int task_delay_ms = 10;
-    const int HISTORY_SAMPLES_MAX = 20;
-    int history_samples;
-    float pressureHistory[HISTORY_SAMPLES_MAX];
-    int historyIndex = 0;
-    bool solenoidDisabledByIdle = false;
-    unsigned long idleTimerStart = 0;
+    static ControlParams params;   // too large for this task's stack
+    ControlInput input;
+    ControlOutput out;
+    SensorSample sensors;
+    PowerPolicy power;
+    PowerDecision powerDecision = {false, false, 0, 0};
 
+    int local_valve_frequency;
     int intervalTime;
     bool mosfetState = false;
     unsigned long controlLastTime = 0;
+    float lastAppliedPercent = 0;
+    bool lastDutyOverridden = false;   // lastAppliedPercent was not the PID's duty
+    bool feedForwardCleared = false;   // `ff clear` emptied the map this tick
 
     local_valve_frequency = valveFrequencyHz;
     intervalTime = 1000 / local_valve_frequency;
-    local_kpa_rate_time_interval_ms = kpa_rate_time_interval_ms;
-    history_samples = min(local_kpa_rate_time_interval_ms / task_delay_ms, HISTORY_SAMPLES_MAX);
 
-    float initialMeasuredVoltage = readOversampledVoltage();
-    float initialVoltage = initialMeasuredVoltage - scaledVoltageOffset;
-    v_ema_s = initialVoltage;
-    float initialPressure = fmap(initialVoltage, minSensorVoltage, maxSensorVoltage, MIN_KPA, MAX_KPA) + PRESSURE_CORRECTION_KPA;
-    for(int i = 0; i < history_samples; i++) {
-        pressureHistory[i] = initialPressure;
+    // Let the DMA scan fill the averaging window (at most SENSOR_AVERAGE_MAX
+    // conversions, about 26 ms) before the first reading.
+    int window = OVERSAMPLE_COUNT < SENSOR_AVERAGE_MAX ? OVERSAMPLE_COUNT : SENSOR_AVERAGE_MAX;
+    readSensorSample(sensors);
+    for (int attempt = 0; attempt < 100 && sensors.samples[SENSOR_MAP] < window; attempt++) {
+        vTaskDelay(pdMS_TO_TICKS(CONTROL_TASK_DELAY_MS));
+        readSensorSample(sensors);
+    }
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        fillControlParams(params);
+        xSemaphoreGive(dataMutex);
     }
+    unsigned long controlStartTime = millis();
+    controlInit(controlState, params, sensors.voltage[SENSOR_MAP], controlStartTime);
+    controlState.yieldHook = controlYield;
+    if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+        controlState.feedForward = feedForwardTable;
+        xSemaphoreGive(dataMutex);
+    }
+#ifdef BOOST_TRACE_LOG
+    // What the replay starts the controller from (tools/common/trace_log.h).
+    Serial.printf("# start=%lu,%.9g\n", controlStartTime, (double)sensors.voltage[SENSOR_MAP]);
+    Serial.print("# ff=");
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        Serial.printf("%.9g:%u%s", (double)controlState.feedForward.dutyPercent[i], (unsigned)controlState.feedForward.samples[i],
+                      i + 1 < FF_TABLE_POINTS ? "," : "\n");
+    }
+#endif
+    powerPolicyInit(power, millis());
 
     for (;;) {
-        if (millis() % 1000 < task_delay_ms) {
+        // Idle (power.h): the scan is stopped between ticks, so refill the window first.
+        if (powerDecision.burstMs > 0) sensorScanBurst(powerDecision.burstMs);
+        unsigned long currentTime = millis();
+        if (currentTime % 1000 < CONTROL_TASK_DELAY_MS) {
             local_valve_frequency = valveFrequencyHz;
             intervalTime = 1000 / local_valve_frequency;
-            local_kpa_rate_time_interval_ms = kpa_rate_time_interval_ms;
-            history_samples = min(local_kpa_rate_time_interval_ms / task_delay_ms, HISTORY_SAMPLES_MAX);
         }
 
-        float measuredVoltage = readOversampledVoltage();
-        float sensorVoltage = measuredVoltage - scaledVoltageOffset;
-        float rawPressure = fmap(sensorVoltage, minSensorVoltage, maxSensorVoltage, MIN_KPA, MAX_KPA) + PRESSURE_CORRECTION_KPA;
-        
-        int lookbackIndex = (historyIndex + 1) % history_samples;
-        float pressureChange = abs(rawPressure - pressureHistory[lookbackIndex]);
-        float current_alpha = (pressureChange > kpa_rate_change_threshold) ? fast_ema_a : slow_ema_a;
-        v_ema_s = (current_alpha * sensorVoltage) + ((1 - current_alpha) * v_ema_s);
-        
-        pressureHistory[historyIndex] = rawPressure;
-        historyIndex = (historyIndex + 1) % history_samples;
-        
-        float currentPressure = fmap(v_ema_s, minSensorVoltage, maxSensorVoltage, MIN_KPA, MAX_KPA) + PRESSURE_CORRECTION_KPA;
-        bool activityDetected = false;
+        readSensorSample(sensors);
+        input.timeMs = currentTime;
+        input.measuredVoltage = sensors.voltage[SENSOR_MAP];
+        input.sensors = &sensors;
+        input.activityDetected = false;
+        input.previousDutyPercent = lastAppliedPercent;
+        input.rpmPulses = rpmCounter.takePulses(rpmCounter.context);
+        input.speedPulses = speedCounter.takePulses(speedCounter.context);
         if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            // The menus, the serial console and the factory reset write these
+            // under the mutex, so a tick never sees half a preset or table.
+            fillControlParams(params);
             if(userActivity) {
-                activityDetected = true;
+                input.activityDetected = true;
                 userActivity = false;
             }
+            input.targetkPa = targetkPa;
+            feedForwardCleared = feedForwardClearRequested;
+            if (feedForwardClearRequested) {
+                feedForwardClear(controlState.feedForward);
+                controlState.feedForward.dirty = true;
+                feedForwardClearRequested = false;
+            }
+            if (sensorFaultClearRequested) {
+                sensorFaultClear(controlState.sensorFault);
+                sensorFaultClearRequested = false;
+            }
             xSemaphoreGive(dataMutex);
         }
-        if (activityDetected) {
-            idleTimerStart = 0;
-        }
 
-        if (currentPressure > IDLE_PRESSURE_MIN_KPA && currentPressure < IDLE_PRESSURE_MAX_KPA || currentPressure < MIN_KPA) {
-            if (idleTimerStart == 0) {
-                idleTimerStart = millis();
-            } else if (millis() - idleTimerStart > (IDLE_TIMEOUT_SECONDS * 1000)) {
-                solenoidDisabledByIdle = true;
-                if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) { isDisplayAsleep = true; xSemaphoreGive(dataMutex); }
-            }
-        } else {
-            idleTimerStart = 0;
+#ifdef BOOST_TRACE_LOG
+        // Capture format read by tools/replay (tools/common/trace_log.h):
+        // time_ms,voltage,target_kpa,flags,rpm_pulses,speed_pulses,backpressure_v,iat_v,supply_v,applied_pct
+        {
+            bool auxSensors = sensors.samples[SENSOR_BACKPRESSURE] > 0 && sensors.samples[SENSOR_IAT] > 0 && sensors.samples[SENSOR_SUPPLY] > 0;
+            unsigned flags = (input.activityDetected ? 0x1 : 0) | (auxSensors ? 0x2 : 0) | (lastDutyOverridden ? 0x4 : 0) |
+                             (feedForwardCleared ? 0x8 : 0);
+            Serial.printf("%lu,%.9g,%.9g,%u,%lu,%lu,%.9g,%.9g,%.9g,%.9g\n", (unsigned long)input.timeMs, (double)input.measuredVoltage,
+                          (double)input.targetkPa, flags, (unsigned long)input.rpmPulses, (unsigned long)input.speedPulses,
+                          (double)sensors.voltage[SENSOR_BACKPRESSURE], (double)sensors.voltage[SENSOR_IAT], (double)sensors.voltage[SENSOR_SUPPLY],
+                          (double)input.previousDutyPercent);
         }
+#endif
 
-        if (solenoidDisabledByIdle && currentPressure < REACTIVATE_PRESSURE_KPA) {
-            solenoidDisabledByIdle = false;
-            if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) { isDisplayAsleep = false; xSemaphoreGive(dataMutex); }
-        }
+        controlStep(controlState, params, input, out);
+        float currentPressure = out.currentPressure;
+        float localControlPercent = out.controlPercent;
+        float drivePercent = out.solenoidPercent;
+        bool overboostCut = overboostGuardTripped();
+        bool sensorFault = out.sensorFault != SENSOR_FAULT_NONE;
+        bool characterizing = false;
+        bool tunerOwnsSolenoid = false;
 
-        float localTargetkPa;
         if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
-            pressurekPa = currentPressure;
-            if (currentPressure > peakHoldkPa) {
-                peakHoldkPa = currentPressure;
+            if (out.sensorFaultRaised != SENSOR_FAULT_NONE) {
+                SensorFaultRecord record = {out.sensorFaultRaised, (uint32_t)currentTime, input.measuredVoltage, controlState.sensorFault.detail};
+                sensorFaultLogAdd(sensorFaultLog, record);
+            }
+            if (overboostCut) autotuneAbort(autotuner, AUTOTUNE_ABORT_OVERSHOOT);
+            if (sensorFault) {
+                autotuneAbort(autotuner, AUTOTUNE_ABORT_SENSOR);
+                solenoidCharacterizeAbort(solenoidCharacterizer, SOLCHAR_ABORT_SENSOR);
+            }
+            if (!controlState.solenoidDisabledByIdle) {
+                float tunerPercent = localControlPercent;
+                tunerOwnsSolenoid = autotuneStep(autotuner, currentPressure, input.targetkPa, currentTime, tunerPercent);
+                if (tunerOwnsSolenoid) localControlPercent = tunerPercent;
+            }
+            // The characterization measures the bare valve, so its duty skips the output stage.
+            // Without the RPM input it cannot tell the engine is off, so it does not run.
+            if (!params.rpm.enabled) solenoidCharacterizeAbort(solenoidCharacterizer, SOLCHAR_ABORT_NO_RPM);
+            bool engineRunning = controlState.rpm.rpm > 0;
+            characterizing = solenoidCharacterizeStep(solenoidCharacterizer, out.rawPressure, engineRunning, currentTime, drivePercent);
+            int calChannel = calibrationWizard.channel;
+            calibrationWizardStep(calibrationWizard, sensorOutputVoltage(params, calChannel, sensors.voltage[calChannel]), currentTime);
+            if (!characterizing && tunerOwnsSolenoid) {
+                drivePercent = controlSolenoidPercent(controlState, params, localControlPercent);
             }
-            localTargetkPa = targetkPa;
             xSemaphoreGive(dataMutex);
         }
 
-        unsigned long currentTime = millis();
-        unsigned long elapsedTime = currentTime - lastTime;
-
-        static int armingSampleCounter = 0;
-
-        switch (spoolState) {
-            case SPOOL_IDLE:
-                if (currentPressure > ARMING_THRESHOLD_KPA) {
-                    spoolState = SPOOL_ARMING;
-                    armingSampleCounter = 1;
-                }
-                break;
-
-            case SPOOL_ARMING:
-                if (currentPressure > ARMING_THRESHOLD_KPA) {
-                    armingSampleCounter++;
-                    if (armingSampleCounter >= ARMING_DWELL_SAMPLES) {
-                        p_start = currentPressure;
-                        t_start = currentTime;
-                        p_peak = p_start;
-                        t_peak = t_start;
-                        boostEventData.clear();
-                        boostEventData.push_back({p_start, t_start});
-                        spoolState = SPOOL_LOGGING;
-                    }
-                } else {
-                    spoolState = SPOOL_IDLE; 
-                }
-                break;
-
-            case SPOOL_LOGGING:
-                if (boostEventData.size() < MAX_BOOST_EVENT_SAMPLES) {
-                    boostEventData.push_back({currentPressure, currentTime});
-                }
-                if (currentPressure > p_peak) {
-                    p_peak = currentPressure;
-                    t_peak = currentTime;
-                }
-                if (currentPressure < (p_peak - TERMINATION_DROP_KPA)) {
-                    spoolState = SPOOL_CALCULATE_AND_DISPLAY;
-                }
-                break;
-            
-            case SPOOL_CALCULATE_AND_DISPLAY:
-                break;
-        }
+        // The guard holds this ceiling through any stall from here on. The
+        // characterization runs on bench air with the engine off, so the guard
+        // stands down for it.
+        OverboostLimit overboostLimit = out.overboostLimit;
+        if (characterizing) overboostLimit.ceilingkPa = 0;
+        overboostGuardSetLimit(overboostLimit);
+        if (sensorFault) drivePercent = params.sensorFailsafePercent;
+        if (overboostCut) drivePercent = 0;
+        // The next tick's identification and feed-forward learning, and the
+        // trace, get the duty the valve was given, not the PID's.
+        bool driveOverridden = characterizing || sensorFault || overboostCut;
+        float appliedPercent = driveOverridden ? controlPercentForSolenoid(controlState, params, drivePercent) : localControlPercent;
 
+        // The raw pressure, so an engine start wakes the board without the filter's lag.
+        window = OVERSAMPLE_COUNT < SENSOR_AVERAGE_MAX ? OVERSAMPLE_COUNT : SENSOR_AVERAGE_MAX;
+        PowerInput powerInput = {(uint32_t)currentTime, idlePowerMode, controlState.solenoidDisabledByIdle, input.activityDetected,
+                                 out.rawPressure, window, (uint32_t)tsSampleRate};
+        powerPolicyUpdate(power, powerInput, powerDecision);
+        if (powerDecision.enterIdle) powerEnterIdle(idlePowerMode == POWER_SETTING_LIGHT_SLEEP);
+        if (powerDecision.exitIdle) powerExitIdle();
 
-        if (currentPressure < localTargetkPa - pidTriggerkPa) {
-            output = 255.0;
-            integral = 0;
-        } else {
-            error = (localTargetkPa - currentPressure) + PID_Control_Overhead;
-            integral += error * (elapsedTime / 1000.0);
-            if (abs(integral) > maxIntegral) {
-                integral = maxIntegral * (integral > 0 ? 1 : -1);
+        if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            if (out.idleSleepStarted) isDisplayAsleep = true;
+            if (out.idleSleepEnded) isDisplayAsleep = false;
+            // Asleep, any touch is reported as activity, which wakes the board.
+            if (powerDecision.enterIdle) isDisplayAsleep = true;
+            powerPolicy = power;
+            pressurekPa = currentPressure;
+            if (currentPressure > peakHoldkPa) {
+                peakHoldkPa = currentPressure;
             }
-            derivative = (error - lastError) / (elapsedTime / 1000.0);
-            output = (kp * error) + (ki * integral) + (kd * derivative);
-        }
-        
-        lastError = error;
-        lastTime = currentTime;
-        output = constrain(output, 0, 255);
-        output_ema_s = (output_ema_a * output) + ((1 - output_ema_a) * output_ema_s);
-        float localControlPercent = fmap(output_ema_s, 0.0, 255.0, 0.0, 100.0);
-
-        if (solenoidDisabledByIdle) {
-            localControlPercent = 0;
+            if (controlState.feedForward.dirty) {
+                feedForwardTable = controlState.feedForward;
+                controlState.feedForward.dirty = false;
+            }
+            xSemaphoreGive(dataMutex);
         }
 
-        if (spoolState == SPOOL_CALCULATE_AND_DISPLAY) {
-            float maxRate = 0.0;
-            if (boostEventData.size() > 1) {
-                for (size_t i = 1; i < boostEventData.size(); ++i) {
-                    vTaskDelay(1); // Yield to prevent watchdog timeout
-                    float p_delta = boostEventData[i].pressure - boostEventData[i-1].pressure;
-                    unsigned long t_delta = boostEventData[i].timestamp - boostEventData[i-1].timestamp;
-                    if (t_delta > 0) {
-                        float rate = (p_delta / t_delta) * 1000.0;
-                        if (rate > maxRate) {
-                            maxRate = rate;
-                        }
-                    }
-                }
-            }
+        if (out.spoolScoreReady) {
             if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
-                if (maxRate > spoolScore) { spoolScore = maxRate; }
+                if (out.spoolScore > spoolScore) { spoolScore = out.spoolScore; }
                 if (activeProfile == 'A') {
                     if (spoolScore > spoolScoreA) { spoolScoreA = spoolScore; }
                     if (spoolScore > spoolScoreA) { 
@@ -196,58 +201,11 @@ void pidControlTask(void *pvParameters) {
                 }
                 xSemaphoreGive(dataMutex);
             }
-            spoolState = SPOOL_IDLE;
         }
 
-        // Torque Score Calculation
-        if (torqueState == TORQUE_IDLE && currentPressure > ARMING_THRESHOLD_KPA) {
-            torqueState = TORQUE_LOGGING;
-            boostEventData.clear();
-            torqueLoggingStartTime = currentTime;
-        }
-
-        if (torqueState == TORQUE_LOGGING) {
-            if (currentTime - torqueLoggingStartTime > 3000 && currentPressure < localTargetkPa) {
-                torqueState = TORQUE_IDLE;
-                boostEventData.clear();
-            } else {
-                if (boostEventData.size() < MAX_BOOST_EVENT_SAMPLES) {
-                    boostEventData.push_back({currentPressure, currentTime});
-                }
-                if (currentPressure < (p_peak - TERMINATION_DROP_KPA)) {
-                    torqueState = TORQUE_CALCULATE_AND_DISPLAY;
-                }
-            }
-        }
-
-        if (torqueState == TORQUE_CALCULATE_AND_DISPLAY) {
-            float totalScore = 0;
-            unsigned long setpointTime = 0;
-            if (boostEventData.size() > 1) {
-                for (size_t i = 1; i < boostEventData.size(); ++i) {
-                    vTaskDelay(1); // Yield to prevent watchdog timeout
-                    float p_avg = (boostEventData[i].pressure + boostEventData[i-1].pressure) / 2.0;
-                    unsigned long t_delta = boostEventData[i].timestamp - boostEventData[i-1].timestamp;
-                    
-                    if (p_avg >= localTargetkPa && setpointTime == 0) {
-                        setpointTime = boostEventData[i].timestamp;
-                    }
-
-                    if (setpointTime > 0 && boostEventData[i].timestamp - setpointTime > torqueScoreCutoffMs) {
-                        break;
-                    }
-
-                    float area = (p_avg - 100.0) * t_delta; // Area above atmospheric pressure
-
-                    if (p_avg > localTargetkPa) { // Overshoot penalty
-                        area -= (p_avg - localTargetkPa) * t_delta * 2.0; // Penalize overshoot more heavily
-                    }
-                    totalScore += area;
-                }
-            }
+        if (out.torqueScoreReady) {
             if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
-                float scaledTorqueScore = totalScore / 1000.0;
-                if (scaledTorqueScore > torqueScore) { torqueScore = scaledTorqueScore; }
+                if (out.torqueScore > torqueScore) { torqueScore = out.torqueScore; }
                 if (activeProfile == 'A') {
                     if (torqueScore > torqueScoreA) {
                         torqueScoreA = torqueScore;
@@ -261,23 +219,40 @@ void pidControlTask(void *pvParameters) {
                 }
                 xSemaphoreGive(dataMutex);
             }
-            torqueState = TORQUE_IDLE;
         }
 
+        lastAppliedPercent = appliedPercent;
+        lastDutyOverridden = tunerOwnsSolenoid || driveOverridden;
+
         if(xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
             controlPercent = localControlPercent;
-            if (currentScreen == MAIN_SCREEN || currentScreen == TUNE_SCORING_SCREEN) {
+            telemetry.timeMs = currentTime;
+            telemetry.pressurekPa = currentPressure;
+            telemetry.targetkPa = out.targetkPa;
+            telemetry.dutyPercent = localControlPercent;
+            telemetry.gainScale = controlState.gainScale;
+            telemetry.dutyCeiling = controlState.dutyCeiling;
+            telemetry.rpm = controlState.rpm.rpm;
+            telemetry.gear = controlState.rpm.gear;
+            telemetry.backpressurekPa = controlState.aux.backpressurekPa;
+            telemetry.intakeTempC = controlState.aux.intakeTempC;
+            telemetry.supplyVoltage = controlState.aux.supplyVoltage;
+            telemetry.sensorFault = out.sensorFault;
+            telemetry.pressureRate = out.pressureRate;
+            telemetry.oversampleCount = sensors.samples[SENSOR_MAP];
+            sysidEstimate(controlState.sysid, CONTROL_TASK_DELAY_MS, telemetry.plant);
+            if (currentScreen == MAIN_SCREEN || currentScreen == TUNE_SCORING_SCREEN || currentScreen == AUTOTUNE_SCREEN) {
                 displayNeedsUpdate = true;
             }
             xSemaphoreGive(dataMutex);
         }
         
-        if (localControlPercent <= 1.0) {
+        if (drivePercent <= 1.0f) {
             if (mosfetState) { digitalWrite(SOLENOID_PIN, LOW); mosfetState = false; }
-        } else if (localControlPercent >= 99.0) {
+        } else if (drivePercent >= 99.0f) {
             if (!mosfetState) { digitalWrite(SOLENOID_PIN, HIGH); mosfetState = true; }
         } else {
-            int onTime = localControlPercent / 100.0 * intervalTime;
+            int onTime = drivePercent * 0.01f * intervalTime;
             int offTime = intervalTime - onTime;
             unsigned long controlCurrentTime = millis();
             unsigned long controlElapsedTime = controlCurrentTime - controlLastTime;
@@ -291,7 +266,7 @@ void pidControlTask(void *pvParameters) {
                 controlLastTime = controlCurrentTime;
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(tsSampleRate));
+        vTaskDelay(pdMS_TO_TICKS(powerDecision.tickMs - powerDecision.burstMs));
     }
 }
 
@@ -305,9 +280,33 @@ void displayAndInputTask(void *pvParameters) {
             displayNeedsUpdate = true;
         }
         handleTouchInputs();
+        handleSerialCommands();
+        printTelemetry();
+        reportSolenoidCharacterization();
+        reportCalibrationWizard();
+        static bool overboostShown = false;
+        bool overboostCut = overboostGuardTripped();
+        if (overboostCut != overboostShown) {
+            overboostShown = overboostCut;
+            displayNeedsUpdate = true;
+        }
+        static uint8_t sensorFaultShown = SENSOR_FAULT_NONE;
+        uint8_t sensorFault = sensorFaultShown;
+        bool powerIdle = false;
+        if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            sensorFault = telemetry.sensorFault;
+            powerIdle = powerPolicy.mode == POWER_IDLE;
+            xSemaphoreGive(dataMutex);
+        }
+        if (sensorFault != sensorFaultShown) {
+            sensorFaultShown = sensorFault;
+            displayNeedsUpdate = true;
+        }
+        persistFeedForwardIfDue();
+        persistSensorFaultLogIfDue();
         if (displayNeedsUpdate) {
             updateDisplay();
         }
-        vTaskDelay(pdMS_TO_TICKS(50));
+        vTaskDelay(pdMS_TO_TICKS(powerIdle ? POWER_IDLE_TICK_MS : 50));
     }
 }
@@ -0,0 +1,22 @@
+#include "textwrap.h"
+
+//================================================================================
+// TEXT WRAPPING
+//================================================================================
+int textWrapLine(const char* text, int maxChars, const char** next) {
+    if (maxChars < 1) maxChars = 1;
+
+    int length = 0;
+    int breakAt = -1;   // the last space that fits
+    while (text[length] != '\0' && length < maxChars) {
+        if (text[length] == ' ') breakAt = length;
+        length++;
+    }
+    if (text[length] != '\0' && text[length] != ' ' && breakAt > 0) length = breakAt;
+
+    const char* rest = text + length;
+    while (*rest == ' ') rest++;
+    *next = rest;
+    while (length > 0 && text[length - 1] == ' ') length--;
+    return length;
+}
@@ -0,0 +1,17 @@
+#ifndef TEXTWRAP_H
+#define TEXTWRAP_H
+
+//================================================================================
+// TEXT WRAPPING
+//================================================================================
+// Breaks text into lines for the fixed-width 6x8 font, in place and without
+// copying, so the info screen draws from a char buffer on the stack.
+
+const int TEXT_CHAR_WIDTH = 6;   // pixels per character at text size 1
+
+// The line starting at text, at most maxChars long: its length, without the
+// space it breaks at. next is set to the start of the following line, or to
+// the terminating NUL. A word longer than maxChars is split.
+int textWrapLine(const char* text, int maxChars, const char** next);
+
+#endif // TEXTWRAP_H
@@ -0,0 +1,333 @@
+//================================================================================
+// ADC CORRECTION CHECK
+//================================================================================
+// Exercises the ADC correction table (src/sensors.h) against a modelled chip
+// whose conversion has a gain error, an offset and a bend at the top of the
+// range, characterized as the IDF does: the chip's millivolts at every
+// ADC_CORRECTION_STEP codes, rounded to whole millivolts.
+//   - the table reads each knot exactly and the chip at every code between,
+//     fractional codes included, to within rounding of the knots
+//   - the ideal conversion's error against the chip is reported
+//   - through sensorAveragerSample(), dithered codes for a MAP voltage sweep
+//     read within 0.1 kPa of the true pressure with the correction; the ideal
+//     conversion's error is reported alongside
+//   - a characterization with no source, a NaN, a falling point or a point far
+//     from the ideal conversion is refused, and a refused, disabled or missing
+//     correction converts ideally
+// It then times one conversion ideally and through the table, and a whole
+// sensorAveragerSample() each way, in ns and (on x86) TSC ticks.
+// --gain G (fraction), --offset MV and --bend MV shape the modelled chip;
+// --chip FILE reads the "adc.source=" and "adc.mv=" lines the serial command
+// "adc" prints and checks that characterization instead. --ticks N sets how
+// many conversions each is timed over.
+//
+//   adccal [--params FILE] [--set key=value]... [--gain G] [--offset MV] [--bend MV] [--chip FILE] [--ticks N]
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "tool_params.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+static uint64_t cycleCount() { return 0; }   // no counter; the column reads 0
+#endif
+
+//================================================================================
+// CHIP MODEL
+//================================================================================
+// Millivolts at the pin for a (fractional) code: the ideal conversion scaled by
+// 1 + gain, plus offset, plus a bend that grows as the fourth power toward full
+// scale. With --chip, the recorded knots joined by straight lines stand in.
+struct ChipModel {
+    double gain, offsetMv, bendMv;
+    bool recorded;
+    AdcCharacterization table;
+};
+
+static double chipMillivolts(const ChipModel& chip, double code) {
+    if (chip.recorded) {
+        int i = (int)(code / ADC_CORRECTION_STEP);
+        if (i < 0) i = 0;
+        if (i > ADC_CORRECTION_POINTS - 2) i = ADC_CORRECTION_POINTS - 2;
+        double t = (code - i * ADC_CORRECTION_STEP) / ADC_CORRECTION_STEP;
+        return chip.table.millivolts[i] + t * (chip.table.millivolts[i + 1] - chip.table.millivolts[i]);
+    }
+    double ideal = code / 4095.0 * 3300.0;
+    double x = code / 4095.0;
+    return ideal * (1.0 + chip.gain) + chip.offsetMv + chip.bendMv * x * x * x * x;
+}
+
+// The code the chip gives for a pin voltage, as a real number; the converter
+// would give one of the integers either side.
+static double chipCode(const ChipModel& chip, double millivolts) {
+    double lo = 0.0, hi = 4095.0;
+    for (int k = 0; k < 60; k++) {
+        double mid = 0.5 * (lo + hi);
+        if (chipMillivolts(chip, mid) < millivolts) lo = mid;
+        else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+static AdcCharacterization characterize(const ChipModel& chip) {
+    if (chip.recorded) return chip.table;
+    AdcCharacterization out;
+    out.source = ADC_CAL_EFUSE_CURVE;
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) {
+        out.millivolts[i] = (float)floor(chipMillivolts(chip, i * ADC_CORRECTION_STEP) + 0.5);
+    }
+    return out;
+}
+
+static bool loadChip(ChipModel& chip, const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    bool haveSource = false, haveMv = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 11, "adc.source=") == 0) {
+            chip.table.source = atoi(line.c_str() + 11);
+            haveSource = true;
+        } else if (line.compare(0, 7, "adc.mv=") == 0) {
+            const char* p = line.c_str() + 7;
+            int count = 0;
+            while (*p && count < ADC_CORRECTION_POINTS) {
+                char* end;
+                chip.table.millivolts[count++] = strtof(p, &end);
+                if (end == p) break;
+                p = *end == ',' ? end + 1 : end;
+            }
+            haveMv = count == ADC_CORRECTION_POINTS;
+        }
+    }
+    if (!haveSource || !haveMv) {
+        error = path + ": needs adc.source= and adc.mv= with " + std::to_string(ADC_CORRECTION_POINTS) + " values";
+        return false;
+    }
+    chip.recorded = true;
+    return true;
+}
+
+//================================================================================
+// ACCURACY
+//================================================================================
+static void checkTable(const ChipModel& chip, const AdcCorrection& correction) {
+    AdcCharacterization knots = characterize(chip);
+    double worstKnot = 0;
+    for (int i = 0; i < ADC_CORRECTION_POINTS; i++) {
+        worstKnot = fmax(worstKnot, fabs(adcCodeToVolts(&correction, (float)(i * ADC_CORRECTION_STEP)) * 1000.0 - knots.millivolts[i]));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error=%.2e mV", worstKnot);
+    check(worstKnot < 1e-3, "knots exact", detail);
+
+    double worstTable = 0, worstIdeal = 0;
+    for (int sixteenths = 0; sixteenths <= 4095 * 16; sixteenths++) {
+        double code = sixteenths / 16.0;
+        double chipMv = chipMillivolts(chip, code);
+        worstTable = fmax(worstTable, fabs(adcCodeToVolts(&correction, (float)code) * 1000.0 - chipMv));
+        worstIdeal = fmax(worstIdeal, fabs(adcCodeToVolts(nullptr, (float)code) * 1000.0 - chipMv));
+    }
+    snprintf(detail, sizeof(detail), "max_error=%.3f mV over 1/16 codes", worstTable);
+    check(worstTable < 0.6, "table follows the chip", detail);
+    snprintf(detail, sizeof(detail), "max_error=%.1f mV", worstIdeal);
+    check(true, "ideal conversion vs chip", detail);
+}
+
+// Sweeps the MAP channel across the sensor's range. Each reading is a window of
+// codes dithered evenly between the integers either side of the chip's code,
+// as noise does on the real converter, so the average lands on the code.
+static void checkPressure(const ControlParams& params, const ChipModel& chip, const AdcCorrection& correction) {
+    static SensorAverager averager;
+    const int window = 64;
+    double worstCorrected = 0, worstIdeal = 0;
+    for (int step = 0; step <= 200; step++) {
+        double pin = params.minSensorVoltage + params.scaledVoltageOffset +
+                     (params.maxSensorVoltage - params.minSensorVoltage) * step / 200.0;
+        double code = chipCode(chip, pin * 1000.0);
+        double truekPa = voltageToPressure(params, (float)(pin - params.scaledVoltageOffset));
+        for (int pass = 0; pass < 2; pass++) {
+            sensorAveragerInit(averager, window);
+            sensorAveragerSetCorrection(averager, pass ? &correction : nullptr);
+            for (int k = 0; k < window; k++) {
+                int c = (int)floor(code + (k + 0.5) / window);
+                if (c > 4095) c = 4095;
+                for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) sensorAveragerPush(averager, ch, (uint16_t)c);
+            }
+            SensorSample sample;
+            sensorAveragerSample(averager, 0, sample);
+            double error = fabs(voltageToPressure(params, sample.voltage[SENSOR_MAP] - params.scaledVoltageOffset) - truekPa);
+            if (pass) worstCorrected = fmax(worstCorrected, error);
+            else worstIdeal = fmax(worstIdeal, error);
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error=%.3f kPa (ideal %.2f kPa)", worstCorrected, worstIdeal);
+    check(worstCorrected < 0.1, "MAP through the averager", detail);
+}
+
+static void checkRefused(const ChipModel& chip) {
+    AdcCharacterization good = characterize(chip);
+    AdcCorrection correction;
+    struct Case {
+        const char* name;
+        int index;
+        float value;
+        int source;
+    } cases[] = {
+        {"no source", -1, 0.0f, ADC_CAL_NONE},
+        {"unknown source", -1, 0.0f, ADC_CAL_SOURCE_COUNT},
+        {"NaN", 20, NAN, ADC_CAL_EFUSE_CURVE},
+        {"falling", 40, good.millivolts[39] - 5.0f, ADC_CAL_EFUSE_CURVE},
+        {"far from ideal", 10, good.millivolts[10] + ADC_CORRECTION_MAX_DEVIATION_MV + 50.0f, ADC_CAL_EFUSE_CURVE},
+    };
+    char detail[200] = "";
+    bool allRefused = true;
+    for (const Case& c : cases) {
+        AdcCharacterization bad = good;
+        bad.source = c.source;
+        if (c.index >= 0) bad.millivolts[c.index] = c.value;
+        correction.enabled = true;
+        bool built = adcCorrectionBuild(correction, bad);
+        if (built || correction.enabled) {
+            allRefused = false;
+            snprintf(detail + strlen(detail), sizeof(detail) - strlen(detail), "%s accepted; ", c.name);
+        }
+    }
+    if (allRefused) snprintf(detail, sizeof(detail), "%d bad characterizations refused", (int)(sizeof(cases) / sizeof(cases[0])));
+    check(allRefused, "bad data refused", detail);
+
+    // A refused build leaves enabled false, so the table is ignored.
+    bool ideal = true;
+    AdcCorrection disabled;
+    adcCorrectionBuild(disabled, good);
+    disabled.enabled = false;
+    for (int code = 0; code <= 4095; code += 7) {
+        float expected = (float)code * ADC_VOLTS_PER_CODE;
+        if (adcCodeToVolts(nullptr, (float)code) != expected || adcCodeToVolts(&disabled, (float)code) != expected ||
+            adcCodeToVolts(&correction, (float)code) != expected) {
+            ideal = false;
+        }
+    }
+    check(ideal, "fallback to ideal", ideal ? "null, disabled and refused tables convert ideally" : "a table was used");
+}
+
+//================================================================================
+// BENCHMARK
+//================================================================================
+struct Timing {
+    double ns, cycles;
+};
+
+static const int CODE_COUNT = 1024;
+static float codes[CODE_COUNT];
+static volatile float benchSink;
+
+static Timing timeConversions(const AdcCorrection* correction, int ticks) {
+    float sum = 0;
+    uint64_t startCycles = cycleCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) sum += adcCodeToVolts(correction, codes[i & (CODE_COUNT - 1)]);
+    auto end = std::chrono::steady_clock::now();
+    uint64_t cycles = cycleCount() - startCycles;
+    benchSink = sum;
+    return {std::chrono::duration<double, std::nano>(end - start).count() / ticks, (double)cycles / ticks};
+}
+
+static Timing timeSamples(const AdcCorrection* correction, int ticks) {
+    static SensorAverager averager;
+    const int window = 64;
+    sensorAveragerInit(averager, window);
+    sensorAveragerSetCorrection(averager, correction);
+    uint32_t rng = 7;
+    for (int k = 0; k < window; k++) {
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            rng = rng * 1664525u + 1013904223u;
+            sensorAveragerPush(averager, ch, (uint16_t)((rng >> 8) % 4096));
+        }
+    }
+    SensorSample sample;
+    float sum = 0;
+    uint64_t startCycles = cycleCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) {
+        sensorAveragerSample(averager, (uint32_t)i, sample);
+        sum += sample.voltage[i % SENSOR_CHANNEL_COUNT];
+    }
+    auto end = std::chrono::steady_clock::now();
+    uint64_t cycles = cycleCount() - startCycles;
+    benchSink = sum;
+    return {std::chrono::duration<double, std::nano>(end - start).count() / ticks, (double)cycles / ticks};
+}
+
+static void benchmark(const AdcCorrection& correction, int ticks) {
+    uint32_t rng = 31;
+    for (int i = 0; i < CODE_COUNT; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        codes[i] = (float)((rng >> 8) % (4095 * 64)) / 64;
+    }
+    Timing ideal = timeConversions(nullptr, ticks);
+    Timing table = timeConversions(&correction, ticks);
+    Timing idealSample = timeSamples(nullptr, ticks / 8);
+    Timing tableSample = timeSamples(&correction, ticks / 8);
+    printf("\nconversion,ns_per_call,tsc_per_call\n");
+    printf("ideal code to volts,%.2f,%.1f\n", ideal.ns, ideal.cycles);
+    printf("corrected code to volts,%.2f,%.1f\n", table.ns, table.cycles);
+    printf("sensorAveragerSample ideal,%.2f,%.1f\n", idealSample.ns, idealSample.cycles);
+    printf("sensorAveragerSample corrected,%.2f,%.1f\n", tableSample.ns, tableSample.cycles);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    ChipModel chip = {-0.03, 40.0, -80.0, false, {}};
+    int ticks = 4000000;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--gain") chip.gain = atof(value.c_str());
+        else if (arg == "--offset") chip.offsetMv = atof(value.c_str());
+        else if (arg == "--bend") chip.bendMv = atof(value.c_str());
+        else if (arg == "--chip") ok = loadChip(chip, value, error);
+        else if (arg == "--ticks") ok = (ticks = atoi(value.c_str())) > 0;
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: adccal [--params FILE] [--set key=value]... [--gain G] [--offset MV] [--bend MV] [--chip FILE] [--ticks N]\n");
+            return 1;
+        }
+    }
+
+    ControlParams params;
+    toControlParams(tp, params);
+    AdcCorrection correction;
+    AdcCharacterization characterization = characterize(chip);
+    char detail[160];
+    snprintf(detail, sizeof(detail), "source %s", adcCalibrationSourceName(characterization.source));
+    bool built = adcCorrectionBuild(correction, characterization);
+    check(built, "characterization accepted", detail);
+    if (built) {
+        checkTable(chip, correction);
+        checkPressure(params, chip, correction);
+        checkRefused(chip);
+        benchmark(correction, ticks);
+    }
+    return checkExitCode();
+}
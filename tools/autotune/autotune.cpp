@@ -0,0 +1,186 @@
+//================================================================================
+// AUTOTUNE SIMULATION
+//================================================================================
+// Runs the firmware relay autotune (src/autotune.cpp) against the host plant
+// model, then scores the suggested gains with a normal simulated pull.
+//
+// It then checks that an aborted autotune hands the solenoid back to the PID,
+// and exits non-zero if it keeps it.
+//
+//   autotune [--params FILE] [--set key=value]... [--plant key=value]...
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "autotune.h"
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static bool setPlant(PlantModel& m, const std::string& a) {
+    size_t eq = a.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = a.substr(0, eq);
+    float v = strtof(a.c_str() + eq + 1, nullptr);
+    if (key == "springkPa") m.springkPa = v;
+    else if (key == "maxBoostkPa") m.maxBoostkPa = v;
+    else if (key == "spoolTimeMs") m.spoolTimeMs = v;
+    else if (key == "tauMs") m.tauMs = v;
+    else if (key == "deadTimeMs") m.deadTimeMs = v;
+    else if (key == "noisekPa") m.noisekPa = v;
+    else return false;
+    return true;
+}
+
+static AutotuneConfig defaultConfig(AutotuneRule rule) {
+    AutotuneConfig config;
+    config.relayHighPercent = 100;
+    config.relayLowPercent = 0;
+    config.hysteresiskPa = 1.0f;
+    config.overshootLimitkPa = 25.0f;
+    config.liftDropkPa = 30.0f;
+    config.timeoutMs = 8000;
+    config.cyclesRequired = 4;
+    config.rule = rule;
+    return config;
+}
+
+static bool runAutotune(const ToolParams& tp, const PlantModel& model, AutotuneRule rule, Autotuner& tuner) {
+    static ControlState state;
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantState plant;
+    plantInit(plant, model);
+
+    autotuneStart(tuner, defaultConfig(rule));
+
+    const uint32_t throttleOpenMs = 1000;
+    float duty = 0;
+    uint32_t t = 0;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, 100.0f), t);
+    ControlInput input;
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = nullptr;
+    for (t = CONTROL_TASK_DELAY_MS; t < 15000; t += CONTROL_TASK_DELAY_MS) {
+        float p = plantStep(plant, model, duty, t >= throttleOpenMs, (float)(t - throttleOpenMs), CONTROL_TASK_DELAY_MS);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+        autotuneStep(tuner, out.currentPressure, tp.targetkPa, t, duty);
+        if (tuner.phase == AUTOTUNE_DONE || tuner.phase == AUTOTUNE_ABORTED) break;
+    }
+    return tuner.phase == AUTOTUNE_DONE;
+}
+
+// Aborts the relay a second into its run and carries on as the control task
+// does: the tuner's duty replaces the PID's only while autotuneStep() says it
+// owns the solenoid, and it must not touch the duty otherwise. After the abort
+// it may hold the wastegate open briefly,
+// then the PID's duty must reach the solenoid on every tick, and boost must
+// come back to the target.
+static void checkAbortHandsBack(const ToolParams& tp, const PlantModel& model, AutotuneAbortReason reason, const char* name) {
+    static ControlState state;
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantState plant;
+    plantInit(plant, model);
+    Autotuner tuner;
+    autotuneStart(tuner, defaultConfig(AUTOTUNE_RULE_ZIEGLER_NICHOLS));
+
+    const uint32_t throttleOpenMs = 1000, endMs = 9000, settleMs = 2000;
+    float duty = 0, pressure = 0, pressureSum = 0;
+    uint32_t relayStartMs = 0, abortMs = 0;
+    int heldTicks = 0, ownedLater = 0, settleTicks = 0, dutyTouched = 0;
+    bool released = false;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, 100.0f), 0);
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    for (uint32_t t = CONTROL_TASK_DELAY_MS; t < endMs; t += CONTROL_TASK_DELAY_MS) {
+        float p = plantStep(plant, model, duty, t >= throttleOpenMs, (float)(t - throttleOpenMs), CONTROL_TASK_DELAY_MS);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        pressure = out.currentPressure;
+        if (tuner.phase == AUTOTUNE_RELAY && relayStartMs == 0) relayStartMs = t;
+        if (relayStartMs != 0 && abortMs == 0 && t >= relayStartMs + 1000) {
+            autotuneAbort(tuner, reason);
+            abortMs = t;
+        }
+        float tunerPercent = out.controlPercent;
+        bool owns = autotuneStep(tuner, pressure, tp.targetkPa, t, tunerPercent);
+        if (!owns && tunerPercent != out.controlPercent) dutyTouched++;
+        duty = owns ? tunerPercent : out.controlPercent;
+        if (abortMs != 0) {
+            if (owns && !released) heldTicks++;
+            else if (owns) ownedLater++;
+            else released = true;
+        }
+        if (t >= endMs - settleMs) {
+            pressureSum += pressure;
+            settleTicks++;
+        }
+    }
+
+    float meankPa = settleTicks ? pressureSum / settleTicks : 0;
+    char detail[192];
+    snprintf(detail, sizeof(detail), "aborted at %lu ms, wastegate held %d ticks, %d taken back later, %d duty changes unowned, "
+             "last %lu ms mean %.1f kPa (target %.0f)", (unsigned long)abortMs, heldTicks, ownedLater, dutyTouched,
+             (unsigned long)settleMs, meankPa, tp.targetkPa);
+    bool pass = abortMs != 0 && heldTicks >= 1 && heldTicks <= 50 && released && ownedLater == 0 && dutyTouched == 0 &&
+                meankPa > tp.targetkPa - 20.0f;
+    check(pass, name, detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    PlantModel model = defaultPlantModel();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--plant") ok = setPlant(model, value);
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "usage: autotune [--params FILE] [--set key=value]... [--plant key=value]...\n");
+            return 1;
+        }
+    }
+
+    PullMetrics baseline;
+    simulatePull(tp, model, defaultPullProfile(), baseline);
+    printf("rule,Ku,Tu_ms,amplitude_kpa,kp,ki,kd,torque_score,spool_score,overshoot_kpa,settling_ms\n");
+    printf("current,,,,%.3f,%.4f,%.3f,%.1f,%.1f,%.2f,%.0f\n", tp.kp, tp.ki, tp.kd,
+           baseline.torqueScore, baseline.spoolScore, baseline.overshootkPa, baseline.settlingMs);
+
+    for (int r = 0; r < AUTOTUNE_RULE_COUNT; r++) {
+        Autotuner tuner;
+        if (!runAutotune(tp, model, (AutotuneRule)r, tuner)) {
+            printf("%s,aborted (reason %d)\n", autotuneRuleName((AutotuneRule)r), (int)tuner.abortReason);
+            continue;
+        }
+        ToolParams tuned = tp;
+        tuned.kp = tuner.result.kp; tuned.ki = tuner.result.ki; tuned.kd = tuner.result.kd;
+        PullMetrics m;
+        simulatePull(tuned, model, defaultPullProfile(), m);
+        printf("%s,%.3f,%.0f,%.2f,%.3f,%.4f,%.3f,%.1f,%.1f,%.2f,%.0f\n", autotuneRuleName((AutotuneRule)r),
+               tuner.result.ultimateGain, tuner.result.ultimatePeriodMs, tuner.result.amplitudekPa,
+               tuner.result.kp, tuner.result.ki, tuner.result.kd, m.torqueScore, m.spoolScore, m.overshootkPa, m.settlingMs);
+    }
+
+    checkAbortHandsBack(tp, model, AUTOTUNE_ABORT_USER, "user abort hands back to the PID");
+    checkAbortHandsBack(tp, model, AUTOTUNE_ABORT_OVERSHOOT, "overshoot abort hands back");
+    return checkExitCode();
+}
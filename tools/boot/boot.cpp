@@ -0,0 +1,200 @@
+//================================================================================
+// STAGED BOOT CHECK
+//================================================================================
+// Runs the boot sequence (src/boot.h) against a simulated clock, each stage
+// taking a set time, as setup() runs it:
+//   - the critical stages run first and in order, and the control task starts
+//     within 50 ms of reset with typical stage times; the order the firmware
+//     used before would have started it after the display, touch calibration
+//     and the reset window
+//   - the background stages run after it, in order
+//   - a finger left on a button (touch calibration waiting 30 s) or the
+//     factory-reset gesture (3 s window and 2 s message) does not move the
+//     control start
+//   - a failing critical stage is logged and the control task still starts; a
+//     failing background stage skips the ones after it
+//   - every logged duration is the simulated one, across a wrap of micros()
+// --delay stage=ms sets one stage's simulated time (stage names as the serial
+// command "boot" prints them, spaces as underscores).
+//
+//   boot [--delay stage=ms]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "boot.h"
+#include "check.h"
+
+//================================================================================
+// SIMULATED BOARD
+//================================================================================
+struct SimBoard {
+    uint32_t nowUs;
+    uint32_t delayUs[BOOT_STAGE_COUNT];
+    bool fails[BOOT_STAGE_COUNT];
+    int calls[BOOT_STAGE_COUNT];
+    bool controlRunning;
+    bool stageBeforeControl[BOOT_STAGE_COUNT];   // ran while the control task was not yet running
+};
+
+static uint32_t simMicros(void* context) {
+    return ((SimBoard*)context)->nowUs;
+}
+
+template <int STAGE>
+static bool simStage(void* context) {
+    SimBoard& b = *(SimBoard*)context;
+    b.calls[STAGE]++;
+    b.stageBeforeControl[STAGE] = !b.controlRunning;
+    b.nowUs += b.delayUs[STAGE];
+    if (STAGE == BOOT_CONTROL && !b.fails[STAGE]) b.controlRunning = true;
+    return !b.fails[STAGE];
+}
+
+static BootSteps simSteps(SimBoard& b) {
+    BootSteps steps = {&b, simMicros, {simStage<0>, simStage<1>, simStage<2>, simStage<3>,
+                                       simStage<4>, simStage<5>, simStage<6>, simStage<7>}};
+    static_assert(BOOT_STAGE_COUNT == 8, "one simStage per boot stage");
+    return steps;
+}
+
+// Typical times on the ESP32-S3: the EEPROM is read into RAM, the DMA scan and
+// PCNT units start, the SSD1306 is initialized over I2C, touch calibration
+// waits 1.5 s in delay() and the reset window ends at once without a finger
+// on CLR.
+static uint32_t typicalMs[BOOT_STAGE_COUNT] = {1, 12, 6, 1, 80, 1520, 1, 1};
+
+static void boardInit(SimBoard& b, uint32_t startUs = 0) {
+    memset(&b, 0, sizeof(b));
+    b.nowUs = startUs;
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) b.delayUs[i] = typicalMs[i] * 1000;
+}
+
+static bool runBoot(SimBoard& b, BootLog& log) {
+    BootSteps steps = simSteps(b);
+    bootLogInit(log);
+    bootRunCritical(log, steps);
+    return bootRunBackground(log, steps);
+}
+
+//================================================================================
+// CHECKS
+//================================================================================
+static void checkOrder() {
+    SimBoard b;
+    BootLog log;
+    boardInit(b);
+    bool ok = runBoot(b, log);
+    bool inOrder = ok && log.ran == BOOT_STAGE_COUNT;
+    for (int i = 0; i < log.ran; i++) inOrder = inOrder && log.order[i] == i && log.status[i] == BOOT_DONE && b.calls[i] == 1;
+    bool phases = true;
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) phases = phases && b.stageBeforeControl[i] == (i <= BOOT_CONTROL);
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%d stages ran, %d before the control task", log.ran, BOOT_CRITICAL_STAGES);
+    check(inOrder && phases, "stage order", detail);
+
+    uint32_t legacyUs = 0;
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) legacyUs += i == BOOT_INTERFACE ? 0 : b.delayUs[i];
+    snprintf(detail, sizeof(detail), "control at %.1f ms, boot done at %.1f ms (before: control at %.1f ms)",
+             log.endUs[BOOT_CONTROL] * 0.001, log.endUs[BOOT_INTERFACE] * 0.001, legacyUs * 0.001);
+    check(log.endUs[BOOT_CONTROL] < 50000, "control starts early", detail);
+}
+
+static void checkSlowBackground() {
+    SimBoard typical, finger, reset;
+    BootLog typicalLog, fingerLog, resetLog;
+    boardInit(typical);
+    runBoot(typical, typicalLog);
+    boardInit(finger);
+    finger.delayUs[BOOT_TOUCH] = 30000000;
+    bool fingerOk = runBoot(finger, fingerLog);
+    boardInit(reset);
+    reset.delayUs[BOOT_RESET_WINDOW] = 5000000;
+    bool resetOk = runBoot(reset, resetLog);
+    bool same = fingerOk && resetOk && fingerLog.endUs[BOOT_CONTROL] == typicalLog.endUs[BOOT_CONTROL] &&
+                resetLog.endUs[BOOT_CONTROL] == typicalLog.endUs[BOOT_CONTROL];
+    char detail[200];
+    snprintf(detail, sizeof(detail), "control at %.1f ms either way; interface at %.1f s (finger), %.1f s (reset)",
+             fingerLog.endUs[BOOT_CONTROL] * 0.001, fingerLog.startUs[BOOT_INTERFACE] * 1e-6, resetLog.startUs[BOOT_INTERFACE] * 1e-6);
+    check(same && fingerLog.startUs[BOOT_INTERFACE] >= 30000000, "slow background stages", detail);
+}
+
+static void checkFailures() {
+    SimBoard b;
+    BootLog log;
+    boardInit(b);
+    b.fails[BOOT_SENSORS] = true;
+    bool ok = runBoot(b, log);
+    bool carriedOn = ok && log.status[BOOT_SENSORS] == BOOT_FAILED && log.status[BOOT_CONTROL] == BOOT_DONE && b.controlRunning &&
+                     log.status[BOOT_INTERFACE] == BOOT_DONE;
+    check(carriedOn, "critical failure carries on", carriedOn ? "sensors failed, control and interface started" : "boot stopped");
+
+    boardInit(b);
+    b.fails[BOOT_DISPLAY] = true;
+    ok = runBoot(b, log);
+    bool skipped = !ok && log.status[BOOT_DISPLAY] == BOOT_FAILED && b.controlRunning && log.ran == BOOT_DISPLAY + 1;
+    for (int i = BOOT_DISPLAY + 1; i < BOOT_STAGE_COUNT; i++) skipped = skipped && log.status[i] == BOOT_SKIPPED && b.calls[i] == 0;
+    char detail[200];
+    snprintf(detail, sizeof(detail), "display failed; %s, %s and %s %s", bootStageName(BOOT_TOUCH), bootStageName(BOOT_RESET_WINDOW),
+             bootStageName(BOOT_INTERFACE), bootStageStatusName(log.status[BOOT_INTERFACE]));
+    check(skipped, "background failure skips the rest", detail);
+}
+
+static void checkTimings() {
+    bool exact = true;
+    const uint32_t starts[] = {0, 0xFFFFF000u};   // the second wraps micros() during the parameters stage
+    for (uint32_t start : starts) {
+        SimBoard b;
+        BootLog log;
+        boardInit(b, start);
+        runBoot(b, log);
+        for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+            exact = exact && bootStageMicros(log, i) == b.delayUs[i];
+            if (i > 0) exact = exact && log.startUs[i] == log.endUs[i - 1];
+        }
+    }
+    BootLog empty;
+    bootLogInit(empty);
+    bool pending = bootStageMicros(empty, BOOT_CONTROL) == 0 && bootStageMicros(empty, -1) == 0 &&
+                   bootStageMicros(empty, BOOT_STAGE_COUNT) == 0;
+    bool named = strcmp(bootStageName(BOOT_STAGE_COUNT), "unknown") == 0;
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) named = named && strcmp(bootStageName(i), "unknown") != 0;
+    check(exact && pending && named, "stage timings", exact ? "every stage's duration matches, across a wrap" : "a duration is off");
+}
+
+static bool setDelay(const std::string& value) {
+    size_t eq = value.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = value.substr(0, eq);
+    for (char& c : key) if (c == '_') c = ' ';
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+        if (key == bootStageName(i)) {
+            typicalMs[i] = (uint32_t)atoi(value.c_str() + eq + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--delay") ok = setDelay(value);
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "usage: boot [--delay stage=ms]...\n");
+            return 1;
+        }
+    }
+
+    checkOrder();
+    checkSlowBackground();
+    checkFailures();
+    checkTimings();
+    return checkExitCode();
+}
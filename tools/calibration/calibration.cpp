@@ -0,0 +1,577 @@
+//================================================================================
+// SENSOR CALIBRATION TABLE CHECK
+//================================================================================
+// Exercises the multi-point calibration tables (src/sensors.h):
+//   - on a MAP sensor bowed away from its two-point line and an NTC intake
+//     temperature sender in a pull-up divider, a ten-point table read
+//     linearly, and more so by monotone cubic, is far closer to the sensor
+//     than the line through its ends
+//   - the cubic never overshoots: on tables with abrupt changes of slope it
+//     stays monotone and within each segment's end values
+//   - an evenly spaced table is detected as such, and its index lookup reads
+//     the same as the binary search; an uneven one searches
+//   - the curve passes through every point and carries on past the ends
+//     without a step
+//   - the inverse returns the voltage that reads a value, with the slope there
+//   - through controlStep(), the overboost guard's line trips at the voltage
+//     the table reads the ceiling, where the chord would not
+//   - a table that is the two-point line gives the same pull as the line
+//   - through the pipeline on the simulated plant with the bowed sensor, a pull
+//     settles on the target with the table and off it with the line
+//   - the recording wizard records, replaces a point taken at the same
+//     voltage, refuses a reading that moves and a point past the last, sorts
+//     on finishing and refuses points that are not monotone
+//   - the "volts:value,..." form round-trips and bad lists are refused
+// It then times one reading through the line and through a ten-point table
+// by index and by search, linear and cubic, in ns and (on x86) TSC ticks.
+// --ticks N sets how many readings each is timed over.
+//
+//   calibration [--params FILE] [--set key=value]... [--ticks N]
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+static uint64_t cycleCount() { return 0; }   // no counter; the column reads 0
+#endif
+
+//================================================================================
+// SENSOR MODELS
+//================================================================================
+// A MAP sensor whose output bows above its datasheet line by BOW of the span at
+// mid-range; the line through its ends is the two-point calibration. As in the
+// plant simulation, the sensor sees the true pressure less the correction, so
+// a table of these points plus the correction reads the true pressure.
+static const double MAP_BOW = 0.08;
+
+static double bowedMapVolts(const ToolParams& tp, double kPa, double bow = MAP_BOW) {
+    double x = (kPa - tp.MIN_KPA) / (tp.MAX_KPA - tp.MIN_KPA);
+    return tp.RAW_MIN_SENSOR_VOLTAGE + (tp.RAW_MAX_SENSOR_VOLTAGE - tp.RAW_MIN_SENSOR_VOLTAGE) * (x + bow * x * (1.0 - x));
+}
+
+static double bowedMapkPa(const ToolParams& tp, double volts) {
+    double lo = tp.MIN_KPA - 100.0, hi = tp.MAX_KPA + 100.0;
+    for (int k = 0; k < 80; k++) {
+        double mid = 0.5 * (lo + hi);
+        if (bowedMapVolts(tp, mid) < volts) lo = mid;
+        else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+// A 2.2 kOhm (25 C, beta 3950) NTC sender under a 2.49 kOhm pull-up to 5 V.
+static double ntcVolts(double celsius) {
+    double r = 2200.0 * exp(3950.0 * (1.0 / (celsius + 273.15) - 1.0 / 298.15));
+    return 5.0 * r / (r + 2490.0);
+}
+
+static const double IAT_MIN_C = -20.0, IAT_MAX_C = 120.0;
+
+// Ten MAP points a gauge would give at evenly spaced pressures (uneven in
+// volts), or at evenly spaced volts.
+static void gaugeMapTable(const ToolParams& tp, CalibrationTable& table, int interpolation) {
+    calibrationTableReset(table);
+    table.enabled = 1;
+    table.interpolation = interpolation;
+    table.count = CAL_TABLE_POINTS;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        double kPa = tp.MIN_KPA + (tp.MAX_KPA - tp.MIN_KPA) * i / (CAL_TABLE_POINTS - 1);
+        table.volts[i] = (float)bowedMapVolts(tp, kPa);
+        table.value[i] = (float)kPa;
+    }
+}
+
+static void uniformMapTable(const ToolParams& tp, CalibrationTable& table, int interpolation) {
+    calibrationTableReset(table);
+    table.enabled = 1;
+    table.interpolation = interpolation;
+    table.count = CAL_TABLE_POINTS;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        double volts = tp.RAW_MIN_SENSOR_VOLTAGE + (tp.RAW_MAX_SENSOR_VOLTAGE - tp.RAW_MIN_SENSOR_VOLTAGE) * i / (CAL_TABLE_POINTS - 1);
+        table.volts[i] = (float)volts;
+        table.value[i] = (float)bowedMapkPa(tp, volts);
+    }
+}
+
+// Evenly spaced in temperature, so falling in value as the volts rise.
+static void ntcTable(CalibrationTable& table, int interpolation) {
+    calibrationTableReset(table);
+    table.enabled = 1;
+    table.interpolation = interpolation;
+    table.count = CAL_TABLE_POINTS;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        double celsius = IAT_MAX_C - (IAT_MAX_C - IAT_MIN_C) * i / (CAL_TABLE_POINTS - 1);
+        table.volts[i] = (float)ntcVolts(celsius);
+        table.value[i] = (float)celsius;
+    }
+}
+
+static void buildCurve(CalibrationCurve& curve, const CalibrationTable& table, float scale) {
+    calibrationCurveInit(curve);
+    calibrationCurveUpdate(curve, table, scale);
+}
+
+//================================================================================
+// ACCURACY
+//================================================================================
+static void checkMapAccuracy(const ToolParams& tp) {
+    ControlParams params;
+    toControlParams(tp, params);
+    double worst[3] = {0, 0, 0};   // line, linear table, cubic table
+    for (int mode = 0; mode < 3; mode++) {
+        if (mode == 0) calibrationTableReset(params.calibration[SENSOR_MAP]);
+        else gaugeMapTable(tp, params.calibration[SENSOR_MAP], mode == 1 ? CAL_INTERP_LINEAR : CAL_INTERP_CUBIC);
+        for (int i = 0; i <= 2000; i++) {
+            double kPa = tp.MIN_KPA + (tp.MAX_KPA - tp.MIN_KPA) * i / 2000;
+            float sensorVoltage = (float)(bowedMapVolts(tp, kPa) * sensorDividerRatio(SENSOR_MAP));
+            double read = voltageToPressure(params, sensorVoltage) - params.PRESSURE_CORRECTION_KPA;
+            worst[mode] = fmax(worst[mode], fabs(read - kPa));
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error line=%.2f linear=%.3f cubic=%.4f kPa", worst[0], worst[1], worst[2]);
+    check(worst[1] < worst[0] / 10 && worst[2] < worst[1] / 4 && worst[2] < 0.05, "MAP table accuracy", detail);
+}
+
+static void checkNtcAccuracy() {
+    const float scale = sensorDividerRatio(SENSOR_IAT);
+    CalibrationTable table;
+    CalibrationCurve linear, cubic;
+    ntcTable(table, CAL_INTERP_LINEAR);
+    buildCurve(linear, table, scale);
+    ntcTable(table, CAL_INTERP_CUBIC);
+    buildCurve(cubic, table, scale);
+    SensorCalibration line = {table.volts[0], table.volts[CAL_TABLE_POINTS - 1], table.value[0], table.value[CAL_TABLE_POINTS - 1]};
+
+    double worstLine = 0, worstLinear = 0, worstCubic = 0;
+    for (int i = 0; i <= 2000; i++) {
+        double celsius = IAT_MIN_C + (IAT_MAX_C - IAT_MIN_C) * i / 2000;
+        float pin = (float)(ntcVolts(celsius) * scale);
+        worstLine = fmax(worstLine, fabs(sensorValue(line, scale, pin) - celsius));
+        worstLinear = fmax(worstLinear, fabs(calibrationCurveValue(linear, pin) - celsius));
+        worstCubic = fmax(worstCubic, fabs(calibrationCurveValue(cubic, pin) - celsius));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error line=%.1f linear=%.2f cubic=%.2f C", worstLine, worstLinear, worstCubic);
+    check(worstLinear < worstLine / 5 && worstCubic < worstLinear / 2 && worstCubic < 1.0, "NTC table accuracy", detail);
+}
+
+//================================================================================
+// SHAPE
+//================================================================================
+static void checkMonotone() {
+    // Long flats next to steep steps: an unconstrained spline rings here.
+    static const float steps[CAL_TABLE_POINTS] = {0.0f, 0.1f, 0.2f, 10.0f, 10.1f, 10.2f, 30.0f, 30.05f, 30.1f, 100.0f};
+    int violations = 0, outside = 0;
+    for (int direction = 0; direction < 2; direction++) {
+        CalibrationTable table;
+        calibrationTableReset(table);
+        table.enabled = 1;
+        table.interpolation = CAL_INTERP_CUBIC;
+        table.count = CAL_TABLE_POINTS;
+        for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+            table.volts[i] = 0.5f + 0.4f * i + (i % 3) * 0.07f;
+            table.value[i] = direction ? -steps[i] : steps[i];
+        }
+        CalibrationCurve curve;
+        buildCurve(curve, table, 1.0f);
+        const float sign = direction ? -1.0f : 1.0f;
+        float previous = sign * calibrationCurveValue(curve, table.volts[0]);
+        for (int s = 0; s < CAL_TABLE_POINTS - 1; s++) {
+            float lo = sign * table.value[s], hi = sign * table.value[s + 1];
+            for (int k = 1; k <= 500; k++) {
+                float v = table.volts[s] + (table.volts[s + 1] - table.volts[s]) * k / 500;
+                float read = sign * calibrationCurveValue(curve, v);
+                if (read < previous) violations++;
+                if (read < lo - 1e-4f || read > hi + 1e-4f) outside++;
+                previous = read;
+            }
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "rising and falling: %d reversals, %d readings outside their segment", violations, outside);
+    check(violations == 0 && outside == 0, "cubic is monotone", detail);
+}
+
+static void checkUniformLookup(const ToolParams& tp) {
+    const float scale = sensorDividerRatio(SENSOR_MAP);
+    CalibrationTable uniform, gauge;
+    CalibrationCurve byIndex, gaugeCurve;
+    uniformMapTable(tp, uniform, CAL_INTERP_CUBIC);
+    gaugeMapTable(tp, gauge, CAL_INTERP_CUBIC);
+    buildCurve(byIndex, uniform, scale);
+    buildCurve(gaugeCurve, gauge, scale);
+    CalibrationCurve bySearch = byIndex;
+    bySearch.uniform = false;
+
+    double worst = 0;
+    for (int i = 0; i <= 20000; i++) {
+        float pin = (float)((tp.RAW_MIN_SENSOR_VOLTAGE - 0.1 + (tp.RAW_MAX_SENSOR_VOLTAGE - tp.RAW_MIN_SENSOR_VOLTAGE + 0.2) * i / 20000) * scale);
+        worst = fmax(worst, fabs(calibrationCurveValue(byIndex, pin) - calibrationCurveValue(bySearch, pin)));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "even table uniform=%d, gauge table uniform=%d, index vs search max_diff=%.2e kPa",
+             byIndex.uniform, gaugeCurve.uniform, worst);
+    check(byIndex.uniform && !gaugeCurve.uniform && worst < 1e-3, "uniform index lookup", detail);
+}
+
+static void checkKnotsAndEnds(const ToolParams& tp) {
+    const float scale = sensorDividerRatio(SENSOR_MAP);
+    double worstKnot = 0, worstStep = 0;
+    for (int interpolation = 0; interpolation < CAL_INTERP_COUNT; interpolation++) {
+        CalibrationTable table;
+        CalibrationCurve curve;
+        gaugeMapTable(tp, table, interpolation);
+        buildCurve(curve, table, scale);
+        for (int i = 0; i < table.count; i++) {
+            worstKnot = fmax(worstKnot, fabs(calibrationCurveValue(curve, table.volts[i] * scale) - table.value[i]));
+        }
+        // Either side of each end, a step much larger than the slope accounts for is a jump.
+        const float ends[2] = {curve.knots[0], curve.knots[table.count - 1]};
+        const float slopes[2] = {curve.firstSlope, curve.lastSlope};
+        for (int e = 0; e < 2; e++) {
+            float below = calibrationCurveValue(curve, ends[e] - 1e-3f), above = calibrationCurveValue(curve, ends[e] + 1e-3f);
+            worstStep = fmax(worstStep, fabs((above - below) - 2e-3f * slopes[e]));
+        }
+        float far = calibrationCurveValue(curve, curve.knots[table.count - 1] + 0.5f);
+        worstStep = fmax(worstStep, fabs(far - (table.value[table.count - 1] + 0.5f * curve.lastSlope)));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max knot error=%.2e kPa, max step at the ends=%.2e kPa", worstKnot, worstStep);
+    check(worstKnot < 1e-3 && worstStep < 0.05, "knots and extension", detail);
+}
+
+static void checkInverse(const ToolParams& tp) {
+    double worstValue = 0, worstSlope = 0;
+    for (int sensor = 0; sensor < 2; sensor++) {
+        CalibrationTable table;
+        CalibrationCurve curve;
+        float scale = sensorDividerRatio(sensor ? SENSOR_IAT : SENSOR_MAP);
+        if (sensor) ntcTable(table, CAL_INTERP_CUBIC);
+        else gaugeMapTable(tp, table, CAL_INTERP_CUBIC);
+        buildCurve(curve, table, scale);
+        float first = table.value[0], last = table.value[table.count - 1];
+        float span = last - first;
+        for (int i = 0; i <= 1000; i++) {
+            float value = first - 0.1f * span + 1.2f * span * i / 1000;
+            float slope;
+            float pin = calibrationCurveVoltage(curve, value, slope);
+            float read = calibrationCurveValue(curve, pin);
+            worstValue = fmax(worstValue, fabs(read - value) / fabs(span));
+            float h = 1e-3f;
+            float numeric = (calibrationCurveValue(curve, pin + h) - calibrationCurveValue(curve, pin - h)) / (2 * h);
+            worstSlope = fmax(worstSlope, fabs(slope - numeric) / fabs(numeric));
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "MAP and NTC: max value error=%.2e of span, max slope error=%.2e", worstValue, worstSlope);
+    check(worstValue < 1e-4 && worstSlope < 0.02, "inverse and slope", detail);
+}
+
+//================================================================================
+// PIPELINE
+//================================================================================
+static void checkOverboostTangent(const ToolParams& tp) {
+    static ControlState state;
+    ControlParams params;
+    toControlParams(tp, params);
+    if (params.overboostMarginkPa <= 0.0f) params.overboostMarginkPa = OVERBOOST_MARGIN_DEFAULT_KPA;
+    gaugeMapTable(tp, params.calibration[SENSOR_MAP], CAL_INTERP_CUBIC);
+
+    float atmosphere = (float)(bowedMapVolts(tp, 100.0 - params.PRESSURE_CORRECTION_KPA) * sensorDividerRatio(SENSOR_MAP)) +
+                       params.scaledVoltageOffset;
+    controlInit(state, params, atmosphere, 0);
+    ControlInput input = {};
+    ControlOutput out;
+    input.timeMs = CONTROL_TASK_DELAY_MS;
+    input.targetkPa = tp.targetkPa;
+    input.measuredVoltage = atmosphere;
+    controlStep(state, params, input, out);
+    const OverboostLimit& limit = out.overboostLimit;
+
+    // Where the sensor really reaches the ceiling, and what the guard and the chord read there.
+    double ceilingVolts = bowedMapVolts(tp, limit.ceilingkPa - params.PRESSURE_CORRECTION_KPA);
+    float pin = (float)(ceilingVolts * sensorDividerRatio(SENSOR_MAP)) + params.scaledVoltageOffset;
+    float guard = overboostPressure(limit, pin);
+    float chord = linearMapApply(state.pressureMap, pin - params.scaledVoltageOffset);
+    char detail[160];
+    snprintf(detail, sizeof(detail), "ceiling=%.1f kPa, guard reads %.2f there (chord %.2f)", (double)limit.ceilingkPa,
+             (double)guard, (double)chord);
+    check(limit.ceilingkPa > 0.0f && fabsf(guard - limit.ceilingkPa) < 0.1f && fabsf(chord - limit.ceilingkPa) > 1.0f,
+          "overboost guard tangent", detail);
+}
+
+static void checkLineTable(const ToolParams& tp) {
+    PlantModel model = defaultPlantModel();
+    PullProfile pull = defaultPullProfile();
+    PullMetrics line, twoPoint, tenPoint;
+    simulatePull(tp, model, pull, line);
+
+    ToolParams withTable = tp;
+    CalibrationTable& table = withTable.calibrationTables[SENSOR_MAP];
+    calibrationTableReset(table);
+    table.enabled = 1;
+    table.count = 2;
+    table.volts[0] = tp.RAW_MIN_SENSOR_VOLTAGE;
+    table.volts[1] = tp.RAW_MAX_SENSOR_VOLTAGE;
+    table.value[0] = tp.MIN_KPA;
+    table.value[1] = tp.MAX_KPA;
+    simulatePull(withTable, model, pull, twoPoint);
+    // Ten collinear points read by cubic: the monotone cubic reproduces a line.
+    table.interpolation = CAL_INTERP_CUBIC;
+    table.count = CAL_TABLE_POINTS;
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) {
+        float x = (float)i / (CAL_TABLE_POINTS - 1);
+        table.volts[i] = tp.RAW_MIN_SENSOR_VOLTAGE + (tp.RAW_MAX_SENSOR_VOLTAGE - tp.RAW_MIN_SENSOR_VOLTAGE) * x;
+        table.value[i] = tp.MIN_KPA + (tp.MAX_KPA - tp.MIN_KPA) * x;
+    }
+    simulatePull(withTable, model, pull, tenPoint);
+
+    float peakDiff = fmaxf(fabsf(twoPoint.peakkPa - line.peakkPa), fabsf(tenPoint.peakkPa - line.peakkPa));
+    float settleDiff = fmaxf(fabsf(twoPoint.settlingMs - line.settlingMs), fabsf(tenPoint.settlingMs - line.settlingMs));
+    char detail[160];
+    snprintf(detail, sizeof(detail), "peak line=%.2f 2-point=%.2f 10-point=%.2f kPa, settling diff=%.0f ms",
+             (double)line.peakkPa, (double)twoPoint.peakkPa, (double)tenPoint.peakkPa, (double)settleDiff);
+    check(peakDiff < 0.05f && settleDiff <= 2 * CONTROL_TASK_DELAY_MS, "table equal to the line", detail);
+}
+
+// Mean true-pressure error over the last second of a pull read through a
+// sensor with the given bow; the table, when given, is the gauge's.
+static float bowedPullError(const ToolParams& tp, double bow, bool withTable) {
+    static ControlState state;
+    ControlParams params;
+    toControlParams(tp, params);
+    if (withTable) {
+        gaugeMapTable(tp, params.calibration[SENSOR_MAP], CAL_INTERP_CUBIC);
+    }
+    PlantModel model = defaultPlantModel();
+    PullProfile pull = defaultPullProfile();
+    PlantState plant;
+    plantInit(plant, model);
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    float truePressure = plant.pressurekPa;
+    auto volts = [&](float kPa) {
+        return (float)(bowedMapVolts(tp, kPa - params.PRESSURE_CORRECTION_KPA, bow) * sensorDividerRatio(SENSOR_MAP)) +
+               params.scaledVoltageOffset;
+    };
+    controlInit(state, params, volts(truePressure), 0);
+
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    float duty = 0.0f;
+    double errorSum = 0;
+    int errorCount = 0;
+    const uint32_t liftMs = pull.throttleOpenMs + pull.pullMs;
+    for (uint32_t t = (uint32_t)dtMs; t < liftMs; t += (uint32_t)dtMs) {
+        bool throttleOpen = t >= pull.throttleOpenMs;
+        truePressure = plantStep(plant, model, duty, throttleOpen, (float)t - pull.throttleOpenMs, dtMs);
+        input.timeMs = t;
+        input.measuredVoltage = volts(truePressure);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+        if (t + 1000 >= liftMs) {
+            errorSum += truePressure - tp.targetkPa;
+            errorCount++;
+        }
+    }
+    return (float)(errorSum / errorCount);
+}
+
+static void checkBowedPull(const ToolParams& tp) {
+    // The loop's own settled error on a straight sensor is the reference.
+    float straight = bowedPullError(tp, 0.0, false);
+    float lineError = bowedPullError(tp, MAP_BOW, false) - straight;
+    float tableError = bowedPullError(tp, MAP_BOW, true) - straight;
+    char detail[160];
+    snprintf(detail, sizeof(detail), "settled error beyond a straight sensor's: line=%+.2f kPa, table=%+.2f kPa",
+             (double)lineError, (double)tableError);
+    check(fabsf(tableError) < 0.2f && fabsf(lineError) > 10 * fabsf(tableError), "bowed sensor pull", detail);
+}
+
+//================================================================================
+// WIZARD AND TEXT FORM
+//================================================================================
+// Holds the sensor at volts, with uniform noise of the given peak, through one
+// point's average; returns the wizard's result.
+static CalWizardResult recordPoint(CalibrationWizard& wizard, float volts, float reference, float noise, uint32_t& timeMs,
+                                   uint32_t& rng) {
+    if (!calibrationWizardPoint(wizard, reference, timeMs)) return CALWIZ_NONE;
+    for (uint32_t elapsed = 0; wizard.phase == CALWIZ_AVERAGING && elapsed <= 2 * CAL_WIZARD_AVERAGE_MS;
+         elapsed += CONTROL_TASK_DELAY_MS) {
+        rng = rng * 1664525u + 1013904223u;
+        float u = (float)(rng >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+        calibrationWizardStep(wizard, volts + noise * u, timeMs);
+        timeMs += CONTROL_TASK_DELAY_MS;
+    }
+    return wizard.result;
+}
+
+static void checkWizard() {
+    CalibrationWizard wizard = {};
+    CalibrationTable table;
+    calibrationTableReset(table);
+    table.interpolation = CAL_INTERP_CUBIC;
+    uint32_t timeMs = 5000, rng = 7;
+
+    calibrationWizardStart(wizard, SENSOR_IAT);
+    // Out of order, as a bench would be set: a falling table in the end.
+    CalWizardResult first = recordPoint(wizard, 3.0f, 20.0f, 0.005f, timeMs, rng);
+    CalWizardResult second = recordPoint(wizard, 1.0f, 80.0f, 0.005f, timeMs, rng);
+    CalWizardResult again = recordPoint(wizard, 1.02f, 78.0f, 0.005f, timeMs, rng);
+    CalWizardResult noisy = recordPoint(wizard, 2.0f, 50.0f, 0.2f, timeMs, rng);
+    CalWizardResult third = recordPoint(wizard, 2.0f, 50.0f, 0.005f, timeMs, rng);
+    bool midPoint = calibrationWizardPoint(wizard, 60.0f, timeMs);
+    bool busyFinish = calibrationWizardFinish(wizard, table);
+    calibrationWizardStep(wizard, 1.5f, timeMs + CAL_WIZARD_AVERAGE_MS);
+    bool finished = calibrationWizardFinish(wizard, table);
+    bool sorted = finished && table.count == 4 && table.enabled == 1 && table.interpolation == CAL_INTERP_CUBIC &&
+                  table.volts[0] < 1.05f && fabsf(table.value[0] - 78.0f) < 1e-4f && fabsf(table.value[3] - 20.0f) < 1e-4f;
+
+    // A full table refuses the next point; one that is not monotone cannot finish.
+    calibrationWizardStart(wizard, SENSOR_MAP);
+    for (int i = 0; i < CAL_TABLE_POINTS; i++) recordPoint(wizard, 0.5f + 0.4f * i, 20.0f + 30.0f * i, 0.0f, timeMs, rng);
+    CalWizardResult full = recordPoint(wizard, 4.8f, 320.0f, 0.0f, timeMs, rng);
+    calibrationWizardStart(wizard, SENSOR_MAP);
+    recordPoint(wizard, 1.0f, 50.0f, 0.0f, timeMs, rng);
+    recordPoint(wizard, 2.0f, 40.0f, 0.0f, timeMs, rng);
+    recordPoint(wizard, 3.0f, 90.0f, 0.0f, timeMs, rng);
+    CalibrationTable untouched = table;
+    bool crooked = calibrationWizardFinish(wizard, table);
+
+    bool pass = first == CALWIZ_RECORDED && second == CALWIZ_RECORDED && again == CALWIZ_REPLACED && noisy == CALWIZ_UNSTABLE &&
+                third == CALWIZ_RECORDED && midPoint && !busyFinish && sorted && full == CALWIZ_FULL && !crooked &&
+                memcmp(&untouched, &table, sizeof(table)) == 0;
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%s, %s, %s, %s, %s; finish mid-point=%d sorted=%d full=%s crooked=%d",
+             calWizardResultName(first), calWizardResultName(second), calWizardResultName(again),
+             calWizardResultName(noisy), calWizardResultName(third), busyFinish, sorted, calWizardResultName(full), crooked);
+    check(pass, "recording wizard", detail);
+}
+
+static void checkTextForm() {
+    CalibrationTable table, parsed;
+    ntcTable(table, CAL_INTERP_LINEAR);
+    char text[CAL_TABLE_POINTS * 32];
+    calibrationTableFormat(table, text, sizeof(text));
+    calibrationTableReset(parsed);
+    bool roundTrip = calibrationTableParse(parsed, text) && parsed.count == table.count;
+    for (int i = 0; roundTrip && i < table.count; i++) {
+        roundTrip = fabsf(parsed.volts[i] - table.volts[i]) < 1e-5f && fabsf(parsed.value[i] - table.value[i]) < 1e-3f;
+    }
+    static const char* const bad[] = {"1:10,2:5,3:20", "1:10,1:20", "1:10,2", "1:10;2:20", "x:1,2:3", "5",
+                                      "0:1,1:2,2:3,3:4,4:5,5:6,6:7,7:8,8:9,9:10,10:11"};
+    int refused = 0;
+    for (const char* text : bad) {
+        CalibrationTable before = parsed;
+        if (!calibrationTableParse(parsed, text) && memcmp(&before, &parsed, sizeof(parsed)) == 0) refused++;
+    }
+    bool cleared = calibrationTableParse(parsed, "") && parsed.count == 0;
+    CalibrationTable blank;
+    memset(&blank, 0xFF, sizeof(blank));
+    bool sanitized = !calibrationTableSanitize(blank) && blank.count == 0 && blank.enabled == 0;
+    char detail[160];
+    snprintf(detail, sizeof(detail), "round trip=%d, refused %d/%d bad lists, empty clears=%d, blank EEPROM reset=%d",
+             roundTrip, refused, (int)(sizeof(bad) / sizeof(bad[0])), cleared, sanitized);
+    check(roundTrip && refused == (int)(sizeof(bad) / sizeof(bad[0])) && cleared && sanitized, "text form", detail);
+}
+
+//================================================================================
+// BENCHMARK
+//================================================================================
+static const int INPUT_COUNT = 1024;
+static float inputs[INPUT_COUNT];
+static volatile float benchSink;
+
+struct Timing {
+    double ns, cycles;
+};
+
+template <typename Read>
+static Timing timeReadings(int ticks, Read read) {
+    float sum = 0;
+    uint64_t startCycles = cycleCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) sum += read(inputs[i & (INPUT_COUNT - 1)]);
+    auto end = std::chrono::steady_clock::now();
+    uint64_t cycles = cycleCount() - startCycles;
+    benchSink = sum;
+    return {std::chrono::duration<double, std::nano>(end - start).count() / ticks, (double)cycles / ticks};
+}
+
+static void benchmark(const ToolParams& tp, int ticks) {
+    ControlParams params;
+    toControlParams(tp, params);
+    const float scale = sensorDividerRatio(SENSOR_MAP);
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        inputs[i] = params.minSensorVoltage + (params.maxSensorVoltage - params.minSensorVoltage) * ((i * 37) % INPUT_COUNT) / INPUT_COUNT;
+    }
+    static CalibrationCurve curves[4];   // uniform linear, uniform cubic, searched linear, searched cubic
+    for (int k = 0; k < 4; k++) {
+        CalibrationTable table;
+        int interpolation = (k & 1) ? CAL_INTERP_CUBIC : CAL_INTERP_LINEAR;
+        if (k < 2) uniformMapTable(tp, table, interpolation);
+        else gaugeMapTable(tp, table, interpolation);
+        buildCurve(curves[k], table, scale);
+    }
+    LinearMap map = pressureMapFor(params);
+    Timing line = timeReadings(ticks, [&](float v) { return linearMapApply(map, v); });
+    Timing t[4];
+    for (int k = 0; k < 4; k++) {
+        const CalibrationCurve& curve = curves[k];
+        t[k] = timeReadings(ticks, [&](float v) { return calibrationCurveValue(curve, v); });
+    }
+    static const char* const names[4] = {"table by index linear", "table by index cubic", "table by search linear",
+                                         "table by search cubic"};
+    printf("\nreading,ns_per_reading,tsc_per_reading\n");
+    printf("two-point line,%.2f,%.1f\n", line.ns, line.cycles);
+    for (int k = 0; k < 4; k++) printf("%s,%.2f,%.1f\n", names[k], t[k].ns, t[k].cycles);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    int ticks = 4000000;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--ticks") ok = (ticks = atoi(value.c_str())) > 0;
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: calibration [--params FILE] [--set key=value]... [--ticks N]\n");
+            return 1;
+        }
+    }
+
+    checkMapAccuracy(tp);
+    checkNtcAccuracy();
+    checkMonotone();
+    checkUniformLookup(tp);
+    checkKnotsAndEnds(tp);
+    checkInverse(tp);
+    checkOverboostTangent(tp);
+    checkLineTable(tp);
+    checkBowedPull(tp);
+    checkWizard();
+    checkTextForm();
+    benchmark(tp, ticks);
+    return checkExitCode();
+}
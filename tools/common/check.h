@@ -0,0 +1,32 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+//================================================================================
+// PASS/FAIL CHECKS
+//================================================================================
+// The check tools print one line per check and exit 2 when any failed:
+//
+//   check(pass, "name", detail);
+//   ...
+//   return checkExitCode();
+//
+// Header-only, so a tool that needs nothing else from tools/common only adds
+// -Itools/common to its build line.
+
+inline int& checkFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(bool pass, const char* name, const char* detail) {
+    printf("%-34s %s  %s\n", name, pass ? "PASS" : "FAIL", detail);
+    if (!pass) checkFailureCount()++;
+}
+
+inline int checkExitCode() {
+    return checkFailureCount() ? 2 : 0;
+}
+
+#endif // CHECK_H
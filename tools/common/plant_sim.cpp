@@ -0,0 +1,136 @@
+#include "plant_sim.h"
+
+#include <math.h>
+
+PlantModel defaultPlantModel() {
+    PlantModel m;
+    m.springkPa = 45.0f;
+    m.maxBoostkPa = 130.0f;
+    m.spoolTimeMs = 1500.0f;
+    m.tauMs = 120.0f;
+    m.deadTimeMs = 40.0f;
+    m.noisekPa = 0.6f;
+    m.seed = 12345;
+    return m;
+}
+
+PullProfile defaultPullProfile() {
+    PullProfile p;
+    p.throttleOpenMs = 1000;
+    p.pullMs = 4000;
+    p.coastMs = 1500;
+    return p;
+}
+
+static float nextNoise(uint32_t& rng) {
+    // xorshift32: deterministic across platforms so sweeps are reproducible
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng / 4294967296.0f) * 2.0f - 1.0f;
+}
+
+void plantInit(PlantState& plant, const PlantModel& model) {
+    plant.pressurekPa = 100.0f;
+    for (int i = 0; i < 64; i++) plant.dutyHistory[i] = 0;
+    plant.dutyIndex = 0;
+    plant.rng = model.seed ? model.seed : 1;
+}
+
+float plantStep(PlantState& plant, const PlantModel& model, float dutyPercent, bool throttleOpen, float msSinceThrottle, float dtMs) {
+    int delayTicks = (int)(model.deadTimeMs / dtMs);
+    if (delayTicks > 63) delayTicks = 63;
+    plant.dutyHistory[plant.dutyIndex] = dutyPercent;
+    float delayedDuty = plant.dutyHistory[(plant.dutyIndex - delayTicks + 64) % 64];
+    plant.dutyIndex = (plant.dutyIndex + 1) % 64;
+
+    float equilibrium;
+    if (throttleOpen) {
+        float available = msSinceThrottle / model.spoolTimeMs;
+        if (available > 1.0f) available = 1.0f;
+        float wanted = model.springkPa + (delayedDuty / 100.0f) * (model.maxBoostkPa - model.springkPa);
+        equilibrium = 100.0f + wanted * available * available;
+    } else {
+        equilibrium = 100.0f;
+    }
+    plant.pressurekPa += (equilibrium - plant.pressurekPa) * (dtMs / (model.tauMs + dtMs));
+    return plant.pressurekPa;
+}
+
+float plantSensorVoltage(PlantState& plant, const PlantModel& model, const ControlParams& params, float pressurekPa) {
+    float measured = pressurekPa + model.noisekPa * nextNoise(plant.rng) - params.PRESSURE_CORRECTION_KPA;
+    float sensorVoltage = fmap(measured, params.MIN_KPA, params.MAX_KPA, params.minSensorVoltage, params.maxSensorVoltage);
+    return sensorVoltage + params.scaledVoltageOffset;
+}
+
+void simulatePull(const ToolParams& tp, const PlantModel& model, const PullProfile& pull, PullMetrics& metrics,
+                  FeedForwardTable* feedForward) {
+    ControlParams params;
+    toControlParams(tp, params);
+
+    // ControlState carries the 1000-sample event buffer; keep it off small thread stacks.
+    static thread_local ControlState state;
+    PlantState plant;
+    plantInit(plant, model);
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    uint32_t t = 0;
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), t);
+    if (feedForward) state.feedForward = *feedForward;
+
+    metrics.spoolScore = 0;
+    metrics.torqueScore = 0;
+    metrics.overshootkPa = 0;
+    metrics.settlingMs = 0;
+    metrics.peakkPa = truePressure;
+    metrics.timeToTargetMs = (float)pull.pullMs;
+    metrics.peakRiseRate = 0;
+
+    const uint32_t endMs = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+    const uint32_t liftMs = pull.throttleOpenMs + pull.pullMs;
+    int64_t firstAtTargetMs = -1;
+    int64_t lastOutsideBandMs = -1;
+    float duty = 0;
+
+    ControlInput input;
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = nullptr;
+    for (t = (uint32_t)dtMs; t <= endMs; t += (uint32_t)dtMs) {
+        bool throttleOpen = t >= pull.throttleOpenMs && t < liftMs;
+        float previousPressure = truePressure;
+        truePressure = plantStep(plant, model, duty, throttleOpen, (float)(t - pull.throttleOpenMs), dtMs);
+
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, truePressure);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+
+        if (out.spoolScoreReady && out.spoolScore > metrics.spoolScore) metrics.spoolScore = out.spoolScore;
+        if (out.torqueScoreReady && out.torqueScore > metrics.torqueScore) metrics.torqueScore = out.torqueScore;
+
+        if (!throttleOpen) continue;
+        if (truePressure > metrics.peakkPa) metrics.peakkPa = truePressure;
+        float riseRate = (truePressure - previousPressure) * 1000.0f / dtMs;
+        if (firstAtTargetMs < 0 && riseRate > metrics.peakRiseRate) metrics.peakRiseRate = riseRate;
+        if (truePressure - tp.targetkPa > metrics.overshootkPa) metrics.overshootkPa = truePressure - tp.targetkPa;
+        if (firstAtTargetMs < 0 && truePressure >= tp.targetkPa - PULL_SETTLE_BAND_KPA) firstAtTargetMs = t;
+        if (firstAtTargetMs >= 0 && fabsf(truePressure - tp.targetkPa) > PULL_SETTLE_BAND_KPA) lastOutsideBandMs = t;
+    }
+
+    if (feedForward) *feedForward = state.feedForward;
+
+    if (firstAtTargetMs >= 0) metrics.timeToTargetMs = (float)(firstAtTargetMs - pull.throttleOpenMs);
+    if (firstAtTargetMs < 0) {
+        metrics.settlingMs = (float)pull.pullMs; // never reached target
+    } else if (lastOutsideBandMs < 0) {
+        metrics.settlingMs = 0;
+    } else {
+        metrics.settlingMs = (float)(lastOutsideBandMs - firstAtTargetMs);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef PLANT_SIM_H
+#define PLANT_SIM_H
+
+#include <stdint.h>
+#include "control.h"
+#include "tool_params.h"
+
+//================================================================================
+// SYNTHETIC TURBO PLANT
+//================================================================================
+// A deliberately small model of a wastegated turbo under a wide-open-throttle
+// pull. Boost relaxes towards an equilibrium set by the wastegate spring and
+// solenoid duty with a first-order lag and a transport delay. Available boost
+// grows as the engine climbs into the turbo's efficiency range, which gives the
+// familiar spool-up curve.
+
+struct PlantModel {
+    float springkPa;       // boost above atmosphere at 0% duty
+    float maxBoostkPa;     // boost above atmosphere the turbo can make at 100% duty
+    float spoolTimeMs;     // time from throttle open until full boost is available
+    float tauMs;           // manifold pressure time constant
+    float deadTimeMs;      // solenoid to manifold transport delay
+    float noisekPa;        // sensor noise (uniform, peak)
+    uint32_t seed;
+};
+
+struct PullProfile {
+    uint32_t throttleOpenMs;   // closed-throttle cruise before the pull
+    uint32_t pullMs;           // duration at wide-open throttle
+    uint32_t coastMs;          // time after the lift
+};
+
+const float PULL_SETTLE_BAND_KPA = 3.0f;   // around the target, for timeToTargetMs and settlingMs
+
+struct PullMetrics {
+    float spoolScore;
+    float torqueScore;
+    float overshootkPa;        // peak true pressure above target
+    float settlingMs;          // from first reaching target to staying within the band
+    float peakkPa;
+    float timeToTargetMs;      // from throttle open to first reaching the band
+    float peakRiseRate;        // Spool Score's peak dP/dt, on true pressure before reaching the band
+};
+
+PlantModel defaultPlantModel();
+PullProfile defaultPullProfile();
+
+// Plant state advanced one control tick at a time, so other tools can drive it
+// with their own controller.
+struct PlantState {
+    float pressurekPa;
+    float dutyHistory[64];
+    int dutyIndex;
+    uint32_t rng;
+};
+
+void plantInit(PlantState& plant, const PlantModel& model);
+// Returns the true manifold pressure after one tick with the given throttle.
+float plantStep(PlantState& plant, const PlantModel& model, float dutyPercent, bool throttleOpen, float msSinceThrottle, float dtMs);
+// Sensor reading as the firmware would see it on the MAP channel of readSensorSample().
+float plantSensorVoltage(PlantState& plant, const PlantModel& model, const ControlParams& params, float pressurekPa);
+
+// Runs one pull through the full firmware control pipeline. A feed-forward
+// table, when given, is loaded before the pull and receives what it learned.
+void simulatePull(const ToolParams& tp, const PlantModel& model, const PullProfile& pull, PullMetrics& metrics,
+                  FeedForwardTable* feedForward = nullptr);
+
+#endif // PLANT_SIM_H
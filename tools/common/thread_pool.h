@@ -0,0 +1,114 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//================================================================================
+// WORK-STEALING THREAD POOL
+//================================================================================
+// Each worker owns a deque. Batches are dealt round-robin; a worker pops from
+// the back of its own deque and, once empty, steals from the front of the
+// others. Evaluations are independent, so throughput scales with core count
+// until the batch runs dry.
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0) : pending(0), stopping(false), nextQueue(0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) queues.emplace_back(new WorkQueue());
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& w : workers) w.join();
+    }
+
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    void submit(std::function<void()> job) {
+        pending.fetch_add(1);
+        WorkQueue& q = *queues[nextQueue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(i) for i in [0, n) and blocks until all calls finish.
+    void parallelFor(size_t n, const std::function<void(size_t)>& body) {
+        for (size_t i = 0; i < n; i++) submit([&body, i]() { body(i); });
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        done.wait(lock, [this]() { return pending.load() == 0; });
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    bool popOwn(unsigned self, std::function<void()>& job) {
+        WorkQueue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.empty()) return false;
+        job = std::move(q.jobs.back());
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned self, std::function<void()>& job) {
+        for (size_t k = 1; k < queues.size(); k++) {
+            WorkQueue& q = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.jobs.empty()) continue;
+            job = std::move(q.jobs.front());
+            q.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned self) {
+        std::function<void()> job;
+        for (;;) {
+            if (popOwn(self, job) || steal(self, job)) {
+                job();
+                job = nullptr;
+                if (pending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                    done.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (stopping) return;
+            wake.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping;
+    std::atomic<size_t> nextQueue;
+};
+
+#endif // THREAD_POOL_H
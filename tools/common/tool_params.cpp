@@ -0,0 +1,410 @@
+#include "tool_params.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+enum ToolParamType { TP_FLOAT, TP_INT };
+
+struct ToolParamField {
+    const char* key;
+    size_t offset;
+    ToolParamType type;
+};
+
+#define FIELD(name, type) { #name, offsetof(ToolParams, name), type }
+
+static const ToolParamField toolParamFields[] = {
+    FIELD(targetkPa, TP_FLOAT),
+    FIELD(kp, TP_FLOAT),
+    FIELD(ki, TP_FLOAT),
+    FIELD(kd, TP_FLOAT),
+    FIELD(maxIntegral, TP_FLOAT),
+    FIELD(PID_Control_Overhead, TP_FLOAT),
+    FIELD(pidTriggerkPa, TP_FLOAT),
+    FIELD(slow_ema_a, TP_FLOAT),
+    FIELD(fast_ema_a, TP_FLOAT),
+    FIELD(kpa_rate_change_threshold, TP_FLOAT),
+    FIELD(kpa_rate_time_interval_ms, TP_INT),
+    { "filterType", offsetof(ToolParams, filter.type), TP_INT },
+    { "filterCutoffHz", offsetof(ToolParams, filter.cutoffHz), TP_FLOAT },
+    { "filterTrackerAlpha", offsetof(ToolParams, filter.trackerAlpha), TP_FLOAT },
+    { "filterTrackerBeta", offsetof(ToolParams, filter.trackerBeta), TP_FLOAT },
+    { "estimatorEnabled", offsetof(ToolParams, estimator.enabled), TP_INT },
+    { "estimatorNoisekPa", offsetof(ToolParams, estimator.measurementNoisekPa), TP_FLOAT },
+    { "estimatorAccelNoise", offsetof(ToolParams, estimator.accelNoise), TP_FLOAT },
+    FIELD(output_ema_a, TP_FLOAT),
+    FIELD(IDLE_TIMEOUT_SECONDS, TP_FLOAT),
+    FIELD(RAW_MIN_SENSOR_VOLTAGE, TP_FLOAT),
+    FIELD(RAW_MAX_SENSOR_VOLTAGE, TP_FLOAT),
+    FIELD(RAW_VOLTAGE_OFFSET, TP_FLOAT),
+    FIELD(MIN_KPA, TP_FLOAT),
+    FIELD(MAX_KPA, TP_FLOAT),
+    FIELD(PRESSURE_CORRECTION_KPA, TP_FLOAT),
+    FIELD(torqueScoreCutoffMs, TP_INT),
+    FIELD(sysidForgetting, TP_FLOAT),
+    FIELD(sysidDelayTicks, TP_INT),
+    FIELD(adaptiveGains, TP_INT),
+    FIELD(nominalPlantGain, TP_FLOAT),
+    FIELD(pidDerivativeFilterMs, TP_FLOAT),
+    FIELD(pidSetpointWeight, TP_FLOAT),
+    FIELD(pidDerivativeOnMeasurement, TP_INT),
+    FIELD(pidAntiWindupMode, TP_INT),
+    FIELD(pidBumplessTransfer, TP_INT),
+    FIELD(feedForwardEnabled, TP_INT),
+    FIELD(overshootLimiter, TP_INT),
+    FIELD(overshootLeadMs, TP_FLOAT),
+    FIELD(overshootSpankPa, TP_FLOAT),
+    FIELD(overshootFloorPercent, TP_FLOAT),
+    { "gainScheduleEnabled", offsetof(ToolParams, gainSchedule.enabled), TP_INT },
+    { "setpointProfileEnabled", offsetof(ToolParams, setpointProfile.enabled), TP_INT },
+    { "setpointRampkPaPerS", offsetof(ToolParams, setpointProfile.rampkPaPerS), TP_FLOAT },
+    FIELD(rpmInputEnabled, TP_INT),
+    FIELD(rpmPulsesPerRev, TP_FLOAT),
+    FIELD(speedPulsesPerKm, TP_FLOAT),
+    FIELD(gearCount, TP_INT),
+    { "boostMapEnabled", offsetof(ToolParams, boostMap.enabled), TP_INT },
+    { "emapRawMinVoltage", offsetof(ToolParams, backpressureCalibration.rawMinVoltage), TP_FLOAT },
+    { "emapRawMaxVoltage", offsetof(ToolParams, backpressureCalibration.rawMaxVoltage), TP_FLOAT },
+    { "emapMinkPa", offsetof(ToolParams, backpressureCalibration.minValue), TP_FLOAT },
+    { "emapMaxkPa", offsetof(ToolParams, backpressureCalibration.maxValue), TP_FLOAT },
+    { "iatRawMinVoltage", offsetof(ToolParams, intakeTempCalibration.rawMinVoltage), TP_FLOAT },
+    { "iatRawMaxVoltage", offsetof(ToolParams, intakeTempCalibration.rawMaxVoltage), TP_FLOAT },
+    { "iatMinC", offsetof(ToolParams, intakeTempCalibration.minValue), TP_FLOAT },
+    { "iatMaxC", offsetof(ToolParams, intakeTempCalibration.maxValue), TP_FLOAT },
+    { "supplyRawMinVoltage", offsetof(ToolParams, supplyCalibration.rawMinVoltage), TP_FLOAT },
+    { "supplyRawMaxVoltage", offsetof(ToolParams, supplyCalibration.rawMaxVoltage), TP_FLOAT },
+    { "supplyMinV", offsetof(ToolParams, supplyCalibration.minValue), TP_FLOAT },
+    { "supplyMaxV", offsetof(ToolParams, supplyCalibration.maxValue), TP_FLOAT },
+    FIELD(supplyCompensation, TP_INT),
+    FIELD(supplyNominalVoltage, TP_FLOAT),
+    FIELD(iatTrimStartC, TP_FLOAT),
+    FIELD(iatTrimkPaPerC, TP_FLOAT),
+    FIELD(valveFrequencyHz, TP_INT),
+    { "solenoidCurveEnabled", offsetof(ToolParams, solenoidCurve.enabled), TP_INT },
+    { "solenoidDeadTimeMs", offsetof(ToolParams, solenoidCurve.deadTimeMs), TP_FLOAT },
+    FIELD(overboostMarginkPa, TP_FLOAT),
+    FIELD(sensorFaultCheck, TP_INT),
+    FIELD(sensorFailsafePercent, TP_FLOAT),
+    { "calMapEnabled", offsetof(ToolParams, calibrationTables[SENSOR_MAP].enabled), TP_INT },
+    { "calMapInterp", offsetof(ToolParams, calibrationTables[SENSOR_MAP].interpolation), TP_INT },
+    { "calEmapEnabled", offsetof(ToolParams, calibrationTables[SENSOR_BACKPRESSURE].enabled), TP_INT },
+    { "calEmapInterp", offsetof(ToolParams, calibrationTables[SENSOR_BACKPRESSURE].interpolation), TP_INT },
+    { "calIatEnabled", offsetof(ToolParams, calibrationTables[SENSOR_IAT].enabled), TP_INT },
+    { "calIatInterp", offsetof(ToolParams, calibrationTables[SENSOR_IAT].interpolation), TP_INT },
+    { "calSupplyEnabled", offsetof(ToolParams, calibrationTables[SENSOR_SUPPLY].enabled), TP_INT },
+    { "calSupplyInterp", offsetof(ToolParams, calibrationTables[SENSOR_SUPPLY].interpolation), TP_INT },
+};
+
+// Gain schedule cells use the firmware's serial keys, "gs." followed by the
+// gainScheduleEntry() key.
+static const char GS_PREFIX[] = "gs.";
+// Boost map cells are "bm." followed by the boostMapEntry() key; gear ratios
+// are "gear." followed by the 1-based gear.
+static const char BM_PREFIX[] = "bm.";
+static const char GEAR_PREFIX[] = "gear.";
+// Solenoid flow curve points are "sol." followed by the solenoidCurveEntry() key.
+static const char SOL_PREFIX[] = "sol.";
+// The boost curve breakpoints go in one "sp=ms:kPa,..." assignment, as on the console.
+static const char SP_KEY[] = "sp";
+// Calibration table points are "cal." followed by sensorChannelKey(), as on the console.
+static const char CAL_PREFIX[] = "cal.";
+
+#undef FIELD
+
+ToolParams defaultToolParams() {
+    ToolParams tp;
+    tp.targetkPa = 170.0;
+    tp.kp = 10.0; tp.ki = 0.1; tp.kd = 1.0;
+    tp.maxIntegral = 600.0;
+    tp.PID_Control_Overhead = 6.0;
+    tp.pidTriggerkPa = 20.0;
+    tp.slow_ema_a = 0.01;
+    tp.fast_ema_a = 0.3;
+    tp.kpa_rate_change_threshold = 10.0;
+    tp.kpa_rate_time_interval_ms = 50;
+    filterSettingsReset(tp.filter);
+    estimatorSettingsReset(tp.estimator);
+    tp.output_ema_a = 0.2;
+    tp.IDLE_TIMEOUT_SECONDS = 60;
+    tp.RAW_MIN_SENSOR_VOLTAGE = 0.4;
+    tp.RAW_MAX_SENSOR_VOLTAGE = 4.65;
+    tp.RAW_VOLTAGE_OFFSET = -0.09643;
+    tp.MIN_KPA = 20.0;
+    tp.MAX_KPA = 300.0;
+    tp.PRESSURE_CORRECTION_KPA = 1.27;
+    tp.torqueScoreCutoffMs = 500;
+    tp.sysidForgetting = SYSID_DEFAULT_FORGETTING;
+    tp.sysidDelayTicks = SYSID_DEFAULT_DELAY_TICKS;
+    tp.adaptiveGains = 0;
+    tp.nominalPlantGain = 1.0;
+    tp.pidDerivativeFilterMs = 0.0;
+    tp.pidSetpointWeight = 1.0;
+    tp.pidDerivativeOnMeasurement = 0;
+    tp.pidAntiWindupMode = PID_ANTIWINDUP_CLAMP;
+    tp.pidBumplessTransfer = 0;
+    tp.feedForwardEnabled = 0;
+    tp.overshootLimiter = 0;
+    tp.overshootLeadMs = 200.0;
+    tp.overshootSpankPa = 10.0;
+    tp.overshootFloorPercent = 0.0;
+    gainScheduleReset(tp.gainSchedule);
+    setpointProfileReset(tp.setpointProfile);
+    tp.rpmInputEnabled = 0;
+    tp.rpmPulsesPerRev = 2.0;
+    tp.speedPulsesPerKm = 0.0;
+    tp.gearCount = 6;
+    for (float& ratio : tp.gearRpmPerKph) ratio = 0.0;
+    boostMapReset(tp.boostMap);
+    tp.backpressureCalibration = BACKPRESSURE_CALIBRATION_DEFAULT;
+    tp.intakeTempCalibration = IAT_CALIBRATION_DEFAULT;
+    tp.supplyCalibration = SUPPLY_CALIBRATION_DEFAULT;
+    tp.supplyCompensation = 0;
+    tp.supplyNominalVoltage = 13.5;
+    tp.iatTrimStartC = 40.0;
+    tp.iatTrimkPaPerC = 0.0;
+    tp.valveFrequencyHz = 33;
+    solenoidCurveReset(tp.solenoidCurve);
+    tp.overboostMarginkPa = OVERBOOST_MARGIN_DEFAULT_KPA;
+    tp.sensorFaultCheck = 1;
+    tp.sensorFailsafePercent = SENSOR_FAILSAFE_DEFAULT_PERCENT;
+    for (CalibrationTable& table : tp.calibrationTables) calibrationTableReset(table);
+    return tp;
+}
+
+void toControlParams(const ToolParams& tp, ControlParams& params) {
+    params.kp = tp.kp; params.ki = tp.ki; params.kd = tp.kd;
+    params.maxIntegral = tp.maxIntegral;
+    params.PID_Control_Overhead = tp.PID_Control_Overhead;
+    params.pidTriggerkPa = tp.pidTriggerkPa;
+    params.slow_ema_a = tp.slow_ema_a;
+    params.fast_ema_a = tp.fast_ema_a;
+    params.kpa_rate_change_threshold = tp.kpa_rate_change_threshold;
+    params.kpa_rate_time_interval_ms = tp.kpa_rate_time_interval_ms;
+    params.filter = tp.filter;
+    params.estimator = tp.estimator;
+    params.output_ema_a = tp.output_ema_a;
+    params.IDLE_TIMEOUT_SECONDS = tp.IDLE_TIMEOUT_SECONDS;
+    scaleSensorVoltages(tp.RAW_MIN_SENSOR_VOLTAGE, tp.RAW_MAX_SENSOR_VOLTAGE, tp.RAW_VOLTAGE_OFFSET,
+                        params.minSensorVoltage, params.maxSensorVoltage, params.scaledVoltageOffset);
+    params.MIN_KPA = tp.MIN_KPA;
+    params.MAX_KPA = tp.MAX_KPA;
+    params.PRESSURE_CORRECTION_KPA = tp.PRESSURE_CORRECTION_KPA;
+    params.torqueScoreCutoffMs = tp.torqueScoreCutoffMs;
+    params.sysidForgetting = tp.sysidForgetting;
+    params.sysidDelayTicks = tp.sysidDelayTicks;
+    params.adaptiveGains = tp.adaptiveGains != 0;
+    params.nominalPlantGain = tp.nominalPlantGain;
+    params.derivativeFilterMs = tp.pidDerivativeFilterMs;
+    params.setpointWeightP = tp.pidSetpointWeight;
+    params.derivativeOnMeasurement = tp.pidDerivativeOnMeasurement != 0;
+    params.antiWindupMode = tp.pidAntiWindupMode;
+    params.bumplessTransfer = tp.pidBumplessTransfer != 0;
+    params.feedForwardEnabled = tp.feedForwardEnabled != 0;
+    params.gainSchedule = tp.gainSchedule;
+    params.setpointProfile = tp.setpointProfile;
+    params.overshootLimiter = tp.overshootLimiter != 0;
+    params.overshootLeadMs = tp.overshootLeadMs;
+    params.overshootSpankPa = tp.overshootSpankPa;
+    params.overshootFloorPercent = tp.overshootFloorPercent;
+    params.rpm.enabled = tp.rpmInputEnabled != 0;
+    params.rpm.pulsesPerRev = tp.rpmPulsesPerRev;
+    params.rpm.speedPulsesPerKm = tp.speedPulsesPerKm;
+    params.rpm.gearCount = tp.gearCount;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) params.rpm.gearRpmPerKph[g] = tp.gearRpmPerKph[g];
+    params.boostMap = tp.boostMap;
+    params.backpressure = tp.backpressureCalibration;
+    params.intakeTemp = tp.intakeTempCalibration;
+    params.supply = tp.supplyCalibration;
+    params.supplyCompensation = tp.supplyCompensation != 0;
+    params.supplyNominalVoltage = tp.supplyNominalVoltage;
+    params.iatTrimStartC = tp.iatTrimStartC;
+    params.iatTrimkPaPerC = tp.iatTrimkPaPerC;
+    params.valveFrequencyHz = tp.valveFrequencyHz;
+    params.solenoidCurve = tp.solenoidCurve;
+    params.overboostMarginkPa = tp.overboostMarginkPa;
+    params.sensorFaultCheck = tp.sensorFaultCheck != 0;
+    params.sensorFailsafePercent = tp.sensorFailsafePercent;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) params.calibration[c] = tp.calibrationTables[c];
+}
+
+static const ToolParamField* findField(const std::string& key) {
+    for (const ToolParamField& field : toolParamFields) {
+        if (key == field.key) return &field;
+    }
+    return nullptr;
+}
+
+static float* findTableCell(ToolParams& tp, const std::string& key) {
+    if (key.compare(0, sizeof(GS_PREFIX) - 1, GS_PREFIX) == 0) {
+        return gainScheduleEntry(tp.gainSchedule, key.c_str() + sizeof(GS_PREFIX) - 1);
+    }
+    if (key.compare(0, sizeof(BM_PREFIX) - 1, BM_PREFIX) == 0) {
+        return boostMapEntry(tp.boostMap, key.c_str() + sizeof(BM_PREFIX) - 1);
+    }
+    if (key.compare(0, sizeof(SOL_PREFIX) - 1, SOL_PREFIX) == 0) {
+        return solenoidCurveEntry(tp.solenoidCurve, key.c_str() + sizeof(SOL_PREFIX) - 1);
+    }
+    if (key.compare(0, sizeof(GEAR_PREFIX) - 1, GEAR_PREFIX) == 0) {
+        const char* number = key.c_str() + sizeof(GEAR_PREFIX) - 1;
+        char* end = nullptr;
+        long g = strtol(number, &end, 10);
+        if (end == number || *end != '\0' || g < 1 || g > RPM_MAP_GEARS) return nullptr;
+        return &tp.gearRpmPerKph[g - 1];
+    }
+    return nullptr;
+}
+
+bool getToolParamValue(const ToolParams& tp, const std::string& key, double& value) {
+    if (float* cell = findTableCell(const_cast<ToolParams&>(tp), key)) {
+        value = *cell;
+        return true;
+    }
+    const ToolParamField* field = findField(key);
+    if (!field) return false;
+    const char* base = (const char*)&tp + field->offset;
+    value = (field->type == TP_FLOAT) ? *(const float*)base : *(const int*)base;
+    return true;
+}
+
+bool setToolParamValue(ToolParams& tp, const std::string& key, double value) {
+    if (float* cell = findTableCell(tp, key)) {
+        *cell = (float)value;
+        return true;
+    }
+    const ToolParamField* field = findField(key);
+    if (!field) return false;
+    char* base = (char*)&tp + field->offset;
+    if (field->type == TP_FLOAT) *(float*)base = (float)value;
+    else *(int*)base = (int)(value + (value >= 0 ? 0.5 : -0.5));
+    return true;
+}
+
+bool setToolParam(ToolParams& tp, const std::string& assignment) {
+    size_t eq = assignment.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = assignment.substr(0, eq);
+    const char* value = assignment.c_str() + eq + 1;
+    char* end = nullptr;
+
+    if (key == SP_KEY) return setpointProfileParse(tp.setpointProfile, value);
+    if (key.compare(0, sizeof(CAL_PREFIX) - 1, CAL_PREFIX) == 0) {
+        int channel = sensorChannelFromKey(key.c_str() + sizeof(CAL_PREFIX) - 1);
+        return channel >= 0 && calibrationTableParse(tp.calibrationTables[channel], value);
+    }
+    if (float* cell = findTableCell(tp, key)) {
+        float v = strtof(value, &end);
+        if (end == value) return false;
+        *cell = v;
+        return true;
+    }
+    const ToolParamField* field = findField(key);
+    if (!field) return false;
+    char* base = (char*)&tp + field->offset;
+    if (field->type == TP_FLOAT) {
+        float v = strtof(value, &end);
+        if (end == value) return false;
+        *(float*)base = v;
+    } else {
+        long v = strtol(value, &end, 10);
+        if (end == value) return false;
+        *(int*)base = (int)v;
+    }
+    return true;
+}
+
+bool loadToolParamsFile(ToolParams& tp, const std::string& path, std::string& error) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        error = "cannot open " + path;
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        std::string s;
+        for (char* c = line; *c; c++) {
+            if (*c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') s += *c;
+        }
+        if (s.empty()) continue;
+        if (!setToolParam(tp, s)) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), ":%d: ", lineNo);
+            error = path + buf + "bad assignment '" + s + "'";
+            ok = false;
+            break;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+bool writeToolParamsFile(const ToolParams& tp, const std::string& path, const std::string& comment) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    if (!comment.empty()) fprintf(f, "# %s\n", comment.c_str());
+    for (const ToolParamField& field : toolParamFields) {
+        const char* base = (const char*)&tp + field.offset;
+        if (field.type == TP_FLOAT) fprintf(f, "%s=%.9g\n", field.key, *(const float*)base);
+        else fprintf(f, "%s=%d\n", field.key, *(const int*)base);
+    }
+    // Schedule cells only when the table is not flat, to keep ordinary presets short.
+    const GainSchedule& gs = tp.gainSchedule;
+    bool flat = true;
+    for (int r = 0; r < GS_RATE_POINTS; r++) {
+        for (int e = 0; e < GS_ERROR_POINTS; e++) {
+            if (gs.kp[r][e] != 1.0f || gs.ki[r][e] != 1.0f || gs.kd[r][e] != 1.0f) flat = false;
+        }
+    }
+    if (!flat) {
+        for (int r = 0; r < GS_RATE_POINTS; r++) {
+            for (int e = 0; e < GS_ERROR_POINTS; e++) {
+                fprintf(f, "%skp.%d.%d=%.9g\n", GS_PREFIX, r, e, gs.kp[r][e]);
+                fprintf(f, "%ski.%d.%d=%.9g\n", GS_PREFIX, r, e, gs.ki[r][e]);
+                fprintf(f, "%skd.%d.%d=%.9g\n", GS_PREFIX, r, e, gs.kd[r][e]);
+            }
+        }
+    }
+    for (int g = 0; g < RPM_MAP_GEARS; g++) {
+        if (tp.gearRpmPerKph[g] != 0.0f) fprintf(f, "%s%d=%.9g\n", GEAR_PREFIX, g + 1, tp.gearRpmPerKph[g]);
+    }
+    bool mapFlat = true;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) {
+        for (int r = 0; r < RPM_MAP_POINTS; r++) {
+            if (tp.boostMap.offsetkPa[g][r] != 0.0f) mapFlat = false;
+        }
+    }
+    if (!mapFlat) {
+        for (int g = 0; g < RPM_MAP_GEARS; g++) {
+            for (int r = 0; r < RPM_MAP_POINTS; r++) {
+                fprintf(f, "%s%d.%d=%.9g\n", BM_PREFIX, g + 1, r, tp.boostMap.offsetkPa[g][r]);
+            }
+        }
+    }
+    bool straight = true;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) {
+        if (tp.solenoidCurve.flowPercent[i] != i * SOLENOID_CURVE_STEP_PERCENT) straight = false;
+    }
+    if (!straight) {
+        for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) {
+            fprintf(f, "%s%d=%.9g\n", SOL_PREFIX, i, tp.solenoidCurve.flowPercent[i]);
+        }
+    }
+    if (tp.setpointProfile.count > 0) {
+        char curve[SP_PROFILE_POINTS * 32];
+        setpointProfileFormat(tp.setpointProfile, curve, sizeof(curve));
+        fprintf(f, "%s=%s\n", SP_KEY, curve);
+    }
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        if (tp.calibrationTables[c].count == 0) continue;
+        char points[CAL_TABLE_POINTS * 32];
+        calibrationTableFormat(tp.calibrationTables[c], points, sizeof(points));
+        fprintf(f, "%s%s=%s\n", CAL_PREFIX, sensorChannelKey(c), points);
+    }
+    return fclose(f) == 0;
+}
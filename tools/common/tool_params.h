@@ -0,0 +1,87 @@
+#ifndef TOOL_PARAMS_H
+#define TOOL_PARAMS_H
+
+#include <string>
+#include "control.h"
+
+//================================================================================
+// HOST-SIDE PARAMETER SET
+//================================================================================
+// Mirrors the adjustable globals the firmware copies into ControlParams. Keys use
+// the firmware variable names so a preset file reads like the EEPROM layout.
+
+struct ToolParams {
+    float targetkPa;
+    float kp, ki, kd;
+    float maxIntegral;
+    float PID_Control_Overhead;
+    float pidTriggerkPa;
+    float slow_ema_a, fast_ema_a;
+    float kpa_rate_change_threshold;
+    int kpa_rate_time_interval_ms;
+    FilterSettings filter;           // keys filterType, filterCutoffHz, filterTrackerAlpha, filterTrackerBeta
+    EstimatorSettings estimator;     // keys estimatorEnabled, estimatorNoisekPa, estimatorAccelNoise
+    float output_ema_a;
+    float IDLE_TIMEOUT_SECONDS;
+    float RAW_MIN_SENSOR_VOLTAGE, RAW_MAX_SENSOR_VOLTAGE, RAW_VOLTAGE_OFFSET;
+    float MIN_KPA, MAX_KPA;
+    float PRESSURE_CORRECTION_KPA;
+    int torqueScoreCutoffMs;
+    float sysidForgetting;
+    int sysidDelayTicks;
+    int adaptiveGains;
+    float nominalPlantGain;
+    float pidDerivativeFilterMs;
+    float pidSetpointWeight;
+    int pidDerivativeOnMeasurement;
+    int pidAntiWindupMode;
+    int pidBumplessTransfer;
+    int feedForwardEnabled;
+    int overshootLimiter;
+    float overshootLeadMs;
+    float overshootSpankPa;
+    float overshootFloorPercent;
+    GainSchedule gainSchedule;   // keys gainScheduleEnabled and gs.kp.R.E / gs.ki.R.E / gs.kd.R.E
+    SetpointProfile setpointProfile; // keys setpointProfileEnabled, setpointRampkPaPerS and sp=ms:kPa,...
+    int rpmInputEnabled;
+    float rpmPulsesPerRev;
+    float speedPulsesPerKm;
+    int gearCount;
+    float gearRpmPerKph[RPM_MAP_GEARS];  // keys gear.1 .. gear.6
+    BoostTargetMap boostMap;         // keys boostMapEnabled and bm.G.R
+    SensorCalibration backpressureCalibration;  // keys emapRawMinVoltage, emapRawMaxVoltage, emapMinkPa, emapMaxkPa
+    SensorCalibration intakeTempCalibration;    // keys iatRawMinVoltage, iatRawMaxVoltage, iatMinC, iatMaxC
+    SensorCalibration supplyCalibration;        // keys supplyRawMinVoltage, supplyRawMaxVoltage, supplyMinV, supplyMaxV
+    int supplyCompensation;
+    float supplyNominalVoltage;
+    float iatTrimStartC;
+    float iatTrimkPaPerC;
+    int valveFrequencyHz;
+    SolenoidCurve solenoidCurve;     // keys solenoidCurveEnabled, solenoidDeadTimeMs and sol.N
+    float overboostMarginkPa;
+    int sensorFaultCheck;
+    float sensorFailsafePercent;
+    CalibrationTable calibrationTables[SENSOR_CHANNEL_COUNT];  // keys calMapEnabled, calMapInterp, ... and cal.S=volts:value,...
+};
+
+// Values written by initializeDefaultParameters() on a factory reset.
+ToolParams defaultToolParams();
+
+// Same scaling as calculateScaledVoltages() followed by fillControlParams().
+void toControlParams(const ToolParams& tp, ControlParams& params);
+
+// Applies one "key=value" assignment; returns false for an unknown key or bad value.
+bool setToolParam(ToolParams& tp, const std::string& assignment);
+
+// Numeric access by key for sweeps; both return false for an unknown key.
+bool getToolParamValue(const ToolParams& tp, const std::string& key, double& value);
+bool setToolParamValue(ToolParams& tp, const std::string& key, double value);
+
+// Loads "key=value" lines ('#' starts a comment).
+bool loadToolParamsFile(ToolParams& tp, const std::string& path, std::string& error);
+
+// Writes every parameter as "key=value"; the same lines are accepted by the
+// firmware serial console.
+bool writeToolParamsFile(const ToolParams& tp, const std::string& path, const std::string& comment);
+
+#endif // TOOL_PARAMS_H
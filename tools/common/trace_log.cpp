@@ -0,0 +1,232 @@
+#include "trace_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+TraceLog::TraceLog() : startRecorded(false), mapping(nullptr), mappingSize(0), records(nullptr), count(0) {
+    memset(&startState, 0, sizeof(startState));
+}
+
+TraceLog::~TraceLog() {
+    close();
+}
+
+void TraceLog::close() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    loadedRecords.clear();
+    records = nullptr;
+    count = 0;
+    memset(&startState, 0, sizeof(startState));
+    startRecorded = false;
+}
+
+static bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool TraceLog::open(const std::string& path, std::string& error) {
+    close();
+    bool ok = (endsWith(path, ".csv") || endsWith(path, ".txt")) ? openCsv(path, error) : openBinary(path, error);
+    if (ok && !startRecorded && count > 0) {
+        // Nothing recorded: start at the first record with an empty map.
+        memset(&startState, 0, sizeof(startState));
+        startState.timeMs = records[0].timeMs;
+        startState.voltage = records[0].voltage;
+    }
+    return ok;
+}
+
+// "duty:samples,..." with one pair per breakpoint.
+bool TraceLog::parseFeedForward(const char* pairs) {
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        float duty;
+        unsigned samples;
+        int used = 0;
+        if (sscanf(pairs, "%f:%u%n", &duty, &samples, &used) != 2) return false;
+        startState.feedForwardDuty[i] = duty;
+        startState.feedForwardSamples[i] = (uint8_t)(samples > 255 ? 255 : samples);
+        pairs += used;
+        if (i + 1 < FF_TABLE_POINTS && *pairs++ != ',') return false;
+    }
+    return true;
+}
+
+bool TraceLog::openCsv(const std::string& path, std::string& error) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        error = "cannot open " + path;
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        unsigned long startTime;
+        float startVoltage;
+        if (sscanf(line, "# start=%lu,%f", &startTime, &startVoltage) == 2) {
+            startState.timeMs = (uint32_t)startTime;
+            startState.voltage = startVoltage;
+            startRecorded = true;
+            continue;
+        }
+        if (strncmp(line, "# ff=", 5) == 0) {
+            if (!parseFeedForward(line + 5)) {
+                fprintf(stderr, "%s:%d: malformed feed-forward map, starting from an empty one\n", path.c_str(), lineNo);
+                memset(startState.feedForwardDuty, 0, sizeof(startState.feedForwardDuty));
+                memset(startState.feedForwardSamples, 0, sizeof(startState.feedForwardSamples));
+            }
+            continue;
+        }
+        // Skip headers, comments and any non-trace serial output mixed into the capture.
+        if (line[0] < '0' || line[0] > '9') continue;
+        unsigned long t, flags = 0, rpmPulses = 0, speedPulses = 0;
+        float v, target, backpressure = 0, intakeTemp = 0, supply = 0, applied = 0;
+        int fields = sscanf(line, "%lu,%f,%f,%lu,%lu,%lu,%f,%f,%f,%f", &t, &v, &target, &flags, &rpmPulses, &speedPulses,
+                            &backpressure, &intakeTemp, &supply, &applied);
+        if (fields < 3) {
+            fprintf(stderr, "%s:%d: skipping malformed line\n", path.c_str(), lineNo);
+            continue;
+        }
+        TraceRecord r;
+        r.timeMs = (uint32_t)t;
+        r.voltage = v;
+        r.targetkPa = target;
+        // Version 1 wrote activity as 0 or 1, which reads as the same flag.
+        r.flags = (uint32_t)flags;
+        if (fields < 9) r.flags &= ~TRACE_FLAG_AUX_SENSORS;
+        if (fields < 10) r.flags &= ~TRACE_FLAG_DUTY_OVERRIDE;
+        r.rpmPulses = (uint32_t)rpmPulses;
+        r.speedPulses = (uint32_t)speedPulses;
+        r.backpressureVoltage = backpressure;
+        r.intakeTempVoltage = intakeTemp;
+        r.supplyVoltage = supply;
+        r.appliedPercent = applied;
+        loadedRecords.push_back(r);
+    }
+    fclose(f);
+    records = loadedRecords.data();
+    count = loadedRecords.size();
+    return true;
+}
+
+bool TraceLog::openBinary(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+        ::close(fd);
+        error = path + ": too short for a trace header";
+        return false;
+    }
+    mappingSize = st.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        error = "mmap failed for " + path;
+        return false;
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    const TraceHeader* header = (const TraceHeader*)mapping;
+    if (memcmp(header->magic, TRACE_MAGIC, 4) != 0 || header->version < 1 || header->version > TRACE_VERSION) {
+        error = path + ": not a version 1 to 3 boost trace";
+        close();
+        return false;
+    }
+    size_t headerSize = sizeof(TraceHeader) + (header->version >= 3 ? sizeof(TraceStart) : 0);
+    size_t recordSize = header->version == 1 ? sizeof(TraceRecordV1) : sizeof(TraceRecord);
+    if (mappingSize < headerSize || header->recordCount > (mappingSize - headerSize) / recordSize) {
+        error = path + ": truncated";
+        close();
+        return false;
+    }
+    if (header->version >= 3) {
+        memcpy(&startState, (const char*)mapping + sizeof(TraceHeader), sizeof(startState));
+        startRecorded = true;
+    }
+    const char* body = (const char*)mapping + headerSize;
+    if (header->version == 1) {
+        std::vector<TraceRecord> converted(header->recordCount);
+        for (size_t i = 0; i < converted.size(); i++) {
+            TraceRecordV1 old;
+            memcpy(&old, body + i * sizeof(TraceRecordV1), sizeof(old));
+            TraceRecord& r = converted[i];
+            r.timeMs = old.timeMs;
+            r.voltage = old.voltage;
+            r.targetkPa = old.targetkPa;
+            r.flags = old.flags & TRACE_FLAG_ACTIVITY;
+            r.rpmPulses = 0;
+            r.speedPulses = 0;
+            r.backpressureVoltage = 0;
+            r.intakeTempVoltage = 0;
+            r.supplyVoltage = 0;
+            r.appliedPercent = 0;
+        }
+        close();
+        loadedRecords.swap(converted);
+        records = loadedRecords.data();
+        count = loadedRecords.size();
+        return true;
+    }
+    records = (const TraceRecord*)body;
+    count = header->recordCount;
+    return true;
+}
+
+bool TraceLog::writeBinary(const std::string& path, const TraceStart& start, const TraceRecord* recs, size_t n,
+                           std::string& error) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        error = "cannot create " + path;
+        return false;
+    }
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, 4);
+    header.version = TRACE_VERSION;
+    header.recordCount = (uint32_t)n;
+    header.reserved = 0;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok) ok = fwrite(&start, sizeof(start), 1, f) == 1;
+    if (ok && n > 0) ok = fwrite(recs, sizeof(TraceRecord), n, f) == n;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) error = "write failed for " + path;
+    return ok;
+}
+
+void traceSensorSample(const TraceRecord& r, SensorSample& sample) {
+    uint16_t auxSamples = (r.flags & TRACE_FLAG_AUX_SENSORS) ? 1 : 0;
+    sample.timeMs = r.timeMs;
+    sample.voltage[SENSOR_MAP] = r.voltage;
+    sample.voltage[SENSOR_BACKPRESSURE] = r.backpressureVoltage;
+    sample.voltage[SENSOR_IAT] = r.intakeTempVoltage;
+    sample.voltage[SENSOR_SUPPLY] = r.supplyVoltage;
+    sample.samples[SENSOR_MAP] = 1;
+    sample.samples[SENSOR_BACKPRESSURE] = auxSamples;
+    sample.samples[SENSOR_IAT] = auxSamples;
+    sample.samples[SENSOR_SUPPLY] = auxSamples;
+}
+
+void traceControlInit(const TraceLog& log, ControlState& state, const ControlParams& params) {
+    const TraceStart& start = log.start();
+    controlInit(state, params, start.voltage, start.timeMs);
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        state.feedForward.dutyPercent[i] = start.feedForwardDuty[i];
+        state.feedForward.samples[i] = start.feedForwardSamples[i];
+    }
+    // As persistence.cpp does with the map it reads back.
+    feedForwardSanitize(state.feedForward);
+}
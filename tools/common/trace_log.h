@@ -0,0 +1,115 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "control.h"
+
+//================================================================================
+// CAPTURED TRACE LOGS
+//================================================================================
+// One record per control tick, as printed by firmware built with
+// -DBOOST_TRACE_LOG:
+//   time_ms,voltage,target_kpa,flags,rpm_pulses,speed_pulses,backpressure_v,iat_v,supply_v,applied_pct
+// The voltages are the ADC scan's averaged pin voltages, MAP first.
+// applied_pct is the duty applied since the previous tick. Before the first
+// record the control task prints what controlInit() was given and the
+// feed-forward map it loaded from EEPROM:
+//   # start=time_ms,voltage
+//   # ff=duty:samples,duty:samples,...     one pair per breakpoint
+//
+// The binary form is a 16-byte header and the start state followed by packed
+// records, and is memory-mapped, so multi-hour logs replay without being read
+// into memory.
+//
+// Version 1 captures (the first four columns, 16-byte binary records) still
+// open, with no pulses or auxiliary channels; a version 1 binary is read into
+// memory. Captures without a start state (version 1 and 2, or a serial log
+// begun after boot) start the controller at the first record with an empty
+// feed-forward map.
+
+#define TRACE_MAGIC "BCLG"
+#define TRACE_VERSION 3
+
+struct TraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t reserved;
+};
+
+// Follows the header from version 3.
+struct TraceStart {
+    uint32_t timeMs;                                // controlInit() time and MAP voltage
+    float voltage;
+    float feedForwardDuty[FF_TABLE_POINTS];         // map loaded from EEPROM
+    uint8_t feedForwardSamples[FF_TABLE_POINTS];
+};
+
+struct TraceRecord {
+    uint32_t timeMs;
+    float voltage;
+    float targetkPa;
+    uint32_t flags;
+    uint32_t rpmPulses;         // tach pulses since the previous record
+    uint32_t speedPulses;       // vehicle speed pulses since the previous record
+    float backpressureVoltage;  // auxiliary channels, valid with TRACE_FLAG_AUX_SENSORS
+    float intakeTempVoltage;
+    float supplyVoltage;
+    float appliedPercent;       // duty applied since the previous record
+};
+
+struct TraceRecordV1 {
+    uint32_t timeMs;
+    float voltage;
+    float targetkPa;
+    uint32_t flags;
+};
+
+#define TRACE_FLAG_ACTIVITY 0x1
+#define TRACE_FLAG_AUX_SENSORS 0x2   // the scan had data on every auxiliary channel
+#define TRACE_FLAG_DUTY_OVERRIDE 0x4 // appliedPercent came from the relay, cut, failsafe or characterization
+#define TRACE_FLAG_FF_CLEARED 0x8    // `ff clear` emptied the feed-forward map before this tick
+
+// The ADC scan the firmware's control step saw on this record's tick.
+void traceSensorSample(const TraceRecord& r, SensorSample& sample);
+
+class TraceLog;
+// controlInit() as the control task called it at the start of the capture,
+// with the feed-forward map it loaded.
+void traceControlInit(const TraceLog& log, ControlState& state, const ControlParams& params);
+
+class TraceLog {
+public:
+    TraceLog();
+    ~TraceLog();
+
+    // Opens a .csv or binary log; returns false and fills error on failure.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    size_t size() const { return count; }
+    const TraceRecord& operator[](size_t i) const { return records[i]; }
+    const TraceStart& start() const { return startState; }
+
+    static bool writeBinary(const std::string& path, const TraceStart& start, const TraceRecord* recs, size_t n,
+                            std::string& error);
+
+private:
+    bool openCsv(const std::string& path, std::string& error);
+    bool openBinary(const std::string& path, std::string& error);
+    bool parseFeedForward(const char* pairs);
+
+    TraceStart startState;
+    bool startRecorded;
+    std::vector<TraceRecord> loadedRecords;   // CSV and version 1 binary logs
+    void* mapping;
+    size_t mappingSize;
+    const TraceRecord* records;
+    size_t count;
+};
+
+#endif // TRACE_LOG_H
@@ -0,0 +1,397 @@
+//================================================================================
+// PRESSURE ESTIMATOR COMPARISON
+//================================================================================
+// Compares the pressure and rate estimator (src/estimator.h) with what it
+// replaces, tick by tick on the same readings:
+//   - pressure: the MAP filter pipeline's output
+//   - rate: the first difference of the filtered pressure (what the D term
+//     and the spool score differenced) and the raw reading's difference over
+//     the rate period (what the EMA switch compared)
+// For each it reports the lag (the shift in ms that best lines it up with the
+// reference), the RMS error at that shift, and for pressure the roughness
+// (RMS second difference) as a share of the raw reading's.
+//
+// With a captured TRACE the reference is the raw reading (for rate, its
+// centred difference over 100 ms), so the figures are relative only. Without
+// one the readings come from pulls of the synthetic plant, where the true
+// pressure is known, and these are checked:
+//   - the estimate lags the true pressure less than the filter does and is
+//     less than half as rough as the raw reading
+//   - its rate is closer to the true rate than either difference
+//   - with the estimator enabled the loop reaches and holds the target and
+//     the spool score is within 15 % of the true peak rise rate, closer than
+//     the differenced score
+//   - on a noisy sensor, with the noise setting matched to it, the loop
+//     still settles with the D term fed from the estimate, and the D term's
+//     input is closer to the true rate than the raw reading's difference
+//
+//   estimator [--params FILE] [--set key=value]... [TRACE]
+//
+// Prints the comparison table, then one line per check, and exits non-zero
+// when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+#include "trace_log.h"
+
+static const float DT_MS = CONTROL_TASK_DELAY_MS;
+static const int MAX_SHIFT_TICKS = 40;
+static const int REFERENCE_HALF_SPAN = 5;        // ticks either side for a trace's reference rate
+
+// ControlState carries the 1000-sample event buffer; keep it off the stack.
+static ControlState state;
+
+// One tick of a run.
+struct Tick {
+    float truekPa, trueRate;     // reference: the plant, or the trace's raw reading
+    float rawkPa;
+    float filteredkPa;           // MAP filter pipeline
+    float estimatedkPa, estimatedRate;
+    float duty;
+    float derivative;            // the PID's derivative input, per second
+    bool throttleOpen;
+    bool holding;                // well after spool, on target
+};
+
+//================================================================================
+// RUNS
+//================================================================================
+// Pulls of the synthetic plant through the control pipeline, the way
+// simulatePull() drives it, with the estimator also run on the side so its
+// pressure can be compared whether or not the loop uses it.
+// Returns the best spool score the pulls produced.
+static float runPulls(const ToolParams& tp, const PlantModel& model, int pulls, std::vector<Tick>& ticks) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PullProfile pull = defaultPullProfile();
+    PlantState plant;
+    plantInit(plant, model);
+    PressureEstimator side;
+    estimatorInit(side);
+
+    uint32_t t = 0;
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), t);
+    estimatorUpdate(side, params.estimator, truePressure, 0);
+
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    float duty = 0;
+    float spoolScore = 0;
+    const uint32_t pullLength = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+    ticks.clear();
+    for (int n = 0; n < pulls; n++) {
+        uint32_t start = t;
+        for (uint32_t elapsed = (uint32_t)DT_MS; elapsed <= pullLength; elapsed += (uint32_t)DT_MS) {
+            t = start + elapsed;
+            bool throttleOpen = elapsed >= pull.throttleOpenMs && elapsed < pull.throttleOpenMs + pull.pullMs;
+            float previous = truePressure;
+            truePressure = plantStep(plant, model, duty, throttleOpen, (float)elapsed - pull.throttleOpenMs, DT_MS);
+            input.timeMs = t;
+            input.measuredVoltage = plantSensorVoltage(plant, model, params, truePressure);
+            input.previousDutyPercent = duty;
+            controlStep(state, params, input, out);
+            duty = out.controlPercent;
+            if (out.spoolScoreReady && out.spoolScore > spoolScore) spoolScore = out.spoolScore;
+            estimatorUpdate(side, params.estimator, out.rawPressure, DT_MS);
+
+            Tick tick;
+            tick.truekPa = truePressure;
+            tick.trueRate = (truePressure - previous) * 1000.0f / DT_MS;
+            tick.rawkPa = out.rawPressure;
+            tick.filteredkPa = out.currentPressure;
+            tick.estimatedkPa = side.pressure;
+            tick.estimatedRate = side.rate;
+            tick.duty = duty;
+            tick.derivative = float(state.pid.derivative);
+            tick.throttleOpen = throttleOpen;
+            tick.holding = throttleOpen && elapsed > pull.throttleOpenMs + 2500;
+            ticks.push_back(tick);
+        }
+    }
+    return spoolScore;
+}
+
+static bool runTrace(const ToolParams& tp, const std::string& path, std::vector<Tick>& ticks) {
+    TraceLog log;
+    std::string error;
+    if (!log.open(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    if (log.size() < 2 * REFERENCE_HALF_SPAN + 2) {
+        fprintf(stderr, "%s: too short to compare\n", path.c_str());
+        return false;
+    }
+    ControlParams params;
+    toControlParams(tp, params);
+    PressureEstimator side;
+    estimatorInit(side);
+    traceControlInit(log, state, params);
+    ControlInput input = {};
+    ControlOutput out;
+    SensorSample sensors;
+    input.sensors = &sensors;
+    ticks.clear();
+    for (size_t i = 1; i < log.size(); i++) {
+        input.timeMs = log[i].timeMs;
+        input.measuredVoltage = log[i].voltage;
+        input.targetkPa = log[i].targetkPa;
+        input.activityDetected = (log[i].flags & TRACE_FLAG_ACTIVITY) != 0;
+        input.rpmPulses = log[i].rpmPulses;
+        input.speedPulses = log[i].speedPulses;
+        traceSensorSample(log[i], sensors);
+        if (log[i].flags & TRACE_FLAG_FF_CLEARED) feedForwardClear(state.feedForward);
+        input.previousDutyPercent = ticks.empty() ? 0.0f : ticks.back().duty;
+        if (log[i].flags & TRACE_FLAG_DUTY_OVERRIDE) input.previousDutyPercent = log[i].appliedPercent;
+        controlStep(state, params, input, out);
+        estimatorUpdate(side, params.estimator, out.rawPressure, (float)(log[i].timeMs - log[i - 1].timeMs));
+        Tick tick = {};
+        tick.rawkPa = out.rawPressure;
+        tick.filteredkPa = out.currentPressure;
+        tick.estimatedkPa = side.pressure;
+        tick.estimatedRate = side.rate;
+        tick.duty = out.controlPercent;
+        ticks.push_back(tick);
+    }
+    // The raw reading is the only reference; its rate is a centred difference.
+    int n = (int)ticks.size();
+    for (int i = 0; i < n; i++) {
+        ticks[i].truekPa = ticks[i].rawkPa;
+        int lo = i - REFERENCE_HALF_SPAN < 0 ? 0 : i - REFERENCE_HALF_SPAN;
+        int hi = i + REFERENCE_HALF_SPAN >= n ? n - 1 : i + REFERENCE_HALF_SPAN;
+        ticks[i].trueRate = (ticks[hi].rawkPa - ticks[lo].rawkPa) * 1000.0f / ((hi - lo) * DT_MS);
+    }
+    return true;
+}
+
+//================================================================================
+// FIGURES
+//================================================================================
+struct Figures {
+    float lagMs;                 // shift that best lines the estimate up with the reference
+    float rmsError;              // at that shift
+    float roughness;             // RMS second difference
+};
+
+static Figures figuresFor(const std::vector<float>& estimate, const std::vector<float>& reference) {
+    Figures f = {0, 0, 0};
+    int n = (int)estimate.size();
+    double best = -1;
+    for (int shift = 0; shift <= MAX_SHIFT_TICKS; shift++) {
+        double sum = 0;
+        int count = 0;
+        for (int i = MAX_SHIFT_TICKS; i < n; i++) {
+            double e = estimate[i] - reference[i - shift];
+            sum += e * e;
+            count++;
+        }
+        double rms = count ? sqrt(sum / count) : 0;
+        if (best < 0 || rms < best) {
+            best = rms;
+            f.lagMs = shift * DT_MS;
+        }
+    }
+    f.rmsError = (float)best;
+    double sum = 0;
+    for (int i = 2; i < n; i++) {
+        double d = estimate[i] - 2.0 * estimate[i - 1] + estimate[i - 2];
+        sum += d * d;
+    }
+    f.roughness = n > 2 ? (float)sqrt(sum / (n - 2)) : 0.0f;
+    return f;
+}
+
+static float rmsAgainst(const std::vector<float>& estimate, const std::vector<float>& reference) {
+    double sum = 0;
+    for (size_t i = 0; i < estimate.size(); i++) {
+        double e = estimate[i] - reference[i];
+        sum += e * e;
+    }
+    return estimate.empty() ? 0.0f : (float)sqrt(sum / estimate.size());
+}
+
+struct Comparison {
+    Figures raw, filtered, estimated;
+    Figures filteredDifference, lookbackDifference, estimatedRate;
+    float filteredDifferenceError, lookbackDifferenceError, estimatedRateError;   // RMS at zero shift
+};
+
+static void compare(const ToolParams& tp, const std::vector<Tick>& ticks, Comparison& c) {
+    int lookback = tp.kpa_rate_time_interval_ms / CONTROL_TASK_DELAY_MS;
+    if (lookback < 1) lookback = 1;
+    if (lookback > FILTER_LOOKBACK_MAX) lookback = FILTER_LOOKBACK_MAX;
+    int span = lookback > 1 ? lookback - 1 : 1;
+
+    std::vector<float> reference, raw, filtered, estimated;
+    std::vector<float> referenceRate, filteredDifference, lookbackDifference, estimatedRate;
+    for (size_t i = 0; i < ticks.size(); i++) {
+        const Tick& t = ticks[i];
+        reference.push_back(t.truekPa);
+        raw.push_back(t.rawkPa);
+        filtered.push_back(t.filteredkPa);
+        estimated.push_back(t.estimatedkPa);
+        referenceRate.push_back(t.trueRate);
+        filteredDifference.push_back(i ? (t.filteredkPa - ticks[i - 1].filteredkPa) * 1000.0f / DT_MS : 0.0f);
+        size_t back = i >= (size_t)span ? i - span : 0;
+        lookbackDifference.push_back(i ? (t.rawkPa - ticks[back].rawkPa) * 1000.0f / ((i - back) * DT_MS) : 0.0f);
+        estimatedRate.push_back(t.estimatedRate);
+    }
+    c.raw = figuresFor(raw, reference);
+    c.filtered = figuresFor(filtered, reference);
+    c.estimated = figuresFor(estimated, reference);
+    c.filteredDifference = figuresFor(filteredDifference, referenceRate);
+    c.lookbackDifference = figuresFor(lookbackDifference, referenceRate);
+    c.estimatedRate = figuresFor(estimatedRate, referenceRate);
+    c.filteredDifferenceError = rmsAgainst(filteredDifference, referenceRate);
+    c.lookbackDifferenceError = rmsAgainst(lookbackDifference, referenceRate);
+    c.estimatedRateError = rmsAgainst(estimatedRate, referenceRate);
+}
+
+static void printComparison(const char* source, const Comparison& c) {
+    printf("source,quantity,estimate,lag_ms,rms_at_lag,rms_at_zero,roughness_vs_raw\n");
+    const float rawRoughness = c.raw.roughness > 0.0f ? c.raw.roughness : 1.0f;
+    printf("%s,pressure,raw,%.0f,%.3f,,1.000\n", source, c.raw.lagMs, c.raw.rmsError);
+    printf("%s,pressure,filter,%.0f,%.3f,,%.3f\n", source, c.filtered.lagMs, c.filtered.rmsError, c.filtered.roughness / rawRoughness);
+    printf("%s,pressure,estimator,%.0f,%.3f,,%.3f\n", source, c.estimated.lagMs, c.estimated.rmsError, c.estimated.roughness / rawRoughness);
+    printf("%s,rate,filter_difference,%.0f,%.1f,%.1f,\n", source, c.filteredDifference.lagMs, c.filteredDifference.rmsError,
+           c.filteredDifferenceError);
+    printf("%s,rate,lookback_difference,%.0f,%.1f,%.1f,\n", source, c.lookbackDifference.lagMs, c.lookbackDifference.rmsError,
+           c.lookbackDifferenceError);
+    printf("%s,rate,estimator,%.0f,%.1f,%.1f,\n", source, c.estimatedRate.lagMs, c.estimatedRate.rmsError, c.estimatedRateError);
+}
+
+//================================================================================
+// CHECKS
+//================================================================================
+static void checkSynthetic(const ToolParams& tp) {
+    std::vector<Tick> ticks;
+    runPulls(tp, defaultPlantModel(), 3, ticks);
+    Comparison c;
+    compare(tp, ticks, c);
+    printComparison("synthetic", c);
+    printf("\n");
+
+    char detail[128];
+    snprintf(detail, sizeof(detail), "lag %.0f ms (filter %.0f ms)", c.estimated.lagMs, c.filtered.lagMs);
+    check(c.estimated.lagMs < c.filtered.lagMs, "estimator pressure lag", detail);
+    snprintf(detail, sizeof(detail), "roughness %.3f of the raw reading's (filter %.3f)", c.estimated.roughness / c.raw.roughness,
+             c.filtered.roughness / c.raw.roughness);
+    check(c.estimated.roughness < 0.5f * c.raw.roughness, "estimator noise rejection", detail);
+    snprintf(detail, sizeof(detail), "RMS %.1f kPa/s (differenced %.1f, lookback %.1f)", c.estimatedRateError,
+             c.filteredDifferenceError, c.lookbackDifferenceError);
+    check(c.estimatedRateError < c.filteredDifferenceError && c.estimatedRateError < c.lookbackDifferenceError,
+          "estimator rate error", detail);
+}
+
+static float trueSpoolRate(const std::vector<Tick>& ticks) {
+    float peak = 0;
+    for (const Tick& t : ticks) {
+        if (t.throttleOpen && t.trueRate > peak) peak = t.trueRate;
+    }
+    return peak;
+}
+
+// RMS error of the D term's input while holding, where the setpoint is flat
+// and the input should be minus the true rate.
+static float holdingDerivativeError(const std::vector<Tick>& ticks) {
+    double sumSq = 0;
+    int count = 0;
+    for (const Tick& t : ticks) {
+        if (!t.holding) continue;
+        double error = t.derivative + t.trueRate;
+        sumSq += error * error;
+        count++;
+    }
+    return count ? (float)sqrt(sumSq / count) : 0.0f;
+}
+
+static void checkClosedLoop(const ToolParams& tp) {
+    PullProfile pull = defaultPullProfile();
+    PlantModel model = defaultPlantModel();
+    ToolParams on = tp, off = tp;
+    on.estimator.enabled = 1;
+    off.estimator.enabled = 0;
+    PullMetrics withEstimator, without;
+    simulatePull(on, model, pull, withEstimator);
+    simulatePull(off, model, pull, without);
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "to target %.0f ms, settled %.0f ms, overshoot %.1f kPa (off: %.0f, %.0f, %.1f)",
+             withEstimator.timeToTargetMs, withEstimator.settlingMs, withEstimator.overshootkPa, without.timeToTargetMs,
+             without.settlingMs, without.overshootkPa);
+    check(withEstimator.timeToTargetMs < (float)pull.pullMs && withEstimator.settlingMs < (float)pull.pullMs,
+          "estimator loop holds target", detail);
+
+    std::vector<Tick> ticksOn, ticksOff;
+    float scoreOn = runPulls(on, model, 1, ticksOn);
+    float scoreOff = runPulls(off, model, 1, ticksOff);
+    float trueOn = trueSpoolRate(ticksOn), trueOff = trueSpoolRate(ticksOff);
+    float errorOn = fabsf(scoreOn - trueOn) / trueOn, errorOff = fabsf(scoreOff - trueOff) / trueOff;
+    snprintf(detail, sizeof(detail), "%.0f kPa/s vs true %.0f (differenced %.0f vs %.0f)", scoreOn, trueOn, scoreOff, trueOff);
+    check(errorOn < 0.15f && errorOn < errorOff, "spool score from estimator", detail);
+
+    // A noisy sensor, no MAP filtering (an adaptive EMA that is always fast)
+    // and no low-pass on the D term, so the only difference between the runs
+    // is whether the D term sees the estimate or the raw reading's difference.
+    PlantModel noisy = model;
+    noisy.noisekPa = 3.0f;
+    ToolParams matched = on, differenced = off;
+    matched.estimator.measurementNoisekPa = noisy.noisekPa / sqrtf(3.0f);   // sigma of the uniform noise
+    differenced.estimator = matched.estimator;
+    differenced.estimator.enabled = 0;
+    matched.pidDerivativeFilterMs = differenced.pidDerivativeFilterMs = 0.0f;
+    matched.slow_ema_a = matched.fast_ema_a = differenced.slow_ema_a = differenced.fast_ema_a = 1.0f;
+    std::vector<Tick> ticksMatched, ticksDifferenced;
+    runPulls(matched, noisy, 1, ticksMatched);
+    runPulls(differenced, noisy, 1, ticksDifferenced);
+    PullMetrics noisyMetrics;
+    simulatePull(matched, noisy, pull, noisyMetrics);
+    float errorMatched = holdingDerivativeError(ticksMatched), errorDifferenced = holdingDerivativeError(ticksDifferenced);
+    snprintf(detail, sizeof(detail), "D input RMS error %.0f kPa/s while holding (raw difference %.0f), settled %.0f ms",
+             errorMatched, errorDifferenced, noisyMetrics.settlingMs);
+    check(errorMatched < errorDifferenced && noisyMetrics.settlingMs < (float)pull.pullMs, "D term on a noisy sensor", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string tracePath, error;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool ok = true;
+        if ((arg == "--params" || arg == "--set") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+            else ok = setToolParam(tp, value);
+        } else if (arg[0] != '-' && tracePath.empty()) {
+            tracePath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: estimator [--params FILE] [--set key=value]... [TRACE]\n");
+            return 1;
+        }
+    }
+
+    if (!tracePath.empty()) {
+        std::vector<Tick> ticks;
+        if (!runTrace(tp, tracePath, ticks)) return 1;
+        Comparison c;
+        compare(tp, ticks, c);
+        printComparison("trace", c);
+        return 0;
+    }
+    checkSynthetic(tp);
+    checkClosedLoop(tp);
+    return checkExitCode();
+}
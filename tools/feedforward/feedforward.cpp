@@ -0,0 +1,112 @@
+//================================================================================
+// FEED-FORWARD LEARNING CHECK
+//================================================================================
+// Runs repeated simulated pulls at several targets with one feed-forward table
+// carried between them, as the firmware keeps it across pulls. Prints the
+// scores of each pull and the learned table, then checks the duty the table
+// would seed at each target's setpoint against the plant's true holding duty.
+//
+//   feedforward [--params FILE] [--set key=value]... [--plant key=value]...
+//               [--rounds N] [--tolerance PCT]
+//
+// Exits non-zero when a checked seed misses by more than the tolerance
+// (percentage points of duty, default 3) or nothing could be checked.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static bool setPlant(PlantModel& m, const std::string& a) {
+    size_t eq = a.find('=');
+    if (eq == std::string::npos) return false;
+    std::string key = a.substr(0, eq);
+    float v = strtof(a.c_str() + eq + 1, nullptr);
+    if (key == "springkPa") m.springkPa = v;
+    else if (key == "maxBoostkPa") m.maxBoostkPa = v;
+    else if (key == "spoolTimeMs") m.spoolTimeMs = v;
+    else if (key == "tauMs") m.tauMs = v;
+    else if (key == "deadTimeMs") m.deadTimeMs = v;
+    else if (key == "noisekPa") m.noisekPa = v;
+    else return false;
+    return true;
+}
+
+// Duty at which the fully spooled model settles at the given pressure.
+static float trueHoldingDuty(const PlantModel& m, float pressurekPa) {
+    return 100.0f * (pressurekPa - 100.0f - m.springkPa) / (m.maxBoostkPa - m.springkPa);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    tp.feedForwardEnabled = 1;
+    PlantModel model = defaultPlantModel();
+    int rounds = 6;
+    float tolerance = 3.0f;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--plant") ok = setPlant(model, value);
+        else if (arg == "--rounds") rounds = atoi(value.c_str());
+        else if (arg == "--tolerance") tolerance = strtof(value.c_str(), nullptr);
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "usage: feedforward [--params FILE] [--set key=value]... [--plant key=value]... "
+                            "[--rounds N] [--tolerance PCT]\n");
+            return 1;
+        }
+    }
+
+    const float targets[] = {150.0f, 160.0f, 170.0f, 180.0f, 190.0f, 200.0f, 210.0f};
+    FeedForwardTable table;
+    feedForwardClear(table);
+
+    printf("round,target_kpa,overshoot_kpa,settling_ms,torque_score,spool_score\n");
+    for (int r = 0; r < rounds; r++) {
+        for (float target : targets) {
+            ToolParams run = tp;
+            run.targetkPa = target;
+            PullMetrics m;
+            simulatePull(run, model, defaultPullProfile(), m, &table);
+            printf("%d,%.0f,%.2f,%.0f,%.1f,%.1f\n", r + 1, target, m.overshootkPa, m.settlingMs, m.torqueScore, m.spoolScore);
+        }
+    }
+
+    printf("\npoint_kpa,samples,learned_duty,true_duty\n");
+    for (int i = 0; i < FF_TABLE_POINTS; i++) {
+        float kPa = FF_TABLE_MIN_KPA + i * FF_TABLE_STEP_KPA;
+        if (table.samples[i] == 0) printf("%.0f,0,,\n", kPa);
+        else printf("%.0f,%d,%.2f,%.2f\n", kPa, table.samples[i], table.dutyPercent[i], trueHoldingDuty(model, kPa));
+    }
+
+    // What matters is the seed: the lookup at each target's setpoint. Only
+    // setpoints between two trusted breakpoints are checked; pulls that never
+    // held steady near a setpoint (e.g. the turbo cannot make it unsaturated)
+    // leave nothing to compare.
+    int checked = 0, failed = 0;
+    printf("\ntarget_kpa,setpoint_kpa,seed_duty,true_duty,error,result\n");
+    for (float target : targets) {
+        float setpoint = target + tp.PID_Control_Overhead;
+        float expected = trueHoldingDuty(model, setpoint);
+        int i = (int)((setpoint - FF_TABLE_MIN_KPA) / FF_TABLE_STEP_KPA);
+        float seed;
+        if (i < 0 || i >= FF_TABLE_POINTS - 1 || table.samples[i] < FF_MIN_SAMPLES ||
+            table.samples[i + 1] < FF_MIN_SAMPLES || !feedForwardLookup(table, setpoint, seed)) {
+            printf("%.0f,%.0f,,%.2f,,unlearned\n", target, setpoint, expected);
+            continue;
+        }
+        bool ok = fabsf(seed - expected) <= tolerance;
+        checked++;
+        if (!ok) failed++;
+        printf("%.0f,%.0f,%.2f,%.2f,%.2f,%s\n", target, setpoint, seed, expected, seed - expected, ok ? "PASS" : "FAIL");
+    }
+    bool pass = checked > 0 && failed == 0;
+    return pass ? 0 : 2;
+}
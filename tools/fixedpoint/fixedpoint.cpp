@@ -0,0 +1,404 @@
+//================================================================================
+// FIXED-POINT CONTROL PATH CHECK
+//================================================================================
+// Runs the MAP filter pipelines in Q8.24 and the PID in Q16.16 (src/fixed.h),
+// the formats a -DCONTROL_FIXED_POINT build uses, against the float path:
+//   - Fixed<> saturates instead of wrapping, rounds products, quotients and
+//     conversions to nearest, and handles division by zero and NaN
+//   - every filter type tracks the float pipeline to within 0.01 kPa on a
+//     noisy pull, and the PID's output stays within 0.1 counts of the float
+//     controller's for the same inputs, for each anti-windup mode, with the
+//     derivative filter and with the rate supplied
+//   - a closed-loop pull (filter, scaling to kPa, PID, simulated plant) holds
+//     within 0.5 kPa of the float loop
+//   - a pipeline run driven only by integers hashes to a fixed value, so any
+//     host or target that builds this file reproduces the same bits
+// It then prints ns and (on x86) TSC ticks per tick of filter, scaling and PID
+// in each arithmetic. --ticks N sets how many ticks each is timed over.
+//
+//   fixedpoint [--params FILE] [--set key=value]... [--ticks N]
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+static uint64_t cycleCount() { return 0; }   // no counter; the column reads 0
+#endif
+
+static const char* const FILTER_NAMES[FILTER_TYPE_COUNT] = {"adaptive_ema", "median_ema", "biquad", "tracker"};
+static const float TICK_S = CONTROL_TASK_DELAY_MS * SECONDS_PER_MS;
+static const float TARGET_KPA = 170.0f;
+
+template <typename T>
+static FilterConfig<T> filterConfigAs(const FilterConfig<float>& cfg) {
+    FilterConfig<T> result;
+    result.slowAlpha = T(cfg.slowAlpha);
+    result.fastAlpha = T(cfg.fastAlpha);
+    result.changeThreshold = T(cfg.changeThreshold);
+    result.lookback = cfg.lookback;
+    result.externalChange = cfg.externalChange;
+    result.change = T(cfg.change);
+    result.b0 = T(cfg.b0);
+    result.b1 = T(cfg.b1);
+    result.b2 = T(cfg.b2);
+    result.a1 = T(cfg.a1);
+    result.a2 = T(cfg.a2);
+    result.trackerAlpha = T(cfg.trackerAlpha);
+    result.trackerBeta = T(cfg.trackerBeta);
+    result.dtSeconds = T(cfg.dtSeconds);
+    return result;
+}
+
+// As control.cpp sets up the pipeline and the PID.
+static FilterConfig<float> filterConfigFor(const ControlParams& params) {
+    FilterConfig<float> cfg;
+    float kPaPerVolt = pressureMapFor(params).slope;
+    cfg.slowAlpha = params.slow_ema_a;
+    cfg.fastAlpha = params.fast_ema_a;
+    cfg.changeThreshold = params.kpa_rate_change_threshold / kPaPerVolt;
+    cfg.lookback = params.kpa_rate_time_interval_ms / CONTROL_TASK_DELAY_MS;
+    cfg.externalChange = false;
+    cfg.change = 0.0f;
+    cfg.trackerAlpha = params.filter.trackerAlpha;
+    cfg.trackerBeta = params.filter.trackerBeta;
+    cfg.dtSeconds = TICK_S;
+    filterDesignLowPass(cfg, params.filter.cutoffHz, 1.0f / TICK_S);
+    return cfg;
+}
+
+static PidConfig<float> pidConfigFor(const ControlParams& params) {
+    PidConfig<float> cfg;
+    cfg.kp = params.kp;
+    cfg.ki = params.ki;
+    cfg.kd = params.kd;
+    cfg.outMin = 0.0f;
+    cfg.outMax = 255.0f;
+    cfg.integralLimit = params.maxIntegral;
+    cfg.setpointWeightP = params.setpointWeightP;
+    cfg.setpointWeightD = params.derivativeOnMeasurement ? 0.0f : 1.0f;
+    cfg.derivativeFilterS = params.derivativeFilterMs * SECONDS_PER_MS;
+    cfg.trackingTimeS = 0.0f;
+    cfg.integralRate = 1.0f;
+    cfg.antiWindup = PID_ANTIWINDUP_CLAMP;
+    return cfg;
+}
+
+//================================================================================
+// ARITHMETIC
+//================================================================================
+static void checkArithmetic() {
+    const Q16_16 top = Q16_16::fromRaw(Q16_16::RAW_MAX), bottom = Q16_16::fromRaw(Q16_16::RAW_MIN);
+    const Q16_16 one(1), big(30000);
+    bool saturates = top + one == top && bottom - one == bottom && big * big == top && -big * big == bottom &&
+                     big / Q16_16(0.001f) == top && Q16_16(1.0e9f) == top && Q16_16(-1.0e9f) == bottom &&
+                     Q16_16(40000) == top && Q8_24(Q16_16(300)) == Q8_24::fromRaw(Q8_24::RAW_MAX);
+    bool divideByZero = one / Q16_16(0) == top && -one / Q16_16(0) == bottom && Q16_16(0) / Q16_16(0) == Q16_16(0);
+    // 1/3 is 21845.33 raw, 2/3 is 43690.67; halves go away from zero.
+    bool rounds = (one / Q16_16(3)).raw == 21845 && (Q16_16(2) / Q16_16(3)).raw == 43691 &&
+                  (-Q16_16(2) / Q16_16(3)).raw == -43691 && (Q16_16::fromRaw(1) * Q16_16(0.5f)).raw == 1 &&
+                  (Q16_16::fromRaw(-1) * Q16_16(0.5f)).raw == -1 && Q16_16(Q8_24::fromRaw(128)).raw == 1 &&
+                  Q16_16(Q8_24::fromRaw(127)).raw == 0 && Q16_16(1.0f / 131072.0f).raw == 1;
+    bool converts = Q16_16(NAN).raw == 0 && float(Q16_16(-2.5f)) == -2.5f && Q8_24(Q16_16(1.25f)) == Q8_24(1.25f);
+    char detail[160];
+    snprintf(detail, sizeof(detail), "saturation %s, divide by zero %s, rounding %s, conversion %s", saturates ? "ok" : "WRONG",
+             divideByZero ? "ok" : "WRONG", rounds ? "ok" : "WRONG", converts ? "ok" : "WRONG");
+    check(saturates && divideByZero && rounds && converts, "saturating arithmetic", detail);
+}
+
+//================================================================================
+// AGAINST THE FLOAT PATH
+//================================================================================
+struct LoopTrace {
+    std::vector<float> sensorVolts;   // offset already taken off
+    std::vector<float> pressure;      // filtered, kPa
+    std::vector<float> output;        // PID output, counts
+};
+
+// Filter, scaling and PID in T, closing the loop through the plant; as
+// controlStep() without the scoring, schedules and limiters.
+template <typename FT, typename PT>
+static void runLoop(const ControlParams& params, int filterType, LoopTrace& trace) {
+    PlantModel model = defaultPlantModel();
+    PullProfile pull = defaultPullProfile();
+    PlantState plant;
+    plantInit(plant, model);
+    LinearMap map = pressureMapFor(params);
+    FilterConfig<FT> fcfg = filterConfigAs<FT>(filterConfigFor(params));
+    PidConfig<PT> pcfg = pidConfigAs<PT>(pidConfigFor(params));
+    PressureFilter<FT> filter;
+    PidController<PT> pid;
+    pid.reset();
+    filter.reset(filterType, FT((100.0f - map.offset) / map.slope));
+    const PT setpoint = PT(TARGET_KPA + params.PID_Control_Overhead), dt = PT(TICK_S);
+    float duty = 0.0f;
+    trace.sensorVolts.clear();
+    trace.pressure.clear();
+    trace.output.clear();
+    uint32_t length = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+    for (uint32_t ms = CONTROL_TASK_DELAY_MS; ms <= length; ms += CONTROL_TASK_DELAY_MS) {
+        bool open = ms >= pull.throttleOpenMs && ms < pull.throttleOpenMs + pull.pullMs;
+        float measured = plantStep(plant, model, duty, open, (float)ms - pull.throttleOpenMs, (float)CONTROL_TASK_DELAY_MS);
+        float volts = (measured - map.offset) / map.slope;
+        float kPa = float(linearMapApply(map, PT(filter.step(FT(volts), fcfg))));
+        float output;
+        if (kPa < TARGET_KPA - params.pidTriggerkPa) {
+            output = 255.0f;
+            pid.reset();
+        } else {
+            output = float(pid.update(pcfg, setpoint, PT(kPa), dt));
+        }
+        duty = output * OUTPUT_PERCENT_PER_COUNT;
+        trace.sensorVolts.push_back(volts);
+        trace.pressure.push_back(kPa);
+        trace.output.push_back(output);
+    }
+}
+
+static void checkFilters(const ControlParams& params, const LoopTrace& reference) {
+    LinearMap map = pressureMapFor(params);
+    FilterConfig<float> cfg = filterConfigFor(params);
+    FilterConfig<Q8_24> fixedCfg = filterConfigAs<Q8_24>(cfg);
+    float worstAll = 0;
+    char detail[200], parts[4][40];
+    for (int type = 0; type < FILTER_TYPE_COUNT; type++) {
+        PressureFilter<float> single;
+        PressureFilter<Q8_24> fixed;
+        single.reset(type, reference.sensorVolts[0]);
+        fixed.reset(type, Q8_24(reference.sensorVolts[0]));
+        float worst = 0;
+        for (float v : reference.sensorVolts) {
+            float a = single.step(v, cfg);
+            float b = float(fixed.step(Q8_24(v), fixedCfg));
+            worst = fmaxf(worst, fabsf(a - b) * map.slope);
+        }
+        snprintf(parts[type], sizeof(parts[type]), "%s %.1e", FILTER_NAMES[type], worst);
+        worstAll = fmaxf(worstAll, worst);
+    }
+    snprintf(detail, sizeof(detail), "max kPa error: %s, %s, %s, %s", parts[0], parts[1], parts[2], parts[3]);
+    check(worstAll < 0.01f, "filters in Q8.24", detail);
+}
+
+static void checkPid(const ControlParams& params, const LoopTrace& reference) {
+    struct Variant {
+        const char* name;
+        int antiWindup;
+        float derivativeFilterS;
+        bool rate;
+    };
+    const Variant variants[] = {{"clamp", PID_ANTIWINDUP_CLAMP, 0.0f, false},
+                                {"back_calc", PID_ANTIWINDUP_BACK_CALCULATION, 0.0f, false},
+                                {"conditional", PID_ANTIWINDUP_CONDITIONAL, 0.0f, false},
+                                {"d_filter", PID_ANTIWINDUP_CLAMP, 0.05f, false},
+                                {"rate", PID_ANTIWINDUP_CLAMP, 0.0f, true}};
+    float worstAll = 0;
+    std::string detail = "max output error:";
+    for (const Variant& variant : variants) {
+        PidConfig<float> cfg = pidConfigFor(params);
+        cfg.antiWindup = (PidAntiWindup)variant.antiWindup;
+        cfg.derivativeFilterS = variant.derivativeFilterS;
+        PidConfig<Q16_16> fixedCfg = pidConfigAs<Q16_16>(cfg);
+        PidController<float> single;
+        PidController<Q16_16> fixed;
+        single.reset();
+        fixed.reset();
+        float setpoint = TARGET_KPA + params.PID_Control_Overhead, worst = 0, last = reference.pressure[0];
+        for (size_t i = 0; i < reference.pressure.size(); i++) {
+            float kPa = reference.pressure[i];
+            float rate = (kPa - last) / TICK_S;
+            last = kPa;
+            float a, b;
+            if (variant.rate) {
+                a = single.updateWithRate(cfg, setpoint, kPa, rate, TICK_S);
+                b = float(fixed.updateWithRate(fixedCfg, Q16_16(setpoint), Q16_16(kPa), Q16_16(rate), Q16_16(TICK_S)));
+            } else {
+                a = single.update(cfg, setpoint, kPa, TICK_S);
+                b = float(fixed.update(fixedCfg, Q16_16(setpoint), Q16_16(kPa), Q16_16(TICK_S)));
+            }
+            worst = fmaxf(worst, fabsf(a - b));
+        }
+        char part[48];
+        snprintf(part, sizeof(part), " %s %.1e", variant.name, worst);
+        detail += part;
+        worstAll = fmaxf(worstAll, worst);
+    }
+    check(worstAll < 0.1f, "PID in Q16.16", detail.c_str());
+}
+
+static void checkClosedLoop(const ControlParams& params) {
+    float worst = 0;
+    int worstType = 0;
+    for (int type = 0; type < FILTER_TYPE_COUNT; type++) {
+        LoopTrace single, fixed;
+        runLoop<float, float>(params, type, single);
+        runLoop<Q8_24, Q16_16>(params, type, fixed);
+        for (size_t i = 0; i < single.pressure.size(); i++) {
+            float error = fabsf(single.pressure[i] - fixed.pressure[i]);
+            if (error > worst) {
+                worst = error;
+                worstType = type;
+            }
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max pressure difference %.3f kPa (%s)", worst, FILTER_NAMES[worstType]);
+    check(worst < 0.5f, "closed-loop pull", detail);
+}
+
+//================================================================================
+// BIT-EXACT REFERENCE
+//================================================================================
+// Inputs and settings are integers end to end, so the hash depends only on
+// fixed.h, filters.h and pid.h. Change EXPECTED_HASH only with a deliberate
+// change to their arithmetic.
+static const uint32_t EXPECTED_HASH = 0x689cbd2bu;
+
+static uint32_t hashRaw(uint32_t hash, int32_t raw) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (uint32_t)(raw >> (8 * i)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void checkBitExact() {
+    FilterConfig<Q8_24> fcfg;
+    fcfg.slowAlpha = Q8_24::fromRaw(167772);        // 0.01
+    fcfg.fastAlpha = Q8_24::fromRaw(5033165);       // 0.3
+    fcfg.changeThreshold = Q8_24::fromRaw(503316);  // 0.03 V
+    fcfg.lookback = 5;
+    fcfg.externalChange = false;
+    fcfg.change = Q8_24(0);
+    fcfg.b0 = Q8_24::fromRaw(337385);               // 5 Hz at 100 Hz
+    fcfg.b1 = Q8_24::fromRaw(674770);
+    fcfg.b2 = fcfg.b0;
+    fcfg.a1 = Q8_24::fromRaw(-26186778);
+    fcfg.a2 = Q8_24::fromRaw(10759103);
+    fcfg.trackerAlpha = Q8_24::fromRaw(5033165);    // 0.3
+    fcfg.trackerBeta = Q8_24::fromRaw(838861);      // 0.05
+    fcfg.dtSeconds = Q8_24::fromRaw(167772);        // 0.01
+    PidConfig<Q16_16> pcfg;
+    pcfg.kp = Q16_16(10);
+    pcfg.ki = Q16_16::fromRaw(6554);                // 0.1
+    pcfg.kd = Q16_16(1);
+    pcfg.outMin = Q16_16(0);
+    pcfg.outMax = Q16_16(255);
+    pcfg.integralLimit = Q16_16(600);
+    pcfg.setpointWeightP = Q16_16(1);
+    pcfg.setpointWeightD = Q16_16(0);
+    pcfg.derivativeFilterS = Q16_16::fromRaw(3277); // 0.05
+    pcfg.trackingTimeS = Q16_16(0);
+    pcfg.integralRate = Q16_16(1);
+    pcfg.antiWindup = PID_ANTIWINDUP_BACK_CALCULATION;
+    const Q16_16 kPaPerVolt = Q16_16(50), setpoint = Q16_16(176), dt = Q16_16::fromRaw(655);
+
+    uint32_t hash = 2166136261u, rng = 7;
+    for (int type = 0; type < FILTER_TYPE_COUNT; type++) {
+        PressureFilter<Q8_24> filter;
+        PidController<Q16_16> pid;
+        pid.reset();
+        filter.reset(type, Q8_24(2));
+        for (int i = 0; i < 2000; i++) {
+            rng = rng * 1664525u + 1013904223u;
+            // A ramp from 2 V to 3.6 V and back, with noise and a spike every 97 ticks.
+            int32_t ramp = (i < 1000 ? i : 2000 - i) * 26844;
+            int32_t noise = (int32_t)((rng >> 12) & 0x3FFFF) - 0x20000;
+            if (i % 97 == 0) noise += 8388608;
+            Q8_24 volts = Q8_24::fromRaw(33554432 + ramp + noise);
+            Q16_16 kPa = Q16_16(filter.step(volts, fcfg)) * kPaPerVolt;
+            Q16_16 output = pid.update(pcfg, setpoint, kPa, dt);
+            hash = hashRaw(hash, kPa.raw);
+            hash = hashRaw(hash, output.raw);
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "hash 0x%08x (expected 0x%08x)", hash, EXPECTED_HASH);
+    check(hash == EXPECTED_HASH, "bit-exact reference run", detail);
+}
+
+//================================================================================
+// BENCHMARK
+//================================================================================
+static volatile float benchSink;
+
+template <typename FT, typename PT>
+static void timeKernel(const ControlParams& params, int filterType, const std::vector<float>& volts, int ticks, double& ns,
+                       double& cycles) {
+    LinearMap map = pressureMapFor(params);
+    FilterConfig<FT> fcfg = filterConfigAs<FT>(filterConfigFor(params));
+    PidConfig<PT> pcfg = pidConfigAs<PT>(pidConfigFor(params));
+    PressureFilter<FT> filter;
+    PidController<PT> pid;
+    pid.reset();
+    filter.reset(filterType, FT(volts[0]));
+    const PT setpoint = PT(TARGET_KPA), dt = PT(TICK_S);
+    // Inputs are converted ahead, as the firmware's would come from the ADC.
+    std::vector<FT> input;
+    for (float v : volts) input.push_back(FT(v));
+    const int size = (int)input.size();
+    PT sum = PT(0);
+    uint64_t startCycles = cycleCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) {
+        PT kPa = linearMapApply(map, PT(filter.step(input[i % size], fcfg)));
+        sum += pid.update(pcfg, setpoint, kPa, dt) * PT(0.001f);
+    }
+    auto end = std::chrono::steady_clock::now();
+    cycles = (double)(cycleCount() - startCycles) / ticks;
+    ns = std::chrono::duration<double, std::nano>(end - start).count() / ticks;
+    benchSink = float(sum);
+}
+
+static void benchmark(const ControlParams& params, const LoopTrace& reference, int ticks) {
+    printf("\nfilter,float_ns,fixed_ns,float_tsc,fixed_tsc\n");
+    for (int type = 0; type < FILTER_TYPE_COUNT; type++) {
+        double floatNs, fixedNs, floatCycles, fixedCycles;
+        timeKernel<float, float>(params, type, reference.sensorVolts, ticks, floatNs, floatCycles);
+        timeKernel<Q8_24, Q16_16>(params, type, reference.sensorVolts, ticks, fixedNs, fixedCycles);
+        printf("%s,%.2f,%.2f,%.1f,%.1f\n", FILTER_NAMES[type], floatNs, fixedNs, floatCycles, fixedCycles);
+    }
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    int ticks = 2000000;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--ticks") ok = (ticks = atoi(value.c_str())) > 0;
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: fixedpoint [--params FILE] [--set key=value]... [--ticks N]\n");
+            return 1;
+        }
+    }
+
+    ControlParams params;
+    toControlParams(tp, params);
+    LoopTrace reference;
+    runLoop<float, float>(params, FILTER_ADAPTIVE_EMA, reference);
+    checkArithmetic();
+    checkFilters(params, reference);
+    checkPid(params, reference);
+    checkClosedLoop(params);
+    checkBitExact();
+    benchmark(params, reference, ticks);
+    return checkExitCode();
+}
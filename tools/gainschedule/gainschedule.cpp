@@ -0,0 +1,245 @@
+//================================================================================
+// GAIN SCHEDULE COMPARISON
+//================================================================================
+// Runs the same simulated pulls with fixed PID gains and with a gain schedule
+// (src/gainschedule.h) on several plant models, and prints the spool and torque
+// scores, overshoot and settling time of each side by side, averaged over
+// several targets and noise seeds.
+//
+//   gainschedule [--params FILE] [--set key=value]...
+//
+// The schedule comes from the parameters (gs.kp.R.E=... lines, as exported by
+// the firmware's `get`) when they set one; otherwise a built-in example is
+// used that backs Kp and Ki off and adds Kd while pressure is still climbing
+// fast towards the target, and leaves holding and falling pressure alone.
+//
+// It then checks that a change of the Ki multiplier, or the adaptive gain scale
+// switching on and off, while holding boost does not step the PID output, and
+// exits non-zero if either does.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+struct PlantCase {
+    const char* name;
+    PlantModel model;
+};
+
+static bool isFlat(const GainSchedule& s) {
+    for (int r = 0; r < GS_RATE_POINTS; r++) {
+        for (int e = 0; e < GS_ERROR_POINTS; e++) {
+            if (s.kp[r][e] != 1.0f || s.ki[r][e] != 1.0f || s.kd[r][e] != 1.0f) return false;
+        }
+    }
+    return true;
+}
+
+static void exampleSchedule(GainSchedule& s) {
+    gainScheduleReset(s);
+    // Rows: rate -100, 0, 100, 200 kPa/s. Columns: error -20, -10, 0, 10, 20 kPa.
+    for (int r = 2; r < GS_RATE_POINTS; r++) {
+        float strength = (r == 2) ? 0.5f : 1.0f;
+        for (int e = 1; e < GS_ERROR_POINTS; e++) {
+            s.kp[r][e] = 1.0f - 0.5f * strength;
+            s.ki[r][e] = 1.0f - 0.5f * strength;
+            s.kd[r][e] = 1.0f + 2.0f * strength;
+        }
+    }
+}
+
+static void printSchedule(const GainSchedule& s) {
+    const float (*tables[3])[GS_ERROR_POINTS] = {s.kp, s.ki, s.kd};
+    const char* names[] = {"kp", "ki", "kd"};
+    printf("# schedule rows rate_kpa_s, columns err_kpa");
+    for (int e = 0; e < GS_ERROR_POINTS; e++) printf(" %.0f", GS_ERROR_MIN_KPA + e * GS_ERROR_STEP_KPA);
+    printf("\n");
+    for (int t = 0; t < 3; t++) {
+        for (int r = 0; r < GS_RATE_POINTS; r++) {
+            printf("# %s %5.0f:", names[t], GS_RATE_MIN_KPA_S + r * GS_RATE_STEP_KPA_S);
+            for (int e = 0; e < GS_ERROR_POINTS; e++) printf(" %.2f", tables[t][r][e]);
+            printf("\n");
+        }
+    }
+}
+
+// Holds a spooled, noiseless plant at the target, then steps the Ki
+// multiplier through 0.5, 0, 1 and 2. The multiplier sets how fast the I term
+// moves, so no step may move the output, including the steps to and from 0.
+static void checkKiChangeAtHold(const ToolParams& tp) {
+    const float multipliers[] = {1.0f, 0.5f, 0.0f, 1.0f, 2.0f};
+    const int phases = (int)(sizeof(multipliers) / sizeof(multipliers[0]));
+    const uint32_t settleMs = 3000, holdMs = 500;
+    const float TOLERANCE_COUNTS = 0.5f;   // of 255
+
+    ToolParams run = tp;
+    gainScheduleReset(run.gainSchedule);
+    run.gainSchedule.enabled = 1;
+    ControlParams params;
+    toControlParams(run, params);
+    static ControlState state;
+    PlantModel model = defaultPlantModel();
+    model.noisekPa = 0.0f;
+    PlantState plant;
+    plantInit(plant, model);
+    controlInit(state, params, plantSensorVoltage(plant, model, params, plant.pressurekPa), 0);
+    ControlInput input = {};
+    input.targetkPa = run.targetkPa;
+    ControlOutput out;
+
+    float duty = 0, previousOutput = 0, worstStep = 0, worstHold = 0, integralAtFirstStep = 0;
+    int phase = 0;
+    for (uint32_t t = CONTROL_TASK_DELAY_MS; t <= settleMs + holdMs * (phases - 1); t += CONTROL_TASK_DELAY_MS) {
+        int nextPhase = t <= settleMs ? 0 : (int)((t - settleMs - 1) / holdMs) + 1;
+        bool stepped = nextPhase != phase;
+        phase = nextPhase;
+        for (int r = 0; r < GS_RATE_POINTS; r++) {
+            for (int e = 0; e < GS_ERROR_POINTS; e++) params.gainSchedule.ki[r][e] = multipliers[phase];
+        }
+        if (stepped && phase == 1) integralAtFirstStep = float(state.pid.integral);
+
+        float p = plantStep(plant, model, duty, true, 1.0e6f, CONTROL_TASK_DELAY_MS);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+
+        float change = fabsf(float(state.output) - previousOutput);
+        previousOutput = float(state.output);
+        if (stepped) {
+            if (change > worstStep) worstStep = change;
+        } else if (t + holdMs > settleMs && change > worstHold) {
+            worstHold = change;
+        }
+    }
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "largest output move on a Ki step %.3f counts, %.3f between steps; integral %.1f of %.1f",
+             worstStep, worstHold, integralAtFirstStep, params.maxIntegral);
+    check(worstStep <= TOLERANCE_COUNTS, "Ki change at hold", detail);
+}
+
+// Holds a spooled, noiseless plant at the target with the identifier learning,
+// then switches adaptive gains on with a nominal gain twice the identified one
+// and off again: the same jump of the scale as the estimate turning valid and
+// invalid. The scale slews, so no tick may move the output more than a
+// fraction of a count.
+static void checkGainScaleFlipAtHold(const ToolParams& tp) {
+    const uint32_t settleMs = 3000, holdMs = 3000;
+    const float TOLERANCE_COUNTS = 0.5f;   // of 255
+
+    ToolParams run = tp;
+    run.gainSchedule.enabled = 0;
+    run.adaptiveGains = 0;
+    ControlParams params;
+    toControlParams(run, params);
+    static ControlState state;
+    PlantModel model = defaultPlantModel();
+    model.noisekPa = 0.0f;
+    PlantState plant;
+    plantInit(plant, model);
+    controlInit(state, params, plantSensorVoltage(plant, model, params, plant.pressurekPa), 0);
+    ControlInput input = {};
+    input.targetkPa = run.targetkPa;
+    ControlOutput out;
+
+    float duty = 0, previousOutput = 0, worstMove = 0, peakScale = 1.0f;
+    for (uint32_t t = CONTROL_TASK_DELAY_MS; t <= settleMs + 2 * holdMs; t += CONTROL_TASK_DELAY_MS) {
+        if (t == settleMs + CONTROL_TASK_DELAY_MS) {
+            PlantEstimate estimate;
+            sysidEstimate(state.sysid, CONTROL_TASK_DELAY_MS, estimate);
+            params.nominalPlantGain = 2.0f * estimate.gainkPaPerPercent;
+            params.adaptiveGains = 1;
+        }
+        if (t == settleMs + holdMs + CONTROL_TASK_DELAY_MS) params.adaptiveGains = 0;
+
+        float p = plantStep(plant, model, duty, true, 1.0e6f, CONTROL_TASK_DELAY_MS);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+
+        float move = fabsf(float(state.output) - previousOutput);
+        previousOutput = float(state.output);
+        if (t > settleMs && move > worstMove) worstMove = move;
+        if (state.gainScale > peakScale) peakScale = state.gainScale;
+    }
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "largest output move %.3f counts while the scale went 1 -> %.2f -> %.2f",
+             worstMove, peakScale, state.gainScale);
+    check(worstMove <= TOLERANCE_COUNTS && peakScale > 1.5f, "gain scale flip at hold", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: gainschedule [--params FILE] [--set key=value]...\n");
+            return 1;
+        }
+    }
+
+    ToolParams fixed = tp;
+    fixed.gainSchedule.enabled = 0;
+    ToolParams scheduled = tp;
+    if (isFlat(scheduled.gainSchedule)) exampleSchedule(scheduled.gainSchedule);
+    scheduled.gainSchedule.enabled = 1;
+    printSchedule(scheduled.gainSchedule);
+
+    PlantCase cases[4];
+    for (PlantCase& c : cases) c.model = defaultPlantModel();
+    cases[0].name = "default";
+    cases[1].name = "fast_spool";   cases[1].model.spoolTimeMs = 900.0f;
+    cases[2].name = "slow_spool";   cases[2].model.spoolTimeMs = 2500.0f;
+    cases[3].name = "high_gain";    cases[3].model.maxBoostkPa = 180.0f;
+
+    // Single pulls are sensitive to where the noise falls, so each row averages
+    // several targets and noise seeds.
+    const float targetOffsets[] = {-20.0f, 0.0f, 20.0f};
+    const uint32_t seeds[] = {12345, 777, 31337, 4242, 9001};
+    const int pulls = (int)(sizeof(targetOffsets) / sizeof(targetOffsets[0]) * sizeof(seeds) / sizeof(seeds[0]));
+
+    printf("plant,gains,spool_score,torque_score,overshoot_kpa,settling_ms\n");
+    for (const PlantCase& c : cases) {
+        const ToolParams* runs[] = {&fixed, &scheduled};
+        const char* names[] = {"fixed", "scheduled"};
+        for (int k = 0; k < 2; k++) {
+            PullMetrics sum = {0, 0, 0, 0, 0, 0, 0};
+            for (float offset : targetOffsets) {
+                for (uint32_t seed : seeds) {
+                    ToolParams run = *runs[k];
+                    run.targetkPa += offset;
+                    PlantModel model = c.model;
+                    model.seed = seed;
+                    PullMetrics m;
+                    simulatePull(run, model, defaultPullProfile(), m);
+                    sum.spoolScore += m.spoolScore;
+                    sum.torqueScore += m.torqueScore;
+                    sum.overshootkPa += m.overshootkPa;
+                    sum.settlingMs += m.settlingMs;
+                }
+            }
+            printf("%s,%s,%.1f,%.1f,%.2f,%.0f\n", c.name, names[k], sum.spoolScore / pulls,
+                   sum.torqueScore / pulls, sum.overshootkPa / pulls, sum.settlingMs / pulls);
+        }
+    }
+
+    checkKiChangeAtHold(tp);
+    checkGainScaleFlipAtHold(tp);
+    return checkExitCode();
+}
@@ -0,0 +1,399 @@
+//================================================================================
+// HEAP CHECK
+//================================================================================
+// Wraps the host's allocator the way heap_hook.cpp wraps the firmware's
+// (src/heap_guard.h) and runs a whole drive cycle with it armed:
+//   - the hook sees malloc, calloc, realloc, new and std::string, so a zero
+//     below means something
+//   - a drive cycle allocates nothing: engine off until the pipeline and the
+//     board go idle, an engine start, pulls with the RPM and speed inputs
+//     on, a relay autotune on the first, overboost cuts cleared between
+//     them, then engine off and idle again. Every tick goes through what the
+//     firmware runs per tick: the ADC averager and oversampling policy,
+//     controlStep(), the overboost check, the sensor fault log, plant
+//     identification, the idle power policy, the telemetry line and an info
+//     screen's text wrapping
+//   - the text wrapping keeps every line within the width and breaks at
+//     spaces, splitting only a word that cannot fit
+//   - the guard only asks for an abort when armed with abortOnAllocation
+// --pulls N sets the number of pulls (default 8).
+//
+//   heap [--pulls N] [--params FILE] [--set key=value]...
+//
+// Build with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see README).
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "autotune.h"
+#include "check.h"
+#include "control.h"
+#include "heap_guard.h"
+#include "plant_sim.h"
+#include "power.h"
+#include "textwrap.h"
+#include "tool_params.h"
+
+//================================================================================
+// ALLOCATOR HOOK
+//================================================================================
+static HeapGuard guard;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    if (heapGuardRecord(guard, size)) abort();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    if (heapGuardRecord(guard, count * size)) abort();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (heapGuardRecord(guard, size)) abort();
+    return __real_realloc(ptr, size);
+}
+}
+
+// libstdc++'s own operator new calls malloc from inside the shared library,
+// where --wrap does not reach, so new is replaced to go through the wrap.
+// Not inlined, so the compiler does not see new paired with free().
+__attribute__((noinline)) void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+__attribute__((noinline)) void* operator new[](size_t size) { return operator new(size); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete[](void* p, size_t) noexcept { free(p); }
+
+//================================================================================
+// DRIVE CYCLE
+//================================================================================
+static const float CRUISE_VACUUM_KPA = 40.0f;
+static const uint32_t THROTTLE_RAMP_MS = 300;   // closed throttle vacuum to the plant's pressure and back
+static const uint32_t ENGINE_OFF_MS = 70000;     // long enough for the pipeline and then the board to go idle
+static const int WINDOW = 64;
+static const float SPEED_PULSES_PER_KM = 4000.0f;
+static const int LINE_CHARS = 128 / TEXT_CHAR_WIDTH;   // SCREEN_WIDTH in definitions.h
+
+static const char* const INFO_TEXT =
+    "Idle Power: Once asleep, 1 = slow CPU and sampling, 2 = also light sleep (no USB serial). 0 = off.";
+
+struct CycleResult {
+    uint32_t ticks;
+    uint32_t timeMs;
+    float peakkPa;
+    int idleEntries;
+    int wakes;
+    int faultsRaised;
+    uint32_t guardChecks;
+    uint32_t overboostTrips;
+    bool autotuneRelayed;
+    size_t telemetryBytes;
+    int wrappedLines;
+};
+
+static float clamp01(float x) {
+    return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+static void pushConversions(SensorAverager& averager, int channel, float pinVoltage, uint32_t& rng) {
+    float code = pinVoltage / ADC_VOLTS_PER_CODE;
+    for (int i = 0; i < WINDOW; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        float dithered = code + (float)((rng >> 16) & 3) - 1.5f;
+        if (dithered < 0.0f) dithered = 0.0f;
+        if (dithered > 4095.0f) dithered = 4095.0f;
+        sensorAveragerPush(averager, channel, (uint16_t)dithered);
+    }
+}
+
+// The whole cycle, armed after everything the firmware sets up in setup().
+static void runDriveCycle(const ToolParams& tp, int pulls, HeapGuard& armed, CycleResult& r) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantModel model = defaultPlantModel();
+    PullProfile pull = defaultPullProfile();
+    PlantState plant;
+    plantInit(plant, model);
+
+    static ControlState state;
+    static SensorAverager averager;
+    static SensorFaultLog faultLog;
+    OversamplePolicy oversample;
+    OverboostMonitor monitor;
+    Autotuner tuner = {};
+    PowerPolicy power;
+    sensorAveragerInit(averager, WINDOW);
+    oversamplePolicyInit(oversample, WINDOW);
+    sensorAveragerSetSpikeWindow(averager, SPIKE_WINDOW_DEFAULT);
+    overboostInit(monitor);
+    sensorFaultLogClear(faultLog);
+    uint32_t rng = 12345;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) pushConversions(averager, c, 1.0f, rng);
+    SensorSample sample;
+    sensorAveragerSample(averager, 0, sample);
+    controlInit(state, params, plantSensorVoltage(plant, model, params, 100.0f), 0);
+    powerPolicyInit(power, 0);
+    AutotuneConfig autotuneConfig = {100.0f, 0.0f, 1.0f, 25.0f, 30.0f, 8000, 4, AUTOTUNE_RULE_ZIEGLER_NICHOLS};
+    static char telemetryLine[256];
+    char displayLine[LINE_CHARS + 1];
+
+    memset(&r, 0, sizeof(r));
+    const uint32_t cycleMs = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+    const uint32_t startMs = ENGINE_OFF_MS;
+    const uint32_t stopMs = startMs + 2000 + cycleMs * pulls;
+    const uint32_t endMs = stopMs + ENGINE_OFF_MS;
+    float drive = 0.0f;
+    float rpmPulses = 0.0f, speedPulses = 0.0f;
+    float dividerRatio = R2_OHMS / (R1_OHMS + R2_OHMS);
+    PowerDecision decision = {false, false, CONTROL_TASK_DELAY_MS, 0};
+    uint32_t lastMs = 0;
+    int lastPull = -1;
+    heapGuardArm(armed, false);
+
+    for (uint32_t t = CONTROL_TASK_DELAY_MS; t <= endMs; t += decision.tickMs) {
+        float dtMs = (float)(t - lastMs);
+        lastMs = t;
+        bool running = t >= startMs && t < stopMs;
+        bool throttleOpen = false;
+        float blend = 1.0f;   // 0 = closed-throttle vacuum, 1 = the plant's pressure
+        float msSinceThrottle = 0.0f;
+        float rpm = 0.0f;
+        if (t >= startMs + 2000 && t < stopMs) {
+            uint32_t inCycle = (t - startMs - 2000) % cycleMs;
+            int pullIndex = (int)((t - startMs - 2000) / cycleMs);
+            throttleOpen = inCycle >= pull.throttleOpenMs && inCycle < pull.throttleOpenMs + pull.pullMs;
+            msSinceThrottle = (float)inCycle - (float)pull.throttleOpenMs;
+            if (throttleOpen) blend = clamp01(msSinceThrottle / THROTTLE_RAMP_MS);
+            else if (inCycle >= pull.throttleOpenMs + pull.pullMs) blend = clamp01(1.0f - (msSinceThrottle - pull.pullMs) / THROTTLE_RAMP_MS);
+            else blend = 0.0f;
+            rpm = throttleOpen ? 2500.0f + 4000.0f * clamp01(msSinceThrottle / pull.pullMs) : 1500.0f;
+            if (pullIndex != lastPull) {
+                // The stock tune overshoots into the cut, and the tune lifting out
+                // holds the wastegate open; the driver clears both before the next pull.
+                overboostClear(monitor);
+                if (tuner.phase == AUTOTUNE_DONE || tuner.phase == AUTOTUNE_ABORTED) tuner.phase = AUTOTUNE_IDLE;
+                if (pullIndex == 0) autotuneStart(tuner, autotuneConfig);
+                lastPull = pullIndex;
+            }
+        } else if (running) {
+            blend = 1.0f - clamp01((float)(t - startMs) / THROTTLE_RAMP_MS);   // the engine starting
+            rpm = 900.0f;
+        }
+        float plantkPa = plantStep(plant, model, drive, throttleOpen, msSinceThrottle, dtMs);
+        float truekPa = running ? CRUISE_VACUUM_KPA + (plantkPa - CRUISE_VACUUM_KPA) * blend : plantkPa;
+
+        // -- readSensorSample() --
+        pushConversions(averager, SENSOR_MAP, plantSensorVoltage(plant, model, params, truekPa), rng);
+        pushConversions(averager, SENSOR_BACKPRESSURE, 1.0f + 0.004f * truekPa, rng);
+        pushConversions(averager, SENSOR_IAT, 1.6f, rng);
+        pushConversions(averager, SENSOR_SUPPLY, 13.8f * dividerRatio, rng);
+        int window = oversamplePolicyUpdate(oversample, averager, SENSOR_MAP, OVERSAMPLE_MIN_DEFAULT, WINDOW);
+        sensorAveragerSetWindow(averager, window);
+        sensorAveragerSample(averager, t, sample);
+
+        // -- the control task's tick --
+        rpmPulses += rpm / 60000.0f * params.rpm.pulsesPerRev * dtMs;
+        speedPulses += (rpm / 60.0f) * SPEED_PULSES_PER_KM / 3600000.0f * dtMs;
+        ControlInput input = {};
+        input.timeMs = t;
+        input.measuredVoltage = sample.voltage[SENSOR_MAP];
+        input.sensors = &sample;
+        input.targetkPa = tp.targetkPa;
+        input.previousDutyPercent = drive;
+        input.rpmPulses = (uint32_t)rpmPulses;
+        input.speedPulses = (uint32_t)speedPulses;
+        rpmPulses -= (float)input.rpmPulses;
+        speedPulses -= (float)input.speedPulses;
+        ControlOutput out;
+        controlStep(state, params, input, out);
+        if (out.sensorFaultRaised != SENSOR_FAULT_NONE) {
+            SensorFaultRecord record = {out.sensorFaultRaised, t, input.measuredVoltage, state.sensorFault.detail};
+            sensorFaultLogAdd(faultLog, record);
+            r.faultsRaised++;
+        }
+        float localControlPercent = out.controlPercent;
+        drive = out.solenoidPercent;
+        if (!state.solenoidDisabledByIdle) autotuneStep(tuner, out.currentPressure, input.targetkPa, t, localControlPercent);
+        if (localControlPercent != out.controlPercent) drive = controlSolenoidPercent(state, params, localControlPercent);
+        PlantEstimate estimate;
+        sysidEstimate(state.sysid, CONTROL_TASK_DELAY_MS, estimate);
+
+        // -- the overboost guard, once per tick here --
+        float guardVoltage;
+        if (sensorAveragerRecent(averager, SENSOR_MAP, OVERBOOST_WINDOW, guardVoltage)) {
+            if (overboostCheck(monitor, out.overboostLimit, guardVoltage, t * 1000)) drive = 0.0f;
+            overboostCheckDone(monitor, t * 1000, t * 1000 + 20);
+        }
+
+        PowerInput powerInput = {t, POWER_SETTING_SCALING, state.solenoidDisabledByIdle, false, out.rawPressure, WINDOW,
+                                 CONTROL_TASK_DELAY_MS};
+        powerPolicyUpdate(power, powerInput, decision);
+        if (decision.enterIdle) r.idleEntries++;
+        if (decision.exitIdle) r.wakes++;
+
+        // -- the display and input task --
+        int length = snprintf(telemetryLine, sizeof(telemetryLine), "%lu,%.2f,%.1f,%.1f,%.3f,%.2f,%.5f,%.5f,%.3f,%.3f,%.0f,%d\n",
+                              (unsigned long)t, out.currentPressure, out.targetkPa, localControlPercent, state.gainScale,
+                              state.dutyCeiling, estimate.a, estimate.b, estimate.c, estimate.gainkPaPerPercent,
+                              estimate.timeConstantMs, estimate.valid ? 1 : 0);
+        r.telemetryBytes += (size_t)length;
+        const char* rest = INFO_TEXT;
+        while (*rest) {
+            const char* next;
+            int lineLength = textWrapLine(rest, LINE_CHARS, &next);
+            memcpy(displayLine, rest, lineLength);
+            displayLine[lineLength] = '\0';
+            r.wrappedLines++;
+            rest = next;
+        }
+
+        if (out.currentPressure > r.peakkPa) r.peakkPa = out.currentPressure;
+        if (tuner.phase == AUTOTUNE_RELAY) r.autotuneRelayed = true;
+        r.ticks++;
+        r.timeMs = t;
+    }
+    heapGuardDisarm(armed);
+    r.guardChecks = monitor.checks;
+    r.overboostTrips = monitor.trips;
+}
+
+//================================================================================
+// CHECKS
+//================================================================================
+// Keeps the compiler from eliding the allocations below.
+static void* volatile sink;
+
+static void checkHook() {
+    heapGuardArm(guard, false);
+    void* block = malloc(24);
+    void* zeroed = calloc(4, 8);
+    block = realloc(block, 48);
+    int* numbers = new int[4];
+    std::string* text = new std::string(40, 'x');
+    sink = zeroed;
+    sink = block;
+    sink = numbers;
+    sink = text->data();
+    heapGuardDisarm(guard);
+    uint32_t seen = guard.allocations;
+    delete text;
+    delete[] numbers;
+    free(zeroed);
+    free(block);
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%lu allocations seen, %lu bytes, largest %lu", (unsigned long)seen, (unsigned long)guard.bytes,
+             (unsigned long)guard.largest);
+    check(seen >= 6 && guard.largest >= 48, "hook sees allocations", detail);
+}
+
+static void checkDriveCycle(const ToolParams& tp, int pulls) {
+    CycleResult r;
+    runDriveCycle(tp, pulls, guard, r);
+    bool exercised = r.peakkPa > tp.targetkPa - 10.0f && r.idleEntries >= 2 && r.wakes >= 1 && r.guardChecks == r.ticks &&
+                     r.overboostTrips >= 1 && r.autotuneRelayed && r.wrappedLines > 0;
+    char detail[240];
+    snprintf(detail, sizeof(detail), "%lu allocations (%lu bytes) over %lu ticks, %.1f min: %d pulls, peak %.1f kPa, idle %d times, "
+             "%lu cuts", (unsigned long)guard.allocations, (unsigned long)guard.bytes, (unsigned long)r.ticks, r.timeMs / 60000.0,
+             pulls, r.peakkPa, r.idleEntries, (unsigned long)r.overboostTrips);
+    check(guard.allocations == 0 && exercised, "drive cycle allocates nothing", detail);
+}
+
+static void checkTextWrap() {
+    static const char* const samples[] = {
+        INFO_TEXT,
+        "Sleep Delay (s): Idle time at atmos before screen/solenoid turns off.",
+        "exactly twenty-one ch and then some",
+        "a_single_word_far_longer_than_one_line_of_the_screen",
+        "  leading spaces",
+        "",
+    };
+    bool ok = true;
+    int lines = 0, splits = 0;
+    for (const char* text : samples) {
+        const char* rest = text;
+        while (*rest == ' ') rest++;
+        std::string rebuilt;
+        while (*rest) {
+            const char* next;
+            int length = textWrapLine(rest, LINE_CHARS, &next);
+            ok = ok && length > 0 && length <= LINE_CHARS && next > rest;
+            // A line ends at a space or the end unless the word is too long for any line.
+            bool atBreak = rest[length] == '\0' || rest[length] == ' ';
+            if (!atBreak) {
+                splits++;
+                ok = ok && memchr(rest, ' ', length) == nullptr;
+            }
+            rebuilt.append(rest, length);
+            rebuilt += atBreak ? " " : "";
+            rest = next;
+            lines++;
+        }
+        // The words come back in order, with single spaces.
+        std::string words;
+        bool space = false;
+        for (const char* p = text; *p; p++) {
+            if (*p == ' ') { space = !words.empty(); continue; }
+            if (space) words += ' ';
+            space = false;
+            words += *p;
+        }
+        while (!rebuilt.empty() && rebuilt.back() == ' ') rebuilt.pop_back();
+        ok = ok && rebuilt == words;
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%d lines of at most %d characters, %d split inside a word", lines, LINE_CHARS, splits);
+    check(ok && splits == 2, "text wrapping", detail);
+}
+
+static void checkAbortMode() {
+    HeapGuard g;
+    heapGuardInit(g);
+    bool disarmed = !heapGuardRecord(g, 8) && g.allocations == 0;
+    heapGuardArm(g, false);
+    bool counting = !heapGuardRecord(g, 8) && g.allocations == 1;
+    heapGuardArm(g, true);
+    bool aborting = heapGuardRecord(g, 8) && g.allocations == 1;
+    check(disarmed && counting && aborting, "abort only when asked", "disarmed ignores, counting counts, abort mode aborts");
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    tp.rpmInputEnabled = 1;
+    tp.speedPulsesPerKm = SPEED_PULSES_PER_KM;
+    int pulls = 8;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--pulls") ok = (pulls = atoi(value.c_str())) > 0;
+        else if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    heapGuardInit(guard);
+    checkHook();
+    checkDriveCycle(tp, pulls);
+    checkTextWrap();
+    checkAbortMode();
+    return checkExitCode();
+}
@@ -0,0 +1,232 @@
+//================================================================================
+// SINGLE-PRECISION KERNEL CHECK
+//================================================================================
+// Compares the float-only conversions of the control path (src/numeric.h)
+// with the forms they replaced, which divided per reading and promoted to
+// double, against a double-precision reference:
+//   - the pressure map's slope and offset give the same kPa as fmap() to
+//     within 0.001 kPa across the sensor range, offset included
+//   - ADC codes to volts by ADC_VOLTS_PER_CODE are within 1 uV of code / 4095 * 3.3
+//   - PID output to duty % and milliseconds to seconds by a constant factor
+//     agree to float rounding
+// It then times one tick's worth of these conversions in each form, and a
+// whole controlStep() through a simulated pull, in ns and (on x86) TSC ticks.
+// On the host the FPU does double in hardware, so the gap is far smaller than
+// on the ESP32-S3; the serial command "bench" times controlStep() on target.
+// --ticks N sets how many ticks each is timed over.
+//
+//   numeric [--params FILE] [--set key=value]... [--ticks N]
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycleCount() { return __rdtsc(); }
+#else
+static uint64_t cycleCount() { return 0; }   // no counter; the column reads 0
+#endif
+
+//================================================================================
+// ACCURACY
+//================================================================================
+static void checkPressureMap(const ControlParams& params) {
+    LinearMap map = pressureMapFor(params);
+    double worstMap = 0, worstFmap = 0;
+    for (int i = 0; i <= 10000; i++) {
+        float v = params.minSensorVoltage - 0.1f + (params.maxSensorVoltage - params.minSensorVoltage + 0.2f) * i / 10000;
+        double exact = ((double)v - params.minSensorVoltage) * ((double)params.MAX_KPA - params.MIN_KPA) /
+                           ((double)params.maxSensorVoltage - params.minSensorVoltage) + params.MIN_KPA + params.PRESSURE_CORRECTION_KPA;
+        float viaFmap = fmap(v, params.minSensorVoltage, params.maxSensorVoltage, params.MIN_KPA, params.MAX_KPA) +
+                        params.PRESSURE_CORRECTION_KPA;
+        worstMap = fmax(worstMap, fabs(linearMapApply(map, v) - exact));
+        worstFmap = fmax(worstFmap, fabs(viaFmap - exact));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error=%.2e kPa (fmap %.2e)", worstMap, worstFmap);
+    check(worstMap < 1e-3, "pressure map", detail);
+}
+
+static void checkConstants() {
+    double worstVolts = 0;
+    for (int sum = 0; sum <= 4095 * 64; sum += 7) {
+        float code = (float)sum / 64;
+        double exact = (double)sum / 64 / 4095.0 * 3.3;
+        worstVolts = fmax(worstVolts, fabs(code * ADC_VOLTS_PER_CODE - exact));
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error=%.2e V", worstVolts);
+    check(worstVolts < 1e-6, "ADC codes to volts", detail);
+
+    double worstPercent = 0, worstSeconds = 0;
+    for (int i = 0; i <= 25500; i++) {
+        float output = i * 0.01f;
+        worstPercent = fmax(worstPercent, fabs(output * OUTPUT_PERCENT_PER_COUNT - (double)output * 100.0 / 255.0));
+    }
+    for (uint32_t ms = 1; ms < 100000; ms += 13) {
+        worstSeconds = fmax(worstSeconds, fabs(ms * SECONDS_PER_MS - ms / 1000.0) / (ms / 1000.0));
+    }
+    snprintf(detail, sizeof(detail), "duty max_error=%.2e %%, seconds max relative error=%.2e", worstPercent, worstSeconds);
+    check(worstPercent < 1e-4 && worstSeconds < 1e-6, "constant factors", detail);
+}
+
+//================================================================================
+// BENCHMARK
+//================================================================================
+// Inputs differ from tick to tick so nothing folds away.
+struct TickInput {
+    uint32_t sums[SENSOR_CHANNEL_COUNT];
+    float filteredVoltage;
+    float pressureStep;
+    uint32_t elapsedMs;
+    float output;
+};
+
+static const int INPUT_COUNT = 1024;
+static TickInput inputs[INPUT_COUNT];
+static volatile float benchSink;
+
+// The conversions as the control task used to write them.
+static float promotedTick(const ControlParams& params, const TickInput& in) {
+    float volts[SENSOR_CHANNEL_COUNT];
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) volts[c] = (in.sums[c] / 64.0) / 4095.0 * 3.3;
+    float sensorVoltage = volts[SENSOR_MAP] - params.scaledVoltageOffset;
+    float raw = fmap(sensorVoltage, params.minSensorVoltage, params.maxSensorVoltage, params.MIN_KPA, params.MAX_KPA) + params.PRESSURE_CORRECTION_KPA;
+    float filtered = fmap(in.filteredVoltage, params.minSensorVoltage, params.maxSensorVoltage, params.MIN_KPA, params.MAX_KPA) + params.PRESSURE_CORRECTION_KPA;
+    float rate = (in.pressureStep / in.elapsedMs) * 1000.0;
+    float average = (raw + filtered) / 2.0;
+    float area = (average - 100.0) * in.elapsedMs;
+    area -= (average - filtered) * in.elapsedMs * 2.0;
+    float dt = in.elapsedMs / 1000.0;
+    float percent = fmap(in.output, 0.0, 255.0, 0.0, 100.0);
+    return volts[SENSOR_BACKPRESSURE] + volts[SENSOR_IAT] + volts[SENSOR_SUPPLY] + rate + area / 1000.0 + dt + percent;
+}
+
+static float floatTick(const ControlParams& params, const TickInput& in) {
+    float volts[SENSOR_CHANNEL_COUNT];
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) volts[c] = (float)in.sums[c] / 64 * ADC_VOLTS_PER_CODE;
+    LinearMap map = pressureMapFor(params);
+    float sensorVoltage = volts[SENSOR_MAP] - params.scaledVoltageOffset;
+    float raw = linearMapApply(map, sensorVoltage);
+    float filtered = linearMapApply(map, in.filteredVoltage);
+    float rate = (in.pressureStep / in.elapsedMs) * MS_PER_SECOND;
+    float average = (raw + filtered) * 0.5f;
+    float area = (average - 100.0f) * in.elapsedMs;
+    area -= (average - filtered) * in.elapsedMs * 2.0f;
+    float dt = in.elapsedMs * SECONDS_PER_MS;
+    float percent = in.output * OUTPUT_PERCENT_PER_COUNT;
+    return volts[SENSOR_BACKPRESSURE] + volts[SENSOR_IAT] + volts[SENSOR_SUPPLY] + rate + area * SECONDS_PER_MS + dt + percent;
+}
+
+struct Timing {
+    double ns, cycles;
+};
+
+template <typename Tick>
+static Timing timeTicks(const ControlParams& params, int ticks, Tick tick) {
+    float sum = 0;
+    uint64_t startCycles = cycleCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) sum += tick(params, inputs[i & (INPUT_COUNT - 1)]);
+    auto end = std::chrono::steady_clock::now();
+    uint64_t cycles = cycleCount() - startCycles;
+    benchSink = sum;
+    return {std::chrono::duration<double, std::nano>(end - start).count() / ticks, (double)cycles / ticks};
+}
+
+// One pull through the pipeline, repeated until ticks have run.
+static Timing timeControlStep(const ControlParams& params, int ticks) {
+    static ControlState state;
+    PlantModel model = defaultPlantModel();
+    PullProfile pull = defaultPullProfile();
+    const int pullTicks = (int)((pull.throttleOpenMs + pull.pullMs + pull.coastMs) / CONTROL_TASK_DELAY_MS);
+    static float volts[4096];
+    int count = pullTicks < 4096 ? pullTicks : 4096;
+    PlantState plant;
+    plantInit(plant, model);
+    for (int i = 0; i < count; i++) {
+        uint32_t ms = (uint32_t)i * CONTROL_TASK_DELAY_MS;
+        bool open = ms >= pull.throttleOpenMs && ms < pull.throttleOpenMs + pull.pullMs;
+        float kPa = plantStep(plant, model, open ? 60.0f : 0.0f, open, (float)ms - pull.throttleOpenMs, CONTROL_TASK_DELAY_MS);
+        volts[i] = plantSensorVoltage(plant, model, params, kPa);
+    }
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = 170.0f;
+    double ns = 0, cycles = 0;
+    for (int done = 0; done < ticks;) {
+        controlInit(state, params, volts[0], 0);
+        int run = ticks - done < count ? ticks - done : count;
+        uint64_t startCycles = cycleCount();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i < run; i++) {
+            input.timeMs = (uint32_t)i * CONTROL_TASK_DELAY_MS;
+            input.measuredVoltage = volts[i];
+            input.previousDutyPercent = out.solenoidPercent;
+            controlStep(state, params, input, out);
+        }
+        auto end = std::chrono::steady_clock::now();
+        cycles += (double)(cycleCount() - startCycles);
+        ns += std::chrono::duration<double, std::nano>(end - start).count();
+        done += run;
+    }
+    benchSink = out.currentPressure;
+    return {ns / ticks, cycles / ticks};
+}
+
+static void benchmark(const ControlParams& params, int ticks) {
+    uint32_t rng = 99;
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+            rng = rng * 1664525u + 1013904223u;
+            inputs[i].sums[c] = (rng >> 8) % (4095 * 64);
+        }
+        inputs[i].filteredVoltage = params.minSensorVoltage + (params.maxSensorVoltage - params.minSensorVoltage) * (i % 97) / 97;
+        inputs[i].pressureStep = (float)(i % 31) - 15.0f;
+        inputs[i].elapsedMs = CONTROL_TASK_DELAY_MS + (i % 3);
+        inputs[i].output = (float)(i % 256);
+    }
+    Timing promoted = timeTicks(params, ticks, promotedTick);
+    Timing single = timeTicks(params, ticks, floatTick);
+    Timing step = timeControlStep(params, ticks / 16 > 1000 ? ticks / 16 : 1000);
+    printf("\nkernel,ns_per_tick,tsc_per_tick\n");
+    printf("promoted conversions,%.2f,%.1f\n", promoted.ns, promoted.cycles);
+    printf("float conversions,%.2f,%.1f\n", single.ns, single.cycles);
+    printf("controlStep,%.2f,%.1f\n", step.ns, step.cycles);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    int ticks = 4000000;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--ticks") ok = (ticks = atoi(value.c_str())) > 0;
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: numeric [--params FILE] [--set key=value]... [--ticks N]\n");
+            return 1;
+        }
+    }
+
+    ControlParams params;
+    toControlParams(tp, params);
+    checkPressureMap(params);
+    checkConstants();
+    benchmark(params, ticks);
+    return checkExitCode();
+}
@@ -0,0 +1,355 @@
+//================================================================================
+// OVERBOOST CUT CHECK
+//================================================================================
+// Exercises the overboost guard (src/overboost.h) against the control
+// pipeline, on a microsecond clock:
+//   - the ceiling is the target plus the limiter overhead and margin, clamped
+//     to what the sensor can read, off with no margin, and the limit's voltage
+//     line reproduces voltageToPressure()
+//   - a reading over the ceiling in one check does not trip the guard; two in
+//     a row do, it stays latched until cleared, and re-trips after a clear
+//   - with the control task hung for 400 ms, the valve held open, once the
+//     turbo has spooled, the pin goes low within OVERBOOST_LATENCY_BOUND_US of
+//     the true pressure crossing the ceiling, with and without timer jitter,
+//     the guard's own latency figure agrees, the cut holds through the rest of
+//     the pull, and the peak is lower than with the guard off
+//   - normal pulls with 100 us full-scale glitches on the MAP channel, enough
+//     to put single checks over the ceiling, never trip it
+//
+// The ADC scan delivers a MAP conversion every 50 us (20 kHz per channel) into
+// the same SensorAverager the firmware drains; the control task averages the
+// firmware's default OVERSAMPLE_COUNT of them every 10 ms unless stalled, the
+// plant advances every 1 ms, and the guard checks every OVERBOOST_PERIOD_US
+// plus a random delay of up to the jitter. Spike rejection is left off, so the
+// glitches reach the guard. The overshoot limiter is on unless --set says
+// otherwise, as untuned the synthetic plant overshoots by more than the
+// default margin; the stall runs use a noise-free sensor.
+//
+//   overboost [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static const uint32_t CONVERSION_US = 50;
+static const int FIRMWARE_OVERSAMPLE_COUNT = 64;
+static const uint32_t CHECK_COST_US = 30;        // reading the scan to writing the pin
+static const uint32_t STALL_MS = 400;
+static const uint32_t GLITCH_EVERY = 137;        // conversions, ~7 ms, drifting across the checks
+static const int GLITCH_CONVERSIONS = 2;
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static float pinVoltageFor(const ControlParams& params, float pressurekPa) {
+    float v = fmap(pressurekPa - params.PRESSURE_CORRECTION_KPA, params.MIN_KPA, params.MAX_KPA, params.minSensorVoltage,
+                   params.maxSensorVoltage);
+    return v + params.scaledVoltageOffset;
+}
+
+struct PullRun {
+    bool guard;
+    bool stall;
+    bool glitches;
+    uint32_t jitterUs;
+    uint32_t seed;
+    float targetkPa;
+};
+
+struct PullResult {
+    bool stalled;
+    float ceilingkPa;
+    int64_t crossUs;           // true pressure first at or over the ceiling
+    int64_t cutUs;             // pin written low
+    float peakkPa;             // true pressure, whole pull
+    bool heldLow;              // the pin never went high again after the cut
+    bool trippedAtEnd;
+    int singleOverChecks;      // checks over the ceiling that did not trip
+    OverboostMonitor monitor;
+};
+
+static void runPull(const ToolParams& tp, const PullRun& run, PullResult& r) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantModel model = defaultPlantModel();
+    model.seed = run.seed;
+    // Near the ceiling the pressure rises a fraction of the noise per
+    // millisecond, so with noise the crossing is not one instant.
+    if (run.stall) model.noisekPa = 0.0f;
+    PullProfile pull = defaultPullProfile();
+
+    static ControlState state;
+    static SensorAverager averager;
+    sensorAveragerInit(averager, FIRMWARE_OVERSAMPLE_COUNT);
+    PlantState plant;
+    plantInit(plant, model);
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), 0);
+
+    OverboostMonitor& monitor = r.monitor;
+    overboostInit(monitor);
+    OverboostLimit limit = {0.0f, 0.0f, 0.0f};
+    uint32_t jitterRng = run.seed * 2654435761u + 1;
+
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = run.targetkPa;
+    float drive = 0.0f;
+    bool pinLow = false;             // held low by the guard
+    int64_t stallEndUs = -1;
+    uint32_t conversions = 0;
+    uint32_t nominalCheckUs = OVERBOOST_PERIOD_US;
+    uint32_t nextCheckUs = nominalCheckUs;
+    int previousOverChecks = 0;
+
+    r.stalled = false;
+    r.ceilingkPa = 0.0f;
+    r.crossUs = -1;
+    r.cutUs = -1;
+    r.peakkPa = truePressure;
+    r.heldLow = true;
+    r.singleOverChecks = 0;
+
+    const uint32_t endUs = (pull.throttleOpenMs + pull.pullMs + pull.coastMs) * 1000;
+    const uint32_t liftUs = (pull.throttleOpenMs + pull.pullMs) * 1000;
+    for (uint32_t t = CONVERSION_US; t <= endUs; t += CONVERSION_US) {
+        float applied = pinLow ? 0.0f : drive;
+
+        // -- Plant --
+        if (t % 1000 == 0) {
+            bool throttleOpen = t >= pull.throttleOpenMs * 1000 && t < liftUs;
+            float msSinceThrottle = (float)(t / 1000) - (float)pull.throttleOpenMs;
+            truePressure = plantStep(plant, model, applied, throttleOpen, msSinceThrottle, 1.0f);
+            if (truePressure > r.peakkPa) r.peakkPa = truePressure;
+            if (r.crossUs < 0 && limit.ceilingkPa > 0.0f && truePressure >= limit.ceilingkPa) r.crossUs = t;
+        }
+
+        // -- ADC scan --
+        float v = plantSensorVoltage(plant, model, params, truePressure);
+        if (run.glitches && conversions % GLITCH_EVERY < (uint32_t)GLITCH_CONVERSIONS) v = ADC_FULL_SCALE_VOLTS;
+        float code = roundf(v / ADC_FULL_SCALE_VOLTS * ADC_FULL_SCALE_CODE);
+        if (code < 0.0f) code = 0.0f;
+        if (code > ADC_FULL_SCALE_CODE) code = ADC_FULL_SCALE_CODE;
+        sensorAveragerPush(averager, SENSOR_MAP, (uint16_t)code);
+        conversions++;
+
+        // -- Control task --
+        if (t % (CONTROL_TASK_DELAY_MS * 1000) == 0) {
+            if (run.stall && !r.stalled && t >= (pull.throttleOpenMs + (uint32_t)model.spoolTimeMs) * 1000) {
+                r.stalled = true;
+                stallEndUs = (int64_t)t + STALL_MS * 1000;
+            }
+            if (stallEndUs < 0 || (int64_t)t >= stallEndUs) {
+                SensorSample sample;
+                sensorAveragerSample(averager, t / 1000, sample);
+                input.timeMs = t / 1000;
+                input.measuredVoltage = sample.voltage[SENSOR_MAP];
+                input.previousDutyPercent = applied;
+                controlStep(state, params, input, out);
+                if (run.guard) limit = out.overboostLimit;
+                else r.ceilingkPa = out.overboostLimit.ceilingkPa;
+                drive = monitor.tripped ? 0.0f : out.solenoidPercent;
+            } else {
+                drive = 100.0f;      // hung with the valve held open
+            }
+        }
+        if (limit.ceilingkPa > 0.0f) r.ceilingkPa = limit.ceilingkPa;
+
+        // -- Guard --
+        if (run.guard && t >= nextCheckUs) {
+            float recent;
+            if (sensorAveragerRecent(averager, SENSOR_MAP, OVERBOOST_WINDOW, recent)) {
+                bool cut = overboostCheck(monitor, limit, recent, t);
+                if (cut && !pinLow) r.cutUs = t + CHECK_COST_US;
+                if (cut) pinLow = true;
+                overboostCheckDone(monitor, t, t + CHECK_COST_US);
+                if (monitor.overChecks == 0 && previousOverChecks > 0 && !monitor.tripped) r.singleOverChecks++;
+                previousOverChecks = monitor.overChecks;
+            }
+            nominalCheckUs += OVERBOOST_PERIOD_US;
+            nextCheckUs = nominalCheckUs + (run.jitterUs ? nextRandom(jitterRng) % (run.jitterUs + 1) : 0);
+        }
+        // Once the control task is back it must keep the solenoid off too.
+        if (r.cutUs >= 0 && (!monitor.tripped || drive > 0.0f) && (stallEndUs < 0 || (int64_t)t >= stallEndUs))
+            r.heldLow = false;
+    }
+    r.trippedAtEnd = monitor.tripped;
+}
+
+static void checkCeiling(const ToolParams& tp) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    ControlInput input = {};
+    ControlOutput out;
+    float idleVoltage = pinVoltageFor(params, 100.0f);
+    controlInit(state, params, idleVoltage, 0);
+    input.measuredVoltage = idleVoltage;
+    input.targetkPa = tp.targetkPa;
+    input.timeMs = CONTROL_TASK_DELAY_MS;
+    controlStep(state, params, input, out);
+    OverboostLimit limit = out.overboostLimit;
+
+    float worstLine = 0.0f;
+    for (int k = 0; k <= 33; k++) {
+        float pin = k * 0.1f;
+        float expected = voltageToPressure(params, pin - params.scaledVoltageOffset);
+        worstLine = fmaxf(worstLine, fabsf(overboostPressure(limit, pin) - expected));
+    }
+    float overhead = params.PID_Control_Overhead > 0.0f ? params.PID_Control_Overhead : 0.0f;
+    float expected = tp.targetkPa + overhead + tp.overboostMarginkPa;
+    bool plainOk = tp.overboostMarginkPa <= 0.0f ? limit.ceilingkPa == 0.0f : fabsf(limit.ceilingkPa - expected) < 1e-3f;
+
+    ControlParams off = params;
+    off.overboostMarginkPa = 0.0f;
+    controlInit(state, off, idleVoltage, 0);
+    controlStep(state, off, input, out);
+    float offCeiling = out.overboostLimit.ceilingkPa;
+
+    ControlParams high = params;
+    high.overboostMarginkPa = OVERBOOST_MARGIN_MAX_KPA;
+    ControlInput highInput = input;
+    highInput.targetkPa = params.MAX_KPA;
+    controlInit(state, high, idleVoltage, 0);
+    controlStep(state, high, highInput, out);
+    float readable = params.MAX_KPA + params.PRESSURE_CORRECTION_KPA;
+    float clamped = out.overboostLimit.ceilingkPa;
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "ceiling %.1f kPa (expected %.1f), off %.1f, clamped %.2f of %.2f, line error %.4f kPa",
+             limit.ceilingkPa, expected, offCeiling, clamped, readable, worstLine);
+    check(plainOk && offCeiling == 0.0f && fabsf(clamped - readable) < 1e-3f && worstLine < 0.01f, "ceiling", detail);
+}
+
+static void checkConfirm(const ToolParams& tp) {
+    ControlParams params;
+    toControlParams(tp, params);
+    OverboostLimit limit;
+    limit.ceilingkPa = 200.0f;
+    limit.kPaAtZeroVolts = voltageToPressure(params, -params.scaledVoltageOffset);
+    limit.kPaPerVolt = voltageToPressure(params, 1.0f - params.scaledVoltageOffset) - limit.kPaAtZeroVolts;
+    float below = pinVoltageFor(params, 190.0f);
+    float above = pinVoltageFor(params, 210.0f);
+    OverboostMonitor m;
+    overboostInit(m);
+
+    uint32_t t = 0;
+    auto step = [&](float v) {
+        t += OVERBOOST_PERIOD_US;
+        bool cut = overboostCheck(m, limit, v, t);
+        overboostCheckDone(m, t, t + CHECK_COST_US);
+        return cut;
+    };
+    bool spikeRejected = !step(below) && !step(above) && !step(below) && !step(above) && !step(below);
+    bool confirmed = !step(above) && step(above);
+    uint32_t latency = m.latencyUs;
+    bool latched = step(below) && step(below) && m.tripped;
+    overboostClear(m);
+    bool cleared = !step(below) && !m.tripped && m.trips == 1;
+    bool retripped = !step(above) && step(above) && m.trips == 2;
+    bool offIgnores = true;
+    OverboostLimit offLimit = limit;
+    offLimit.ceilingkPa = 0.0f;
+    overboostInit(m);
+    for (int i = 0; i < 10; i++) offIgnores = offIgnores && !overboostCheck(m, offLimit, above, (uint32_t)i * 500);
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "spike %s, confirm %s (latency %u us), latch %s, clear %s, re-trip %s, off %s",
+             spikeRejected ? "ok" : "TRIPPED", confirmed ? "ok" : "no", (unsigned)latency, latched ? "ok" : "no",
+             cleared ? "ok" : "no", retripped ? "ok" : "no", offIgnores ? "ok" : "TRIPPED");
+    check(spikeRejected && confirmed && latency == OVERBOOST_PERIOD_US + CHECK_COST_US && latched && cleared && retripped &&
+          offIgnores, "confirm and latch", detail);
+}
+
+static void checkStall(const ToolParams& tp, uint32_t jitterUs, const char* name) {
+    // 190 kPa's ceiling is within a few kPa of what the default plant can make.
+    const float targets[] = {150.0f, 165.0f, 180.0f};
+    const uint32_t seeds[] = {12345, 777, 31337};
+    int runs = 0, cut = 0, held = 0;
+    int64_t worstLatency = 0, worstReported = 0;
+    float worstReduction = 1e9f;
+    for (float target : targets) {
+        for (uint32_t seed : seeds) {
+            PullRun off = {false, true, false, jitterUs, seed, target};
+            PullRun on = off;
+            on.guard = true;
+            PullResult a, b;
+            runPull(tp, off, a);
+            runPull(tp, on, b);
+            runs++;
+            if (!b.stalled || b.crossUs < 0 || b.cutUs < 0) continue;
+            cut++;
+            if (b.heldLow && b.trippedAtEnd) held++;
+            int64_t latency = b.cutUs - b.crossUs;
+            if (latency > worstLatency) worstLatency = latency;
+            if ((int64_t)b.monitor.latencyUs > worstReported) worstReported = b.monitor.latencyUs;
+            worstReduction = fminf(worstReduction, a.peakkPa - b.peakkPa);
+        }
+    }
+    char detail[200];
+    snprintf(detail, sizeof(detail),
+             "%d/%d cut, %d held; latency worst %lld us (guard reports %lld, bound %u); peak %.1f kPa lower at least",
+             cut, runs, held, (long long)worstLatency, (long long)worstReported, (unsigned)OVERBOOST_LATENCY_BOUND_US,
+             worstReduction);
+    check(cut == runs && held == runs && worstLatency <= (int64_t)OVERBOOST_LATENCY_BOUND_US &&
+          worstReported <= (int64_t)OVERBOOST_LATENCY_BOUND_US && worstReduction > 0.0f, name, detail);
+}
+
+static void checkNoFalseTrips(const ToolParams& tp) {
+    const float targets[] = {150.0f, 170.0f, 190.0f};
+    const uint32_t seeds[] = {12345, 777, 31337, 4242, 9001};
+    int runs = 0, trips = 0, singles = 0;
+    float closest = 1e9f;
+    uint32_t maxGap = 0;
+    for (float target : targets) {
+        for (uint32_t seed : seeds) {
+            PullRun run = {true, false, true, 0, seed, target};
+            PullResult r;
+            runPull(tp, run, r);
+            runs++;
+            if (r.monitor.trips) trips++;
+            singles += r.singleOverChecks;
+            closest = fminf(closest, r.ceilingkPa - r.peakkPa);
+            if (r.monitor.maxGapUs > maxGap) maxGap = r.monitor.maxGapUs;
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%d/%d tripped, %d single glitch checks over the ceiling, peak %.1f kPa under it",
+             trips, runs, singles, closest);
+    check(trips == 0 && singles > 0 && maxGap == OVERBOOST_PERIOD_US, "no false trips", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    tp.overshootLimiter = 1;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    checkCeiling(tp);
+    checkConfirm(tp);
+    checkStall(tp, 0, "stall cut");
+    checkStall(tp, 300, "stall cut with jitter");
+    checkNoFalseTrips(tp);
+    return checkExitCode();
+}
@@ -0,0 +1,293 @@
+//================================================================================
+// ADAPTIVE OVERSAMPLING CHECK
+//================================================================================
+// Runs the MAP channel's conversions through the SensorAverager once a control
+// tick, as readSensorSample() does, with the window fixed at the longest and
+// shortest bound and chosen each tick by OversamplePolicy (src/sensors.h), and
+// compares each tick's reading with the true pressure at the end of the tick.
+// Conversions come at 20 kHz with Gaussian noise added, interpolated from
+// the synthetic plant under open-throttle pulls (1 ms steps), or from a
+// captured TRACE's voltages (10 ms steps) when one is given.
+//
+// It prints RMS error on transient ticks (true pressure moving faster than
+// TRANSIENT_KPA_PER_S) and steady ticks, the worst error and the mean window
+// for each, then checks:
+//   - on transients the adaptive window's error is under 0.6 of the longest
+//     window's
+//   - when steady it is within 15 % of the longest window's and below the
+//     shortest's, and holds the longest window on 90 % of ticks once the
+//     pressure has held for REGROW_TICKS
+//   - the window stays within the bounds and grows by at most a quarter a tick
+//   - no change of window moves the reading, against the true pressure, by
+//     more than the longest window's worst lag error, so a shrink only ever
+//     catches up
+//
+//   oversample [--params FILE] [--set key=value]... [--min N] [--max N] [--noise CODES] [TRACE]
+//
+// Prints the table, then one line per check, and exits non-zero when any
+// fails.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+#include "trace_log.h"
+
+static const float TRANSIENT_KPA_PER_S = 20.0f;
+static const int CONVERSIONS_PER_MS = (int)(SENSOR_SCAN_HZ / 1000.0f);
+
+static uint32_t nextRandom(uint32_t& rng) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static float gaussian(uint32_t& rng) {
+    float u1 = ((nextRandom(rng) & 0xFFFFFF) + 1.0f) / 16777217.0f;
+    float u2 = (nextRandom(rng) & 0xFFFFFF) / 16777216.0f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+static float voltsToCode(float volts) {
+    return volts / ADC_FULL_SCALE_VOLTS * ADC_FULL_SCALE_CODE;
+}
+
+//================================================================================
+// SOURCES
+//================================================================================
+// True MAP pin voltage, one value per millisecond.
+static void syntheticSource(const ToolParams& tp, std::vector<float>& volts) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantModel model = defaultPlantModel();
+    model.noisekPa = 0.0f;     // the noise is added per conversion
+    PlantState plant;
+    plantInit(plant, model);
+    PullProfile pull = defaultPullProfile();
+    const float duties[] = {30.0f, 60.0f, 90.0f};
+    volts.clear();
+    for (float duty : duties) {
+        uint32_t length = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+        for (uint32_t ms = 1; ms <= length; ms++) {
+            bool throttleOpen = ms >= pull.throttleOpenMs && ms < pull.throttleOpenMs + pull.pullMs;
+            float kPa = plantStep(plant, model, throttleOpen ? duty : 0.0f, throttleOpen, (float)ms - pull.throttleOpenMs, 1.0f);
+            volts.push_back(plantSensorVoltage(plant, model, params, kPa));
+        }
+    }
+}
+
+static bool traceSource(const std::string& path, std::vector<float>& volts) {
+    TraceLog log;
+    std::string error;
+    if (!log.open(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    if (log.size() < 2) {
+        fprintf(stderr, "%s: too short\n", path.c_str());
+        return false;
+    }
+    volts.clear();
+    for (size_t i = 1; i < log.size(); i++) {
+        uint32_t gap = log[i].timeMs - log[i - 1].timeMs;
+        for (uint32_t ms = 1; ms <= gap; ms++) {
+            volts.push_back(log[i - 1].voltage + (log[i].voltage - log[i - 1].voltage) * ms / gap);
+        }
+    }
+    return true;
+}
+
+//================================================================================
+// RUN
+//================================================================================
+struct Run {
+    std::vector<float> errorkPa;     // reading - truth, per tick
+    std::vector<float> truekPa;
+    std::vector<int> window;
+};
+
+// window > 0 fixes it; 0 lets the policy choose between minWindow and maxWindow.
+static void runAverager(const ToolParams& tp, const std::vector<float>& volts, int window, int minWindow, int maxWindow,
+                        float noiseCodes, Run& run) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static SensorAverager averager;
+    sensorAveragerInit(averager, window > 0 ? window : maxWindow);
+    OversamplePolicy policy;
+    oversamplePolicyInit(policy, maxWindow);
+    uint32_t rng = 1234;   // the same noise for every strategy
+    const int tickMs = (int)CONTROL_TASK_DELAY_MS;
+    run.errorkPa.clear();
+    run.truekPa.clear();
+    run.window.clear();
+    float previous = volts[0];
+    for (size_t ms = 0; ms < volts.size(); ms++) {
+        for (int n = 1; n <= CONVERSIONS_PER_MS; n++) {
+            float v = previous + (volts[ms] - previous) * n / CONVERSIONS_PER_MS;
+            float code = voltsToCode(v) + noiseCodes * gaussian(rng);
+            code = code < 0.0f ? 0.0f : (code > ADC_FULL_SCALE_CODE ? ADC_FULL_SCALE_CODE : code);
+            sensorAveragerPush(averager, SENSOR_MAP, (uint16_t)lroundf(code));
+        }
+        previous = volts[ms];
+        if ((ms + 1) % tickMs) continue;
+        int chosen = window > 0 ? window : oversamplePolicyUpdate(policy, averager, SENSOR_MAP, minWindow, maxWindow);
+        sensorAveragerSetWindow(averager, chosen);
+        SensorSample sample;
+        sensorAveragerSample(averager, (uint32_t)ms, sample);
+        float truth = voltageToPressure(params, volts[ms]);
+        run.truekPa.push_back(truth);
+        run.errorkPa.push_back(voltageToPressure(params, sample.voltage[SENSOR_MAP]) - truth);
+        run.window.push_back(sample.samples[SENSOR_MAP]);
+    }
+}
+
+struct Figures {
+    float transientRms, steadyRms, worst, meanWindow;
+    int transientTicks, steadyTicks;
+};
+
+// Skips the first ticks, while the averager fills.
+static const int SETTLE_TICKS = 5;
+// Ticks after a transient before the window is expected back at its longest.
+static const int REGROW_TICKS = 20;
+
+static bool transientTick(const Run& run, size_t i) {
+    float rate = (run.truekPa[i] - run.truekPa[i - 1]) * 1000.0f / CONTROL_TASK_DELAY_MS;
+    return fabsf(rate) > TRANSIENT_KPA_PER_S;
+}
+
+static Figures figuresFor(const Run& run) {
+    Figures f = {0, 0, 0, 0, 0, 0};
+    double transientSq = 0, steadySq = 0, windowSum = 0;
+    for (size_t i = SETTLE_TICKS; i < run.errorkPa.size(); i++) {
+        float e = run.errorkPa[i];
+        if (transientTick(run, i)) {
+            transientSq += e * e;
+            f.transientTicks++;
+        } else {
+            steadySq += e * e;
+            f.steadyTicks++;
+        }
+        f.worst = fmaxf(f.worst, fabsf(e));
+        windowSum += run.window[i];
+    }
+    int n = f.transientTicks + f.steadyTicks;
+    f.transientRms = f.transientTicks ? (float)sqrt(transientSq / f.transientTicks) : 0.0f;
+    f.steadyRms = f.steadyTicks ? (float)sqrt(steadySq / f.steadyTicks) : 0.0f;
+    f.meanWindow = n ? (float)(windowSum / n) : 0.0f;
+    return f;
+}
+
+static void printRow(const char* source, const char* strategy, const Figures& f) {
+    printf("%s,%s,%.3f,%.3f,%.3f,%.0f\n", source, strategy, f.transientRms, f.steadyRms, f.worst, f.meanWindow);
+}
+
+//================================================================================
+// CHECKS
+//================================================================================
+static void checkPolicy(const ToolParams& tp, const char* source, const std::vector<float>& volts, int minWindow,
+                        int maxWindow, float noiseCodes) {
+    Run longest, shortest, adaptive;
+    runAverager(tp, volts, maxWindow, minWindow, maxWindow, noiseCodes, longest);
+    runAverager(tp, volts, minWindow, minWindow, maxWindow, noiseCodes, shortest);
+    runAverager(tp, volts, 0, minWindow, maxWindow, noiseCodes, adaptive);
+    Figures fl = figuresFor(longest), fs = figuresFor(shortest), fa = figuresFor(adaptive);
+    char name[32];
+    printf("source,strategy,transient_rms_kpa,steady_rms_kpa,worst_kpa,mean_window\n");
+    snprintf(name, sizeof(name), "fixed_%d", maxWindow);
+    printRow(source, name, fl);
+    snprintf(name, sizeof(name), "fixed_%d", minWindow);
+    printRow(source, name, fs);
+    printRow(source, "adaptive", fa);
+    printf("\n");
+
+    char detail[160];
+    if (fa.transientTicks == 0) {
+        check(true, "transient error", "no transient ticks");
+    } else {
+        snprintf(detail, sizeof(detail), "RMS %.3f kPa over %d ticks (fixed %d: %.3f, fixed %d: %.3f)", fa.transientRms,
+                 fa.transientTicks, maxWindow, fl.transientRms, minWindow, fs.transientRms);
+        check(fa.transientRms < 0.6f * fl.transientRms, "transient error", detail);
+    }
+
+    // The window takes a dozen ticks to grow back after a transient, so the
+    // share is counted once the pressure has held for REGROW_TICKS.
+    int settled = 0, settledAtMax = 0, sinceTransient = REGROW_TICKS;
+    for (size_t i = SETTLE_TICKS; i < adaptive.window.size(); i++) {
+        sinceTransient = transientTick(adaptive, i) ? 0 : sinceTransient + 1;
+        if (sinceTransient < REGROW_TICKS) continue;
+        settled++;
+        if (adaptive.window[i] == maxWindow) settledAtMax++;
+    }
+    float share = settled ? (float)settledAtMax / settled : 1.0f;
+    snprintf(detail, sizeof(detail), "RMS %.3f kPa (fixed %d: %.3f, fixed %d: %.3f), longest window %.0f %% of held ticks",
+             fa.steadyRms, maxWindow, fl.steadyRms, minWindow, fs.steadyRms, share * 100.0f);
+    check(fa.steadyRms <= 1.15f * fl.steadyRms && fa.steadyRms < fs.steadyRms && share >= 0.9f, "steady resolution", detail);
+
+    bool bounded = true;
+    int worstGrowth = 0;
+    for (size_t i = SETTLE_TICKS + 1; i < adaptive.window.size(); i++) {
+        int w = adaptive.window[i], last = adaptive.window[i - 1];
+        if (w < minWindow || w > maxWindow) bounded = false;
+        int allowed = last / 4 > 1 ? last / 4 : 1;
+        if (w - last > allowed) bounded = false;
+        if (w - last > worstGrowth) worstGrowth = w - last;
+    }
+    snprintf(detail, sizeof(detail), "%d..%d, largest step up %d", minWindow, maxWindow, worstGrowth);
+    check(bounded, "window bounds and growth", detail);
+
+    float worstJump = 0;
+    for (size_t i = SETTLE_TICKS + 1; i < adaptive.errorkPa.size(); i++) {
+        if (adaptive.window[i] == adaptive.window[i - 1]) continue;
+        worstJump = fmaxf(worstJump, fabsf(adaptive.errorkPa[i] - adaptive.errorkPa[i - 1]));
+    }
+    snprintf(detail, sizeof(detail), "worst %.3f kPa on a window change (fixed %d worst error %.3f)", worstJump, maxWindow, fl.worst);
+    check(worstJump <= fl.worst, "glitch-free window changes", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    int minWindow = OVERSAMPLE_MIN_DEFAULT, maxWindow = 256;
+    float noiseCodes = 4.0f;
+    std::string tracePath, error;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool ok = true;
+        if (arg.compare(0, 2, "--") != 0) {
+            tracePath = arg;
+            continue;
+        }
+        if (i + 1 >= argc) ok = false;
+        else {
+            std::string value = argv[++i];
+            if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+            else if (arg == "--set") ok = setToolParam(tp, value);
+            else if (arg == "--min") ok = (minWindow = atoi(value.c_str())) >= 1;
+            else if (arg == "--max") ok = (maxWindow = atoi(value.c_str())) >= 1 && maxWindow <= SENSOR_AVERAGE_MAX;
+            else if (arg == "--noise") ok = (noiseCodes = (float)atof(value.c_str())) > 0.0f;
+            else ok = false;
+        }
+        if (!ok || minWindow > maxWindow) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: oversample [--params FILE] [--set key=value]... [--min N] [--max N] [--noise CODES] [TRACE]\n");
+            return 1;
+        }
+    }
+
+    std::vector<float> volts;
+    if (tracePath.empty()) {
+        syntheticSource(tp, volts);
+        checkPolicy(tp, "synthetic", volts, minWindow, maxWindow, noiseCodes);
+    } else {
+        if (!traceSource(tracePath, volts)) return 1;
+        checkPolicy(tp, "trace", volts, minWindow, maxWindow, noiseCodes);
+    }
+    return checkExitCode();
+}
@@ -0,0 +1,121 @@
+//================================================================================
+// OVERSHOOT LIMITER CHECK
+//================================================================================
+// Runs the same simulated pulls with the predictive overshoot limiter
+// (src/overshoot.h) off and on, on several plant models, and prints the
+// overshoot, spool rate, time to target, spool and torque scores and settling
+// time of each side by side, averaged over several targets and noise seeds.
+//
+//   overshoot [--params FILE] [--set key=value]... [--spool-tolerance PCT]
+//
+// Each plant's row is a PASS when the limiter reduces the average overshoot
+// without lowering the average Spool Score by more than the tolerance
+// (default 5%). The spool rate, the Spool Score's peak dP/dt taken on the
+// simulated true pressure before it first reaches the target, is printed
+// beside it. Time to target is expected to grow a little: the limiter trades
+// the last few kPa of approach speed for the overshoot.
+//
+// The limiter fails this on the fast_spool, high_gain and slow_manifold
+// plants, and no lead, span or floor tried holds the Spool Score on all of
+// them, so it is off by default. The tool exits non-zero when the parameters
+// given (the defaults unless --params/--set say otherwise) turn the limiter on
+// while any plant fails.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+struct PlantCase {
+    const char* name;
+    PlantModel model;
+};
+
+static void averagePulls(const ToolParams& tp, const PlantModel& base, PullMetrics& avg) {
+    // Single pulls are sensitive to where the noise falls.
+    const float targetOffsets[] = {-20.0f, 0.0f, 20.0f};
+    const uint32_t seeds[] = {12345, 777, 31337, 4242, 9001};
+    int pulls = 0;
+    avg = PullMetrics{0, 0, 0, 0, 0, 0, 0};
+    for (float offset : targetOffsets) {
+        for (uint32_t seed : seeds) {
+            ToolParams run = tp;
+            run.targetkPa += offset;
+            PlantModel model = base;
+            model.seed = seed;
+            PullMetrics m;
+            simulatePull(run, model, defaultPullProfile(), m);
+            avg.spoolScore += m.spoolScore;
+            avg.torqueScore += m.torqueScore;
+            avg.overshootkPa += m.overshootkPa;
+            avg.settlingMs += m.settlingMs;
+            avg.timeToTargetMs += m.timeToTargetMs;
+            avg.peakRiseRate += m.peakRiseRate;
+            pulls++;
+        }
+    }
+    avg.spoolScore /= pulls;
+    avg.torqueScore /= pulls;
+    avg.overshootkPa /= pulls;
+    avg.settlingMs /= pulls;
+    avg.timeToTargetMs /= pulls;
+    avg.peakRiseRate /= pulls;
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    float spoolTolerancePercent = 5.0f;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--spool-tolerance") spoolTolerancePercent = strtof(value.c_str(), nullptr);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: overshoot [--params FILE] [--set key=value]... [--spool-tolerance PCT]\n");
+            return 1;
+        }
+    }
+
+    ToolParams off = tp;
+    off.overshootLimiter = 0;
+    ToolParams on = tp;   // with the limiter's settings from --params/--set
+    on.overshootLimiter = 1;
+
+    PlantCase cases[5];
+    for (PlantCase& c : cases) c.model = defaultPlantModel();
+    cases[0].name = "default";
+    cases[1].name = "fast_spool";     cases[1].model.spoolTimeMs = 900.0f;
+    cases[2].name = "slow_spool";     cases[2].model.spoolTimeMs = 2500.0f;
+    cases[3].name = "high_gain";      cases[3].model.maxBoostkPa = 180.0f;
+    cases[4].name = "slow_manifold";  cases[4].model.tauMs = 250.0f;
+
+    int failures = 0;
+    printf("plant,limiter,overshoot_kpa,spool_rate_kpa_s,time_to_target_ms,spool_score,torque_score,settling_ms,result\n");
+    for (const PlantCase& c : cases) {
+        PullMetrics a, b;
+        averagePulls(off, c.model, a);
+        averagePulls(on, c.model, b);
+        bool pass = b.overshootkPa < a.overshootkPa &&
+                    b.spoolScore >= a.spoolScore * (1.0f - spoolTolerancePercent / 100.0f);
+        if (!pass) failures++;
+        printf("%s,off,%.2f,%.0f,%.0f,%.1f,%.1f,%.0f,\n", c.name, a.overshootkPa, a.peakRiseRate, a.timeToTargetMs, a.spoolScore,
+               a.torqueScore, a.settlingMs);
+        printf("%s,on,%.2f,%.0f,%.0f,%.1f,%.1f,%.0f,%s\n", c.name, b.overshootkPa, b.peakRiseRate, b.timeToTargetMs, b.spoolScore,
+               b.torqueScore, b.settlingMs, pass ? "PASS" : "FAIL");
+    }
+
+    bool enabled = tp.overshootLimiter != 0;
+    char detail[128];
+    snprintf(detail, sizeof(detail), "limiter %s, lowers the Spool Score or misses overshoot on %d of 5 plants",
+             enabled ? "on" : "off", failures);
+    check(!enabled || failures == 0, "limiter default", detail);
+    return checkExitCode();
+}
@@ -0,0 +1,177 @@
+//================================================================================
+// PID STEP RESPONSE CHARACTERIZATION
+//================================================================================
+// Characterizes the PID options in src/pid.h on the host plant model. Each
+// option set runs two experiments:
+//   step  a fully spooled plant with sensor noise, run through the firmware
+//         control pipeline (src/control.cpp) while the target steps up.
+//         Reports rise time, overshoot, settling, the offset from the
+//         setpoint it holds, the jump of the PID output before its
+//         limits on the step tick (proportional and derivative kick; the
+//         limited output saturates with any of the options) and the output
+//         noise while holding.
+//   pull  a full wide-open-throttle pull, scored as on the device.
+//
+//   pidstep [--params FILE] [--set key=value]... [--step KPA]
+//
+// The default 10 kPa step stays inside the PID trigger window, so every
+// option is in closed loop on the step tick and the kicks compare like for
+// like.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+struct OptionSet {
+    const char* name;
+    float derivativeFilterMs;
+    float setpointWeight;
+    int derivativeOnMeasurement;
+    int antiWindupMode;
+    int bumplessTransfer;
+};
+
+struct StepMetrics {
+    float riseMs;          // 10% to 90% of the step
+    float overshootkPa;
+    float settlingMs;      // until staying within the band around the final pressure
+    float offsetkPa;       // final pressure minus the setpoint (target + PID_Control_Overhead)
+    float kick;            // |unsaturated output change| on the step tick, in 0-255 counts
+    float outputNoise;     // output standard deviation while holding, 0-255
+};
+
+static const float STEP_SETTLE_BAND_KPA = 2.0f;
+static const uint32_t STEP_AT_MS = 3000;
+static const uint32_t STEP_HOLD_MS = 3000;
+static const uint32_t STEP_FINAL_MS = 500;   // the end of the hold averaged for the final pressure
+
+static void applyOptions(const OptionSet& o, ToolParams& tp) {
+    tp.pidDerivativeFilterMs = o.derivativeFilterMs;
+    tp.pidSetpointWeight = o.setpointWeight;
+    tp.pidDerivativeOnMeasurement = o.derivativeOnMeasurement;
+    tp.pidAntiWindupMode = o.antiWindupMode;
+    tp.pidBumplessTransfer = o.bumplessTransfer;
+}
+
+static void runStep(const ToolParams& tp, float stepkPa, StepMetrics& m) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    PlantModel model = defaultPlantModel();
+    PlantState plant;
+    plantInit(plant, model);
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    const float baseTarget = tp.targetkPa - stepkPa / 2;
+    const float stepTarget = baseTarget + stepkPa;
+    // The loop regulates to the target plus PID_Control_Overhead, so the
+    // step is measured against that. Where it holds short of it (the
+    // integral at Max I term), settling is to the pressure it holds and the
+    // shortfall is reported as the offset.
+    const float baseSetpoint = baseTarget + tp.PID_Control_Overhead;
+    const float stepSetpoint = stepTarget + tp.PID_Control_Overhead;
+    const uint32_t endMs = STEP_AT_MS + STEP_HOLD_MS;
+    uint32_t t = 0;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, plant.pressurekPa), t);
+    ControlInput input;
+    ControlOutput out;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = nullptr;
+    float duty = 0;
+    int64_t t10 = -1, t90 = -1;
+    std::vector<float> afterStep;
+    double sum = 0, sumSq = 0;
+    int holdSamples = 0;
+    m.overshootkPa = 0;
+    m.kick = 0;
+
+    // Throttle is already wide open and fully spooled; only the target moves.
+    for (t = (uint32_t)dtMs; t <= endMs; t += (uint32_t)dtMs) {
+        float p = plantStep(plant, model, duty, true, 1.0e6f, dtMs);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.targetkPa = t < STEP_AT_MS ? baseTarget : stepTarget;
+        input.previousDutyPercent = duty;
+        float previousOutput = float(state.pid.unsaturated);
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+
+        if (t == STEP_AT_MS) m.kick = fabsf(float(state.pid.unsaturated) - previousOutput);
+        if (t + 1000 >= STEP_AT_MS && t < STEP_AT_MS) {
+            sum += state.output; sumSq += (double)state.output * state.output; holdSamples++;
+        }
+        if (t < STEP_AT_MS) continue;
+        if (t10 < 0 && p >= baseSetpoint + 0.1f * stepkPa) t10 = t;
+        if (t90 < 0 && p >= baseSetpoint + 0.9f * stepkPa) t90 = t;
+        if (p - stepSetpoint > m.overshootkPa) m.overshootkPa = p - stepSetpoint;
+        afterStep.push_back(p);
+    }
+
+    const size_t finalSamples = STEP_FINAL_MS / (uint32_t)dtMs;
+    double finalSum = 0;
+    for (size_t i = afterStep.size() - finalSamples; i < afterStep.size(); i++) finalSum += afterStep[i];
+    const float finalkPa = (float)(finalSum / finalSamples);
+    int64_t lastOutside = -1;
+    for (size_t i = 0; i < afterStep.size(); i++) {
+        if (fabsf(afterStep[i] - finalkPa) > STEP_SETTLE_BAND_KPA) lastOutside = (int64_t)(i * (uint32_t)dtMs);
+    }
+    m.offsetkPa = finalkPa - stepSetpoint;
+
+    m.riseMs = (t10 >= 0 && t90 >= 0) ? (float)(t90 - t10) : (float)STEP_HOLD_MS;
+    m.settlingMs = lastOutside < 0 ? 0.0f : (float)lastOutside;
+    double mean = holdSamples ? sum / holdSamples : 0;
+    m.outputNoise = holdSamples ? (float)sqrt(std::max(0.0, sumSq / holdSamples - mean * mean)) : 0.0f;
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    float stepkPa = 10.0f;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--step") stepkPa = strtof(value.c_str(), nullptr);
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "usage: pidstep [--params FILE] [--set key=value]... [--step KPA]\n");
+            return 1;
+        }
+    }
+
+    const OptionSet options[] = {
+        {"original",            0.0f,  1.0f,  0, PID_ANTIWINDUP_CLAMP,            0},
+        {"d_filter_20ms",       20.0f, 1.0f,  0, PID_ANTIWINDUP_CLAMP,            0},
+        {"d_on_measurement",    0.0f,  1.0f,  1, PID_ANTIWINDUP_CLAMP,            0},
+        {"setpoint_weight_0.5", 0.0f,  0.5f,  0, PID_ANTIWINDUP_CLAMP,            0},
+        {"back_calculation",    0.0f,  1.0f,  0, PID_ANTIWINDUP_BACK_CALCULATION, 0},
+        {"conditional",         0.0f,  1.0f,  0, PID_ANTIWINDUP_CONDITIONAL,      0},
+        {"bumpless",            0.0f,  1.0f,  0, PID_ANTIWINDUP_CLAMP,            1},
+        {"combined",            20.0f, 0.7f,  1, PID_ANTIWINDUP_BACK_CALCULATION, 1},
+    };
+
+    printf("option,step_rise_ms,step_overshoot_kpa,step_settling_ms,step_offset_kpa,step_kick,hold_output_noise,"
+           "pull_overshoot_kpa,pull_settling_ms,torque_score,spool_score\n");
+    for (const OptionSet& o : options) {
+        ToolParams run = tp;
+        applyOptions(o, run);
+        StepMetrics step;
+        runStep(run, stepkPa, step);
+        PullMetrics pull;
+        simulatePull(run, defaultPlantModel(), defaultPullProfile(), pull);
+        printf("%s,%.0f,%.2f,%.0f,%.2f,%.1f,%.2f,%.2f,%.0f,%.1f,%.1f\n", o.name, step.riseMs, step.overshootkPa,
+               step.settlingMs, step.offsetkPa, step.kick, step.outputNoise, pull.overshootkPa, pull.settlingMs,
+               pull.torqueScore, pull.spoolScore);
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+//================================================================================
+// IDLE POWER CHECK
+//================================================================================
+// Runs the control pipeline and the idle power policy (src/power.h) together
+// the way the control task does, ticking every CONTROL_TASK_DELAY_MS at full
+// rate and every POWER_IDLE_TICK_MS while idle, with the engine off:
+//   - the board goes idle POWER_IDLE_ENTER_MS after the pipeline has turned
+//     the solenoid off for idle, and the solenoid stays off throughout
+//   - an engine start (MAP falling from atmosphere to idle vacuum) wakes it
+//     back to full rate within powerWakeBoundMs() of crossing the wake
+//     threshold, swept across the idle tick, and the pipeline reactivates no
+//     more than one idle tick later than it does at full rate all along
+//   - a touch wakes it within the same bound, and it goes idle again once
+//     left alone
+//   - with the setting off, or touched every few seconds, it never goes idle
+//   - the time in each mode adds up to the time run
+//   - the estimated mean current is lower with light sleep than with
+//     frequency scaling alone, and both are lower than at full rate
+//   - every idle burst lasts long enough to refill the averaging window
+//
+//   power [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "power.h"
+#include "tool_params.h"
+
+static const float ATMOSPHERE_KPA = 100.0f;
+static const float IDLE_VACUUM_KPA = 35.0f;
+static const uint32_t CRANK_DROP_MS = 300;   // atmosphere to idle vacuum once the engine fires
+static const int WINDOW = 64;                // conversions averaged per reading (Oversampling)
+static const int MAX_TOUCHES = 32;
+
+struct BoardRun {
+    int setting;               // PowerSetting
+    uint32_t crankMs;          // the engine starts here; 0 = it stays off
+    uint32_t touchMs[MAX_TOUCHES];
+    int touches;
+    uint32_t endMs;
+};
+
+struct BoardResult {
+    PowerPolicy power;
+    uint32_t endMs;              // the last tick
+    uint32_t pipelineIdleMs;     // first tick with the solenoid off for idle; 0 = never
+    uint32_t powerIdleMs;        // first tick entering POWER_IDLE; 0 = never
+    int idleEntries;
+    bool solenoidOffWhileIdle;
+    uint32_t thresholdMs;        // true pressure first below the wake threshold after the start
+    uint32_t crankActiveMs;      // first tick back in POWER_ACTIVE after the threshold
+    uint32_t reactivatedMs;      // the pipeline leaving idle after the start
+    uint32_t touchWakeMs;        // latency, the first touch while idle to POWER_ACTIVE
+    uint32_t reentryMs;          // from that wake to POWER_IDLE again
+};
+
+static float crankPressure(const BoardRun& run, uint32_t t) {
+    if (run.crankMs == 0 || t < run.crankMs) return ATMOSPHERE_KPA;
+    if (t >= run.crankMs + CRANK_DROP_MS) return IDLE_VACUUM_KPA;
+    return ATMOSPHERE_KPA - (ATMOSPHERE_KPA - IDLE_VACUUM_KPA) * (float)(t - run.crankMs) / (float)CRANK_DROP_MS;
+}
+
+// The first millisecond at or after fromMs that the true pressure is below kPa.
+static uint32_t crossingMs(const BoardRun& run, uint32_t fromMs, float kPa) {
+    for (uint32_t t = fromMs; t < run.endMs; t++) {
+        if (crankPressure(run, t) < kPa) return t;
+    }
+    return 0;
+}
+
+static void runBoard(const ToolParams& tp, const BoardRun& run, BoardResult& r) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantModel model = defaultPlantModel();
+    PlantState plant;
+    plantInit(plant, model);
+
+    static ControlState state;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, ATMOSPHERE_KPA), 0);
+    powerPolicyInit(r.power, 0);
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+
+    r.pipelineIdleMs = r.powerIdleMs = 0;
+    r.idleEntries = 0;
+    r.solenoidOffWhileIdle = true;
+    r.thresholdMs = run.crankMs ? crossingMs(run, run.crankMs, REACTIVATE_PRESSURE_KPA + POWER_WAKE_MARGIN_KPA) : 0;
+    r.crankActiveMs = r.reactivatedMs = 0;
+    r.touchWakeMs = r.reentryMs = 0;
+    uint32_t touchWokeAtMs = 0;
+    uint32_t firstIdleTouchMs = 0;
+
+    uint32_t previousMs = 0;
+    uint32_t t = CONTROL_TASK_DELAY_MS;
+    while (t <= run.endMs) {
+        bool touched = false;
+        for (int i = 0; i < run.touches; i++) touched = touched || (run.touchMs[i] > previousMs && run.touchMs[i] <= t);
+        if (touched && r.power.mode == POWER_IDLE && firstIdleTouchMs == 0) {
+            for (int i = 0; i < run.touches; i++) {
+                if (run.touchMs[i] > previousMs && run.touchMs[i] <= t) { firstIdleTouchMs = run.touchMs[i]; break; }
+            }
+        }
+
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, crankPressure(run, t));
+        input.activityDetected = touched;
+        input.previousDutyPercent = out.solenoidPercent;
+        controlStep(state, params, input, out);
+
+        PowerInput powerInput = {t, run.setting, state.solenoidDisabledByIdle, touched, out.rawPressure, WINDOW, CONTROL_TASK_DELAY_MS};
+        PowerDecision decision;
+        bool wasIdle = r.power.mode == POWER_IDLE;
+        powerPolicyUpdate(r.power, powerInput, decision);
+
+        if (state.solenoidDisabledByIdle && r.pipelineIdleMs == 0) r.pipelineIdleMs = t;
+        if (decision.enterIdle) {
+            if (r.powerIdleMs == 0) r.powerIdleMs = t;
+            if (touchWokeAtMs && r.reentryMs == 0) r.reentryMs = t - touchWokeAtMs;
+            r.idleEntries++;
+        }
+        if ((wasIdle || r.power.mode == POWER_IDLE) && out.solenoidPercent != 0.0f) r.solenoidOffWhileIdle = false;
+        if (r.thresholdMs && t >= r.thresholdMs) {
+            if (r.crankActiveMs == 0 && r.power.mode == POWER_ACTIVE) r.crankActiveMs = t;
+            if (r.reactivatedMs == 0 && !state.solenoidDisabledByIdle) r.reactivatedMs = t;
+        }
+        if (firstIdleTouchMs && touchWokeAtMs == 0 && r.power.mode == POWER_ACTIVE) {
+            touchWokeAtMs = t;
+            r.touchWakeMs = t - firstIdleTouchMs;
+        }
+
+        previousMs = t;
+        t += decision.tickMs;
+    }
+    r.endMs = previousMs;
+}
+
+static BoardRun engineOff(int setting, uint32_t endMs) {
+    BoardRun run = {};
+    run.setting = setting;
+    run.endMs = endMs;
+    return run;
+}
+
+//================================================================================
+// CHECKS
+//================================================================================
+static void checkIdleEntry(const ToolParams& tp) {
+    BoardRun run = engineOff(POWER_SETTING_SCALING, 120000);
+    BoardResult r;
+    runBoard(tp, run, r);
+    // Quiet counts from the last tick that was not, one tick before the first idle one.
+    uint32_t after = r.powerIdleMs - r.pipelineIdleMs + CONTROL_TASK_DELAY_MS;
+    bool ok = r.pipelineIdleMs > 0 && r.powerIdleMs > 0 && after >= POWER_IDLE_ENTER_MS &&
+              after <= POWER_IDLE_ENTER_MS + CONTROL_TASK_DELAY_MS && r.idleEntries == 1 && r.power.mode == POWER_IDLE &&
+              r.solenoidOffWhileIdle;
+    char detail[200];
+    snprintf(detail, sizeof(detail), "solenoid off for idle at %.2f s, board idle at %.2f s, solenoid %s", r.pipelineIdleMs * 0.001,
+             r.powerIdleMs * 0.001, r.solenoidOffWhileIdle ? "off throughout" : "DRIVEN while idle");
+    check(ok, "idle entry", detail);
+}
+
+static void checkEngineStart(const ToolParams& tp) {
+    uint32_t bound = powerWakeBoundMs(WINDOW, CONTROL_TASK_DELAY_MS);
+    uint32_t worstWake = 0, worstExtra = 0;
+    int runs = 0, woke = 0;
+    bool ok = true;
+    for (uint32_t phase = 0; phase < POWER_IDLE_TICK_MS; phase += 7, runs++) {
+        BoardRun run = engineOff(POWER_SETTING_SCALING, 100000);
+        run.crankMs = 90000 + phase;
+        BoardResult idle, full;
+        runBoard(tp, run, idle);
+        run.setting = POWER_SETTING_OFF;
+        runBoard(tp, run, full);
+
+        bool wasIdle = idle.powerIdleMs > 0 && idle.powerIdleMs < run.crankMs;
+        bool byPressure = idle.power.stats.wakes[POWER_WAKE_PRESSURE] + idle.power.stats.wakes[POWER_WAKE_CONTROL] == 1;
+        if (wasIdle && byPressure && idle.crankActiveMs) woke++;
+        uint32_t wake = idle.crankActiveMs - idle.thresholdMs;
+        uint32_t extra = idle.reactivatedMs > full.reactivatedMs ? idle.reactivatedMs - full.reactivatedMs : 0;
+        if (wake > worstWake) worstWake = wake;
+        if (extra > worstExtra) worstExtra = extra;
+        ok = ok && idle.crankActiveMs && idle.reactivatedMs && full.reactivatedMs && wake <= bound && extra <= POWER_IDLE_TICK_MS;
+    }
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%d/%d starts woke it, worst %lu ms (bound %lu ms); pipeline up to %lu ms later than at full rate",
+             woke, runs, (unsigned long)worstWake, (unsigned long)bound, (unsigned long)worstExtra);
+    check(ok && woke == runs, "engine start wakes it", detail);
+}
+
+static void checkTouch(const ToolParams& tp) {
+    BoardRun run = engineOff(POWER_SETTING_LIGHT_SLEEP, 100000);
+    run.touchMs[run.touches++] = 80033;
+    BoardResult r;
+    runBoard(tp, run, r);
+    uint32_t bound = powerWakeBoundMs(WINDOW, CONTROL_TASK_DELAY_MS);
+    bool ok = r.power.stats.wakes[POWER_WAKE_ACTIVITY] == 1 && r.touchWakeMs > 0 && r.touchWakeMs <= bound &&
+              r.idleEntries == 2 && r.reentryMs + CONTROL_TASK_DELAY_MS >= POWER_IDLE_ENTER_MS && r.reentryMs <= POWER_IDLE_ENTER_MS + CONTROL_TASK_DELAY_MS &&
+              r.solenoidOffWhileIdle;
+    char detail[200];
+    snprintf(detail, sizeof(detail), "awake %lu ms after the touch (bound %lu ms), idle again %.2f s later", (unsigned long)r.touchWakeMs,
+             (unsigned long)bound, r.reentryMs * 0.001);
+    check(ok, "touch wakes it", detail);
+}
+
+static void checkStaysActive(const ToolParams& tp) {
+    BoardRun off = engineOff(POWER_SETTING_OFF, 120000);
+    BoardResult offResult;
+    runBoard(tp, off, offResult);
+
+    BoardRun touched = engineOff(POWER_SETTING_LIGHT_SLEEP, 120000);
+    // From just after the pipeline has turned the solenoid off, which a touch would put off.
+    for (uint32_t t = 61000; t < touched.endMs && touched.touches < MAX_TOUCHES; t += POWER_IDLE_ENTER_MS - 1000) {
+        touched.touchMs[touched.touches++] = t;
+    }
+    BoardResult touchedResult;
+    runBoard(tp, touched, touchedResult);
+
+    bool ok = offResult.pipelineIdleMs > 0 && offResult.idleEntries == 0 && offResult.power.stats.modeMs[POWER_ACTIVE] == offResult.endMs &&
+              touchedResult.pipelineIdleMs > 0 && touchedResult.idleEntries == 0;
+    char detail[200];
+    snprintf(detail, sizeof(detail), "setting off: %d idle entries; touched every %.0f s: %d", offResult.idleEntries,
+             (POWER_IDLE_ENTER_MS - 1000) * 0.001, touchedResult.idleEntries);
+    check(ok, "stays active", detail);
+}
+
+static void checkResidencyAndCurrent(const ToolParams& tp) {
+    BoardRun run = engineOff(POWER_SETTING_LIGHT_SLEEP, 600000);
+    run.crankMs = 500000;
+    BoardResult r;
+    runBoard(tp, run, r);
+    uint32_t sum = 0;
+    for (int mode = 0; mode < POWER_MODE_COUNT; mode++) sum += r.power.stats.modeMs[mode];
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%.1f s active, %.1f s idle, %.3f s waking, of %.1f s", r.power.stats.modeMs[POWER_ACTIVE] * 0.001,
+             r.power.stats.modeMs[POWER_IDLE] * 0.001, r.power.stats.modeMs[POWER_WAKING] * 0.001, r.endMs * 0.001);
+    check(sum == r.endMs && r.power.stats.modeMs[POWER_WAKING] > 0, "time in each mode", detail);
+
+    float sleeping = powerEstimatedCurrentmA(r.power.stats, WINDOW, true);
+    float scaling = powerEstimatedCurrentmA(r.power.stats, WINDOW, false);
+    PowerStats idleOnly = {};
+    idleOnly.modeMs[POWER_IDLE] = 1000;
+    float idleSleeping = powerEstimatedCurrentmA(idleOnly, WINDOW, true);
+    float idleScaling = powerEstimatedCurrentmA(idleOnly, WINDOW, false);
+    bool ordered = sleeping < scaling && scaling < POWER_ACTIVE_MA && idleSleeping < idleScaling && idleScaling < POWER_ACTIVE_MA &&
+                   idleSleeping > POWER_LIGHT_SLEEP_MA;
+    snprintf(detail, sizeof(detail), "mean %.1f mA light sleep, %.1f mA scaling (%.1f mA full rate); idle alone %.2f / %.1f mA", sleeping,
+             scaling, POWER_ACTIVE_MA, idleSleeping, idleScaling);
+    check(ordered, "estimated current", detail);
+}
+
+static void checkBurst() {
+    bool ok = true;
+    int worstWindow = 0;
+    float worstSpareMs = 1e9f;
+    for (int window = 1; window <= SENSOR_AVERAGE_MAX; window++) {
+        float fillMs = (float)window * 1000.0f / SENSOR_SCAN_HZ;
+        float spare = (float)powerBurstMs(window) - fillMs;
+        if (spare < worstSpareMs) { worstSpareMs = spare; worstWindow = window; }
+        ok = ok && spare >= 1.0f && spare <= 2.0f && powerBurstMs(window) < (int)POWER_IDLE_TICK_MS &&
+             powerWakeBoundMs(window, CONTROL_TASK_DELAY_MS) >= POWER_IDLE_TICK_MS + (uint32_t)powerBurstMs(window);
+    }
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%d ms for %d conversions, %d ms for %d; least spare %.2f ms (window %d)", powerBurstMs(WINDOW), WINDOW,
+             powerBurstMs(SENSOR_AVERAGE_MAX), SENSOR_AVERAGE_MAX, worstSpareMs, worstWindow);
+    check(ok, "idle burst fills the window", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    checkIdleEntry(tp);
+    checkEngineStart(tp);
+    checkTouch(tp);
+    checkStaysActive(tp);
+    checkResidencyAndCurrent(tp);
+    checkBurst();
+    return checkExitCode();
+}
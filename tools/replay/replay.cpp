@@ -0,0 +1,177 @@
+//================================================================================
+// TRACE REPLAY
+//================================================================================
+// Runs a captured trace through the firmware's control pipeline (src/control.cpp)
+// and prints one CSV row per tick. Floats are printed with full precision so two
+// runs can be compared with a plain diff.
+//
+//   replay [--params FILE] [--set key=value]... [--out FILE] [--convert FILE.bin]
+//          [--expect FILE] TRACE
+//
+// With --expect the rows are also compared with a previous run's output and
+// the tool exits non-zero at the first difference. tools/replay/reference.csv
+// is a checked-in capture with its expected output:
+//
+//   replay --params tools/replay/reference_params.txt tools/replay/reference.csv
+//          --expect tools/replay/reference_expected.csv --out /dev/null
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "control.h"
+#include "tool_params.h"
+#include "trace_log.h"
+
+static ControlState state;
+
+static void usage() {
+    fprintf(stderr,
+        "usage: replay [--params FILE] [--set key=value]... [--out FILE] [--convert FILE.bin] [--expect FILE] TRACE\n"
+        "  TRACE     .csv capture (time_ms,voltage,target_kpa,flags,rpm_pulses,speed_pulses,\n"
+        "            backpressure_v,iat_v,supply_v,applied_pct) or binary trace\n"
+        "  --convert write TRACE as a binary trace and exit\n"
+        "  --expect  compare the output with FILE and exit non-zero if it differs\n");
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string tracePath, outPath, convertPath, expectPath, error;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--params" || arg == "--set" || arg == "--out" || arg == "--convert" || arg == "--expect") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--params") {
+                if (!loadToolParamsFile(tp, value, error)) { fprintf(stderr, "%s\n", error.c_str()); return 1; }
+            } else if (arg == "--set") {
+                if (!setToolParam(tp, value)) { fprintf(stderr, "bad --set '%s'\n", value.c_str()); return 1; }
+            } else if (arg == "--out") {
+                outPath = value;
+            } else if (arg == "--expect") {
+                expectPath = value;
+            } else {
+                convertPath = value;
+            }
+        } else if (arg[0] != '-' && tracePath.empty()) {
+            tracePath = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (tracePath.empty()) {
+        usage();
+        return 1;
+    }
+
+    TraceLog log;
+    if (!log.open(tracePath, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (log.size() == 0) {
+        fprintf(stderr, "%s: no records\n", tracePath.c_str());
+        return 1;
+    }
+
+    if (!convertPath.empty()) {
+        if (!TraceLog::writeBinary(convertPath, log.start(), &log[0], log.size(), error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<std::string> expected;
+    if (!expectPath.empty()) {
+        FILE* f = fopen(expectPath.c_str(), "r");
+        if (!f) { fprintf(stderr, "cannot open %s\n", expectPath.c_str()); return 1; }
+        char line[256];
+        while (fgets(line, sizeof(line), f)) expected.push_back(line);
+        fclose(f);
+    }
+
+    FILE* out = stdout;
+    if (!outPath.empty()) {
+        out = fopen(outPath.c_str(), "w");
+        if (!out) { fprintf(stderr, "cannot create %s\n", outPath.c_str()); return 1; }
+    }
+
+    ControlParams params;
+    toControlParams(tp, params);
+    traceControlInit(log, state, params);
+
+    // Rows are compared with --expect as they are printed; the header is row 0.
+    size_t row = 0, firstDifference = 0;
+    bool differs = false;
+    char text[256];
+    auto emit = [&]() {
+        fputs(text, out);
+        if (!expectPath.empty() && !differs && (row >= expected.size() || expected[row] != text)) {
+            differs = true;
+            firstDifference = row;
+        }
+        row++;
+    };
+
+    snprintf(text, sizeof(text), "time_ms,raw_kpa,filtered_kpa,duty_pct,spool_state,torque_state,spool_score,torque_score\n");
+    emit();
+    int spoolEvents = 0, torqueEvents = 0;
+    float bestSpool = 0, bestTorque = 0;
+    ControlInput input;
+    ControlOutput result;
+    SensorSample sensors;
+    input.previousDutyPercent = 0;
+    input.sensors = &sensors;
+    for (size_t i = 0; i < log.size(); i++) {
+        const TraceRecord& r = log[i];
+        input.timeMs = r.timeMs;
+        input.measuredVoltage = r.voltage;
+        input.targetkPa = r.targetkPa;
+        input.activityDetected = (r.flags & TRACE_FLAG_ACTIVITY) != 0;
+        input.rpmPulses = r.rpmPulses;
+        input.speedPulses = r.speedPulses;
+        traceSensorSample(r, sensors);
+        if (r.flags & TRACE_FLAG_FF_CLEARED) feedForwardClear(state.feedForward);
+        // The relay, the overboost cut, the failsafe or the characterization
+        // drove the solenoid, not this controller.
+        if (r.flags & TRACE_FLAG_DUTY_OVERRIDE) input.previousDutyPercent = r.appliedPercent;
+        controlStep(state, params, input, result);
+        input.previousDutyPercent = result.controlPercent;
+
+        snprintf(text, sizeof(text), "%u,%.9g,%.9g,%.9g,%d,%d,%.9g,%.9g\n", (unsigned)r.timeMs, result.rawPressure,
+                 result.currentPressure, result.controlPercent, (int)state.spoolState, (int)state.torqueState,
+                 result.spoolScoreReady ? result.spoolScore : 0.0f, result.torqueScoreReady ? result.torqueScore : 0.0f);
+        emit();
+        if (result.spoolScoreReady) {
+            spoolEvents++;
+            if (result.spoolScore > bestSpool) bestSpool = result.spoolScore;
+        }
+        if (result.torqueScoreReady) {
+            torqueEvents++;
+            if (result.torqueScore > bestTorque) bestTorque = result.torqueScore;
+        }
+    }
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "%zu ticks, %d spool events (best %.1f), %d torque events (best %.1f)\n",
+            log.size(), spoolEvents, bestSpool, torqueEvents, bestTorque);
+    if (expectPath.empty()) return 0;
+
+    if (!differs && row != expected.size()) {
+        differs = true;
+        firstDifference = row;
+    }
+    char detail[160];
+    if (differs) {
+        snprintf(detail, sizeof(detail), "first difference at row %zu of %zu (%s)", firstDifference, expected.size(),
+                 expectPath.c_str());
+    } else {
+        snprintf(detail, sizeof(detail), "%zu rows match %s", row, expectPath.c_str());
+    }
+    check(!differs, "replay matches expected", detail);
+    return checkExitCode();
+}
@@ -0,0 +1,340 @@
+//================================================================================
+// RPM INPUT AND BOOST MAP CHECK
+//================================================================================
+// Drives the RPM subsystem (src/rpm.h) from a simulated engine behind the same
+// PulseCounter interface the firmware's PCNT backend implements. The engine
+// pulls through the gears, shifting at a set RPM with a short clutch dip, and
+// produces tach and speed pulses with the fractional remainder carried over.
+// Checks:
+//   - RPM and speed estimates match the simulated engine averaged over the
+//     same window, to within one pulse
+//   - gear from the speed input, and gear from RPM drops alone, agree with
+//     the engine once each shift has settled, and RPM inference drops back to
+//     first after idling
+//   - the boost map reproduces a bilinear surface, clamps at its edges and
+//     parses its serial keys
+//   - through the full control pipeline on the simulated plant, the target
+//     the loop chases follows the map's first-gear row, then the second's
+//
+//   rpm [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+//--------------------------------------------------------------------------------
+// Simulated engine
+//--------------------------------------------------------------------------------
+
+static const float ENGINE_RPM_PER_KPH[RPM_MAP_GEARS] = {140.0f, 85.0f, 60.0f, 46.0f, 37.0f, 31.0f};
+static const float SHIFT_RPM = 6500.0f;
+static const float SHIFT_MS = 250.0f;
+
+struct FakeEngine {
+    float speedKph;
+    int gear;
+    float shiftRemainingMs;     // > 0 while the clutch is in
+    float shiftFromRpm;
+    float rpm;
+    double tachCarry, speedCarry;
+    uint32_t tachPulses, speedPulses;   // accumulated since the last takePulses()
+    float pulsesPerRev, speedPulsesPerKm;
+};
+
+static uint32_t takeTach(void* context) {
+    FakeEngine& e = *(FakeEngine*)context;
+    uint32_t n = e.tachPulses;
+    e.tachPulses = 0;
+    return n;
+}
+
+static uint32_t takeSpeed(void* context) {
+    FakeEngine& e = *(FakeEngine*)context;
+    uint32_t n = e.speedPulses;
+    e.speedPulses = 0;
+    return n;
+}
+
+static void engineInit(FakeEngine& e, float speedKph, float pulsesPerRev, float speedPulsesPerKm) {
+    e.speedKph = speedKph;
+    e.gear = 1;
+    e.shiftRemainingMs = 0;
+    e.shiftFromRpm = 0;
+    e.rpm = speedKph * ENGINE_RPM_PER_KPH[0];
+    e.tachCarry = 0;
+    e.speedCarry = 0;
+    e.tachPulses = 0;
+    e.speedPulses = 0;
+    e.pulsesPerRev = pulsesPerRev;
+    e.speedPulsesPerKm = speedPulsesPerKm;
+}
+
+// Wide-open throttle: accelerates, shifts at SHIFT_RPM through gearCount gears.
+// Without throttle it coasts down to idle with the clutch in.
+static void engineStep(FakeEngine& e, float dtMs, int gearCount, bool throttle) {
+    if (!throttle) {
+        e.rpm += (900.0f - e.rpm) * dtMs / 400.0f;
+        e.speedKph -= 10.0f * dtMs / 1000.0f;
+        if (e.speedKph < 0) e.speedKph = 0;
+    } else {
+        e.speedKph += (40.0f / e.gear) * dtMs / 1000.0f;
+        float geared = e.speedKph * ENGINE_RPM_PER_KPH[e.gear - 1];
+        if (e.shiftRemainingMs > 0) {
+            e.shiftRemainingMs -= dtMs;
+            float frac = e.shiftRemainingMs > 0 ? e.shiftRemainingMs / SHIFT_MS : 0.0f;
+            e.rpm = geared + (e.shiftFromRpm - geared) * frac;
+        } else {
+            e.rpm = geared;
+            if (e.rpm >= SHIFT_RPM && e.gear < gearCount) {
+                e.shiftFromRpm = e.rpm;
+                e.gear++;
+                e.shiftRemainingMs = SHIFT_MS;
+            }
+        }
+    }
+    e.tachCarry += e.rpm / 60.0 * e.pulsesPerRev * dtMs / 1000.0;
+    e.speedCarry += e.speedKph / 3600.0 * e.speedPulsesPerKm * dtMs / 1000.0;
+    uint32_t tach = (uint32_t)e.tachCarry;
+    uint32_t speed = (uint32_t)e.speedCarry;
+    e.tachCarry -= tach;
+    e.speedCarry -= speed;
+    e.tachPulses += tach;
+    e.speedPulses += speed;
+}
+
+static RpmConfig engineConfig(bool speedInput) {
+    RpmConfig config;
+    config.enabled = true;
+    config.pulsesPerRev = 2.0f;
+    config.speedPulsesPerKm = speedInput ? 2000.0f : 0.0f;
+    config.gearCount = RPM_MAP_GEARS;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) config.gearRpmPerKph[g] = ENGINE_RPM_PER_KPH[g];
+    return config;
+}
+
+//--------------------------------------------------------------------------------
+// Checks
+//--------------------------------------------------------------------------------
+
+static void checkEstimates() {
+    RpmConfig config = engineConfig(true);
+    FakeEngine engine;
+    engineInit(engine, 20.0f, config.pulsesPerRev, config.speedPulsesPerKm);
+    PulseCounter tach = {&engine, takeTach};
+    PulseCounter speed = {&engine, takeSpeed};
+    RpmState state;
+    rpmInit(state);
+
+    // True values averaged over the same trailing window the estimator sums.
+    float rpmHistory[RPM_WINDOW_TICKS] = {0};
+    float speedHistory[RPM_WINDOW_TICKS] = {0};
+    const uint32_t dtMs = CONTROL_TASK_DELAY_MS;
+    float worstRpm = 0, worstSpeed = 0;
+    bool rpmOk = true, speedOk = true;
+    for (int tick = 0; tick < 1500; tick++) {
+        engineStep(engine, (float)dtMs, config.gearCount, true);
+        rpmHistory[tick % RPM_WINDOW_TICKS] = engine.rpm;
+        speedHistory[tick % RPM_WINDOW_TICKS] = engine.speedKph;
+        rpmUpdate(state, config, tach.takePulses(tach.context), speed.takePulses(speed.context), dtMs, true);
+        if (tick < RPM_WINDOW_TICKS) continue;
+        float rpmMean = 0, speedMean = 0;
+        for (int i = 0; i < RPM_WINDOW_TICKS; i++) {
+            rpmMean += rpmHistory[i] / RPM_WINDOW_TICKS;
+            speedMean += speedHistory[i] / RPM_WINDOW_TICKS;
+        }
+        float windowMs = (float)(RPM_WINDOW_TICKS * dtMs);
+        float rpmPulse = 60000.0f / (config.pulsesPerRev * windowMs);
+        float speedPulse = 3600000.0f / (config.speedPulsesPerKm * windowMs);
+        float rpmError = fabsf(state.rpm - rpmMean);
+        float speedError = fabsf(state.speedKph - speedMean);
+        if (rpmError > worstRpm) worstRpm = rpmError;
+        if (speedError > worstSpeed) worstSpeed = speedError;
+        if (rpmError > rpmPulse * 1.01f) rpmOk = false;
+        if (speedError > speedPulse * 1.01f) speedOk = false;
+    }
+    char detail[128];
+    snprintf(detail, sizeof(detail), "max_error=%.0f rpm (one pulse = %.0f)", worstRpm,
+             60000.0f / (config.pulsesPerRev * RPM_WINDOW_TICKS * CONTROL_TASK_DELAY_MS));
+    check(rpmOk, "rpm estimate", detail);
+    snprintf(detail, sizeof(detail), "max_error=%.2f km/h", worstSpeed);
+    check(speedOk, "speed estimate", detail);
+}
+
+// Runs a pull up through the gears and counts ticks where the inferred gear
+// disagrees with the engine, ignoring each shift and the settle time after it.
+static void checkGears(bool speedInput, const char* name) {
+    RpmConfig config = engineConfig(speedInput);
+    FakeEngine engine;
+    engineInit(engine, 20.0f, config.pulsesPerRev, config.speedPulsesPerKm);
+    RpmState state;
+    rpmInit(state);
+
+    const uint32_t dtMs = CONTROL_TASK_DELAY_MS;
+    const float settleMs = 400.0f;
+    float sinceShiftMs = settleMs;
+    int lastGear = engine.gear;
+    int compared = 0, wrong = 0, topGear = 0, engineTopGear = 0;
+    for (int tick = 0; tick < 6000 && !(engine.gear == config.gearCount && engine.rpm > 6000.0f); tick++) {
+        engineStep(engine, (float)dtMs, config.gearCount, true);
+        rpmUpdate(state, config, takeTach(&engine), takeSpeed(&engine), dtMs, true);
+        if (engine.gear != lastGear) {
+            lastGear = engine.gear;
+            sinceShiftMs = 0;
+        }
+        sinceShiftMs += dtMs;
+        if (tick < RPM_WINDOW_TICKS || engine.shiftRemainingMs > 0 || sinceShiftMs < settleMs) continue;
+        compared++;
+        if (state.gear != engine.gear) wrong++;
+        if (state.gear > topGear) topGear = state.gear;
+        if (engine.gear > engineTopGear) engineTopGear = engine.gear;
+    }
+
+    // Lift, clutch in, idle: RPM inference starts over in first.
+    bool reset = true;
+    if (!speedInput) {
+        for (int tick = 0; tick < 400; tick++) {
+            engineStep(engine, (float)dtMs, config.gearCount, false);
+            rpmUpdate(state, config, takeTach(&engine), takeSpeed(&engine), dtMs, false);
+        }
+        reset = state.gear == 1;
+    }
+    char detail[128];
+    snprintf(detail, sizeof(detail), "wrong %d of %d settled ticks, top gear %d of %d, idle reset %s", wrong, compared,
+             topGear, engineTopGear, speedInput ? "n/a" : (reset ? "yes" : "no"));
+    check(compared > 0 && wrong * 50 <= compared && topGear == engineTopGear && engineTopGear >= 4 && reset, name, detail);
+}
+
+static void checkMap() {
+    BoostTargetMap map;
+    boostMapReset(map);
+    map.enabled = 1;
+    // A plane is reproduced exactly by bilinear interpolation.
+    for (int g = 0; g < RPM_MAP_GEARS; g++) {
+        for (int r = 0; r < RPM_MAP_POINTS; r++) {
+            float rpm = RPM_MAP_MIN_RPM + r * RPM_MAP_STEP_RPM;
+            map.offsetkPa[g][r] = -30.0f + 5.0f * g + 0.004f * (rpm - 1000.0f);
+        }
+    }
+    float worst = 0;
+    for (float gear = 1.0f; gear <= 6.0f; gear += 0.25f) {
+        for (float rpm = 1000.0f; rpm <= 8000.0f; rpm += 137.0f) {
+            float expected = -30.0f + 5.0f * (gear - 1.0f) + 0.004f * (rpm - 1000.0f);
+            float error = fabsf(boostMapLookup(map, rpm, gear) - expected);
+            if (error > worst) worst = error;
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "max_error=%.5f kPa", worst);
+    check(worst < 1e-3f, "map bilinear", detail);
+
+    float below = boostMapLookup(map, 200.0f, 1.0f);
+    float above = boostMapLookup(map, 9500.0f, 9.0f);
+    float unknownGear = boostMapLookup(map, 3000.0f, 0.0f);
+    snprintf(detail, sizeof(detail), "below=%.2f above=%.2f unknown_gear=%.2f", below, above, unknownGear);
+    check(fabsf(below - map.offsetkPa[0][0]) < 1e-4f &&
+          fabsf(above - map.offsetkPa[RPM_MAP_GEARS - 1][RPM_MAP_POINTS - 1]) < 1e-4f &&
+          fabsf(unknownGear - map.offsetkPa[0][2]) < 1e-4f, "map edges", detail);
+
+    bool keys = boostMapEntry(map, "1.0") == &map.offsetkPa[0][0] && boostMapEntry(map, "6.7") == &map.offsetkPa[5][7] &&
+                !boostMapEntry(map, "0.0") && !boostMapEntry(map, "7.0") && !boostMapEntry(map, "1.8") &&
+                !boostMapEntry(map, "1") && !boostMapEntry(map, "1.2x") && !boostMapEntry(map, "a.1");
+    check(keys, "map keys", "");
+
+    BoostTargetMap blank;
+    unsigned char* bytes = (unsigned char*)&blank;
+    for (size_t i = 0; i < sizeof(blank); i++) bytes[i] = 0xFF;
+    bool reset = !boostMapSanitize(blank) && blank.enabled == 0 && blank.offsetkPa[3][3] == 0.0f;
+    check(reset && boostMapSanitize(map), "map sanitize", "");
+}
+
+// Full pipeline: the plant makes boost, the engine makes pulses, and the map
+// holds first gear 40 kPa below the target.
+static void checkClosedLoop(const ToolParams& base) {
+    ToolParams tp = base;
+    tp.rpmInputEnabled = 1;
+    tp.rpmPulsesPerRev = 2.0f;
+    tp.speedPulsesPerKm = 2000.0f;
+    tp.gearCount = RPM_MAP_GEARS;
+    for (int g = 0; g < RPM_MAP_GEARS; g++) tp.gearRpmPerKph[g] = ENGINE_RPM_PER_KPH[g];
+    boostMapReset(tp.boostMap);
+    tp.boostMap.enabled = 1;
+    for (int r = 0; r < RPM_MAP_POINTS; r++) tp.boostMap.offsetkPa[0][r] = -40.0f;
+    setpointProfileReset(tp.setpointProfile);
+
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    const PlantModel model = defaultPlantModel();
+    PlantState plant;
+    plantInit(plant, model);
+    FakeEngine engine;
+    engineInit(engine, 12.0f, tp.rpmPulsesPerRev, tp.speedPulsesPerKm);
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), 0);
+    ControlInput input;
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    input.activityDetected = false;
+    input.sensors = nullptr;
+    float duty = 0;
+    int firstGearTicks = 0, firstGearWrong = 0, secondGearTicks = 0, secondGearWrong = 0;
+    for (uint32_t t = (uint32_t)dtMs; t <= 6000 && engine.gear <= 2; t += (uint32_t)dtMs) {
+        engineStep(engine, dtMs, 2, true);
+        truePressure = plantStep(plant, model, duty, true, (float)t, dtMs);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, truePressure);
+        input.previousDutyPercent = duty;
+        input.rpmPulses = takeTach(&engine);
+        input.speedPulses = takeSpeed(&engine);
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+        if (t < 500 || engine.shiftRemainingMs > 0) continue;
+        if (state.rpm.gear == 1 && engine.gear == 1) {
+            firstGearTicks++;
+            if (fabsf(out.targetkPa - (tp.targetkPa - 40.0f)) > 1e-3f) firstGearWrong++;
+        } else if (state.rpm.gear == 2 && engine.gear == 2) {
+            secondGearTicks++;
+            if (fabsf(out.targetkPa - tp.targetkPa) > 1e-3f) secondGearWrong++;
+        }
+        if (engine.gear == 2 && engine.rpm >= SHIFT_RPM) break;
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "1st: %d/%d ticks at %.0f kPa, 2nd: %d/%d ticks at %.0f kPa",
+             firstGearTicks - firstGearWrong, firstGearTicks, tp.targetkPa - 40.0f, secondGearTicks - secondGearWrong,
+             secondGearTicks, tp.targetkPa);
+    check(firstGearTicks > 0 && secondGearTicks > 0 && firstGearWrong == 0 && secondGearWrong == 0,
+          "pipeline target by gear", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: rpm [--params FILE] [--set key=value]...\n");
+            return 1;
+        }
+    }
+
+    checkEstimates();
+    checkGears(true, "gear from speed input");
+    checkGears(false, "gear from rpm drops");
+    checkMap();
+    checkClosedLoop(tp);
+    return checkExitCode();
+}
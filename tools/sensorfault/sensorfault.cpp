@@ -0,0 +1,319 @@
+//================================================================================
+// SENSOR FAULT CHECK
+//================================================================================
+// Injects MAP sensor faults into simulated pulls through the full control
+// pipeline and checks the plausibility monitor (src/sensorfault.h):
+//   - open circuit (pin at 0 V) and short to the 5 V supply are raised on the
+//     tick they appear
+//   - a reading frozen just short of the target, the loop moving the duty
+//     against it, is raised as stuck on the tick the duty has swung
+//     SENSOR_STUCK_DUTY_SPAN, once it has been flat for SENSOR_STUCK_TICKS
+//   - an intermittent connection dropping the reading for single ticks is
+//     raised as slew within two ticks of the first dropout
+//   - a noisy sensor (+/- 8 kPa, under the slew limit) is raised as noise
+//   - each fault is raised once, with the right code, the solenoid is at the
+//     failsafe duty on that same tick and held there for the rest of the run,
+//     and the fault is not raised with the check off
+//   - once cleared with a healthy signal the loop boosts again without
+//     re-raising
+//   - no fault is raised over normal pulls (back to back, several targets,
+//     seeds, and fast, slow and laggy plants)
+//   - the fault log keeps the newest SENSOR_FAULT_LOG_SIZE records in order
+//     and a blank or corrupt log is cleared
+//
+//   sensorfault [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static const float NOISE_FAULT_KPA = 8.0f;
+static const int DROPOUT_EVERY = 5;          // ticks between single-tick dropouts
+static const float DROPOUT_KPA = 60.0f;      // reading during a dropout
+static const float TEST_FAILSAFE_PERCENT = 30.0f;
+static const float STUCK_BELOW_TARGET_KPA = 10.0f;
+
+struct FaultRun {
+    uint8_t fault;             // SensorFaultCode to inject, SENSOR_FAULT_NONE for a clean run
+    uint32_t injectMs;
+    float injectAtkPa;         // when set, inject once the true pressure first reaches it instead
+    uint32_t clearMs;          // 0 = never; the signal is healthy again from here
+    float targetkPa;
+    int pulls;
+    PlantModel model;
+};
+
+struct FaultResult {
+    int raisedCount;
+    uint8_t firstCode;
+    int detectTicks;           // from injection to the tick it was raised
+    int spanTicks;             // from injection until the applied duty had swung SENSOR_STUCK_DUTY_SPAN
+    bool failsafeOnRaise;      // solenoid at the failsafe duty that tick
+    bool failsafeHeld;         // and every tick until cleared
+    float peakAfterClearkPa;
+};
+
+static void runFault(const ToolParams& tp, const FaultRun& run, FaultResult& r) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PullProfile pull = defaultPullProfile();
+    const uint32_t cycleMs = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+
+    static ControlState state;
+    PlantState plant;
+    plantInit(plant, run.model);
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, run.model, params, truePressure), 0);
+    uint32_t faultRng = run.model.seed * 2654435761u + 7;
+
+    ControlInput input = {};
+    ControlOutput out;
+    input.targetkPa = run.targetkPa;
+    float drive = 0.0f;
+    float frozenVoltage = 0.0f;
+    uint32_t injectMs = run.injectAtkPa > 0.0f ? UINT32_MAX : run.injectMs;
+
+    r.raisedCount = 0;
+    r.firstCode = SENSOR_FAULT_NONE;
+    r.detectTicks = -1;
+    r.spanTicks = -1;
+    float dutyMin = 0.0f, dutyMax = 0.0f;
+    r.failsafeOnRaise = false;
+    r.failsafeHeld = true;
+    r.peakAfterClearkPa = 0.0f;
+
+    float dividerRatio = R2_OHMS / (R1_OHMS + R2_OHMS);
+    const uint32_t endMs = cycleMs * run.pulls;
+    for (uint32_t t = CONTROL_TASK_DELAY_MS; t <= endMs; t += CONTROL_TASK_DELAY_MS) {
+        uint32_t inCycle = t % cycleMs;
+        bool throttleOpen = inCycle >= pull.throttleOpenMs && inCycle < pull.throttleOpenMs + pull.pullMs;
+        float msSinceThrottle = (float)inCycle - (float)pull.throttleOpenMs;
+        truePressure = plantStep(plant, run.model, drive, throttleOpen, msSinceThrottle, (float)CONTROL_TASK_DELAY_MS);
+        float v = plantSensorVoltage(plant, run.model, params, truePressure);
+        if (injectMs == UINT32_MAX && truePressure >= run.injectAtkPa) injectMs = t;
+
+        bool faulty = run.fault != SENSOR_FAULT_NONE && t >= injectMs && (run.clearMs == 0 || t < run.clearMs);
+        if (faulty) {
+            if (run.fault == SENSOR_FAULT_OPEN) {
+                v = 0.0f;
+            } else if (run.fault == SENSOR_FAULT_SHORT) {
+                v = 5.0f * dividerRatio;
+            } else if (run.fault == SENSOR_FAULT_STUCK) {
+                if (t == injectMs) frozenVoltage = v;
+                v = frozenVoltage;
+            } else if (run.fault == SENSOR_FAULT_SLEW) {
+                if ((t - injectMs) / CONTROL_TASK_DELAY_MS % DROPOUT_EVERY == 0) {
+                    v = plantSensorVoltage(plant, run.model, params, DROPOUT_KPA);
+                }
+            } else if (run.fault == SENSOR_FAULT_NOISE) {
+                faultRng ^= faultRng << 13;
+                faultRng ^= faultRng >> 17;
+                faultRng ^= faultRng << 5;
+                float u = (float)(faultRng & 0xFFFF) / 32767.5f - 1.0f;
+                v += u * NOISE_FAULT_KPA * (params.maxSensorVoltage - params.minSensorVoltage) / (params.MAX_KPA - params.MIN_KPA);
+            }
+        }
+        if (t == run.clearMs) sensorFaultClear(state.sensorFault);
+
+        input.timeMs = t;
+        input.measuredVoltage = v;
+        input.previousDutyPercent = drive;
+        if (t == injectMs) dutyMin = dutyMax = drive;
+        if (t >= injectMs && r.spanTicks < 0) {
+            dutyMin = fminf(dutyMin, drive);
+            dutyMax = fmaxf(dutyMax, drive);
+            if (dutyMax - dutyMin >= SENSOR_STUCK_DUTY_SPAN) r.spanTicks = (int)((t - injectMs) / CONTROL_TASK_DELAY_MS);
+        }
+        controlStep(state, params, input, out);
+        drive = out.solenoidPercent;
+
+        if (out.sensorFaultRaised != SENSOR_FAULT_NONE) {
+            if (r.raisedCount == 0) {
+                r.firstCode = out.sensorFaultRaised;
+                r.detectTicks = t >= injectMs ? (int)((t - injectMs) / CONTROL_TASK_DELAY_MS) : -1;
+                r.failsafeOnRaise = out.solenoidPercent == params.sensorFailsafePercent;
+            }
+            r.raisedCount++;
+        }
+        if (r.raisedCount > 0 && (run.clearMs == 0 || t < run.clearMs) &&
+            (out.sensorFault == SENSOR_FAULT_NONE || out.solenoidPercent != params.sensorFailsafePercent)) {
+            r.failsafeHeld = false;
+        }
+        if (run.clearMs && t >= run.clearMs && truePressure > r.peakAfterClearkPa) r.peakAfterClearkPa = truePressure;
+    }
+}
+
+static PlantModel plantWithSeed(uint32_t seed) {
+    PlantModel model = defaultPlantModel();
+    model.seed = seed;
+    return model;
+}
+
+// maxTicks bounds the ticks from injection to the fault being raised; for a
+// stuck reading they are counted from when the check can first call it, the
+// run long enough and the duty swung far enough.
+static void checkFault(const ToolParams& tp, uint8_t fault, int maxTicks, const char* name) {
+    PullProfile pull = defaultPullProfile();
+    // Mid-pull, except that a stuck reading freezes just short of the target,
+    // so the loop goes on moving the duty against it.
+    uint32_t injectMs = pull.throttleOpenMs + 2000;
+    const float targets[] = {150.0f, 170.0f, 190.0f};
+    const uint32_t seeds[] = {12345, 777, 31337};
+    int runs = 0, detected = 0, failsafe = 0, held = 0, worstTicks = 0;
+    for (float target : targets) {
+        for (uint32_t seed : seeds) {
+            FaultRun run = {fault, injectMs, fault == SENSOR_FAULT_STUCK ? target - STUCK_BELOW_TARGET_KPA : 0.0f, 0, target, 1,
+                            plantWithSeed(seed)};
+            FaultResult r;
+            runFault(tp, run, r);
+            runs++;
+            int ticks = r.detectTicks;
+            if (fault == SENSOR_FAULT_STUCK) {
+                ticks = r.spanTicks < 0 ? -1 : r.detectTicks - std::max(r.spanTicks, SENSOR_STUCK_TICKS - 1);
+            }
+            if (r.raisedCount == 1 && r.firstCode == fault && r.detectTicks >= 0 && ticks >= 0 && ticks <= maxTicks) detected++;
+            if (r.failsafeOnRaise) failsafe++;
+            if (r.failsafeHeld) held++;
+            if (ticks > worstTicks) worstTicks = ticks;
+        }
+    }
+
+    // The configured duty is what is held, and nothing is raised with the check off.
+    ToolParams custom = tp;
+    custom.sensorFailsafePercent = TEST_FAILSAFE_PERCENT;
+    FaultRun run = {fault, injectMs, fault == SENSOR_FAULT_STUCK ? 170.0f - STUCK_BELOW_TARGET_KPA : 0.0f, 0, 170.0f, 1,
+                    plantWithSeed(12345)};
+    FaultResult r;
+    runFault(custom, run, r);
+    bool customOk = r.raisedCount == 1 && r.failsafeOnRaise && r.failsafeHeld;
+    ToolParams off = tp;
+    off.sensorFaultCheck = 0;
+    runFault(off, run, r);
+    bool offOk = r.raisedCount == 0;
+
+    char detail[200];
+    snprintf(detail, sizeof(detail), "%d/%d raised as %s, worst %d ticks (bound %d), failsafe %d same tick %d held, %.0f%% %s, off %s",
+             detected, runs, sensorFaultName(fault), worstTicks, maxTicks, failsafe, held, TEST_FAILSAFE_PERCENT,
+             customOk ? "ok" : "no", offOk ? "ok" : "RAISED");
+    check(detected == runs && failsafe == runs && held == runs && customOk && offOk, name, detail);
+}
+
+static void checkClear(const ToolParams& tp) {
+    PullProfile pull = defaultPullProfile();
+    // Open circuit during the cruise before the second pull, reconnected and
+    // cleared before it starts.
+    uint32_t cycleMs = pull.throttleOpenMs + pull.pullMs + pull.coastMs;
+    FaultRun run = {SENSOR_FAULT_OPEN, cycleMs + 200, 0.0f, cycleMs + 600, 170.0f, 2, plantWithSeed(12345)};
+    FaultResult r;
+    runFault(tp, run, r);
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%d raised, peak %.1f kPa after the clear (target %.0f)", r.raisedCount,
+             r.peakAfterClearkPa, run.targetkPa);
+    check(r.raisedCount == 1 && r.failsafeHeld && r.peakAfterClearkPa > run.targetkPa - 10.0f, "clear and resume", detail);
+}
+
+static void checkNoFalseFaults(const ToolParams& tp) {
+    const float targets[] = {130.0f, 150.0f, 170.0f, 190.0f};
+    const uint32_t seeds[] = {12345, 777, 31337, 4242, 9001};
+    PlantModel plants[4];
+    const char* const plantNames[4] = {"default", "fast spool", "slow spool", "laggy"};
+    plants[0] = defaultPlantModel();
+    plants[1] = plants[0];
+    plants[1].spoolTimeMs = 700.0f;
+    plants[2] = plants[0];
+    plants[2].spoolTimeMs = 2500.0f;
+    plants[3] = plants[0];
+    plants[3].tauMs = 250.0f;
+    plants[3].deadTimeMs = 80.0f;
+    int runs = 0, raised = 0;
+    char first[96] = "";
+    for (int p = 0; p < 4; p++) {
+        for (float target : targets) {
+            for (uint32_t seed : seeds) {
+                FaultRun run = {SENSOR_FAULT_NONE, 0, 0.0f, 0, target, 3, plants[p]};
+                run.model.seed = seed;
+                FaultResult r;
+                runFault(tp, run, r);
+                runs++;
+                if (r.raisedCount > 0) {
+                    if (raised == 0) {
+                        snprintf(first, sizeof(first), ", first %s (%s, %.0f kPa, seed %u)", sensorFaultName(r.firstCode),
+                                 plantNames[p], target, (unsigned)seed);
+                    }
+                    raised++;
+                }
+            }
+        }
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%d/%d runs of 3 pulls raised a fault%s", raised, runs, first);
+    check(raised == 0, "no false faults", detail);
+}
+
+static void checkLog() {
+    SensorFaultLog log;
+    sensorFaultLogClear(log);
+    const int added = SENSOR_FAULT_LOG_SIZE + 3;
+    for (int i = 0; i < added; i++) {
+        SensorFaultRecord record = {(uint8_t)(SENSOR_FAULT_OPEN + i % (SENSOR_FAULT_CODE_COUNT - 1)), (uint32_t)(1000 * (i + 1)),
+                                    0.1f * i, (float)i};
+        sensorFaultLogAdd(log, record);
+    }
+    bool ordered = log.count == SENSOR_FAULT_LOG_SIZE && log.dirty;
+    SensorFaultRecord record;
+    for (int age = 0; age < SENSOR_FAULT_LOG_SIZE; age++) {
+        if (!sensorFaultLogGet(log, age, record) || record.timeMs != (uint32_t)(1000 * (added - age))) ordered = false;
+    }
+    bool bounded = !sensorFaultLogGet(log, SENSOR_FAULT_LOG_SIZE, record) && !sensorFaultLogGet(log, -1, record);
+
+    SensorFaultLog kept = log;
+    bool validKept = sensorFaultLogSanitize(kept) && memcmp(kept.records, log.records, sizeof(log.records)) == 0 &&
+                     kept.count == log.count && !kept.dirty;
+    SensorFaultLog blank;
+    memset(&blank, 0xFF, sizeof(blank));
+    bool blankCleared = !sensorFaultLogSanitize(blank) && blank.count == 0 && !sensorFaultLogGet(blank, 0, record);
+    SensorFaultLog corrupt = log;
+    corrupt.records[(corrupt.next + SENSOR_FAULT_LOG_SIZE - 3) % SENSOR_FAULT_LOG_SIZE].detail = NAN;
+    bool corruptCleared = !sensorFaultLogSanitize(corrupt) && corrupt.count == 0;
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%d added, order %s, bounds %s, valid kept %s, blank %s, corrupt %s", added,
+             ordered ? "ok" : "no", bounded ? "ok" : "no", validKept ? "ok" : "no", blankCleared ? "cleared" : "KEPT",
+             corruptCleared ? "cleared" : "KEPT");
+    check(ordered && bounded && validKept && blankCleared && corruptCleared, "fault log", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    checkFault(tp, SENSOR_FAULT_OPEN, 0, "open circuit");
+    checkFault(tp, SENSOR_FAULT_SHORT, 0, "short to supply");
+    checkFault(tp, SENSOR_FAULT_STUCK, 0, "stuck reading");
+    checkFault(tp, SENSOR_FAULT_SLEW, 1, "intermittent (slew)");
+    checkFault(tp, SENSOR_FAULT_NOISE, SENSOR_NOISE_WARMUP_TICKS, "noisy sensor");
+    checkClear(tp);
+    checkNoFalseFaults(tp);
+    checkLog();
+    return checkExitCode();
+}
@@ -0,0 +1,268 @@
+//================================================================================
+// MULTI-CHANNEL SENSOR CHECK
+//================================================================================
+// Exercises the acquisition layer and the auxiliary channels (src/sensors.h):
+//   - the per-channel moving average matches a direct average of the newest
+//     OVERSAMPLE_COUNT conversions, with the channels interleaved as the DMA
+//     scan delivers them, across window changes and the 512 clamp
+//   - calibration reproduces both ends of each sensor's range through its
+//     divider, and blank or inverted calibrations are reset
+//   - supply compensation and the IAT trim follow their formulas and limits
+//   - through the full control pipeline on the simulated plant, with the
+//     solenoid's drive scaled by supply / nominal voltage, compensation at a
+//     sagging supply reproduces the pressure trace at nominal voltage much
+//     more closely than running uncompensated; and hot intake air lowers the
+//     target by the trim and the pull settles on the trimmed target
+//
+//   sensors [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static bool near(float a, float b, float tolerance) {
+    return fabsf(a - b) <= tolerance;
+}
+
+static void checkAverager() {
+    static SensorAverager averager;
+    sensorAveragerInit(averager, 256);
+    char detail[128];
+
+    SensorSample sample;
+    sensorAveragerSample(averager, 5, sample);
+    bool empty = sample.timeMs == 5;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) empty = empty && sample.samples[c] == 0 && sample.voltage[c] == 0.0f;
+    check(empty, "empty window", "");
+
+    // Pseudo-random codes per channel, pushed round-robin like a scan pass.
+    std::vector<uint16_t> history[SENSOR_CHANNEL_COUNT];
+    uint32_t rng = 12345;
+    float worst = 0.0f;
+    int windows[] = {256, 256, 16, 600, 1, 100};
+    for (int phase = 0; phase < 6; phase++) {
+        sensorAveragerSetWindow(averager, windows[phase]);
+        int window = windows[phase] > SENSOR_AVERAGE_MAX ? SENSOR_AVERAGE_MAX : windows[phase];
+        for (int pass = 0; pass < 700; pass++) {
+            for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+                rng = rng * 1664525u + 1013904223u;
+                uint16_t code = (uint16_t)((rng >> 8) % 4096);
+                sensorAveragerPush(averager, c, code);
+                history[c].push_back(code);
+            }
+            if (pass % 37 != 0) continue;
+            sensorAveragerSample(averager, pass, sample);
+            for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+                int count = (int)history[c].size() < window ? (int)history[c].size() : window;
+                double sum = 0;
+                for (int i = 0; i < count; i++) sum += history[c][history[c].size() - 1 - i];
+                float expected = (float)(sum / count) / ADC_FULL_SCALE_CODE * ADC_FULL_SCALE_VOLTS;
+                float error = fabsf(sample.voltage[c] - expected);
+                if (error > worst) worst = error;
+                if (sample.samples[c] != count) worst = 1.0f;
+            }
+        }
+    }
+    snprintf(detail, sizeof(detail), "max_error=%.2e V", worst);
+    check(worst < 1e-5f, "moving average", detail);
+}
+
+static void checkCalibration() {
+    char detail[160];
+    const float divider = R2_OHMS / (R1_OHMS + R2_OHMS);
+    const float supplyDivider = SUPPLY_R2_OHMS / (SUPPLY_R1_OHMS + SUPPLY_R2_OHMS);
+    const SensorCalibration& emap = BACKPRESSURE_CALIBRATION_DEFAULT;
+    const SensorCalibration& iat = IAT_CALIBRATION_DEFAULT;
+    const SensorCalibration& supply = SUPPLY_CALIBRATION_DEFAULT;
+
+    float emapLow = sensorValue(emap, divider, emap.rawMinVoltage * divider);
+    float emapHigh = sensorValue(emap, divider, emap.rawMaxVoltage * divider);
+    float iatMid = sensorValue(iat, divider, 0.5f * (iat.rawMinVoltage + iat.rawMaxVoltage) * divider);
+    float supply12 = sensorValue(supply, supplyDivider, 12.0f * supplyDivider);
+    snprintf(detail, sizeof(detail), "emap %.2f..%.2f kPa, iat_mid=%.2f C, supply(12V)=%.3f V, 16V pin=%.2f V",
+             emapLow, emapHigh, iatMid, supply12, 16.0f * supplyDivider);
+    check(near(emapLow, emap.minValue, 1e-3f) && near(emapHigh, emap.maxValue, 1e-2f) &&
+          near(iatMid, 0.5f * (iat.minValue + iat.maxValue), 1e-3f) && near(supply12, 12.0f, 1e-4f) &&
+          16.0f * supplyDivider < ADC_FULL_SCALE_VOLTS, "calibration", detail);
+
+    SensorCalibration blank = {NAN, NAN, NAN, NAN};
+    SensorCalibration inverted = {4.5f, 0.5f, -40.0f, 150.0f};
+    SensorCalibration good = {0.2f, 4.8f, 0.0f, 400.0f};
+    bool blankReset = !sensorCalibrationSanitize(blank, emap) && blank.rawMaxVoltage == emap.rawMaxVoltage;
+    bool invertedReset = !sensorCalibrationSanitize(inverted, iat) && inverted.rawMinVoltage == iat.rawMinVoltage;
+    bool goodKept = sensorCalibrationSanitize(good, emap) && good.maxValue == 400.0f;
+    check(blankReset && invertedReset && goodKept, "calibration sanitize", "");
+}
+
+static void checkCompensation() {
+    char detail[160];
+    float low = supplyCompensatedDuty(50.0f, 12.0f, 13.5f);
+    float high = supplyCompensatedDuty(50.0f, 14.4f, 13.5f);
+    float clampedUp = supplyCompensatedDuty(50.0f, 7.0f, 13.5f);
+    float capped = supplyCompensatedDuty(95.0f, 11.0f, 13.5f);
+    float fullOn = supplyCompensatedDuty(100.0f, 15.0f, 13.5f);
+    float unwired = supplyCompensatedDuty(50.0f, 0.3f, 13.5f);
+    snprintf(detail, sizeof(detail), "12V=%.2f 14.4V=%.2f 7V=%.2f 95%%@11V=%.1f full=%.1f unwired=%.1f", low, high,
+             clampedUp, capped, fullOn, unwired);
+    check(near(low, 56.25f, 1e-3f) && near(high, 46.875f, 1e-3f) && near(clampedUp, 50.0f * SUPPLY_COMP_MAX, 1e-3f) &&
+          capped == 100.0f && fullOn == 100.0f && unwired == 50.0f, "supply compensation", detail);
+
+    float cool = intakeTempTrimkPa(35.0f, 40.0f, 1.0f);
+    float warm = intakeTempTrimkPa(55.0f, 40.0f, 1.5f);
+    float hot = intakeTempTrimkPa(120.0f, 40.0f, 1.5f);
+    float off = intakeTempTrimkPa(120.0f, 40.0f, 0.0f);
+    snprintf(detail, sizeof(detail), "35C=%.1f 55C=%.1f 120C=%.1f off=%.1f", cool, warm, hot, off);
+    check(cool == 0.0f && near(warm, -22.5f, 1e-4f) && near(hot, -IAT_TRIM_MAX_KPA, 1e-4f) && off == 0.0f,
+          "iat trim", detail);
+}
+
+// Pin voltages that read back as the given values.
+static SensorSample auxSample(const ToolParams& tp, float backpressurekPa, float intakeTempC, float supplyVoltage) {
+    const float divider = R2_OHMS / (R1_OHMS + R2_OHMS);
+    const float supplyDivider = SUPPLY_R2_OHMS / (SUPPLY_R1_OHMS + SUPPLY_R2_OHMS);
+    auto pinVoltage = [](const SensorCalibration& cal, float ratio, float value) {
+        float raw = cal.rawMinVoltage + (value - cal.minValue) * (cal.rawMaxVoltage - cal.rawMinVoltage) /
+                                            (cal.maxValue - cal.minValue);
+        return raw * ratio;
+    };
+    SensorSample sample;
+    sample.timeMs = 0;
+    sample.voltage[SENSOR_MAP] = 0.0f;
+    sample.voltage[SENSOR_BACKPRESSURE] = pinVoltage(tp.backpressureCalibration, divider, backpressurekPa);
+    sample.voltage[SENSOR_IAT] = pinVoltage(tp.intakeTempCalibration, divider, intakeTempC);
+    sample.voltage[SENSOR_SUPPLY] = pinVoltage(tp.supplyCalibration, supplyDivider, supplyVoltage);
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) sample.samples[c] = 256;
+    return sample;
+}
+
+struct PullTrace {
+    std::vector<float> pressure;
+    float finalMeankPa;
+    float finalTargetkPa;
+};
+
+// One pull on the default plant. The solenoid's drive, and so the duty the
+// plant sees, scales with supply / nominal voltage below full on.
+static void runPull(const ToolParams& tp, float supplyVoltage, float intakeTempC, PullTrace& trace) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    const PlantModel model = defaultPlantModel();
+    PlantState plant;
+    plantInit(plant, model);
+
+    const PullProfile pull = defaultPullProfile();
+    const uint32_t liftMs = pull.throttleOpenMs + pull.pullMs;
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), 0);
+
+    SensorSample sensors = auxSample(tp, 110.0f, intakeTempC, supplyVoltage);
+    ControlInput input;
+    ControlOutput out;
+    input.targetkPa = tp.targetkPa;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = &sensors;
+    trace.pressure.clear();
+    trace.finalMeankPa = 0;
+    int finalSamples = 0;
+    float duty = 0, plantDuty = 0;
+    for (uint32_t t = (uint32_t)dtMs; t < liftMs; t += (uint32_t)dtMs) {
+        bool throttleOpen = t >= pull.throttleOpenMs;
+        truePressure = plantStep(plant, model, plantDuty, throttleOpen, (float)(t - pull.throttleOpenMs), dtMs);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, truePressure);
+        sensors.voltage[SENSOR_MAP] = input.measuredVoltage;
+        sensors.timeMs = t;
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+        plantDuty = out.solenoidPercent >= SUPPLY_COMP_FULL_PERCENT ? 100.0f
+                                                                    : out.solenoidPercent * supplyVoltage / tp.supplyNominalVoltage;
+        if (plantDuty > 100.0f) plantDuty = 100.0f;
+
+        if (throttleOpen) trace.pressure.push_back(truePressure);
+        if (t + 1000 >= liftMs) {
+            trace.finalMeankPa += truePressure;
+            finalSamples++;
+        }
+        trace.finalTargetkPa = out.targetkPa;
+    }
+    trace.finalMeankPa /= finalSamples;
+}
+
+static float rmsDifference(const PullTrace& a, const PullTrace& b) {
+    double sum = 0;
+    size_t n = a.pressure.size() < b.pressure.size() ? a.pressure.size() : b.pressure.size();
+    for (size_t i = 0; i < n; i++) {
+        double d = a.pressure[i] - b.pressure[i];
+        sum += d * d;
+    }
+    return n ? (float)sqrt(sum / n) : 0.0f;
+}
+
+static void checkClosedLoop(const ToolParams& tp) {
+    char detail[200];
+
+    ToolParams compensated = tp;
+    compensated.supplyCompensation = 1;
+    ToolParams plain = tp;
+    plain.supplyCompensation = 0;
+    const float sagVoltage = 11.0f;
+    PullTrace nominal, sagPlain, sagCompensated;
+    runPull(plain, tp.supplyNominalVoltage, 25.0f, nominal);
+    runPull(plain, sagVoltage, 25.0f, sagPlain);
+    runPull(compensated, sagVoltage, 25.0f, sagCompensated);
+    float plainError = rmsDifference(sagPlain, nominal);
+    float compensatedError = rmsDifference(sagCompensated, nominal);
+    snprintf(detail, sizeof(detail), "rms vs %.1f V trace at %.1f V: plain %.3f kPa, compensated %.3f kPa",
+             tp.supplyNominalVoltage, sagVoltage, plainError, compensatedError);
+    check(compensatedError < 0.5f * plainError, "supply compensation pull", detail);
+
+    // Trim from 20 kPa above the usual target, so the trimmed pull lands back
+    // on it, clear of the wastegate spring where duty runs out of authority.
+    ToolParams trimmed = tp;
+    trimmed.targetkPa = tp.targetkPa + 20.0f;
+    trimmed.iatTrimStartC = 40.0f;
+    trimmed.iatTrimkPaPerC = 1.0f;
+    PullTrace cool, hot;
+    runPull(trimmed, tp.supplyNominalVoltage, 35.0f, cool);
+    runPull(trimmed, tp.supplyNominalVoltage, 60.0f, hot);
+    snprintf(detail, sizeof(detail), "target at 35 C %.1f, at 60 C %.1f, final mean at 60 C %.1f kPa",
+             cool.finalTargetkPa, hot.finalTargetkPa, hot.finalMeankPa);
+    check(near(cool.finalTargetkPa, trimmed.targetkPa, 1e-3f) && near(hot.finalTargetkPa, tp.targetkPa, 0.05f) &&
+          near(hot.finalMeankPa, tp.targetkPa, 3.0f), "iat trim pull", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: sensors [--params FILE] [--set key=value]...\n");
+            return 1;
+        }
+    }
+
+    checkAverager();
+    checkCalibration();
+    checkCompensation();
+    checkClosedLoop(tp);
+    return checkExitCode();
+}
@@ -0,0 +1,255 @@
+//================================================================================
+// SETPOINT PROFILE CHECK
+//================================================================================
+// Exercises the setpoint trajectory (src/setpoint.h): breakpoint interpolation,
+// the forward-only cursor, restart on a new spool, the target slew limit and
+// the "ms:kPa,..." parser, then runs closed-loop pulls on the simulated plant
+// through the full control pipeline:
+//   - a traction curve (30 kPa held back for the first 1.5 s of boost) must
+//     lower the early peak by at least half the hold-back and still settle on
+//     the full target by the end of the pull. The peak is compared with the
+//     plain pull rather than the held target: with the default tuning the
+//     spool-up overshoots either way, the curve only moves where it lands
+//   - a ramped mid-pull target step must overshoot the new target less than
+//     the plain step, unless the plain step already stays within 3 kPa
+//
+//   setpoint [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "plant_sim.h"
+#include "tool_params.h"
+
+static bool near(float a, float b, float tolerance) {
+    return fabsf(a - b) <= tolerance;
+}
+
+static SetpointProfile tractionProfile() {
+    SetpointProfile profile;
+    setpointProfileReset(profile);
+    profile.enabled = 1;
+    profile.count = 3;
+    profile.timeMs[0] = 200.0f;  profile.offsetkPa[0] = -30.0f;
+    profile.timeMs[1] = 1500.0f; profile.offsetkPa[1] = -30.0f;
+    profile.timeMs[2] = 2500.0f; profile.offsetkPa[2] = 0.0f;
+    return profile;
+}
+
+static void checkEvaluation() {
+    SetpointProfile profile = tractionProfile();
+    char detail[128];
+
+    int cursor = 0;
+    float before = setpointOffset(profile, cursor, 100.0f);
+    float flat = setpointOffset(profile, cursor, 800.0f);
+    float middle = setpointOffset(profile, cursor, 2000.0f);
+    float after = setpointOffset(profile, cursor, 9000.0f);
+    snprintf(detail, sizeof(detail), "before=%.2f flat=%.2f middle=%.2f after=%.2f", before, flat, middle, after);
+    check(near(before, -30.0f, 1e-4f) && near(flat, -30.0f, 1e-4f) && near(middle, -15.0f, 1e-4f) &&
+          near(after, 0.0f, 1e-4f), "interpolation", detail);
+
+    // One forward sweep moves the cursor at most count - 1 times and agrees
+    // with a fresh evaluation at every tick.
+    cursor = 0;
+    float worst = 0.0f;
+    for (int t = 0; t <= 4000; t += 10) {
+        int fresh = 0;
+        float expected = setpointOffset(profile, fresh, (float)t);
+        float error = fabsf(setpointOffset(profile, cursor, (float)t) - expected);
+        if (error > worst) worst = error;
+    }
+    snprintf(detail, sizeof(detail), "cursor=%d max_error=%.6f", cursor, worst);
+    check(cursor <= profile.count - 1 && worst < 1e-5f, "cursor amortization", detail);
+
+    // The curve follows time since spool and starts over on the next pull.
+    SetpointState state;
+    setpointInit(state);
+    uint32_t t = 0;
+    float setpoint = 0.0f;
+    for (; t < 500; t += 10) setpoint = setpointUpdate(state, profile, 170.0f, false, t, 10.0f);
+    float offBoost = setpoint;
+    for (; t < 3500; t += 10) setpoint = setpointUpdate(state, profile, 170.0f, true, t, 10.0f);
+    float endOfPull = setpoint;
+    for (; t < 4000; t += 10) setpoint = setpointUpdate(state, profile, 170.0f, false, t, 10.0f);
+    for (; t < 4500; t += 10) setpoint = setpointUpdate(state, profile, 170.0f, true, t, 10.0f);
+    float nextPull = setpoint;
+    snprintf(detail, sizeof(detail), "off_boost=%.1f end_of_pull=%.1f next_pull=%.1f", offBoost, endOfPull, nextPull);
+    check(near(offBoost, 140.0f, 1e-3f) && near(endOfPull, 170.0f, 1e-3f) && near(nextPull, 140.0f, 1e-3f),
+          "restart on spool", detail);
+}
+
+static void checkRamp() {
+    SetpointProfile profile;
+    setpointProfileReset(profile);
+    profile.rampkPaPerS = 100.0f;
+    SetpointState state;
+    setpointInit(state);
+    char detail[128];
+
+    float first = setpointUpdate(state, profile, 150.0f, false, 0, 10.0f);
+    float oneTick = setpointUpdate(state, profile, 200.0f, false, 10, 10.0f);
+    float halfway = oneTick;
+    for (uint32_t t = 20; t <= 250; t += 10) halfway = setpointUpdate(state, profile, 200.0f, false, t, 10.0f);
+    float settled = halfway;
+    for (uint32_t t = 260; t <= 1000; t += 10) settled = setpointUpdate(state, profile, 200.0f, false, t, 10.0f);
+    float down = setpointUpdate(state, profile, 100.0f, false, 1010, 10.0f);
+    snprintf(detail, sizeof(detail), "first=%.2f tick=%.2f 250ms=%.2f settled=%.2f down=%.2f", first, oneTick, halfway,
+             settled, down);
+    check(near(first, 150.0f, 1e-4f) && near(oneTick, 151.0f, 1e-3f) && near(halfway, 175.0f, 1e-2f) &&
+          near(settled, 200.0f, 1e-4f) && near(down, 199.0f, 1e-3f), "ramp slew limit", detail);
+
+    profile.rampkPaPerS = 0.0f;
+    float step = setpointUpdate(state, profile, 120.0f, false, 1020, 10.0f);
+    snprintf(detail, sizeof(detail), "step=%.2f", step);
+    check(near(step, 120.0f, 1e-4f), "ramp off steps", detail);
+}
+
+static void checkParse() {
+    SetpointProfile profile = tractionProfile();
+    char text[SP_PROFILE_POINTS * 32];
+    setpointProfileFormat(profile, text, sizeof(text));
+    SetpointProfile parsed;
+    setpointProfileReset(parsed);
+    bool ok = setpointProfileParse(parsed, text);
+    bool same = ok && parsed.count == profile.count;
+    for (int i = 0; same && i < profile.count; i++) {
+        same = parsed.timeMs[i] == profile.timeMs[i] && parsed.offsetkPa[i] == profile.offsetkPa[i];
+    }
+    check(same, "format/parse round trip", text);
+
+    const char* const malformed[] = {
+        "abc", "100", "100:", ":5", "100:5;200:0", "200:-5,100:0", "100:-5,100:0", "-1:0", "100:500",
+        "0:0,1:0,2:0,3:0,4:0,5:0,6:0",
+    };
+    bool allRejected = true;
+    for (const char* bad : malformed) {
+        SetpointProfile untouched = profile;
+        if (setpointProfileParse(untouched, bad) || untouched.count != profile.count ||
+            untouched.timeMs[1] != profile.timeMs[1]) {
+            printf("  accepted or altered by '%s'\n", bad);
+            allRejected = false;
+        }
+    }
+    check(allRejected, "malformed lists rejected", "");
+
+    SetpointProfile cleared = profile;
+    check(setpointProfileParse(cleared, "") && cleared.count == 0, "empty list clears", "");
+}
+
+struct PullTrace {
+    float earlyPeakkPa;      // peak true pressure in the first earlyMs after throttle open
+    float finalMeankPa;      // mean true pressure over the last second of the pull
+    float stepOvershootkPa;  // peak above the target after the mid-pull change, if any
+};
+
+// Like simulatePull(), but with an optional mid-pull target change and the
+// figures this check needs.
+static void runPull(const ToolParams& tp, const PlantModel& model, float earlyMs, uint32_t changeAtMs, float changedTargetkPa,
+                    PullTrace& trace) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    PlantState plant;
+    plantInit(plant, model);
+
+    const PullProfile pull = defaultPullProfile();
+    const uint32_t liftMs = pull.throttleOpenMs + pull.pullMs;
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    float truePressure = plant.pressurekPa;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, truePressure), 0);
+
+    trace.earlyPeakkPa = 0;
+    trace.finalMeankPa = 0;
+    trace.stepOvershootkPa = 0;
+    int finalSamples = 0;
+    float duty = 0;
+    ControlInput input;
+    ControlOutput out;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = nullptr;
+    for (uint32_t t = (uint32_t)dtMs; t < liftMs; t += (uint32_t)dtMs) {
+        bool throttleOpen = t >= pull.throttleOpenMs;
+        truePressure = plantStep(plant, model, duty, throttleOpen, (float)(t - pull.throttleOpenMs), dtMs);
+        input.targetkPa = (changeAtMs && t >= changeAtMs) ? changedTargetkPa : tp.targetkPa;
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, truePressure);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+
+        if (throttleOpen && t < pull.throttleOpenMs + earlyMs && truePressure > trace.earlyPeakkPa) {
+            trace.earlyPeakkPa = truePressure;
+        }
+        if (t + 1000 >= liftMs) {
+            trace.finalMeankPa += truePressure;
+            finalSamples++;
+        }
+        if (changeAtMs && t >= changeAtMs && truePressure - changedTargetkPa > trace.stepOvershootkPa) {
+            trace.stepOvershootkPa = truePressure - changedTargetkPa;
+        }
+    }
+    trace.finalMeankPa /= finalSamples;
+}
+
+static void checkClosedLoop(const ToolParams& tp) {
+    const PlantModel model = defaultPlantModel();
+    char detail[160];
+
+    ToolParams plain = tp;
+    setpointProfileReset(plain.setpointProfile);
+    ToolParams curved = plain;
+    curved.setpointProfile = tractionProfile();
+
+    PullTrace a, b;
+    const float holdMs = 1500.0f;
+    runPull(plain, model, holdMs, 0, 0, a);
+    runPull(curved, model, holdMs, 0, 0, b);
+    float holdBackkPa = -curved.setpointProfile.offsetkPa[1];
+    snprintf(detail, sizeof(detail), "early_peak %.1f -> %.1f (hold-back %.0f), final %.1f -> %.1f (target %.0f)",
+             a.earlyPeakkPa, b.earlyPeakkPa, holdBackkPa, a.finalMeankPa, b.finalMeankPa, tp.targetkPa);
+    check(a.earlyPeakkPa - b.earlyPeakkPa >= 0.5f * holdBackkPa && near(b.finalMeankPa, tp.targetkPa, 3.0f),
+          "traction curve pull", detail);
+
+    // Target raised 40 kPa once the turbo is fully spooled.
+    ToolParams ramped = plain;
+    ramped.setpointProfile.rampkPaPerS = 40.0f;
+    const uint32_t changeAtMs = 3000;
+    const float raisedkPa = tp.targetkPa + 40.0f;
+    runPull(plain, model, 0, changeAtMs, raisedkPa, a);
+    runPull(ramped, model, 0, changeAtMs, raisedkPa, b);
+    snprintf(detail, sizeof(detail), "overshoot after +40 kPa: step %.2f, ramp %.2f", a.stepOvershootkPa, b.stepOvershootkPa);
+    check(b.stepOvershootkPa < a.stepOvershootkPa || (a.stepOvershootkPa <= 3.0f && b.stepOvershootkPa <= 3.0f),
+          "ramped target step", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: setpoint [--params FILE] [--set key=value]...\n");
+            return 1;
+        }
+    }
+
+    checkEvaluation();
+    checkRamp();
+    checkParse();
+    checkClosedLoop(tp);
+    return checkExitCode();
+}
@@ -0,0 +1,260 @@
+//================================================================================
+// SOLENOID LINEARIZATION CHECK
+//================================================================================
+// Exercises the solenoid output stage (src/solenoid.h):
+//   - with a straight curve and no dead time, linearization passes duty through
+//   - the inverse mapping: for convex, concave, S-shaped, saturating and
+//     late-opening curves, at several valve frequencies, the curve's flow at
+//     the linearized duty reproduces the requested flow and rises with it
+//   - the dead band is the dead time's share of the PWM period, and a
+//     sagging supply stretches it through the pipeline's output stage
+//   - the bench characterization, run against a simulated valve with
+//     pneumatic lag and sensor noise, recovers its response whichever way the
+//     valve is plumbed, and aborts without air or with the engine running
+//   - through the measured curve, the valve's gain (flow per % of controller
+//     output) is close to constant where the bare valve's varies several-fold
+//
+//   solenoid [--params FILE] [--set key=value]...
+//
+// Prints one line per check and exits non-zero when any fails.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "control.h"
+#include "tool_params.h"
+
+static float smoothstep(float x) {
+    if (x <= 0.0f) return 0.0f;
+    if (x >= 1.0f) return 1.0f;
+    return x * x * (3.0f - 2.0f * x);
+}
+
+// Shapes for the table, as flow (%) at effective duty e in 0..1.
+static float shapeConvex(float e) { return 100.0f * e * e; }
+static float shapeConcave(float e) { return 100.0f * sqrtf(e); }
+static float shapeS(float e) { return 100.0f * smoothstep(e); }
+static float shapeSaturating(float e) { return 100.0f * smoothstep(e / 0.7f); }
+static float shapeLateOpening(float e) { return e < 0.25f ? 0.0f : 100.0f * (e - 0.25f) / 0.75f; }
+
+static SolenoidCurve curveFrom(float (*shape)(float), float deadTimeMs) {
+    SolenoidCurve curve;
+    curve.enabled = 1;
+    curve.deadTimeMs = deadTimeMs;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) curve.flowPercent[i] = shape(i / (SOLENOID_CURVE_POINTS - 1.0f));
+    return curve;
+}
+
+static void checkPassThrough() {
+    SolenoidCurve curve;
+    solenoidCurveReset(curve);
+    SolenoidLinearizer linearizer;
+    solenoidLinearizerInit(linearizer);
+    solenoidLinearizerUpdate(linearizer, curve);
+    float worst = 0.0f;
+    for (int k = 0; k <= 1000; k++) {
+        float duty = k * 0.1f;
+        float error = fabsf(solenoidLinearize(linearizer, duty, solenoidDeadBandPercent(curve.deadTimeMs, 33)) - duty);
+        if (error > worst) worst = error;
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), "max_error=%.2e %%", worst);
+    check(worst < 1e-4f, "pass-through", detail);
+}
+
+static void checkInverse() {
+    struct Shape { const char* name; float (*fn)(float); };
+    const Shape shapes[] = {{"convex", shapeConvex}, {"concave", shapeConcave}, {"s-curve", shapeS},
+                            {"saturating", shapeSaturating}, {"late-opening", shapeLateOpening}};
+    const int frequencies[] = {20, 33, 50};
+    const float deadTimeMs = 2.5f;
+
+    float worst = 0.0f;
+    const char* worstShape = "";
+    int worstFrequency = 0;
+    bool monotonic = true, ends = true;
+    SolenoidLinearizer linearizer;
+    solenoidLinearizerInit(linearizer);
+    for (const Shape& shape : shapes) {
+        SolenoidCurve curve = curveFrom(shape.fn, deadTimeMs);
+        solenoidLinearizerUpdate(linearizer, curve);
+        for (int frequency : frequencies) {
+            float deadBand = solenoidDeadBandPercent(deadTimeMs, frequency);
+            if (solenoidLinearize(linearizer, 0.0f, deadBand) != 0.0f ||
+                solenoidLinearize(linearizer, 100.0f, deadBand) != 100.0f) ends = false;
+            float previous = 0.0f;
+            for (int k = 1; k < 400; k++) {
+                float flow = k * 0.25f;
+                float duty = solenoidLinearize(linearizer, flow, deadBand);
+                if (duty < previous) monotonic = false;
+                previous = duty;
+                float error = fabsf(solenoidFlow(curve, duty, deadBand) - flow);
+                if (error > worst) {
+                    worst = error;
+                    worstShape = shape.name;
+                    worstFrequency = frequency;
+                }
+            }
+        }
+    }
+    char detail[128];
+    snprintf(detail, sizeof(detail), "max flow error %.3f %% (%s, %d Hz)", worst, worstShape, worstFrequency);
+    check(worst < 0.5f && monotonic && ends, "inverse mapping", detail);
+}
+
+static void checkDeadBand(const ToolParams& tp) {
+    char detail[160];
+    float at20 = solenoidDeadBandPercent(3.0f, 20);
+    float at33 = solenoidDeadBandPercent(3.0f, 33);
+    float at50 = solenoidDeadBandPercent(3.0f, 50);
+    float capped = solenoidDeadBandPercent(SOLENOID_DEAD_TIME_MAX_MS, 50);
+    snprintf(detail, sizeof(detail), "3 ms at 20/33/50 Hz = %.2f/%.2f/%.2f %%, 20 ms at 50 Hz = %.0f %%", at20, at33,
+             at50, capped);
+    check(fabsf(at20 - 6.0f) < 1e-4f && fabsf(at33 - 9.9f) < 1e-4f && fabsf(at50 - 15.0f) < 1e-4f &&
+          capped == SOLENOID_DEAD_BAND_MAX_PERCENT, "dead band", detail);
+
+    // Through the pipeline's output stage, with the supply read at 11 V.
+    ControlParams params;
+    ToolParams t = tp;
+    t.solenoidCurve = curveFrom(shapeS, 3.0f);
+    t.supplyCompensation = 1;
+    toControlParams(t, params);
+    static ControlState state;
+    controlInit(state, params, 1.0f, 0);
+    solenoidLinearizerUpdate(state.solenoid, params.solenoidCurve);
+    state.aux.primed = true;
+    state.aux.supplyVoltage = 11.0f;
+    float sagged = controlSolenoidPercent(state, params, 0.001f);
+    state.aux.supplyVoltage = t.supplyNominalVoltage;
+    float nominal = controlSolenoidPercent(state, params, 0.001f);
+    float expectedSagged = solenoidDeadBandPercent(3.0f * t.supplyNominalVoltage / 11.0f, t.valveFrequencyHz);
+    snprintf(detail, sizeof(detail), "lowest duty at %.1f V %.2f %%, at 11 V %.2f %% (expected %.2f)",
+             t.supplyNominalVoltage, nominal, sagged, expectedSagged);
+    check(fabsf(nominal - solenoidDeadBandPercent(3.0f, t.valveFrequencyHz)) < 0.01f &&
+          fabsf(sagged - expectedSagged) < 0.01f, "supply dead time", detail);
+}
+
+// Bench valve: no flow for deadTimeMs of each period, then a rise that
+// steepens mid-travel and saturates before full duty. The line pressure
+// follows it with a lag.
+struct BenchValve {
+    float deadTimeMs;
+    int frequencyHz;
+    float lowkPa, highkPa;   // line pressure at no flow and full flow
+    float flow(float duty) const {
+        float deadBand = deadTimeMs * frequencyHz / 10.0f;
+        if (duty <= deadBand) return 0.0f;
+        float x = (duty - deadBand) / (100.0f - deadBand) / 0.85f;
+        if (x > 1.0f) x = 1.0f;
+        return 100.0f * (0.4f * x + 0.6f * smoothstep(x));
+    }
+};
+
+static uint32_t rngState = 2024;
+static float noise() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState / 4294967296.0f) * 2.0f - 1.0f;
+}
+
+// Runs the routine to completion; returns the elapsed time in ms.
+static uint32_t runCharacterization(SolenoidCharacterizer& c, const BenchValve& valve, uint32_t engineStartMs) {
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    const float tauMs = 150.0f;
+    float pressure = valve.lowkPa;
+    float duty = 0.0f;
+    solenoidCharacterizeStart(c, valve.frequencyHz, 1.0f);
+    uint32_t t = 0;
+    for (; c.phase == SOLCHAR_RUNNING && t < 120000; t += (uint32_t)dtMs) {
+        float equilibrium = valve.lowkPa + (valve.highkPa - valve.lowkPa) * valve.flow(duty) / 100.0f;
+        pressure += (equilibrium - pressure) * dtMs / (tauMs + dtMs);
+        float measured = pressure + 0.5f * noise();
+        if (!solenoidCharacterizeStep(c, measured, t >= engineStartMs, t, duty)) duty = 0.0f;
+    }
+    return t;
+}
+
+static void checkCharacterization() {
+    char detail[200];
+    const BenchValve valve = {2.5f, 33, 100.0f, 220.0f};
+    static SolenoidCharacterizer c;
+    uint32_t elapsed = runCharacterization(c, valve, UINT32_MAX);
+    bool done = c.phase == SOLCHAR_DONE;
+
+    // The measured dead time and curve together must reproduce the valve.
+    SolenoidCurve measured;
+    measured.enabled = 1;
+    measured.deadTimeMs = c.deadTimeMs;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) measured.flowPercent[i] = c.flowPercent[i];
+    float deadBand = solenoidDeadBandPercent(measured.deadTimeMs, valve.frequencyHz);
+    float worst = 0.0f;
+    for (int k = 0; k <= 100; k++) {
+        float error = fabsf(solenoidFlow(measured, (float)k, deadBand) - valve.flow((float)k));
+        if (error > worst) worst = error;
+    }
+    snprintf(detail, sizeof(detail), "%.1f s, dead time %.2f ms (valve %.2f), max response error %.2f %%",
+             elapsed / 1000.0f, c.deadTimeMs, valve.deadTimeMs, worst);
+    check(done && fabsf(c.deadTimeMs - valve.deadTimeMs) < 1.0f && worst < 4.0f, "characterization", detail);
+
+    // A valve plumbed the other way round lowers the line pressure as it opens.
+    const BenchValve inverted = {2.5f, 33, 220.0f, 100.0f};
+    static SolenoidCharacterizer ci;
+    runCharacterization(ci, inverted, UINT32_MAX);
+    float spread = 0.0f;
+    for (int i = 0; i < SOLENOID_CURVE_POINTS; i++) spread = fmaxf(spread, fabsf(ci.flowPercent[i] - c.flowPercent[i]));
+    snprintf(detail, sizeof(detail), "max difference from normal plumbing %.2f %%", spread);
+    check(ci.phase == SOLCHAR_DONE && spread < 2.0f, "characterization inverted", detail);
+
+    const BenchValve noAir = {2.5f, 33, 100.0f, 102.0f};
+    static SolenoidCharacterizer cn;
+    runCharacterization(cn, noAir, UINT32_MAX);
+    static SolenoidCharacterizer ce;
+    runCharacterization(ce, valve, 5000);
+    snprintf(detail, sizeof(detail), "no air: %s, engine started: %s", solenoidCharAbortName(cn.abortReason),
+             solenoidCharAbortName(ce.abortReason));
+    check(cn.phase == SOLCHAR_ABORTED && cn.abortReason == SOLCHAR_ABORT_NO_RESPONSE && ce.phase == SOLCHAR_ABORTED &&
+          ce.abortReason == SOLCHAR_ABORT_ENGINE, "characterization aborts", detail);
+
+    // Gain of the valve, flow per % of output, over 5 % steps of the output:
+    // the bare valve against the valve driven through the measured curve.
+    SolenoidLinearizer linearizer;
+    solenoidLinearizerInit(linearizer);
+    solenoidLinearizerUpdate(linearizer, measured);
+    float bareMin = 1e9f, bareMax = 0.0f, linMin = 1e9f, linMax = 0.0f;
+    for (int k = 10; k < 90; k += 5) {
+        float bare = (valve.flow(k + 5.0f) - valve.flow((float)k)) / 5.0f;
+        float lin = (valve.flow(solenoidLinearize(linearizer, k + 5.0f, deadBand)) -
+                     valve.flow(solenoidLinearize(linearizer, (float)k, deadBand))) / 5.0f;
+        bareMin = fminf(bareMin, bare); bareMax = fmaxf(bareMax, bare);
+        linMin = fminf(linMin, lin); linMax = fmaxf(linMax, lin);
+    }
+    snprintf(detail, sizeof(detail), "gain over 10-90 %% output: bare %.2f..%.2f, linearized %.2f..%.2f", bareMin,
+             bareMax, linMin, linMax);
+    check(linMin > 0.8f && linMax < 1.2f && bareMax > 3.0f * fmaxf(bareMin, 0.01f), "loop gain", detail);
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else ok = false;
+        if (!ok) {
+            if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+            fprintf(stderr, "usage: solenoid [--params FILE] [--set key=value]...\n");
+            return 1;
+        }
+    }
+
+    checkPassThrough();
+    checkInverse();
+    checkDeadBand(tp);
+    checkCharacterization();
+    return checkExitCode();
+}
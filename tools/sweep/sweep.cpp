@@ -0,0 +1,366 @@
+//================================================================================
+// PARAMETER SWEEP / TUNING OPTIMIZER
+//================================================================================
+// Evaluates parameter sets across simulated pulls (tools/common/plant_sim) and
+// replayed captures, in parallel on every core, and ranks them by Torque Score,
+// Spool Score, overshoot and settling time. The best candidates are exported as
+// "key=value" preset files that can be sent to the firmware serial console.
+//
+//   sweep [--params FILE] --range key=min:max:steps ... [--mode grid|descent]
+//         [--iterations N] [--pulls N] [--trace FILE]... [--rank METRIC]
+//         [--top N] [--export DIR] [--threads N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "control.h"
+#include "plant_sim.h"
+#include "thread_pool.h"
+#include "tool_params.h"
+#include "trace_log.h"
+
+struct SweepRange {
+    std::string key;
+    double minValue, maxValue;
+    int steps;
+};
+
+enum RankMetric { RANK_COMPOSITE, RANK_TORQUE, RANK_SPOOL, RANK_OVERSHOOT, RANK_SETTLING };
+
+struct Candidate {
+    ToolParams params;
+    PullMetrics metrics;
+    double cost;
+};
+
+struct Scenario {
+    PlantModel model;
+    const TraceLog* trace;   // null for a simulated pull
+};
+
+static std::vector<Scenario> scenarios;
+static PullProfile pullProfile;
+static RankMetric rankMetric = RANK_COMPOSITE;
+
+//================================================================================
+// EVALUATION
+//================================================================================
+// Scored against each record's target. A trace has no throttle signal, so a
+// pull lasts while the filtered pressure is above the arming threshold.
+// Settling is measured per pull as simulatePull() does, from first reaching
+// the band below the target to the last tick outside it. The drop out of the
+// band at the lift only counts if the pressure comes back into it. Pulls that
+// never reach the band (part throttle) are not scored; the slowest of the
+// others is reported.
+static void replayTrace(const ToolParams& tp, const TraceLog& log, PullMetrics& m) {
+    static thread_local ControlState state;
+    ControlParams params;
+    toControlParams(tp, params);
+    traceControlInit(log, state, params);
+
+    m.spoolScore = 0; m.torqueScore = 0; m.overshootkPa = 0; m.settlingMs = 0; m.peakkPa = 0;
+    ControlInput input;
+    ControlOutput out;
+    SensorSample sensors;
+    input.previousDutyPercent = 0;
+    int64_t firstAtTargetMs = -1, lastOutsideBandMs = -1, pendingOutsideMs = -1;
+    auto endPull = [&]() {
+        if (firstAtTargetMs >= 0 && lastOutsideBandMs >= 0 && lastOutsideBandMs - firstAtTargetMs > m.settlingMs) {
+            m.settlingMs = (float)(lastOutsideBandMs - firstAtTargetMs);
+        }
+        firstAtTargetMs = lastOutsideBandMs = pendingOutsideMs = -1;
+    };
+    for (size_t i = 0; i < log.size(); i++) {
+        const TraceRecord& r = log[i];
+        input.timeMs = r.timeMs;
+        input.measuredVoltage = r.voltage;
+        input.targetkPa = r.targetkPa;
+        input.activityDetected = (r.flags & TRACE_FLAG_ACTIVITY) != 0;
+        input.rpmPulses = r.rpmPulses;
+        input.speedPulses = r.speedPulses;
+        traceSensorSample(r, sensors);
+        if (r.flags & TRACE_FLAG_FF_CLEARED) feedForwardClear(state.feedForward);
+        input.sensors = &sensors;
+        if (r.flags & TRACE_FLAG_DUTY_OVERRIDE) input.previousDutyPercent = r.appliedPercent;
+        controlStep(state, params, input, out);
+        input.previousDutyPercent = out.controlPercent;
+        if (out.spoolScoreReady && out.spoolScore > m.spoolScore) m.spoolScore = out.spoolScore;
+        if (out.torqueScoreReady && out.torqueScore > m.torqueScore) m.torqueScore = out.torqueScore;
+
+        const float p = out.currentPressure;
+        if (p > m.peakkPa) m.peakkPa = p;
+        if (p - r.targetkPa > m.overshootkPa) m.overshootkPa = p - r.targetkPa;
+        if (p <= ARMING_THRESHOLD_KPA) {
+            endPull();
+            continue;
+        }
+        if (firstAtTargetMs < 0 && p >= r.targetkPa - PULL_SETTLE_BAND_KPA) firstAtTargetMs = r.timeMs;
+        if (firstAtTargetMs < 0) continue;
+        if (fabsf(p - r.targetkPa) > PULL_SETTLE_BAND_KPA) {
+            pendingOutsideMs = r.timeMs;
+        } else if (pendingOutsideMs >= 0) {
+            lastOutsideBandMs = pendingOutsideMs;
+            pendingOutsideMs = -1;
+        }
+    }
+    endPull();
+}
+
+static double costOf(const PullMetrics& m) {
+    switch (rankMetric) {
+        case RANK_TORQUE: return -m.torqueScore;
+        case RANK_SPOOL: return -m.spoolScore;
+        case RANK_OVERSHOOT: return m.overshootkPa;
+        case RANK_SETTLING: return m.settlingMs;
+        case RANK_COMPOSITE:
+        default:
+            return -m.torqueScore - 0.5 * m.spoolScore + 2.0 * m.overshootkPa + 0.01 * m.settlingMs;
+    }
+}
+
+static void evaluate(Candidate& c) {
+    PullMetrics sum = {0, 0, 0, 0, 0, 0, 0};
+    for (const Scenario& s : scenarios) {
+        PullMetrics m;
+        if (s.trace) replayTrace(c.params, *s.trace, m);
+        else simulatePull(c.params, s.model, pullProfile, m);
+        sum.spoolScore += m.spoolScore;
+        sum.torqueScore += m.torqueScore;
+        sum.overshootkPa += m.overshootkPa;
+        sum.settlingMs += m.settlingMs;
+        sum.peakkPa = std::max(sum.peakkPa, m.peakkPa);
+    }
+    float n = (float)scenarios.size();
+    c.metrics.spoolScore = sum.spoolScore / n;
+    c.metrics.torqueScore = sum.torqueScore / n;
+    c.metrics.overshootkPa = sum.overshootkPa / n;
+    c.metrics.settlingMs = sum.settlingMs / n;
+    c.metrics.peakkPa = sum.peakkPa;
+    c.cost = costOf(c.metrics);
+}
+
+static void evaluateAll(ThreadPool& pool, std::vector<Candidate>& candidates) {
+    pool.parallelFor(candidates.size(), [&candidates](size_t i) { evaluate(candidates[i]); });
+}
+
+//================================================================================
+// SEARCH STRATEGIES
+//================================================================================
+static double stepValue(const SweepRange& r, int i) {
+    if (r.steps <= 1) return r.minValue;
+    return r.minValue + (r.maxValue - r.minValue) * i / (r.steps - 1);
+}
+
+static std::vector<Candidate> gridSearch(ThreadPool& pool, const ToolParams& base, const std::vector<SweepRange>& ranges) {
+    size_t total = 1;
+    for (const SweepRange& r : ranges) total *= (size_t)std::max(1, r.steps);
+    std::vector<Candidate> candidates(total);
+    for (size_t n = 0; n < total; n++) {
+        candidates[n].params = base;
+        size_t rest = n;
+        for (const SweepRange& r : ranges) {
+            int steps = std::max(1, r.steps);
+            setToolParamValue(candidates[n].params, r.key, stepValue(r, (int)(rest % steps)));
+            rest /= steps;
+        }
+    }
+    fprintf(stderr, "grid: %zu candidates x %zu scenarios on %u threads\n", total, scenarios.size(), pool.size());
+    evaluateAll(pool, candidates);
+    return candidates;
+}
+
+// Coordinate descent: probe +/- one step on every coordinate in parallel, move
+// to the best improvement, and halve the steps when nothing improves.
+static std::vector<Candidate> descentSearch(ThreadPool& pool, const ToolParams& base, const std::vector<SweepRange>& ranges, int iterations) {
+    std::vector<Candidate> history;
+    Candidate best;
+    best.params = base;
+    for (const SweepRange& r : ranges) {
+        double v;
+        getToolParamValue(best.params, r.key, v);
+        setToolParamValue(best.params, r.key, std::min(r.maxValue, std::max(r.minValue, v)));
+    }
+    evaluate(best);
+    history.push_back(best);
+
+    std::vector<double> steps;
+    for (const SweepRange& r : ranges) steps.push_back((r.maxValue - r.minValue) / 4.0);
+
+    for (int it = 0; it < iterations; it++) {
+        std::vector<Candidate> probes;
+        for (size_t k = 0; k < ranges.size(); k++) {
+            double v;
+            getToolParamValue(best.params, ranges[k].key, v);
+            for (int dir = -1; dir <= 1; dir += 2) {
+                double nv = v + dir * steps[k];
+                if (nv < ranges[k].minValue || nv > ranges[k].maxValue) continue;
+                Candidate c;
+                c.params = best.params;
+                setToolParamValue(c.params, ranges[k].key, nv);
+                probes.push_back(c);
+            }
+        }
+        if (probes.empty()) break;
+        evaluateAll(pool, probes);
+        history.insert(history.end(), probes.begin(), probes.end());
+
+        const Candidate* winner = nullptr;
+        for (const Candidate& c : probes) {
+            if (c.cost < best.cost && (!winner || c.cost < winner->cost)) winner = &c;
+        }
+        if (winner) {
+            best = *winner;
+        } else {
+            bool anyLeft = false;
+            for (size_t k = 0; k < steps.size(); k++) {
+                steps[k] *= 0.5;
+                if (steps[k] > (ranges[k].maxValue - ranges[k].minValue) * 1e-3) anyLeft = true;
+            }
+            if (!anyLeft) break;
+        }
+        fprintf(stderr, "descent %d: cost %.3f\n", it + 1, best.cost);
+    }
+    return history;
+}
+
+//================================================================================
+// COMMAND LINE
+//================================================================================
+static bool parseRange(const std::string& arg, SweepRange& r) {
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos) return false;
+    r.key = arg.substr(0, eq);
+    r.steps = 5;
+    int fields = sscanf(arg.c_str() + eq + 1, "%lf:%lf:%d", &r.minValue, &r.maxValue, &r.steps);
+    ToolParams probe = defaultToolParams();
+    double unused;
+    return fields >= 2 && r.maxValue >= r.minValue && getToolParamValue(probe, r.key, unused);
+}
+
+static bool parseRank(const std::string& s) {
+    if (s == "composite") rankMetric = RANK_COMPOSITE;
+    else if (s == "torque") rankMetric = RANK_TORQUE;
+    else if (s == "spool") rankMetric = RANK_SPOOL;
+    else if (s == "overshoot") rankMetric = RANK_OVERSHOOT;
+    else if (s == "settling") rankMetric = RANK_SETTLING;
+    else return false;
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: sweep [--params FILE] --range key=min:max[:steps]... [--mode grid|descent]\n"
+        "             [--iterations N] [--pulls N] [--trace FILE]... [--rank METRIC]\n"
+        "             [--top N] [--export DIR] [--threads N]\n"
+        "  METRIC: composite (default), torque, spool, overshoot, settling\n");
+}
+
+int main(int argc, char** argv) {
+    ToolParams base = defaultToolParams();
+    std::vector<SweepRange> ranges;
+    std::vector<std::string> tracePaths;
+    std::string mode = "grid", exportDir, error;
+    int iterations = 40, pulls = 4, top = 10;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) { usage(); return 1; }
+        std::string value = argv[++i];
+        if (arg == "--params") {
+            if (!loadToolParamsFile(base, value, error)) { fprintf(stderr, "%s\n", error.c_str()); return 1; }
+        } else if (arg == "--range") {
+            SweepRange r;
+            if (!parseRange(value, r)) { fprintf(stderr, "bad --range '%s'\n", value.c_str()); return 1; }
+            ranges.push_back(r);
+        } else if (arg == "--mode") {
+            mode = value;
+        } else if (arg == "--iterations") {
+            iterations = atoi(value.c_str());
+        } else if (arg == "--pulls") {
+            pulls = atoi(value.c_str());
+        } else if (arg == "--trace") {
+            tracePaths.push_back(value);
+        } else if (arg == "--rank") {
+            if (!parseRank(value)) { usage(); return 1; }
+        } else if (arg == "--top") {
+            top = atoi(value.c_str());
+        } else if (arg == "--export") {
+            exportDir = value;
+        } else if (arg == "--threads") {
+            threads = (unsigned)atoi(value.c_str());
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (ranges.empty() || (mode != "grid" && mode != "descent")) {
+        usage();
+        return 1;
+    }
+
+    // Simulated pulls vary noise seed and spool rate so a tune cannot overfit one plant.
+    pullProfile = defaultPullProfile();
+    for (int p = 0; p < pulls; p++) {
+        Scenario s;
+        s.model = defaultPlantModel();
+        s.model.seed = 1000 + p;
+        s.model.spoolTimeMs *= 0.8f + 0.4f * (pulls > 1 ? (float)p / (pulls - 1) : 0.5f);
+        s.trace = nullptr;
+        scenarios.push_back(s);
+    }
+    std::vector<TraceLog> traces(tracePaths.size());
+    for (size_t t = 0; t < tracePaths.size(); t++) {
+        if (!traces[t].open(tracePaths[t], error) || traces[t].size() == 0) {
+            fprintf(stderr, "%s\n", error.empty() ? (tracePaths[t] + ": no records").c_str() : error.c_str());
+            return 1;
+        }
+        Scenario s;
+        s.model = defaultPlantModel();
+        s.trace = &traces[t];
+        scenarios.push_back(s);
+    }
+    if (scenarios.empty()) {
+        fprintf(stderr, "nothing to evaluate: use --pulls or --trace\n");
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<Candidate> results = (mode == "grid")
+        ? gridSearch(pool, base, ranges)
+        : descentSearch(pool, base, ranges, iterations);
+
+    std::sort(results.begin(), results.end(), [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+    printf("rank,cost,torque_score,spool_score,overshoot_kpa,settling_ms");
+    for (const SweepRange& r : ranges) printf(",%s", r.key.c_str());
+    printf("\n");
+    int shown = std::min((int)results.size(), top);
+    for (int n = 0; n < shown; n++) {
+        const Candidate& c = results[n];
+        printf("%d,%.3f,%.1f,%.1f,%.2f,%.0f", n + 1, c.cost, c.metrics.torqueScore, c.metrics.spoolScore,
+               c.metrics.overshootkPa, c.metrics.settlingMs);
+        for (const SweepRange& r : ranges) {
+            double v;
+            getToolParamValue(c.params, r.key, v);
+            printf(",%.6g", v);
+        }
+        printf("\n");
+
+        if (!exportDir.empty()) {
+            char path[512], comment[160];
+            snprintf(path, sizeof(path), "%s/preset_%02d.txt", exportDir.c_str(), n + 1);
+            snprintf(comment, sizeof(comment), "sweep rank %d: TS %.1f SS %.1f overshoot %.2f kPa settling %.0f ms",
+                     n + 1, c.metrics.torqueScore, c.metrics.spoolScore, c.metrics.overshootkPa, c.metrics.settlingMs);
+            if (!writeToolParamsFile(c.params, path, comment)) {
+                fprintf(stderr, "cannot write %s\n", path);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
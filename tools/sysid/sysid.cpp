@@ -0,0 +1,146 @@
+//================================================================================
+// PLANT IDENTIFICATION CHECK
+//================================================================================
+// Drives the firmware's recursive-least-squares identifier (src/sysid.cpp) with
+// simulated plants and compares the identified gain and time constant to the
+// model's true values. Each plant runs twice: open loop with a pseudo-random
+// duty sequence (the identifier alone), and closed loop through the full
+// control pipeline, where the regressor sees the filtered pressure and the
+// PID's own duty as on the device.
+//
+//   sysid [--params FILE] [--set key=value]... [--tolerance PCT]
+//
+// Exits non-zero when an open-loop estimate misses the true gain or time
+// constant by more than the tolerance (default 15%).
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "control.h"
+#include "plant_sim.h"
+#include "sysid.h"
+#include "tool_params.h"
+
+struct PlantCase {
+    const char* name;
+    PlantModel model;
+};
+
+static const uint32_t THROTTLE_OPEN_MS = 1000;
+static const uint32_t RUN_MS = 20000;
+static const int PRBS_HOLD_TICKS = 25;
+
+// At full spool the sim settles to spring + duty * (max - spring) / 100 above
+// atmosphere through a discrete lag with a = tau / (tau + dt).
+static float trueGain(const PlantModel& m) { return (m.maxBoostkPa - m.springkPa) / 100.0f; }
+static float trueTauMs(const PlantModel& m, float dtMs) {
+    float a = m.tauMs / (m.tauMs + dtMs);
+    return -dtMs / logf(a);
+}
+
+static void runOpenLoop(const ToolParams& tp, const PlantModel& model, PlantEstimate& est) {
+    ControlParams params;
+    toControlParams(tp, params);
+    PlantState plant;
+    plantInit(plant, model);
+    SystemIdentifier id;
+    sysidInit(id);
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    int delayTicks = (int)(model.deadTimeMs / dtMs);
+    uint32_t rng = 0xACE1u;
+    float duty = 50.0f;
+    int tick = 0;
+    for (uint32_t t = (uint32_t)dtMs; t <= RUN_MS; t += (uint32_t)dtMs, tick++) {
+        bool spooled = t >= THROTTLE_OPEN_MS + (uint32_t)model.spoolTimeMs;
+        float p = plantStep(plant, model, duty, t >= THROTTLE_OPEN_MS, (float)(t - THROTTLE_OPEN_MS), dtMs);
+        float measured = voltageToPressure(params, plantSensorVoltage(plant, model, params, p));
+        sysidUpdate(id, measured, duty, delayTicks, params.sysidForgetting, spooled);
+        if (tick % PRBS_HOLD_TICKS == 0) {
+            // 16-bit Galois LFSR; holds long enough for the lag to respond
+            rng = (rng >> 1) ^ (-(rng & 1u) & 0xB400u);
+            duty = (rng & 1u) ? 70.0f : 30.0f;
+        }
+    }
+    sysidEstimate(id, dtMs, est);
+}
+
+static void runClosedLoop(const ToolParams& tp, const PlantModel& model, PlantEstimate& est) {
+    ControlParams params;
+    toControlParams(tp, params);
+    static ControlState state;
+    PlantState plant;
+    plantInit(plant, model);
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    uint32_t t = 0;
+    controlInit(state, params, plantSensorVoltage(plant, model, params, plant.pressurekPa), t);
+    ControlInput input;
+    ControlOutput out;
+    input.activityDetected = false;
+    input.rpmPulses = 0;
+    input.speedPulses = 0;
+    input.sensors = nullptr;
+    float duty = 0;
+    for (t = (uint32_t)dtMs; t <= RUN_MS; t += (uint32_t)dtMs) {
+        float p = plantStep(plant, model, duty, t >= THROTTLE_OPEN_MS, (float)(t - THROTTLE_OPEN_MS), dtMs);
+        // Step the target so the loop keeps exciting the plant.
+        input.targetkPa = tp.targetkPa + (((t / 2000) % 2) ? 10.0f : -10.0f);
+        input.timeMs = t;
+        input.measuredVoltage = plantSensorVoltage(plant, model, params, p);
+        input.previousDutyPercent = duty;
+        controlStep(state, params, input, out);
+        duty = out.controlPercent;
+    }
+    sysidEstimate(state.sysid, dtMs, est);
+}
+
+static float errorPercent(float estimated, float actual) {
+    return 100.0f * fabsf(estimated - actual) / actual;
+}
+
+int main(int argc, char** argv) {
+    ToolParams tp = defaultToolParams();
+    float tolerancePercent = 15.0f;
+    std::string error;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--params") ok = loadToolParamsFile(tp, value, error);
+        else if (arg == "--set") ok = setToolParam(tp, value);
+        else if (arg == "--tolerance") tolerancePercent = strtof(value.c_str(), nullptr);
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "usage: sysid [--params FILE] [--set key=value]... [--tolerance PCT]\n");
+            return 1;
+        }
+    }
+
+    PlantCase cases[5];
+    for (PlantCase& c : cases) c.model = defaultPlantModel();
+    cases[0].name = "default";
+    cases[1].name = "slow_manifold";  cases[1].model.tauMs = 250.0f;
+    cases[2].name = "fast_manifold";  cases[2].model.tauMs = 60.0f;
+    cases[3].name = "high_gain";      cases[3].model.maxBoostkPa = 180.0f;
+    cases[4].name = "low_gain";       cases[4].model.maxBoostkPa = 90.0f; cases[4].model.springkPa = 40.0f;
+
+    const float dtMs = CONTROL_TASK_DELAY_MS;
+    bool allPass = true;
+    printf("plant,true_gain,true_tau_ms,open_gain,open_tau_ms,open_gain_err_pct,open_tau_err_pct,closed_gain,closed_tau_ms,result\n");
+    for (const PlantCase& c : cases) {
+        PlantEstimate open, closed;
+        runOpenLoop(tp, c.model, open);
+        runClosedLoop(tp, c.model, closed);
+        float gain = trueGain(c.model), tau = trueTauMs(c.model, dtMs);
+        float gainErr = open.valid ? errorPercent(open.gainkPaPerPercent, gain) : 100.0f;
+        float tauErr = open.valid ? errorPercent(open.timeConstantMs, tau) : 100.0f;
+        bool pass = open.valid && gainErr <= tolerancePercent && tauErr <= tolerancePercent;
+        if (!pass) allPass = false;
+        printf("%s,%.3f,%.0f,%.3f,%.0f,%.1f,%.1f,%.3f,%.0f,%s\n", c.name, gain, tau,
+               open.gainkPaPerPercent, open.timeConstantMs, gainErr, tauErr,
+               closed.gainkPaPerPercent, closed.timeConstantMs, pass ? "PASS" : "FAIL");
+    }
+    return allPass ? 0 : 2;
+}